@@ -0,0 +1,302 @@
+#include "SlippiCompression.h"
+
+#include <cstring>
+
+#include <zlib.h>
+
+#include "SlippiGame.h"
+
+namespace Slippi {
+  // Anything claiming to be bigger than this is treated as a corrupt block
+  const uint32_t MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+  static uint32_t readU32(const uint8_t* a) {
+    return a[0] << 24 | a[1] << 16 | a[2] << 8 | a[3];
+  }
+
+  static void writeU32(uint8_t* a, uint32_t value) {
+    a[0] = value >> 24;
+    a[1] = value >> 16;
+    a[2] = value >> 8;
+    a[3] = value;
+  }
+
+  // Frame updates start with the frame number, the player index and the follower flag. Those
+  // last two pick the slot holding the previous update this one is coded against
+  static int getDeltaSlot(uint8_t command, const uint8_t* payload, uint32_t payloadSize) {
+    if (command != EVENT_PRE_FRAME_UPDATE && command != EVENT_POST_FRAME_UPDATE) {
+      return -1;
+    }
+
+    if (payloadSize < 6 || payload[4] >= PLAYER_SLOT_COUNT || payload[5] > 1) {
+      return -1;
+    }
+
+    int commandOffset = command == EVENT_POST_FRAME_UPDATE ? 2 * PLAYER_SLOT_COUNT : 0;
+    return commandOffset + payload[5] * PLAYER_SLOT_COUNT + payload[4];
+  }
+
+  // Figures out the size of the event at the start of data. Fails for unknown commands and
+  // events that are cut off
+  static bool getPayloadSize(const uint8_t* data, size_t size,
+                             const std::array<uint32_t, 256>& payloadSizes,
+                             const std::array<bool, 256>& isSizeKnown, uint32_t& payloadSize) {
+    uint8_t command = data[0];
+    if (command == EVENT_PAYLOAD_SIZES) {
+      if (size < 2) {
+        return false;
+      }
+      payloadSize = data[1];
+    } else if (isSizeKnown[command]) {
+      payloadSize = payloadSizes[command];
+    } else {
+      return false;
+    }
+
+    return size >= (size_t)payloadSize + 1;
+  }
+
+  static void loadPayloadSizes(const uint8_t* event, std::array<uint32_t, 256>& payloadSizes,
+                               std::array<bool, 256>& isSizeKnown) {
+    int payloadLength = event[1];
+    for (int i = 2; i + 2 < payloadLength + 1; i += 3) {
+      uint8_t command = event[i];
+      payloadSizes[command] = event[i + 1] << 8 | event[i + 2];
+      isSizeKnown[command] = true;
+    }
+  }
+
+  bool isCompressedReplay(const uint8_t* buffer, size_t size) {
+    return size >= COMPRESSED_HEADER_SIZE &&
+      memcmp(buffer, COMPRESSED_MAGIC, sizeof(COMPRESSED_MAGIC)) == 0;
+  }
+
+  void writeCompressedHeader(std::vector<uint8_t>& out) {
+    out.insert(out.end(), COMPRESSED_MAGIC, COMPRESSED_MAGIC + sizeof(COMPRESSED_MAGIC));
+    out.push_back(COMPRESSED_VERSION);
+  }
+
+  bool writeCompressedBlock(uint8_t type, const uint8_t* data, size_t size,
+                            std::vector<uint8_t>& out) {
+    size_t headerPos = out.size();
+    uLongf compressedSize = compressBound((uLong)size);
+    out.resize(headerPos + COMPRESSED_BLOCK_HEADER_SIZE + compressedSize);
+
+    int result = compress2(&out[headerPos + COMPRESSED_BLOCK_HEADER_SIZE], &compressedSize, data,
+                           (uLong)size, Z_DEFAULT_COMPRESSION);
+    if (result != Z_OK) {
+      out.resize(headerPos);
+      return false;
+    }
+
+    out[headerPos] = type;
+    writeU32(&out[headerPos + 1], (uint32_t)size);
+    writeU32(&out[headerPos + 5], (uint32_t)compressedSize);
+    out.resize(headerPos + COMPRESSED_BLOCK_HEADER_SIZE + compressedSize);
+    return true;
+  }
+
+  //**********************************************************************
+  //*                             Encoder
+  //**********************************************************************
+  ReplayEncoder::ReplayEncoder() {
+    reset();
+  }
+
+  void ReplayEncoder::reset() {
+    payloadSizes.fill(0);
+    isSizeKnown.fill(false);
+    blockSizeTable.assign(2, 0);
+    for (auto& slot : previous) {
+      slot.clear();
+    }
+    pending.clear();
+    isPassThrough = false;
+  }
+
+  void ReplayEncoder::appendEvents(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    while (pos < size) {
+      uint32_t payloadSize = 0;
+      if (isPassThrough ||
+          !getPayloadSize(&data[pos], size - pos, payloadSizes, isSizeKnown, payloadSize)) {
+        // Can't split this up into events anymore, the decoder will hit the same spot
+        isPassThrough = true;
+        pending.insert(pending.end(), &data[pos], data + size);
+        return;
+      }
+
+      uint8_t command = data[pos];
+      const uint8_t* payload = &data[pos + 1];
+      pending.push_back(command);
+
+      int slot = getDeltaSlot(command, payload, payloadSize);
+      if (slot < 0) {
+        pending.insert(pending.end(), payload, payload + payloadSize);
+      } else {
+        std::vector<uint8_t>& prev = previous[slot];
+        if (prev.size() != payloadSize) {
+          prev.assign(payloadSize, 0);
+        }
+
+        size_t start = pending.size();
+        pending.resize(start + payloadSize);
+        uint8_t* coded = &pending[start];
+
+        writeU32(coded, readU32(payload) - readU32(&prev[0]));
+        coded[4] = payload[4];
+        coded[5] = payload[5];
+        for (uint32_t i = 6; i < payloadSize; i++) {
+          coded[i] = payload[i] ^ prev[i];
+        }
+
+        memcpy(&prev[0], payload, payloadSize);
+      }
+
+      if (command == EVENT_PAYLOAD_SIZES) {
+        loadPayloadSizes(&data[pos], payloadSizes, isSizeKnown);
+      }
+
+      pos += payloadSize + 1;
+    }
+  }
+
+  void ReplayEncoder::finishBlock(std::vector<uint8_t>& out) {
+    if (pending.empty()) {
+      return;
+    }
+
+    blockBuffer = blockSizeTable;
+    blockBuffer.insert(blockBuffer.end(), pending.begin(), pending.end());
+    writeCompressedBlock(BLOCK_TYPE_EVENTS, &blockBuffer[0], blockBuffer.size(), out);
+
+    // The next block starts over with the sizes known at this point and no delta history
+    blockSizeTable.assign(2, 0);
+    uint16_t count = 0;
+    for (int command = 0; command < 256; command++) {
+      if (!isSizeKnown[command]) {
+        continue;
+      }
+
+      blockSizeTable.push_back((uint8_t)command);
+      blockSizeTable.push_back(payloadSizes[command] >> 8);
+      blockSizeTable.push_back(payloadSizes[command] & 0xFF);
+      count++;
+    }
+    blockSizeTable[0] = count >> 8;
+    blockSizeTable[1] = count & 0xFF;
+
+    for (auto& slot : previous) {
+      slot.clear();
+    }
+    pending.clear();
+    isPassThrough = false;
+  }
+
+  //**********************************************************************
+  //*                             Decoder
+  //**********************************************************************
+  ReplayDecoder::ReplayDecoder() : isMetadataReached(false) {
+  }
+
+  size_t ReplayDecoder::decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    size_t pos = 0;
+    while (size - pos >= COMPRESSED_BLOCK_HEADER_SIZE) {
+      uint8_t type = data[pos];
+      uint32_t rawSize = readU32(&data[pos + 1]);
+      uint32_t compressedSize = readU32(&data[pos + 5]);
+      if (size - pos - COMPRESSED_BLOCK_HEADER_SIZE < compressedSize) {
+        // The rest of this block hasn't been written yet
+        break;
+      }
+
+      const uint8_t* compressed = &data[pos + COMPRESSED_BLOCK_HEADER_SIZE];
+      pos += COMPRESSED_BLOCK_HEADER_SIZE + compressedSize;
+
+      if (type == BLOCK_TYPE_METADATA) {
+        // Game data is over, nothing in here is needed for playback
+        isMetadataReached = true;
+        continue;
+      }
+
+      if (type != BLOCK_TYPE_EVENTS || rawSize == 0 || rawSize > MAX_BLOCK_SIZE) {
+        continue;
+      }
+
+      blockBuffer.resize(rawSize);
+      uLongf decompressedSize = rawSize;
+      int result = uncompress(&blockBuffer[0], &decompressedSize, compressed, compressedSize);
+      if (result != Z_OK || decompressedSize != rawSize) {
+        // Skip corrupt blocks, every block stands on its own so the next one is still usable
+        continue;
+      }
+
+      decodeEvents(&blockBuffer[0], rawSize, out);
+    }
+
+    return pos;
+  }
+
+  void ReplayDecoder::decodeEvents(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    payloadSizes.fill(0);
+    isSizeKnown.fill(false);
+    for (auto& slot : previous) {
+      slot.clear();
+    }
+
+    if (size < 2) {
+      return;
+    }
+
+    size_t pos = 2;
+    uint16_t count = data[0] << 8 | data[1];
+    for (uint16_t i = 0; i < count && pos + 3 <= size; i++) {
+      payloadSizes[data[pos]] = data[pos + 1] << 8 | data[pos + 2];
+      isSizeKnown[data[pos]] = true;
+      pos += 3;
+    }
+
+    while (pos < size) {
+      uint32_t payloadSize = 0;
+      if (!getPayloadSize(&data[pos], size - pos, payloadSizes, isSizeKnown, payloadSize)) {
+        // The encoder stored the rest of the block as is from here on
+        out.insert(out.end(), &data[pos], data + size);
+        return;
+      }
+
+      uint8_t command = data[pos];
+      const uint8_t* payload = &data[pos + 1];
+      size_t eventStart = out.size();
+      out.push_back(command);
+
+      int slot = getDeltaSlot(command, payload, payloadSize);
+      if (slot < 0) {
+        out.insert(out.end(), payload, payload + payloadSize);
+      } else {
+        std::vector<uint8_t>& prev = previous[slot];
+        if (prev.size() != payloadSize) {
+          prev.assign(payloadSize, 0);
+        }
+
+        size_t start = out.size();
+        out.resize(start + payloadSize);
+        uint8_t* decoded = &out[start];
+
+        writeU32(decoded, readU32(payload) + readU32(&prev[0]));
+        decoded[4] = payload[4];
+        decoded[5] = payload[5];
+        for (uint32_t i = 6; i < payloadSize; i++) {
+          decoded[i] = payload[i] ^ prev[i];
+        }
+
+        memcpy(&prev[0], decoded, payloadSize);
+      }
+
+      if (command == EVENT_PAYLOAD_SIZES) {
+        loadPayloadSizes(&out[eventStart], payloadSizes, isSizeKnown);
+      }
+
+      pos += payloadSize + 1;
+    }
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed replay format
+//
+// The file starts with COMPRESSED_MAGIC followed by a version byte. After that it is a sequence
+// of blocks, each made of a one byte type, the big endian size of the decompressed contents and
+// the big endian size of the zlib stream that follows.
+//
+// An events block decompresses to a payload size table (count, then command/u16 size triplets)
+// followed by whole events exactly as they appear in the raw element of a .slp file, except that
+// pre and post frame updates are delta coded against the previous update for the same player in
+// the same block: the frame number is stored as the difference from that update and the rest of
+// the payload is XORed with it. Both the delta state and the payload sizes start fresh in every
+// block, so each block can be decoded on its own.
+//
+// The metadata block holds the same UBJSON bytes that end a regular .slp file.
+namespace Slippi {
+  const uint8_t COMPRESSED_MAGIC[] = { 'S', 'L', 'P', 'Z' };
+  const uint8_t COMPRESSED_VERSION = 1;
+  const uint32_t COMPRESSED_HEADER_SIZE = sizeof(COMPRESSED_MAGIC) + 1;
+  const uint32_t COMPRESSED_BLOCK_HEADER_SIZE = 9;
+
+  const uint8_t BLOCK_TYPE_EVENTS = 1;
+  const uint8_t BLOCK_TYPE_METADATA = 2;
+
+  // One delta slot per player and follower for both frame update events
+  const uint32_t DELTA_SLOT_COUNT = 16;
+
+  bool isCompressedReplay(const uint8_t* buffer, size_t size);
+  void writeCompressedHeader(std::vector<uint8_t>& out);
+
+  // Compresses data into a single block and appends it (header included) to out. Only fails if
+  // zlib runs out of memory
+  bool writeCompressedBlock(uint8_t type, const uint8_t* data, size_t size,
+                            std::vector<uint8_t>& out);
+
+  class ReplayEncoder
+  {
+  public:
+    ReplayEncoder();
+    void reset();
+
+    // Takes whole events, including their command byte
+    void appendEvents(const uint8_t* data, size_t size);
+
+    // Number of event bytes waiting to be written out as a block
+    size_t pendingSize() const { return pending.size(); }
+
+    // Writes everything appended since the last block as an events block
+    void finishBlock(std::vector<uint8_t>& out);
+
+  private:
+    std::array<uint32_t, 256> payloadSizes;
+    std::array<bool, 256> isSizeKnown;
+    std::vector<uint8_t> blockSizeTable;
+
+    std::array<std::vector<uint8_t>, DELTA_SLOT_COUNT> previous;
+    std::vector<uint8_t> pending;
+    std::vector<uint8_t> blockBuffer;
+
+    // Set when a command of unknown size shows up, the rest of the block is stored as is
+    bool isPassThrough;
+  };
+
+  class ReplayDecoder
+  {
+  public:
+    ReplayDecoder();
+
+    // Decodes as many complete blocks as there are at the start of data and appends the
+    // resulting events to out. Returns how many bytes were consumed, a partially written block
+    // is left for the next call
+    size_t decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+    bool hasReachedMetadata() const { return isMetadataReached; }
+
+  private:
+    void decodeEvents(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+    std::array<uint32_t, 256> payloadSizes;
+    std::array<bool, 256> isSizeKnown;
+    std::array<std::vector<uint8_t>, DELTA_SLOT_COUNT> previous;
+    std::vector<uint8_t> blockBuffer;
+    bool isMetadataReached;
+  };
+}
@@ -2,9 +2,6 @@
 
 namespace Slippi {
 
-  //**********************************************************************
-  //*                         Event Handlers
-  //**********************************************************************
   //The read operators will read a value and increment the index so the next read will read in the correct location
   uint8_t readByte(uint8_t* a, int& idx, uint32_t maxSize, uint8_t defaultValue) {
     if (idx >= (int)maxSize) {
@@ -42,7 +39,42 @@ namespace Slippi {
     return *(float*)(&bytes);
   }
 
-  void handleGameInit(Game* game, uint32_t maxSize) {
+  //**********************************************************************
+  //*                         Frame Storage
+  //**********************************************************************
+  FrameData* findFrame(Game* game, int32_t frame) {
+    int32_t index = frame - GAME_FIRST_FRAME;
+    if (index < 0 || index >= game->frameSlotCount) {
+      return nullptr;
+    }
+
+    return &game->frameChunks[index / FRAME_CHUNK_SIZE][index % FRAME_CHUNK_SIZE];
+  }
+
+  FrameData* findOrCreateFrame(Game* game, int32_t frame) {
+    int32_t index = frame - GAME_FIRST_FRAME;
+    if (index < 0) {
+      return nullptr;
+    }
+
+    // Frames come in order so this only ever grows by one chunk at a time
+    while (index >= (int32_t)game->frameChunks.size() * FRAME_CHUNK_SIZE) {
+      game->frameChunks.emplace_back(new FrameData[FRAME_CHUNK_SIZE]());
+    }
+
+    if (index >= game->frameSlotCount) {
+      game->frameSlotCount = index + 1;
+    }
+
+    FrameData* result = &game->frameChunks[index / FRAME_CHUNK_SIZE][index % FRAME_CHUNK_SIZE];
+    result->frame = frame;
+    return result;
+  }
+
+  //**********************************************************************
+  //*                         Event Handlers
+  //**********************************************************************
+  bool handleGameInit(Game* game, uint8_t* data, uint32_t maxSize) {
     int idx = 0;
 
     // Read version number
@@ -87,42 +119,44 @@ namespace Slippi {
         continue;
       }
 
-      PlayerSettings* p = new PlayerSettings();
+      PlayerSettings& p = game->settings.players[i];
 
       // Get player settings
-      p->controllerPort = i;
-      p->characterId = playerInfo >> 24;
-      p->playerType = playerType;
-      p->characterColor = playerInfo & 0xFF;
-      p->nametag = playerNametags[i];
-
-      //Add player settings to result
-      game->settings.players[i] = *p;
+      p.controllerPort = i;
+      p.characterId = playerInfo >> 24;
+      p.playerType = playerType;
+      p.characterColor = playerInfo & 0xFF;
+      p.nametag = playerNametags[i];
     }
 
     game->settings.stage = gameInfoHeader[3] & 0xFFFF;
+    return false;
   }
 
-  void handlePreFrameUpdate(Game* game, uint32_t maxSize) {
+  bool handlePreFrameUpdate(Game* game, uint8_t* data, uint32_t maxSize) {
     int idx = 0;
 
     //Check frame count
     int32_t frameCount = readWord(data, idx, maxSize, 0);
     game->frameCount = frameCount;
 
-    FrameData* frame = new FrameData();
-    if (game->frameData.count(frameCount)) {
-      // If this frame already exists, this is probably another player
-      // in this frame, so let's fetch it.
-      frame = &game->frameData[frameCount];
-    }
-
-    frame->frame = frameCount;
-
-    PlayerFrameData* p = new PlayerFrameData();
+    // If this frame already exists, this is probably another player
+    // in this frame, so we will get the existing one back
+    FrameData* frame = findOrCreateFrame(game, frameCount);
 
     uint8_t playerSlot = readByte(data, idx, maxSize, 0);
     uint8_t isFollower = readByte(data, idx, maxSize, 0);
+    if (!frame || playerSlot >= PLAYER_SLOT_COUNT) {
+      return false;
+    }
+
+    // Write straight into the slot for the player or follower
+    PlayerFrameData* p = isFollower ? &frame->followers[playerSlot] : &frame->players[playerSlot];
+    if (isFollower) {
+      frame->hasFollower[playerSlot] = true;
+    } else {
+      frame->hasPlayer[playerSlot] = true;
+    }
 
     //Load random seed for player frame update
     p->randomSeed = readWord(data, idx, maxSize, 0);
@@ -146,53 +180,56 @@ namespace Slippi {
     p->lTrigger = readFloat(data, idx, maxSize, 0);
     p->rTrigger = readFloat(data, idx, maxSize, 0);
 
-    if (asmEvents[EVENT_PRE_FRAME_UPDATE] >= 59) {
+    if (maxSize >= 59) {
       p->joystickXRaw = readByte(data, idx, maxSize, 0);
     }
 
     uint32_t noPercent = 0xFFFFFFFF;
     p->percent = readFloat(data, idx, maxSize, *(float*)(&noPercent));
 
-    // Add player data to frame
-    std::unordered_map<uint8_t, PlayerFrameData>* target;
-    target = isFollower ? &frame->followers : &frame->players;
-
-    // Set the player data for the player or follower
-    target->operator[](playerSlot) = *p;
-
-    // Add frame to game
-    game->frameData[frameCount] = *frame;
-
     // Check if a player started as sheik and update
     if (frameCount == GAME_FIRST_FRAME && p->internalCharacterId == GAME_SHEIK_INTERNAL_ID) {
       game->settings.players[playerSlot].characterId = GAME_SHEIK_EXTERNAL_ID;
     }
+
+    return false;
   }
 
-  void handlePostFrameUpdate(Game* game, uint32_t maxSize) {
+  bool handlePostFrameUpdate(Game* game, uint8_t* data, uint32_t maxSize) {
     int idx = 0;
 
     //Check frame count
     int32_t frameCount = readWord(data, idx, maxSize, 0);
 
-    FrameData* frame = new FrameData();
-    if (game->frameData.count(frameCount)) {
-      // If this frame already exists, this is probably another player
-      // in this frame, so let's fetch it.
-      frame = &game->frameData[frameCount];
+    // If this frame already exists, this is probably another player
+    // in this frame, so we will get the existing one back
+    FrameData* frame = findOrCreateFrame(game, frameCount);
+
+    uint8_t playerSlot = readByte(data, idx, maxSize, 0);
+    uint8_t isFollower = readByte(data, idx, maxSize, 0);
+    if (!frame || playerSlot >= PLAYER_SLOT_COUNT) {
+      return false;
     }
 
     // As soon as a post frame update happens, we know we have received all the inputs
     // This is used to determine if a frame is ready to be used for a replay (for mirroring)
     frame->inputsFullyFetched = true;
 
-    uint8_t playerSlot = readByte(data, idx, maxSize, 0);
-    uint8_t isFollower = readByte(data, idx, maxSize, 0);
-
     PlayerFrameData* p = isFollower ? &frame->followers[playerSlot] : &frame->players[playerSlot];
 
     p->internalCharacterId = readByte(data, idx, maxSize, 0);
 
+    // Skip action state, position, facing direction and percent. Playback feeds the values from
+    // the pre frame update back to the game so those must not be overwritten
+    idx += 18;
+
+    // Resulting state of the character after this frame
+    p->shieldSize = readFloat(data, idx, maxSize, 0);
+    p->lastMoveHitId = readByte(data, idx, maxSize, 0);
+    p->comboCount = readByte(data, idx, maxSize, 0);
+    p->lastHitBy = readByte(data, idx, maxSize, 0);
+    p->stocks = readByte(data, idx, maxSize, 0);
+
     // Check if a player started as sheik and update
     if (frameCount == GAME_FIRST_FRAME && p->internalCharacterId == GAME_SHEIK_INTERNAL_ID) {
       game->settings.players[playerSlot].characterId = GAME_SHEIK_EXTERNAL_ID;
@@ -201,32 +238,37 @@ namespace Slippi {
     // Set settings loaded if this is the last character
     if (frameCount == GAME_FIRST_FRAME) {
       uint8_t lastPlayerIndex = 0;
-      for (auto it = frame->players.begin(); it != frame->players.end(); ++it) {
-        if (it->first <= lastPlayerIndex) {
-          continue;
+      for (uint8_t i = 0; i < PLAYER_SLOT_COUNT; i++) {
+        if (frame->hasPlayer[i]) {
+          lastPlayerIndex = i;
         }
-
-        lastPlayerIndex = it->first;
       }
 
       if (playerSlot >= lastPlayerIndex) {
         game->areSettingsLoaded = true;
       }
     }
+
+    return false;
   }
 
-  void handleGameEnd(Game* game, uint32_t maxSize) {
+  bool handleGameEnd(Game* game, uint8_t* data, uint32_t maxSize) {
     int idx = 0;
 
     game->winCondition = readByte(data, idx, maxSize, 0);
+    return true;
   }
 
-  // This function gets the position where the raw data starts
-  int getRawDataPosition(std::ifstream* f) {
-    char buffer[2];
-    f->seekg(0, std::ios::beg);
-    f->read(buffer, 2);
+  bool handleMetadataStart(Game* game, uint8_t* data, uint32_t maxSize) {
+    // This is sort of a hack to prevent this functioning
+    // from processing the metadata as raw data. 0x55 is 'U'
+    // which is the first character after the raw data in the
+    // ubjson file format
+    return true;
+  }
 
+  // This function gets the position where the raw data starts
+  int getRawDataPosition(uint8_t* buffer) {
     if (buffer[0] == 0x36) {
       return 0;
     }
@@ -241,47 +283,69 @@ namespace Slippi {
     return 15;
   }
 
-  uint32_t getRawDataLength(std::ifstream* f, int position, int fileSize) {
-    if (position == 0) {
-      return fileSize;
+  void loadMessageSizes(uint8_t* buffer, std::array<EventEntry, 256>& eventTable) {
+    if (buffer[0] != EVENT_PAYLOAD_SIZES) {
+      return;
     }
 
-    char buffer[4];
-    f->seekg(position - 4, std::ios::beg);
-    f->read(buffer, 4);
+    // Only the events listed here exist in this file
+    for (auto& entry : eventTable) {
+      entry.payloadSize = 0;
+    }
 
-    uint8_t* byteBuf = (uint8_t*)&buffer[0];
-    uint32_t length = byteBuf[0] << 24 | byteBuf[1] << 16 | byteBuf[2] << 8 | byteBuf[3];
-    return length;
-  }
+    int payloadLength = buffer[1];
+    eventTable[EVENT_PAYLOAD_SIZES].payloadSize = payloadLength;
 
-  std::unordered_map<uint8_t, uint32_t> getMessageSizes(std::ifstream* f, int position) {
-    char buffer[2];
-    f->seekg(position, std::ios::beg);
-    f->read(buffer, 2);
-    if (buffer[0] != EVENT_PAYLOAD_SIZES) {
-      return {};
+    for (int i = 2; i < payloadLength + 1; i += 3) {
+      uint8_t command = buffer[i];
+      uint16_t size = buffer[i + 1] << 8 | buffer[i + 2];
+      eventTable[command].payloadSize = size;
     }
+  }
 
-    int payloadLength = buffer[1];
-    std::unordered_map<uint8_t, uint32_t> messageSizes = {
-      { EVENT_PAYLOAD_SIZES, payloadLength }
-    };
+  // Appends whatever was written to the file since the last call to rawData. Returns
+  // false if there is nothing new
+  bool SlippiGame::readNewData() {
+    // Clear eof from the last read so that we can keep following the file as it grows
+    file->clear();
+    file->seekg(0, std::ios::end);
+    int64_t fileSize = (int64_t)file->tellg();
+
+    if (fileReadPos == 0) {
+      if (fileSize < COMPRESSED_HEADER_SIZE) {
+        // If we can't even tell where the raw data starts yet, return
+        return false;
+      }
+
+      uint8_t start[COMPRESSED_HEADER_SIZE];
+      file->seekg(0, std::ios::beg);
+      file->read((char*)start, COMPRESSED_HEADER_SIZE);
+      isCompressed = isCompressedReplay(start, COMPRESSED_HEADER_SIZE);
+      fileReadPos = isCompressed ? COMPRESSED_HEADER_SIZE : getRawDataPosition(start);
+    }
 
-    std::vector<char> messageSizesBuffer(payloadLength - 1);
-    f->read(&messageSizesBuffer[0], payloadLength - 1);
-    for (int i = 0; i < payloadLength - 1; i += 3) {
-      uint8_t command = messageSizesBuffer[i];
+    int64_t sizeToRead = fileSize - fileReadPos;
+    if (sizeToRead <= 0) {
+      return false;
+    }
 
-      // Extract the bytes in u8s. Without this the chars don't or together well
-      uint8_t byte1 = messageSizesBuffer[i + 1];
-      uint8_t byte2 = messageSizesBuffer[i + 2];
+    std::vector<uint8_t>& target = isCompressed ? compressedData : rawData;
+    size_t oldSize = target.size();
+    target.resize(oldSize + (size_t)sizeToRead);
+    file->seekg(fileReadPos, std::ios::beg);
+    file->read((char*)&target[oldSize], sizeToRead);
+    fileReadPos = fileSize;
 
-      uint16_t size = byte1 << 8 | byte2;
-      messageSizes[command] = size;
+    if (!isCompressed) {
+      return true;
     }
 
-    return messageSizes;
+    // Only whole blocks can be decoded, a block that is still being written stays around
+    size_t oldRawSize = rawData.size();
+    size_t consumed = decoder.decode(&compressedData[0], compressedData.size(), rawData);
+    compressedData.erase(compressedData.begin(), compressedData.begin() + consumed);
+
+    return rawData.size() > oldRawSize || decoder.hasReachedMetadata();
   }
 
   void SlippiGame::processData() {
@@ -290,104 +354,70 @@ namespace Slippi {
       return;
     }
 
-    // This function will process as much data as possible
-    int startPos = (int)file->tellg();
-    //file = new std::ifstream(path, std::ios::in | std::ios::binary);
-    file->seekg(startPos);
-    if (startPos == 0) {
-      file->seekg(0, std::ios::end);
-      int len = (int)file->tellg();
-      if (len < 2) {
-        // If we can't read message sizes payload size yet, return
-        return;
-      }
-
-      int rawDataPos = getRawDataPosition(file);
-      int rawDataLen = len - rawDataPos;
-      if (rawDataLen < 2) {
-        // If we don't have enough raw data yet to read the replay file, return
-        // Reset to begining so that the startPos condition will be hit again
-        file->seekg(0);
-        return;
-      }
-
-      startPos = rawDataPos;
+    // Only the newly appended bytes get read and parsed
+    if (!readNewData()) {
+      return;
+    }
 
-      char buffer[2];
-      file->seekg(startPos);
-      file->read(buffer, 2);
-      file->seekg(startPos);
-      auto messageSizesSize = (int)buffer[1];
-      if (rawDataLen < messageSizesSize) {
+    int sizeToRead = (int)rawData.size();
+    if (!areMessageSizesLoaded) {
+      if (sizeToRead < 2 || sizeToRead < rawData[1] + 1) {
         // If we haven't received the full payload sizes message, return
-        // Reset to begining so that the startPos condition will be hit again
-        file->seekg(0);
         return;
       }
 
-      asmEvents = getMessageSizes(file, rawDataPos);
-    }
-
-    // Read everything to the end
-    file->seekg(0, std::ios::end);
-    int endPos = (int)file->tellg();
-    int sizeToRead = endPos - startPos;
-    file->seekg(startPos);
-    //log << "Size to read: " << sizeToRead << "\n";
-    //log << "Start Pos: " << startPos << "\n";
-    //log << "End Pos: " << endPos << "\n\n";
-    if (sizeToRead <= 0) {
-      return;
+      loadMessageSizes(&rawData[0], eventTable);
+      areMessageSizesLoaded = true;
     }
 
-    std::vector<char> newData(sizeToRead);
-    file->read(&newData[0], sizeToRead);
-
     int newDataPos = 0;
     while (newDataPos < sizeToRead) {
-      auto command = newData[newDataPos];
-      auto payloadSize = asmEvents[command];
-
-      //char buff[100];
-      //snprintf(buff, sizeof(buff), "%x", command);
-      //log << "Command: " << buff << " | Payload Size: " << payloadSize << "\n";
+      const EventEntry& event = eventTable[rawData[newDataPos]];
+      uint32_t payloadSize = event.payloadSize;
 
       auto remainingLen = sizeToRead - newDataPos;
       if (remainingLen < ((int)payloadSize + 1)) {
         // Here we don't have enough data to read the whole payload
         // Will be processed after getting more data (hopefully)
-        file->seekg(-remainingLen, std::ios::cur);
-        return;
+        break;
       }
 
-      data = (uint8_t*)&newData[newDataPos + 1];
-      switch (command) {
-      case EVENT_GAME_INIT:
-        handleGameInit(game, payloadSize);
-        break;
-      case EVENT_PRE_FRAME_UPDATE:
-        handlePreFrameUpdate(game, payloadSize);
-        break;
-      case EVENT_POST_FRAME_UPDATE:
-        handlePostFrameUpdate(game, payloadSize);
-        break;
-      case EVENT_GAME_END:
-        handleGameEnd(game, payloadSize);
-        //log.close();
-        isProcessingComplete = true;
+      if (event.handler) {
+        isProcessingComplete = event.handler(game, &rawData[newDataPos + 1], payloadSize);
+      }
+
+      if (isProcessingComplete) {
         break;
-      case 0x55:
-        // This is sort of a hack to prevent this functioning
-        // from processing the metadata as raw data. 0x55 is 'U'
-        // which is the first character after the raw data in the
-        // ubjson file format
-        //log.close();
-        isProcessingComplete = true;
-        file->seekg(-remainingLen, std::ios::cur);
-        return;
       }
+
       newDataPos += payloadSize + 1;
     }
+
+    // Keep only the partial event at the end around for the next poll
+    rawData.erase(rawData.begin(), rawData.begin() + newDataPos);
+
+    // Compressed replays have no 0x55 in the event stream, the metadata block marks the end
+    if (isCompressed && decoder.hasReachedMetadata()) {
+      isProcessingComplete = true;
+    }
+  }
+
+  std::array<EventEntry, 256> SlippiGame::createEventTable() {
+    std::array<EventEntry, 256> table = {};
+
+    // Sizes used until the payload sizes event has been read
+    table[EVENT_GAME_INIT] = { 320, handleGameInit };
+    table[EVENT_PRE_FRAME_UPDATE] = { 58, handlePreFrameUpdate };
+    table[EVENT_POST_FRAME_UPDATE] = { 33, handlePostFrameUpdate };
+    table[EVENT_GAME_END] = { 1, handleGameEnd };
+    table[0x55] = { 0, handleMetadataStart };
+
+    return table;
+  }
+
+  SlippiGame::~SlippiGame() {
+    delete file;
+    delete game;
   }
 
   SlippiGame* SlippiGame::FromFile(std::string path) {
@@ -397,6 +427,7 @@ namespace Slippi {
     result->file = new std::ifstream(path, std::ios::in | std::ios::binary);
     //result->log.open("log.txt");
     if (!result->file->is_open()) {
+      delete result;
       return nullptr;
     }
 
@@ -425,12 +456,12 @@ namespace Slippi {
 
   bool SlippiGame::DoesFrameExist(int32_t frame) {
     processData();
-    return (bool)game->frameData.count(frame);
+    return findFrame(game, frame) != nullptr;
   }
 
   FrameData* SlippiGame::GetFrame(int32_t frame) {
-    // Get the frame we want
-    return &game->frameData.at(frame);
+    // Get the frame we want, this is a plain index into the frame storage
+    return findFrame(game, frame);
   }
 
   int32_t SlippiGame::GetFrameCount() {
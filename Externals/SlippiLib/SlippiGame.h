@@ -2,11 +2,14 @@
 
 #include <string>
 #include <array>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <iostream>
 #include <fstream>
 
+#include "SlippiCompression.h"
+
 namespace Slippi {
   const uint8_t EVENT_PAYLOAD_SIZES = 0x35;
   const uint8_t EVENT_GAME_INIT = 0x36;
@@ -21,7 +24,11 @@ namespace Slippi {
   const uint8_t GAME_SHEIK_INTERNAL_ID = 0x7;
   const uint8_t GAME_SHEIK_EXTERNAL_ID = 0x13;
 
-  static uint8_t* data;
+  const uint8_t PLAYER_SLOT_COUNT = 4;
+
+  // Frames are stored densely in chunks of this many frames. Chunks never move once allocated
+  // so FrameData pointers stay valid while more data is parsed
+  const int32_t FRAME_CHUNK_SIZE = 256;
 
   typedef struct {
     // Every player update has its own rng seed because it might change in between players
@@ -58,8 +65,12 @@ namespace Slippi {
   typedef struct {
     int32_t frame;
     bool inputsFullyFetched = false;
-    std::unordered_map<uint8_t, PlayerFrameData> players;
-    std::unordered_map<uint8_t, PlayerFrameData> followers;
+
+    // Fixed slots per port, the has* arrays tell which of them have been filled in
+    std::array<bool, PLAYER_SLOT_COUNT> hasPlayer = {};
+    std::array<bool, PLAYER_SLOT_COUNT> hasFollower = {};
+    std::array<PlayerFrameData, PLAYER_SLOT_COUNT> players;
+    std::array<PlayerFrameData, PLAYER_SLOT_COUNT> followers;
   } FrameData;
 
   typedef struct {
@@ -81,7 +92,11 @@ namespace Slippi {
 
   typedef struct {
     std::array<uint8_t, 4> version;
-    std::unordered_map<int32_t, FrameData> frameData;
+
+    // Frame-indexed storage, frame N lives at index N - GAME_FIRST_FRAME
+    std::vector<std::unique_ptr<FrameData[]>> frameChunks;
+    int32_t frameSlotCount = 0;
+
     GameSettings settings;
     bool areSettingsLoaded = false;
 
@@ -91,18 +106,18 @@ namespace Slippi {
     uint8_t winCondition;
   } Game;
 
-  // TODO: This shouldn't be static. Doesn't matter too much atm because we always
-  // TODO: only read one file at a time
-  static std::unordered_map<uint8_t, uint32_t> asmEvents = {
-    { EVENT_GAME_INIT, 320 },
-    { EVENT_PRE_FRAME_UPDATE, 58 },
-    { EVENT_POST_FRAME_UPDATE, 33 },
-    { EVENT_GAME_END, 1 }
-  };
+  // Handlers return true once the end of the game data has been reached
+  typedef bool (*EventHandler)(Game* game, uint8_t* data, uint32_t maxSize);
+
+  typedef struct {
+    uint32_t payloadSize;
+    EventHandler handler;
+  } EventEntry;
 
   class SlippiGame
   {
   public:
+    ~SlippiGame();
     static SlippiGame* FromFile(std::string path);
     bool AreSettingsLoaded();
     bool DoesFrameExist(int32_t frame);
@@ -114,11 +129,31 @@ namespace Slippi {
   private:
     Game* game;
     std::ifstream* file;
-    std::vector<uint8_t> rawData;
     std::string path;
     std::ofstream log;
 
+    // Bytes of the file that have been pulled into rawData so far. Every poll only reads what
+    // was appended after this position
+    int64_t fileReadPos = 0;
+    bool areMessageSizesLoaded = false;
+
+    // Payload sizes as announced at the start of this file together with the handler for every
+    // event, indexed by command byte. Kept per game so several replays can be parsed on
+    // different threads at the same time
+    std::array<EventEntry, 256> eventTable = createEventTable();
+    static std::array<EventEntry, 256> createEventTable();
+
+    // Raw data that has been read but not parsed yet (usually a partially written event). The
+    // buffer is reused between polls so steady state parsing does not allocate
+    std::vector<uint8_t> rawData;
+
+    // Compressed replays are read into here first, complete blocks get decoded into rawData
+    bool isCompressed = false;
+    std::vector<uint8_t> compressedData;
+    ReplayDecoder decoder;
+
     bool isProcessingComplete = false;
     void processData();
+    bool readNewData();
   };
 }
@@ -549,7 +549,7 @@ public final class SettingsFragmentPresenter
     sl.add(new SingleChoiceSetting(SettingsFile.KEY_TEXCACHE_ACCURACY,
             Settings.SECTION_GFX_SETTINGS, R.string.texture_cache_accuracy,
             R.string.texture_cache_accuracy_description, R.array.textureCacheAccuracyEntries,
-            R.array.textureCacheAccuracyValues, 128, texCacheAccuracy));
+            R.array.textureCacheAccuracyValues, 0, texCacheAccuracy));
     sl.add(new CheckBoxSetting(SettingsFile.KEY_GPU_TEXTURE_DECODING, Settings.SECTION_GFX_SETTINGS,
             R.string.gpu_texture_decoding, R.string.gpu_texture_decoding_description, false,
             gpuTextureDecoding));
@@ -5,6 +5,7 @@
 #include "Common/Hash.h"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include "Common/BitUtils.h"
 #include "Common/CPUDetect.h"
@@ -13,11 +14,14 @@
 
 #ifdef _M_ARM_64
 #include <arm_acle.h>
+#include <arm_neon.h>
 #endif
 
 namespace Common
 {
 static u64 (*ptrHashFunction)(const u8* src, u32 len, u32 samples) = nullptr;
+static void (*ptrAccumulateStripes)(u64* acc, const u8* data, u32 stripes,
+                                    const u64* secret) = nullptr;
 
 // uint32_t
 // WARNING - may read one more byte!
@@ -501,14 +505,205 @@ static u64 GetMurmurHash3(const u8* src, u32 len, u32 samples)
 }
 #endif
 
+// Hash of all of the data, used when no samples are requested.
+//
+// Every 64 byte stripe of the data is mixed into 8 64-bit accumulators, one for every 8 bytes of
+// the stripe: the 8 bytes are xored with a secret, and the product of the two 32-bit halves of
+// that is added to the accumulator, together with the 8 bytes next to them. This is the scheme
+// of XXH3, and maps directly to SIMD multiplications of 32-bit values. The stripes of a block use
+// the secret at different offsets, so stripes that are swapped change the hash, and the
+// accumulators are scrambled after every block.
+//
+// All implementations of the stripe accumulation give the same hashes.
+constexpr u32 HASH_LANES = 8;
+constexpr u32 HASH_STRIPE_SIZE = HASH_LANES * sizeof(u64);
+constexpr u32 HASH_STRIPES_PER_BLOCK = 16;
+constexpr u32 HASH_SECRET_SIZE = HASH_LANES + HASH_STRIPES_PER_BLOCK;
+
+// splitmix64 of a fixed seed
+static constexpr std::array<u64, HASH_SECRET_SIZE> MakeHashSecret()
+{
+  std::array<u64, HASH_SECRET_SIZE> secret{};
+  u64 state = 0x2545f4914f6cdd1d;
+  for (u64& value : secret)
+  {
+    state += 0x9e3779b97f4a7c15;
+    u64 z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    value = z ^ (z >> 31);
+  }
+  return secret;
+}
+
+alignas(32) static constexpr std::array<u64, HASH_SECRET_SIZE> s_hash_secret = MakeHashSecret();
+
+static u64 AvalancheHash(u64 h)
+{
+  h ^= h >> 37;
+  h *= 0x165667919e3779f9;
+  h ^= h >> 32;
+  return h;
+}
+
+// Stripe i uses the secret from secret[i]
+static void AccumulateStripes_Generic(u64* acc, const u8* data, u32 stripes, const u64* secret)
+{
+  for (u32 stripe = 0; stripe < stripes; stripe++, data += HASH_STRIPE_SIZE, secret++)
+  {
+    u64 values[HASH_LANES];
+    std::memcpy(values, data, sizeof(values));
+    for (u32 i = 0; i < HASH_LANES; i++)
+    {
+      const u64 key = values[i] ^ secret[i];
+      acc[i] += (key & 0xffffffff) * (key >> 32) + values[i ^ 1];
+    }
+  }
+}
+
+#if defined(_M_X86)
+
+static void AccumulateStripes_SSE2(u64* acc, const u8* data, u32 stripes, const u64* secret)
+{
+  __m128i sums[HASH_LANES / 2];
+  for (u32 i = 0; i < HASH_LANES / 2; i++)
+    sums[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+
+  for (u32 stripe = 0; stripe < stripes; stripe++, data += HASH_STRIPE_SIZE, secret++)
+  {
+    for (u32 i = 0; i < HASH_LANES / 2; i++)
+    {
+      const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+      const __m128i key =
+          _mm_xor_si128(values, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+      const __m128i product =
+          _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+      const __m128i swapped = _mm_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2));
+      sums[i] = _mm_add_epi64(sums[i], _mm_add_epi64(product, swapped));
+    }
+  }
+
+  for (u32 i = 0; i < HASH_LANES / 2; i++)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, sums[i]);
+}
+
+FUNCTION_TARGET_AVX2
+static void AccumulateStripes_AVX2(u64* acc, const u8* data, u32 stripes, const u64* secret)
+{
+  __m256i sums[HASH_LANES / 4];
+  for (u32 i = 0; i < HASH_LANES / 4; i++)
+    sums[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + i);
+
+  for (u32 stripe = 0; stripe < stripes; stripe++, data += HASH_STRIPE_SIZE, secret++)
+  {
+    for (u32 i = 0; i < HASH_LANES / 4; i++)
+    {
+      const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + i);
+      const __m256i key = _mm256_xor_si256(
+          values, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+      const __m256i product =
+          _mm256_mul_epu32(key, _mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+      const __m256i swapped = _mm256_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2));
+      sums[i] = _mm256_add_epi64(sums[i], _mm256_add_epi64(product, swapped));
+    }
+  }
+
+  for (u32 i = 0; i < HASH_LANES / 4; i++)
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + i, sums[i]);
+}
+
+#elif defined(_M_ARM_64)
+
+static void AccumulateStripes_NEON(u64* acc, const u8* data, u32 stripes, const u64* secret)
+{
+  uint64x2_t sums[HASH_LANES / 2];
+  for (u32 i = 0; i < HASH_LANES / 2; i++)
+    sums[i] = vld1q_u64(acc + i * 2);
+
+  for (u32 stripe = 0; stripe < stripes; stripe++, data += HASH_STRIPE_SIZE, secret++)
+  {
+    for (u32 i = 0; i < HASH_LANES / 2; i++)
+    {
+      const uint64x2_t values = vreinterpretq_u64_u8(vld1q_u8(data + i * 16));
+      const uint64x2_t key = veorq_u64(values, vld1q_u64(secret + i * 2));
+      const uint64x2_t product = vmull_u32(vmovn_u64(key), vshrn_n_u64(key, 32));
+      const uint64x2_t swapped = vextq_u64(values, values, 1);
+      sums[i] = vaddq_u64(sums[i], vaddq_u64(product, swapped));
+    }
+  }
+
+  for (u32 i = 0; i < HASH_LANES / 2; i++)
+    vst1q_u64(acc + i * 2, sums[i]);
+}
+
+#endif
+
+static u64 GetFullHash(const u8* src, u32 len)
+{
+  u64 acc[HASH_LANES] = {0xc2b2ae3d27d4eb4f, 0x9e3779b185ebca87, 0x27d4eb2f165667c5,
+                         0x85ebca77c2b2ae63, 0x165667b19e3779f9, 0x61c8864e7a143579,
+                         0x9e3779b97f4a7c15, 0xd6e8feb86659fd93};
+  const u64* secret = s_hash_secret.data();
+
+  const u32 stripes = len / HASH_STRIPE_SIZE;
+  for (u32 first = 0; first < stripes; first += HASH_STRIPES_PER_BLOCK)
+  {
+    const u32 count = std::min(HASH_STRIPES_PER_BLOCK, stripes - first);
+    ptrAccumulateStripes(acc, src + first * HASH_STRIPE_SIZE, count, secret);
+    if (count < HASH_STRIPES_PER_BLOCK)
+      break;
+
+    for (u32 i = 0; i < HASH_LANES; i++)
+      acc[i] = (acc[i] ^ (acc[i] >> 47) ^ secret[HASH_STRIPES_PER_BLOCK + i]) * 0x9e3779b1;
+  }
+
+  // The rest is padded with zeros to a stripe of its own, the length tells them apart
+  const u32 rest = len % HASH_STRIPE_SIZE;
+  if (rest != 0)
+  {
+    u8 last_stripe[HASH_STRIPE_SIZE] = {};
+    std::memcpy(last_stripe, src + stripes * HASH_STRIPE_SIZE, rest);
+    ptrAccumulateStripes(acc, last_stripe, 1, secret + stripes % HASH_STRIPES_PER_BLOCK);
+  }
+
+  u64 hash = len * 0x9e3779b185ebca87;
+  for (u32 i = 0; i < HASH_LANES; i++)
+    hash = AvalancheHash(hash ^ acc[i]) + secret[HASH_STRIPES_PER_BLOCK + i];
+  return AvalancheHash(hash);
+}
+
 u64 GetHash64(const u8* src, u32 len, u32 samples)
 {
+  if (samples == 0)
+    return GetFullHash(src, len);
+
   return ptrHashFunction(src, len, samples);
 }
 
 // sets the hash function used for the texture cache
 void SetHash64Function()
 {
+#if defined(_M_X86)
+  if (cpu_info.bAVX2)
+  {
+    ptrAccumulateStripes = &AccumulateStripes_AVX2;
+  }
+  else if (cpu_info.bSSE2)
+  {
+    ptrAccumulateStripes = &AccumulateStripes_SSE2;
+  }
+  else
+#elif defined(_M_ARM_64)
+  if (cpu_info.bASIMD)
+  {
+    ptrAccumulateStripes = &AccumulateStripes_NEON;
+  }
+  else
+#endif
+  {
+    ptrAccumulateStripes = &AccumulateStripes_Generic;
+  }
+
 #if defined(_M_X86_64) || defined(_M_X86)
   if (cpu_info.bSSE4_2)  // sse crc32 version
   {
@@ -13,6 +13,8 @@ namespace Common
 u32 HashFletcher(const u8* data_u8, size_t length);  // FAST. Length & 1 == 0.
 u32 HashAdler32(const u8* data, size_t len);         // Fairly accurate, slightly slower
 u32 HashEctor(const u8* ptr, int length);            // JUNK. DO NOT USE FOR NEW THINGS
+// Hashes every len / 8 / samples-th 8 bytes, or all of the data with 0 samples
 u64 GetHash64(const u8* src, u32 len, u32 samples);
+// Picks the fastest implementations the CPU supports
 void SetHash64Function();
 }  // namespace Common
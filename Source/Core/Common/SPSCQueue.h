@@ -8,8 +8,10 @@
 // single producer, single consumer queue
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <utility>
 
 #include "Common/CommonTypes.h"
 
@@ -107,4 +109,65 @@ private:
   ElementPtr* m_read_ptr;
   std::atomic<u32> m_size;
 };
+
+// a bounded variant of the above backed by a fixed ring of N slots. Push never allocates, so it
+// is suitable for handing work off from the CPU thread. N must be a power of two.
+template <typename T, size_t N>
+class FixedSPSCQueue
+{
+  static_assert(N != 0 && (N & (N - 1)) == 0, "FixedSPSCQueue size must be a power of two");
+
+public:
+  static constexpr size_t Capacity() { return N; }
+
+  u32 Size() const
+  {
+    return static_cast<u32>(m_write_idx.load(std::memory_order_acquire) -
+                            m_read_idx.load(std::memory_order_acquire));
+  }
+
+  bool Empty() const { return Size() == 0; }
+  bool Full() const { return Size() == N; }
+
+  // producer side. returns false (and leaves t untouched) if the queue is full
+  template <typename Arg>
+  bool TryPush(Arg&& t)
+  {
+    const size_t write_idx = m_write_idx.load(std::memory_order_relaxed);
+    if (write_idx - m_read_idx.load(std::memory_order_acquire) == N)
+      return false;
+
+    m_storage[write_idx & (N - 1)] = std::forward<Arg>(t);
+    m_write_idx.store(write_idx + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  T& Front() { return m_storage[m_read_idx.load(std::memory_order_relaxed) & (N - 1)]; }
+  void Pop()
+  {
+    m_read_idx.store(m_read_idx.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  bool Pop(T& t)
+  {
+    const size_t read_idx = m_read_idx.load(std::memory_order_relaxed);
+    if (read_idx == m_write_idx.load(std::memory_order_acquire))
+      return false;
+
+    t = std::move(m_storage[read_idx & (N - 1)]);
+    m_read_idx.store(read_idx + 1, std::memory_order_release);
+    return true;
+  }
+
+  // not thread-safe
+  void Clear() { m_read_idx.store(m_write_idx.load()); }
+
+private:
+  std::array<T, N> m_storage{};
+
+  // keep the indices on separate cache lines so the two threads don't false share
+  alignas(64) std::atomic<size_t> m_write_idx{0};
+  alignas(64) std::atomic<size_t> m_read_idx{0};
+};
 }
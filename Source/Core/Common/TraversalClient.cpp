@@ -318,7 +318,7 @@ bool EnsureTraversalClient(const std::string& server, u16 server_port, u16 liste
     ENetAddress addr = {ENET_HOST_ANY, listen_port};
     ENetHost* host = enet_host_create(&addr,  // address
                                       50,     // peerCount
-                                      1,      // channelLimit
+                                      3,      // channelLimit
                                       0,      // incomingBandwidth
                                       0);     // outgoingBandwidth
     if (!host)
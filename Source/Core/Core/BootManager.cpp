@@ -42,6 +42,7 @@
 #include "Core/HW/WiimoteReal/WiimoteReal.h"
 #include "Core/Movie.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlaySessionReplay.h"
 #include "Core/PowerPC/PowerPC.h"
 
 #include "DiscIO/Enums.h"
@@ -341,9 +342,12 @@ bool BootCore(std::unique_ptr<BootParameters> boot)
     }
   }
 
-  if (NetPlay::IsNetPlayRunning())
+  // Session replays boot with the settings of the netplay host
+  const bool is_session_replay = NetPlay::IsSessionReplayActive();
+  if (NetPlay::IsNetPlayRunning() || is_session_replay)
   {
-    const NetPlay::NetSettings& netplay_settings = NetPlay::GetNetSettings();
+    const NetPlay::NetSettings& netplay_settings =
+        is_session_replay ? NetPlay::GetSessionReplayLog().settings : NetPlay::GetNetSettings();
     Config::AddLayer(ConfigLoaders::GenerateNetPlayConfigLoader(netplay_settings));
     StartUp.bCPUThread = netplay_settings.m_CPUthread;
     StartUp.bEnableCheats = netplay_settings.m_EnableCheats;
@@ -397,10 +401,9 @@ bool BootCore(std::unique_ptr<BootParameters> boot)
     if (netplay_settings.m_HostInputAuthority && !netplay_settings.m_IsHosting)
       config_cache.bSetEmulationSpeed = true;
   }
-  else
-  {
+
+  if (!NetPlay::IsNetPlayRunning())
     g_SRAM_netplay_initialized = false;
-  }
 
   const bool ntsc = DiscIO::IsNTSC(StartUp.m_region);
 
@@ -35,4 +35,30 @@ const ConfigInfo<bool> NETPLAY_USE_UPNP{{System::Main, "NetPlay", "UseUPNP"}, fa
 
 const ConfigInfo<bool> NETPLAY_ENABLE_QOS{{System::Main, "NetPlay", "EnableQoS"}, true};
 
+const ConfigInfo<bool> NETPLAY_ENABLE_ROLLBACK{{System::Main, "NetPlay", "EnableRollback"}, false};
+const ConfigInfo<int> NETPLAY_ROLLBACK_FRAMES{{System::Main, "NetPlay", "RollbackFrames"}, 7};
+
+const ConfigInfo<bool> NETPLAY_AUTO_BUFFER{{System::Main, "NetPlay", "AutoBuffer"}, false};
+const ConfigInfo<float> NETPLAY_AUTO_BUFFER_STALL_PROBABILITY{
+    {System::Main, "NetPlay", "AutoBufferStallProbability"}, 0.01f};
+
+// MEM1, one pass every 24 frames
+const ConfigInfo<std::string> NETPLAY_DESYNC_HASH_REGIONS{
+    {System::Main, "NetPlay", "DesyncHashRegions"}, "80000000-81800000"};
+const ConfigInfo<int> NETPLAY_DESYNC_HASH_BYTES_PER_FRAME{
+    {System::Main, "NetPlay", "DesyncHashBytesPerFrame"}, 0x100000};
+const ConfigInfo<bool> NETPLAY_WRITE_SESSION_LOG{{System::Main, "NetPlay", "WriteSessionLog"},
+                                                 false};
+const ConfigInfo<bool> NETPLAY_SHOW_TELEMETRY{{System::Main, "NetPlay", "ShowTelemetry"}, false};
+const ConfigInfo<bool> NETPLAY_WRITE_TELEMETRY{{System::Main, "NetPlay", "WriteTelemetry"}, false};
+
+// 0 doesn't accept spectators
+const ConfigInfo<u16> NETPLAY_SPECTATOR_PORT{{System::Main, "NetPlay", "SpectatorPort"}, 0};
+const ConfigInfo<int> NETPLAY_SPECTATOR_DELAY{{System::Main, "NetPlay", "SpectatorDelay"}, 5000};
+const ConfigInfo<int> NETPLAY_SPECTATOR_MAX_VIEWERS{
+    {System::Main, "NetPlay", "SpectatorMaxViewers"}, 8};
+// One minute
+const ConfigInfo<int> NETPLAY_SPECTATOR_KEYFRAME_INTERVAL{
+    {System::Main, "NetPlay", "SpectatorKeyframeInterval"}, 3600};
+
 }  // namespace Config
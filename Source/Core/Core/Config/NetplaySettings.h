@@ -31,4 +31,21 @@ extern const ConfigInfo<bool> NETPLAY_USE_UPNP;
 
 extern const ConfigInfo<bool> NETPLAY_ENABLE_QOS;
 
+extern const ConfigInfo<bool> NETPLAY_ENABLE_ROLLBACK;
+extern const ConfigInfo<int> NETPLAY_ROLLBACK_FRAMES;
+
+extern const ConfigInfo<bool> NETPLAY_AUTO_BUFFER;
+extern const ConfigInfo<float> NETPLAY_AUTO_BUFFER_STALL_PROBABILITY;
+
+extern const ConfigInfo<std::string> NETPLAY_DESYNC_HASH_REGIONS;
+extern const ConfigInfo<int> NETPLAY_DESYNC_HASH_BYTES_PER_FRAME;
+extern const ConfigInfo<bool> NETPLAY_WRITE_SESSION_LOG;
+extern const ConfigInfo<bool> NETPLAY_SHOW_TELEMETRY;
+extern const ConfigInfo<bool> NETPLAY_WRITE_TELEMETRY;
+
+extern const ConfigInfo<u16> NETPLAY_SPECTATOR_PORT;
+extern const ConfigInfo<int> NETPLAY_SPECTATOR_DELAY;
+extern const ConfigInfo<int> NETPLAY_SPECTATOR_MAX_VIEWERS;
+extern const ConfigInfo<int> NETPLAY_SPECTATOR_KEYFRAME_INTERVAL;
+
 }  // namespace Config
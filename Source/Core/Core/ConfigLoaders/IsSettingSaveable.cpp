@@ -48,6 +48,8 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
       Config::GFX_DUMP_TEXTURES.location,
       Config::GFX_HIRES_TEXTURES.location,
       Config::GFX_CACHE_HIRES_TEXTURES.location,
+      Config::GFX_HIRES_TEXTURE_LOADER_THREADS.location,
+      Config::GFX_HIRES_TEXTURE_MEMORY_BUDGET.location,
       Config::GFX_DUMP_EFB_TARGET.location,
       Config::GFX_DUMP_FRAMES_AS_IMAGES.location,
       Config::GFX_FREE_LOOK.location,
@@ -77,6 +79,7 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
       Config::GFX_SHADER_COMPILATION_MODE.location,
       Config::GFX_SHADER_COMPILER_THREADS.location,
       Config::GFX_SHADER_PRECOMPILER_THREADS.location,
+      Config::GFX_TEXTURE_DECODER_THREADS.location,
 
       Config::GFX_SW_ZCOMPLOC.location,
       Config::GFX_SW_ZFREEZE.location,
@@ -92,6 +92,7 @@ void SConfig::SaveSettings()
   SaveBluetoothPassthroughSettings(ini);
   SaveUSBPassthroughSettings(ini);
   SaveAutoUpdateSettings(ini);
+  SaveSlippiSettings(ini);
 
   ini.Save(File::GetUserPath(F_DOLPHINCONFIG_IDX));
 
@@ -352,6 +353,15 @@ void SConfig::SaveAutoUpdateSettings(IniFile& ini)
   section->Set("HashOverride", m_auto_update_hash_override);
 }
 
+void SConfig::SaveSlippiSettings(IniFile& ini)
+{
+  IniFile::Section* slippi = ini.GetOrCreateSection("Slippi");
+
+  slippi->Set("MirrorPort", m_slippiMirrorPort);
+  slippi->Set("CompressReplays", m_slippiCompressReplays);
+  slippi->Set("ProfileCommands", m_slippiProfileCommands);
+}
+
 void SConfig::LoadSettings()
 {
   Config::Load();
@@ -374,6 +384,7 @@ void SConfig::LoadSettings()
   LoadBluetoothPassthroughSettings(ini);
   LoadUSBPassthroughSettings(ini);
   LoadAutoUpdateSettings(ini);
+  LoadSlippiSettings(ini);
 }
 
 void SConfig::LoadGeneralSettings(IniFile& ini)
@@ -647,6 +658,16 @@ void SConfig::LoadAutoUpdateSettings(IniFile& ini)
   section->Get("HashOverride", &m_auto_update_hash_override, "");
 }
 
+void SConfig::LoadSlippiSettings(IniFile& ini)
+{
+  IniFile::Section* slippi = ini.GetOrCreateSection("Slippi");
+
+  // 0 disables the mirror server
+  slippi->Get("MirrorPort", &m_slippiMirrorPort, 0);
+  slippi->Get("CompressReplays", &m_slippiCompressReplays, false);
+  slippi->Get("ProfileCommands", &m_slippiProfileCommands, false);
+}
+
 void SConfig::ResetRunningGameMetadata()
 {
   SetRunningGameMetadata("00000000", "", 0, 0, Core::TitleDatabase::TitleType::Other);
@@ -181,6 +181,9 @@ struct SConfig
   DiscIO::Region m_region;
 
   std::string m_strSlippiInput;
+  int m_slippiMirrorPort;
+  bool m_slippiCompressReplays;
+  bool m_slippiProfileCommands;
 
   std::string m_strVideoBackend;
   std::string m_strGPUDeterminismMode;
@@ -351,6 +354,7 @@ private:
   void SaveBluetoothPassthroughSettings(IniFile& ini);
   void SaveUSBPassthroughSettings(IniFile& ini);
   void SaveAutoUpdateSettings(IniFile& ini);
+  void SaveSlippiSettings(IniFile& ini);
 
   void LoadGeneralSettings(IniFile& ini);
   void LoadInterfaceSettings(IniFile& ini);
@@ -366,6 +370,7 @@ private:
   void LoadBluetoothPassthroughSettings(IniFile& ini);
   void LoadUSBPassthroughSettings(IniFile& ini);
   void LoadAutoUpdateSettings(IniFile& ini);
+  void LoadSlippiSettings(IniFile& ini);
 
   void SetRunningGameMetadata(const std::string& game_id, const std::string& title_description, u64 title_id, u16 revision,
                               Core::TitleDatabase::TitleType type);
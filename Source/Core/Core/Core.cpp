@@ -57,6 +57,7 @@
 #include "Core/Movie.h"
 #include "Core/NetPlayClient.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlaySessionReplay.h"
 #include "Core/PatchEngine.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
@@ -124,6 +125,8 @@ void FrameUpdateOnCPUThread()
 {
   if (NetPlay::IsNetPlayRunning())
     NetPlay::NetPlayClient::SendTimeBase();
+  else if (NetPlay::IsSessionReplayActive())
+    NetPlay::SessionReplayFrameUpdate();
 }
 
 // Display messages and return values
@@ -317,6 +320,8 @@ static void CpuThread(const std::optional<std::string>& savestate_path, bool del
   MemoryWatcher::Init();
 #endif
 
+  NetPlay::RollbackController::Init();
+
   if (savestate_path)
   {
     ::State::LoadAs(*savestate_path);
@@ -882,7 +887,8 @@ void UpdateWantDeterminism(bool initial)
   // For now, this value is not itself configurable.  Instead, individual
   // settings that depend on it, such as GPU determinism mode. should have
   // override options for testing,
-  bool new_want_determinism = Movie::IsMovieActive() || NetPlay::IsNetPlayRunning();
+  bool new_want_determinism = Movie::IsMovieActive() || NetPlay::IsNetPlayRunning() ||
+                              NetPlay::IsSessionReplayActive();
   if (new_want_determinism != s_wants_determinism || initial)
   {
     NOTICE_LOG(COMMON, "Want determinism <- %s", new_want_determinism ? "true" : "false");
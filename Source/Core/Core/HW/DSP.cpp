@@ -38,6 +38,7 @@
 #include "Core/HW/Memmap.h"
 #include "Core/HW/ProcessorInterface.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/SnapshotRing.h"
 
 namespace DSP
 {
@@ -147,7 +148,7 @@ static const int DSP_MAIL_SLICE = 72;
 
 void DoState(PointerWrap& p)
 {
-  if (!s_ARAM.wii_mode)
+  if (!s_ARAM.wii_mode && !State::SkipMemoryInDoState())
     p.DoArray(s_ARAM.ptr, s_ARAM.size);
   p.DoPOD(s_dspState);
   p.DoPOD(s_audioDMA);
@@ -28,6 +28,7 @@
 #include "Core/HW/SystemTimers.h"
 #include "Core/Movie.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlaySessionReplay.h"
 
 #include "DiscIO/Enums.h"
 
@@ -408,6 +409,11 @@ u32 CEXIIPL::GetEmulatedTime(u32 epoch)
     // let's keep time moving forward, regardless of what it starts at
     ltime += CoreTiming::GetTicks() / SystemTimers::GetTicksPerSecond();
   }
+  else if (NetPlay::IsSessionReplayActive())
+  {
+    ltime = NetPlay::GetSessionReplayLog().initial_rtc;
+    ltime += CoreTiming::GetTicks() / SystemTimers::GetTicksPerSecond();
+  }
   else
   {
     ASSERT(!Core::WantsDeterminism());
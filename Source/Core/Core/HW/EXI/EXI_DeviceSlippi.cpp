@@ -5,75 +5,46 @@
 #include "Core/HW/EXI/EXI_DeviceSlippi.h"
 
 #include <SlippiGame.h>
+#include <algorithm>
 #include <array>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 
-#ifdef _WIN32
-#include <share.h>
-#endif
-
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
 #include "Common/Logging/Log.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
+#include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
 #include "Core/NetPlayClient.h"
 
 namespace ExpansionInterface
 {
-// Helper functions
-std::vector<u8> uint16ToVector(u16 num)
-{
-  u8 byte0 = num >> 8;
-  u8 byte1 = num & 0xFF;
-
-  return std::vector<u8>({byte0, byte1});
-}
-
-std::vector<u8> uint32ToVector(u32 num)
-{
-  u8 byte0 = num >> 24;
-  u8 byte1 = (num & 0xFF0000) >> 16;
-  u8 byte2 = (num & 0xFF00) >> 8;
-  u8 byte3 = num & 0xFF;
-
-  return std::vector<u8>({byte0, byte1, byte2, byte3});
-}
-
-std::vector<u8> int32ToVector(int32_t num)
+CEXISlippi::CEXISlippi()
 {
-  u8 byte0 = num >> 24;
-  u8 byte1 = (num & 0xFF0000) >> 16;
-  u8 byte2 = (num & 0xFF00) >> 8;
-  u8 byte3 = num & 0xFF;
-
-  return std::vector<u8>({byte0, byte1, byte2, byte3});
-}
+  INFO_LOG(EXPANSIONINTERFACE, "EXI SLIPPI Constructor called.");
 
-void appendHalfToBuffer(std::vector<u8>* buf, u16 word)
-{
-  auto halfVector = uint16ToVector(word);
-  buf->insert(buf->end(), halfVector.begin(), halfVector.end());
-}
+  // The actual size of this command will be sent in one byte after the command is received.
+  // The other receive command IDs and sizes will be received immediately following
+  registerCommand(CMD_RECEIVE_COMMANDS, 1, &CEXISlippi::handleReceiveData);
 
-void appendWordToBuffer(std::vector<u8>* buf, u32 word)
-{
-  auto wordVector = uint32ToVector(word);
-  buf->insert(buf->end(), wordVector.begin(), wordVector.end());
-}
+  // The following are all commands used to play back a replay and have fixed sizes
+  registerCommand(CMD_PREPARE_REPLAY, 0, &CEXISlippi::handlePrepareReplay);
+  registerCommand(CMD_READ_FRAME, 4, &CEXISlippi::handleReadFrame);
+  registerCommand(CMD_IS_STOCK_STEAL, 5, &CEXISlippi::handleIsStockSteal);
+  registerCommand(CMD_GET_LOCATION, 6, &CEXISlippi::handleReceiveData);
+  registerCommand(CMD_IS_FILE_READY, 0, &CEXISlippi::handleIsFileReady);
 
-CEXISlippi::CEXISlippi()
-{
-  INFO_LOG(EXPANSIONINTERFACE, "EXI SLIPPI Constructor called.");
+  replayComm = std::make_unique<SlippiReplayComm>();
 
-  replayComm = new SlippiReplayComm();
+  int mirrorPort = SConfig::GetInstance().m_slippiMirrorPort;
+  if (mirrorPort > 0 && mirrorPort <= 0xFFFF)
+    m_mirror = std::make_unique<SlippiMirrorServer>(static_cast<u16>(mirrorPort));
 
-  // Loggers will check 5 bytes, make sure we own that memory
-  m_read_queue.reserve(5);
+  m_profiler.SetEnabled(SConfig::GetInstance().m_slippiProfileCommands);
 }
 
 CEXISlippi::~CEXISlippi()
@@ -94,10 +65,56 @@ void CEXISlippi::configureCommands(u8* payload, u8 length)
     // Go through the receive commands payload and set up other commands
     u8 commandByte = payload[i];
     u32 commandPayloadSize = payload[i + 1] << 8 | payload[i + 2];
-    payloadSizes[commandByte] = commandPayloadSize;
+
+    // Anything without a dedicated handler is game data that gets recorded
+    CommandHandler handler = m_commands[commandByte].handler;
+    if (commandByte == CMD_RECEIVE_GAME_END)
+      handler = &CEXISlippi::handleGameEnd;
+    else if (!handler)
+      handler = &CEXISlippi::handleReceiveData;
+
+    registerCommand(commandByte, commandPayloadSize, handler);
   }
 }
 
+void CEXISlippi::registerCommand(u8 command, u32 payloadSize, CommandHandler handler)
+{
+  CommandEntry& entry = m_commands[command];
+  entry.is_known = true;
+  entry.payload_size = payloadSize;
+  entry.handler = handler;
+}
+
+void CEXISlippi::handleReceiveData(u8* command, u32 length)
+{
+  writeToFile(command, length, "");
+}
+
+void CEXISlippi::handleGameEnd(u8* command, u32 length)
+{
+  writeToFile(command, length, "close");
+}
+
+void CEXISlippi::handlePrepareReplay(u8* command, u32 length)
+{
+  prepareGameInfo();
+}
+
+void CEXISlippi::handleReadFrame(u8* command, u32 length)
+{
+  prepareFrameData(&command[1]);
+}
+
+void CEXISlippi::handleIsStockSteal(u8* command, u32 length)
+{
+  prepareIsStockSteal(&command[1]);
+}
+
+void CEXISlippi::handleIsFileReady(u8* command, u32 length)
+{
+  prepareIsFileReady();
+}
+
 void CEXISlippi::updateMetadataFields(u8* payload, u32 length)
 {
   if (length <= 0 || payload[0] != CMD_RECEIVE_POST_FRAME_UPDATE)
@@ -108,6 +125,7 @@ void CEXISlippi::updateMetadataFields(u8* payload, u32 length)
 
   // Keep track of last frame
   lastFrame = payload[1] << 24 | payload[2] << 16 | payload[3] << 8 | payload[4];
+  m_profiler.MarkFrame(lastFrame);
 
   // Keep track of character usage
   u8 playerIndex = payload[5];
@@ -144,110 +162,98 @@ std::unordered_map<u8, std::string> CEXISlippi::getNetplayNames()
   return names;
 }
 
-std::vector<u8> CEXISlippi::generateMetadata()
+void CEXISlippi::generateMetadata(
+    SlippiBufferWriter& metadata, time_t startTime, int32_t lastFrame,
+    const std::unordered_map<u8, std::unordered_map<u8, u32>>& characterUsage,
+    const std::unordered_map<u8, std::string>& playerNames)
 {
-  std::vector<u8> metadata({'U', 8, 'm', 'e', 't', 'a', 'd', 'a', 't', 'a', '{'});
-
-  // TODO: Abstract out UBJSON functions to make this cleaner
+  metadata.WriteBytes({'U', 8, 'm', 'e', 't', 'a', 'd', 'a', 't', 'a', '{'});
 
   // Add game start time
-  uint8_t dateTimeStrLength = sizeof "2011-10-08T07:07:09Z";
-  std::vector<char> dateTimeBuf(dateTimeStrLength);
-  strftime(&dateTimeBuf[0], dateTimeStrLength, "%FT%TZ", gmtime(&gameStartTime));
-  dateTimeBuf.pop_back();  // Removes the \0 from the back of string
-  metadata.insert(metadata.end(), {'U', 7, 's', 't', 'a', 'r', 't', 'A', 't', 'S', 'U',
-                                   (uint8_t)dateTimeBuf.size()});
-  metadata.insert(metadata.end(), dateTimeBuf.begin(), dateTimeBuf.end());
+  char dateTimeBuf[sizeof "2011-10-08T07:07:09Z"];
+  size_t dateTimeLen = strftime(dateTimeBuf, sizeof(dateTimeBuf), "%FT%TZ", gmtime(&startTime));
+  metadata.WriteBytes({'U', 7, 's', 't', 'a', 'r', 't', 'A', 't', 'S', 'U', (u8)dateTimeLen});
+  metadata.WriteBytes(dateTimeBuf, dateTimeLen);
 
   // Add game duration
-  std::vector<u8> lastFrameToWrite = int32ToVector(lastFrame);
-  metadata.insert(metadata.end(), {'U', 9, 'l', 'a', 's', 't', 'F', 'r', 'a', 'm', 'e', 'l'});
-  metadata.insert(metadata.end(), lastFrameToWrite.begin(), lastFrameToWrite.end());
+  metadata.WriteBytes({'U', 9, 'l', 'a', 's', 't', 'F', 'r', 'a', 'm', 'e', 'l'});
+  metadata.WriteS32(lastFrame);
 
   // Add players elements to metadata, one per player index
-  metadata.insert(metadata.end(), {'U', 7, 'p', 'l', 'a', 'y', 'e', 'r', 's', '{'});
-
-  auto playerNames = getNetplayNames();
+  metadata.WriteBytes({'U', 7, 'p', 'l', 'a', 'y', 'e', 'r', 's', '{'});
 
   for (auto it = characterUsage.begin(); it != characterUsage.end(); ++it)
   {
     auto playerIndex = it->first;
-    auto playerCharacterUsage = it->second;
+    auto& playerCharacterUsage = it->second;
 
-    metadata.push_back('U');
+    metadata.WriteU8('U');
     std::string playerIndexStr = std::to_string(playerIndex);
-    metadata.push_back((u8)playerIndexStr.length());
-    metadata.insert(metadata.end(), playerIndexStr.begin(), playerIndexStr.end());
-    metadata.push_back('{');
+    metadata.WriteU8((u8)playerIndexStr.length());
+    metadata.WriteBytes(playerIndexStr.data(), playerIndexStr.length());
+    metadata.WriteU8('{');
 
     // Add names element for this player
-    metadata.insert(metadata.end(), {'U', 5, 'n', 'a', 'm', 'e', 's', '{'});
+    metadata.WriteBytes({'U', 5, 'n', 'a', 'm', 'e', 's', '{'});
 
-    if (playerNames.count(playerIndex))
+    auto playerNameIt = playerNames.find(playerIndex);
+    if (playerNameIt != playerNames.end())
     {
-      auto playerName = playerNames[playerIndex];
+      auto& playerName = playerNameIt->second;
       // Add netplay element for this player name
-      metadata.insert(metadata.end(), {'U', 7, 'n', 'e', 't', 'p', 'l', 'a', 'y', 'S', 'U'});
-      metadata.push_back((u8)playerName.length());
-      metadata.insert(metadata.end(), playerName.begin(), playerName.end());
+      metadata.WriteBytes({'U', 7, 'n', 'e', 't', 'p', 'l', 'a', 'y', 'S', 'U'});
+      metadata.WriteU8((u8)playerName.length());
+      metadata.WriteBytes(playerName.data(), playerName.length());
     }
 
-    metadata.push_back('}');  // close names
+    metadata.WriteU8('}');  // close names
 
     // Add character element for this player
-    metadata.insert(metadata.end(),
-                    {'U', 10, 'c', 'h', 'a', 'r', 'a', 'c', 't', 'e', 'r', 's', '{'});
+    metadata.WriteBytes({'U', 10, 'c', 'h', 'a', 'r', 'a', 'c', 't', 'e', 'r', 's', '{'});
     for (auto it2 = playerCharacterUsage.begin(); it2 != playerCharacterUsage.end(); ++it2)
     {
-      metadata.push_back('U');
+      metadata.WriteU8('U');
       std::string internalCharIdStr = std::to_string(it2->first);
-      metadata.push_back((u8)internalCharIdStr.length());
-      metadata.insert(metadata.end(), internalCharIdStr.begin(), internalCharIdStr.end());
+      metadata.WriteU8((u8)internalCharIdStr.length());
+      metadata.WriteBytes(internalCharIdStr.data(), internalCharIdStr.length());
 
-      metadata.push_back('l');
-      std::vector<u8> frameCount = uint32ToVector(it2->second);
-      metadata.insert(metadata.end(), frameCount.begin(), frameCount.end());
+      metadata.WriteU8('l');
+      metadata.WriteU32(it2->second);
     }
-    metadata.push_back('}');  // close characters
+    metadata.WriteU8('}');  // close characters
 
-    metadata.push_back('}');  // close player
+    metadata.WriteU8('}');  // close player
   }
-  metadata.push_back('}');
+  metadata.WriteU8('}');
 
   // Indicate this was played on dolphin
-  metadata.insert(metadata.end(), {'U', 8,   'p', 'l', 'a', 'y', 'e', 'd', 'O', 'n',
-                                   'S', 'U', 7,   'd', 'o', 'l', 'p', 'h', 'i', 'n'});
+  metadata.WriteBytes({'U', 8, 'p', 'l', 'a', 'y', 'e', 'd', 'O', 'n', 'S', 'U', 7, 'd', 'o', 'l',
+                       'p', 'h', 'i', 'n'});
 
-  metadata.push_back('}');
-  return metadata;
+  metadata.WriteU8('}');
 }
 
 void CEXISlippi::writeToFile(u8* payload, u32 length, std::string fileOption)
 {
-  std::vector<u8> dataToWrite;
   if (fileOption == "create")
   {
     // If the game sends over option 1 that means a file should be created
     createNewFile();
 
-    // Start ubjson file and prepare the "raw" element that game
-    // data output will be dumped into. The size of the raw output will
-    // be initialized to 0 until all of the data has been received
-    std::vector<u8> headerBytes({'{', 'U', 3, 'r', 'a', 'w', '[', '$', 'U', '#', 'l', 0, 0, 0, 0});
-    dataToWrite.insert(dataToWrite.end(), headerBytes.begin(), headerBytes.end());
-
-    // Used to keep track of how many bytes have been written to the file
-    writtenByteCount = 0;
+    if (m_mirror)
+      m_mirror->StartGame();
 
     // Used to track character usage (sheik/zelda)
     characterUsage.clear();
 
+    m_profiler.Reset();
+
     // Reset lastFrame
     lastFrame = Slippi::GAME_FIRST_FRAME;
   }
 
   // If no file, do nothing
-  if (!m_file)
+  if (!m_writer.IsFileOpen())
   {
     return;
   }
@@ -255,60 +261,35 @@ void CEXISlippi::writeToFile(u8* payload, u32 length, std::string fileOption)
   // Update fields relevant to generating metadata at the end
   updateMetadataFields(payload, length);
 
-  // Add the payload to data to write
-  dataToWrite.insert(dataToWrite.end(), payload, payload + length);
-  writtenByteCount += length;
-
-  // If we are going to close the file, generate data to complete the UBJSON file
-  if (fileOption == "close")
-  {
-    // This option indicates we are done sending over body
-    std::vector<u8> closingBytes = generateMetadata();
-    closingBytes.push_back('}');
-    dataToWrite.insert(dataToWrite.end(), closingBytes.begin(), closingBytes.end());
-  }
-
-  // Write data to file
-  bool result = m_file.WriteBytes(&dataToWrite[0], dataToWrite.size());
-  if (!result)
-  {
-    ERROR_LOG(EXPANSIONINTERFACE, "Failed to write data to file.");
-  }
+  // Add the payload to data to write. This only copies into the writer's pending buffer, the
+  // buffer is handed to the writer thread at the end of the DMA
+  m_writer.Write(payload, length);
+  if (m_mirror)
+    m_mirror->Write(payload, length);
 
   // If file should be closed, close it
   if (fileOption == "close")
   {
-    // Write the number of bytes for the raw output
-    std::vector<u8> sizeBytes = uint32ToVector(writtenByteCount);
-    m_file.Seek(11, 0);
-    m_file.WriteBytes(&sizeBytes[0], sizeBytes.size());
-
-    // Close file
     closeFile();
-
-    WARN_LOG(EXPANSIONINTERFACE, "EXI_DeviceSlippi.cpp: Closing replay file.");
   }
 }
 
 void CEXISlippi::createNewFile()
 {
-  if (m_file)
+  if (m_writer.IsFileOpen())
   {
     // If there's already a file open, close that one
     closeFile();
   }
 
-  File::CreateDir("Slippi");
   std::string filepath = generateFileName();
 
   WARN_LOG(EXPANSIONINTERFACE, "EXI_DeviceSlippi.cpp: Creating new replay file %s",
            filepath.c_str());
 
-#ifdef _WIN32
-  m_file = File::IOFile(filepath, "wb", _SH_DENYWR);
-#else
-  m_file = File::IOFile(filepath, "wb");
-#endif
+  m_writer.ResetStats();
+  m_writer.OpenFile(filepath, SConfig::GetInstance().m_slippiCompressReplays);
+  m_current_file_path = filepath;
 }
 
 std::string CEXISlippi::generateFileName()
@@ -318,33 +299,54 @@ std::string CEXISlippi::generateFileName()
   std::vector<char> dateTimeBuf(dateTimeStrLength);
   strftime(&dateTimeBuf[0], dateTimeStrLength, "%Y%m%dT%H%M%S", localtime(&gameStartTime));
 
+  // Compressed replays get their own extension since tools that only know the UBJSON format
+  // can't read them
+  const char* extension = SConfig::GetInstance().m_slippiCompressReplays ? "slpz" : "slp";
+
   std::string str(&dateTimeBuf[0]);
-  return StringFromFormat("Slippi/Game_%s.slp", str.c_str());
+  return StringFromFormat("Slippi/Game_%s.%s", str.c_str(), extension);
 }
 
 void CEXISlippi::closeFile()
 {
-  if (!m_file)
+  if (!m_writer.IsFileOpen())
   {
     // If we have no file or payload is not game end, do nothing
     return;
   }
 
-  // If this is the end of the game end payload, reset the file so that we create a new one
-  m_file.Close();
-  m_file = nullptr;
+  // Everything the metadata needs is captured here, the UBJSON itself is built on the writer
+  // thread together with the raw size patch
+  auto finalize = [startTime = gameStartTime, lastFrame = lastFrame, usage = characterUsage,
+                   names = getNetplayNames()](SlippiBufferWriter& closingBytes, u32) {
+    generateMetadata(closingBytes, startTime, lastFrame, usage, names);
+    closingBytes.WriteU8('}');
+  };
+  m_writer.CloseFile(std::move(finalize));
+
+  if (m_profiler.IsEnabled())
+  {
+    std::string profilePath = m_current_file_path.substr(0, m_current_file_path.rfind('.'));
+    m_profiler.WriteCSV(profilePath + ".profile.csv");
+  }
+
+  SlippiReplayWriter::Stats stats = m_writer.GetStats();
+  WARN_LOG(EXPANSIONINTERFACE,
+           "EXI_DeviceSlippi.cpp: Closing replay file. Writer max queue depth: %u, max write "
+           "latency: %llu us",
+           stats.max_queue_depth, (unsigned long long)stats.max_write_latency_us);
 }
 
 void CEXISlippi::loadFile(std::string path)
 {
   // This doesn't like newline characters in the path, just FYI
-  m_current_game = Slippi::SlippiGame::FromFile((std::string)path);
+  m_current_game.reset(Slippi::SlippiGame::FromFile((std::string)path));
 }
 
 void CEXISlippi::prepareGameInfo()
 {
   // Since we are prepping new data, clear any existing data
-  m_read_queue.clear();
+  m_read_queue.Clear();
 
   if (!m_current_game)
   {
@@ -354,18 +356,18 @@ void CEXISlippi::prepareGameInfo()
 
   if (!m_current_game->AreSettingsLoaded())
   {
-    m_read_queue.push_back(0);
+    m_read_queue.WriteU8(0);
     return;
   }
 
   // Return success code
-  m_read_queue.push_back(1);
+  m_read_queue.WriteU8(1);
 
   Slippi::GameSettings* settings = m_current_game->GetSettings();
 
   // Build a word containing the stage and the presence of the characters
   u32 randomSeed = settings->randomSeed;
-  appendWordToBuffer(&m_read_queue, randomSeed);
+  m_read_queue.WriteU32(randomSeed);
 
   // This is kinda dumb but we need to handle the case where a player transforms
   // into sheik/zelda immediately. This info is not stored in the game info header
@@ -401,23 +403,23 @@ void CEXISlippi::prepareGameInfo()
   // Write entire header to game
   for (int i = 0; i < Slippi::GAME_INFO_HEADER_SIZE; i++)
   {
-    appendWordToBuffer(&m_read_queue, gameInfoHeader[i]);
+    m_read_queue.WriteU32(gameInfoHeader[i]);
   }
 
   // Write UCF toggles
-  std::array<uint32_t, Slippi::UCF_TOGGLE_SIZE> ucfToggles = settings->ucfToggles;
+  auto& ucfToggles = settings->ucfToggles;
   for (int i = 0; i < Slippi::UCF_TOGGLE_SIZE; i++)
   {
-    appendWordToBuffer(&m_read_queue, ucfToggles[i]);
+    m_read_queue.WriteU32(ucfToggles[i]);
   }
 
   // Write nametags
   for (int i = 0; i < 4; i++)
   {
-    auto player = settings->players[i];
+    auto& player = settings->players[i];
     for (int j = 0; j < Slippi::NAMETAG_SIZE; j++)
     {
-      appendHalfToBuffer(&m_read_queue, player.nametag[j]);
+      m_read_queue.WriteU16(player.nametag[j]);
     }
   }
 }
@@ -427,22 +429,22 @@ void CEXISlippi::prepareCharacterFrameData(int32_t frameIndex, u8 port, u8 isFol
   // Load the data from this frame into the read buffer
   Slippi::FrameData* frame = m_current_game->GetFrame(frameIndex);
 
-  std::unordered_map<uint8_t, Slippi::PlayerFrameData> source;
-  source = isFollower ? frame->followers : frame->players;
+  auto& source = isFollower ? frame->followers : frame->players;
+  auto& sourceExists = isFollower ? frame->hasFollower : frame->hasPlayer;
 
   // This must be updated if new data is added
   int characterDataLen = 49;
 
   // Check if player exists
-  if (!source.count(port))
+  if (!sourceExists[port])
   {
     // If player does not exist, insert blank section
-    m_read_queue.insert(m_read_queue.end(), characterDataLen, 0);
+    m_read_queue.Fill(0, characterDataLen);
     return;
   }
 
   // Get data for this player
-  Slippi::PlayerFrameData data = source[port];
+  Slippi::PlayerFrameData& data = source[port];
 
   // log << frameIndex << "\t" << port << "\t" << data.locationX << "\t" << data.locationY << "\t"
   // << data.animation << "\n";
@@ -453,19 +455,19 @@ void CEXISlippi::prepareCharacterFrameData(int32_t frameIndex, u8 port, u8 isFol
   //         data.percent);
 
   // Add all of the inputs in order
-  appendWordToBuffer(&m_read_queue, data.randomSeed);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.joystickX);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.joystickY);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.cstickX);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.cstickY);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.trigger);
-  appendWordToBuffer(&m_read_queue, data.buttons);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.locationX);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.locationY);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.facingDirection);
-  appendWordToBuffer(&m_read_queue, (u32)data.animation);
-  m_read_queue.push_back(data.joystickXRaw);
-  appendWordToBuffer(&m_read_queue, *(u32*)&data.percent);
+  m_read_queue.WriteU32(data.randomSeed);
+  m_read_queue.WriteFloat(data.joystickX);
+  m_read_queue.WriteFloat(data.joystickY);
+  m_read_queue.WriteFloat(data.cstickX);
+  m_read_queue.WriteFloat(data.cstickY);
+  m_read_queue.WriteFloat(data.trigger);
+  m_read_queue.WriteU32(data.buttons);
+  m_read_queue.WriteFloat(data.locationX);
+  m_read_queue.WriteFloat(data.locationY);
+  m_read_queue.WriteFloat(data.facingDirection);
+  m_read_queue.WriteU32((u32)data.animation);
+  m_read_queue.WriteU8(data.joystickXRaw);
+  m_read_queue.WriteFloat(data.percent);
   // NOTE TO DEV: If you add data here, make sure to increase the size above
 }
 
@@ -485,7 +487,7 @@ bool CEXISlippi::checkFrameFullyFetched(int32_t frameIndex)
 void CEXISlippi::prepareFrameData(u8* payload)
 {
   // Since we are prepping new data, clear any existing data
-  m_read_queue.clear();
+  m_read_queue.Clear();
 
   if (!m_current_game)
   {
@@ -498,14 +500,24 @@ void CEXISlippi::prepareFrameData(u8* payload)
 
   //INFO_LOG(EXPANSIONINTERFACE, "Frame %d has been requested!", frameIndex);
 
-  // If a new replay should be played, terminate the current game
-  auto isNewReplay = replayComm->isReplayReady();
+  // If a new replay should be played, terminate the current game. Replays queued up behind the
+  // current one in the same set don't count, those get played once this one is done
+  auto isNewReplay = replayComm->getGeneration() != replayComm->getLoadedGeneration();
   if (isNewReplay)
   {
-    m_read_queue.push_back(2);
+    m_read_queue.WriteU8(2);
     return;
   }
 
+  // Jump around in the current replay if the launcher asked for it
+  int32_t seekFrame;
+  if (replayComm->getSeekRequest(&seekFrame))
+  {
+    if (m_current_game->IsProcessingComplete())
+      seekFrame = std::min(seekFrame, m_current_game->GetFrameCount());
+    m_seek.Seek(seekFrame);
+  }
+
   auto isProcessingComplete = m_current_game->IsProcessingComplete();
 
   // Wait until frame exists in our data before reading it. We also wait until
@@ -524,8 +536,10 @@ void CEXISlippi::prepareFrameData(u8* payload)
     // to end the game as well.
     auto shouldTerminateGame = isProcessingComplete;
     requestResultCode = shouldTerminateGame ? 2 : 0;
+    if (shouldTerminateGame)
+      m_seek.CancelSeek();
 
-    m_read_queue.push_back(requestResultCode);
+    m_read_queue.WriteU8(requestResultCode);
     return;
   }
 
@@ -535,7 +549,10 @@ void CEXISlippi::prepareFrameData(u8* payload)
   //         latestFrame - currentFrame);
 
   // Return success code
-  m_read_queue.push_back(requestResultCode);
+  m_read_queue.WriteU8(requestResultCode);
+
+  m_seek.OnFramePlayed(frameIndex);
+  m_profiler.MarkFrame(frameIndex);
 
   // Add frame data for every character
   for (u8 port = 0; port < 4; port++)
@@ -548,7 +565,7 @@ void CEXISlippi::prepareFrameData(u8* payload)
 void CEXISlippi::prepareIsStockSteal(u8* payload)
 {
   // Since we are prepping new data, clear any existing data
-  m_read_queue.clear();
+  m_read_queue.Clear();
 
   if (!m_current_game)
   {
@@ -565,30 +582,36 @@ void CEXISlippi::prepareIsStockSteal(u8* payload)
   auto isFrameFound = m_current_game->DoesFrameExist(frameIndex);
   if (!isFrameFound)
   {
-    m_read_queue.push_back(0);
+    m_read_queue.WriteU8(0);
     return;
   }
 
   // Load the data from this frame into the read buffer
   Slippi::FrameData* frame = m_current_game->GetFrame(frameIndex);
-  auto players = frame->players;
 
-  u8 playerIsBack = players.count(playerIndex) ? 1 : 0;
-  m_read_queue.push_back(playerIsBack);
+  u8 playerIsBack =
+      playerIndex < Slippi::PLAYER_SLOT_COUNT && frame->hasPlayer[playerIndex] ? 1 : 0;
+  m_read_queue.WriteU8(playerIsBack);
 }
 
 void CEXISlippi::prepareIsFileReady()
 {
-  m_read_queue.clear();
+  m_read_queue.Clear();
 
   auto isNewReplayReady = replayComm->isReplayReady();
   if (!isNewReplayReady)
   {
-    m_read_queue.push_back(0);
+    m_read_queue.WriteU8(0);
     return;
   }
 
   auto replayFilePath = replayComm->getReplay();
+  if (replayFilePath.empty())
+  {
+    m_read_queue.WriteU8(0);
+    return;
+  }
+
   INFO_LOG(EXPANSIONINTERFACE, "EXI_DeviceSlippi.cpp: Attempting to load replay file %s",
            replayFilePath.c_str());
   loadFile(replayFilePath);
@@ -598,17 +621,21 @@ void CEXISlippi::prepareIsFileReady()
     // Do not start if replay file doesn't exist
     // TODO: maybe display error message?
     INFO_LOG(EXPANSIONINTERFACE, "EXI_DeviceSlippi.cpp: Replay file does not exist?");
-    m_read_queue.push_back(0);
+    m_read_queue.WriteU8(0);
     return;
   }
 
+  // Snapshots of the previous replay are useless now
+  m_seek.Reset();
+
   INFO_LOG(EXPANSIONINTERFACE, "EXI_DeviceSlippi.cpp: Replay file loaded successfully!?");
   // Start the playback!
-  m_read_queue.push_back(1);
+  m_read_queue.WriteU8(1);
 }
 
 void CEXISlippi::DMAWrite(u32 address, u32 size)
 {
+  u64 dmaStart = m_profiler.Start();
   u8* memPtr = Memory::GetPointer(address);
 
   u32 bufLoc = 0;
@@ -616,11 +643,13 @@ void CEXISlippi::DMAWrite(u32 address, u32 size)
   u8 byte = memPtr[0];
   if (byte == CMD_RECEIVE_COMMANDS)
   {
+    u64 commandStart = m_profiler.Start();
     time(&gameStartTime);  // Store game start time
     u8 receiveCommandsLen = memPtr[1];
     configureCommands(&memPtr[1], receiveCommandsLen);
     writeToFile(&memPtr[0], receiveCommandsLen + 1, "create");
     bufLoc += receiveCommandsLen + 1;
+    m_profiler.RecordCommand(byte, commandStart);
   }
 
   INFO_LOG(EXPANSIONINTERFACE,
@@ -631,57 +660,50 @@ void CEXISlippi::DMAWrite(u32 address, u32 size)
   while (bufLoc < size)
   {
     byte = memPtr[bufLoc];
-    if (!payloadSizes.count(byte))
+    const CommandEntry& command = m_commands[byte];
+    if (!command.is_known)
     {
       // This should never happen. Do something else if it does?
-      return;
-    }
-
-    u32 payloadLen = payloadSizes[byte];
-    switch (byte)
-    {
-    case CMD_RECEIVE_GAME_END:
-      writeToFile(&memPtr[bufLoc], payloadLen + 1, "close");
-      break;
-    case CMD_PREPARE_REPLAY:
-      // log.open("log.txt");
-      prepareGameInfo();
-      break;
-    case CMD_READ_FRAME:
-      prepareFrameData(&memPtr[1]);
-      break;
-    case CMD_IS_STOCK_STEAL:
-      prepareIsStockSteal(&memPtr[1]);
-      break;
-    case CMD_IS_FILE_READY:
-      prepareIsFileReady();
-      break;
-    default:
-      writeToFile(&memPtr[bufLoc], payloadLen + 1, "");
       break;
     }
 
-    bufLoc += payloadLen + 1;
+    u64 commandStart = m_profiler.Start();
+    (this->*command.handler)(&memPtr[bufLoc], command.payload_size + 1);
+    m_profiler.RecordCommand(byte, commandStart);
+
+    bufLoc += command.payload_size + 1;
   }
+
+  // Hand everything received in this DMA to the writer thread in one go
+  m_writer.Submit();
+  if (m_mirror)
+    m_mirror->Submit();
+
+  m_profiler.RecordDMAWrite(dmaStart);
 }
 
 void CEXISlippi::DMARead(u32 address, u32 size)
 {
-  if (m_read_queue.empty())
+  u64 dmaStart = m_profiler.Start();
+
+  if (m_read_queue.Empty())
   {
     INFO_LOG(EXPANSIONINTERFACE, "EXI SLIPPI DMARead: Empty");
     return;
   }
 
-  auto queueAddr = &m_read_queue[0];
+  auto queueAddr = m_read_queue.Data();
   INFO_LOG(EXPANSIONINTERFACE,
            "EXI SLIPPI DMARead: addr: 0x%08x size: %d, startResp: [%02x %02x %02x %02x %02x]",
            address, size, queueAddr[0], queueAddr[1], queueAddr[2], queueAddr[3], queueAddr[4]);
 
-  // Copy buffer data to memory
-  Memory::CopyToEmu(address, queueAddr, size);
+  // Copy buffer data to memory. The game may ask for more than we prepared, the buffer is
+  // sized for the largest response so anything past it is never read
+  Memory::CopyToEmu(address, queueAddr, std::min<u32>(size, (u32)m_read_queue.Capacity()));
+
+  m_read_queue.Clear();
 
-  m_read_queue.clear();
+  m_profiler.RecordDMARead(dmaStart);
 }
 
 bool CEXISlippi::IsPresent() const
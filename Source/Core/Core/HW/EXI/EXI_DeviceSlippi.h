@@ -5,15 +5,22 @@
 #pragma once
 
 #include <SlippiGame.h>
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <deque>
 #include <ctime>
+#include <memory>
 
 #include "Common/CommonTypes.h"
 #include "Core/HW/EXI/EXI_Device.h"
 #include "Common/File.h"
+#include "Core/Slippi/SlippiBufferWriter.h"
+#include "Core/Slippi/SlippiCommandProfiler.h"
+#include "Core/Slippi/SlippiMirrorServer.h"
 #include "Core/Slippi/SlippiReplayComm.h"
+#include "Core/Slippi/SlippiReplayWriter.h"
+#include "Core/Slippi/SlippiSeekController.h"
 
 namespace ExpansionInterface
 {
@@ -44,25 +51,41 @@ private:
     CMD_IS_STOCK_STEAL = 0x89,
   };
 
-  std::unordered_map<u8, u32> payloadSizes = {
-      // The actual size of this command will be sent in one byte
-      // after the command is received. The other receive command IDs
-      // and sizes will be received immediately following
-      {CMD_RECEIVE_COMMANDS, 1},
+  // Handlers get the command byte followed by its payload, length includes the command byte
+  using CommandHandler = void (CEXISlippi::*)(u8* command, u32 length);
 
-      // The following are all commands used to play back a replay and
-      // have fixed sizes
-      {CMD_PREPARE_REPLAY, 0},
-      {CMD_READ_FRAME, 4},
-      {CMD_IS_STOCK_STEAL, 5},
-      {CMD_GET_LOCATION, 6},
-      {CMD_IS_FILE_READY, 0}};
+  struct CommandEntry
+  {
+    bool is_known = false;
+    u32 payload_size = 0;
+    CommandHandler handler = nullptr;
+  };
+
+  // Indexed by command byte so that dispatching a command is a single array lookup. Playback
+  // commands have fixed sizes, the sizes of the commands that get recorded are sent by the game
+  // in CMD_RECEIVE_COMMANDS at the start of every game
+  std::array<CommandEntry, 256> m_commands;
+
+  void registerCommand(u8 command, u32 payloadSize, CommandHandler handler);
+  void handleReceiveData(u8* command, u32 length);
+  void handleGameEnd(u8* command, u32 length);
+  void handlePrepareReplay(u8* command, u32 length);
+  void handleReadFrame(u8* command, u32 length);
+  void handleIsStockSteal(u8* command, u32 length);
+  void handleIsFileReady(u8* command, u32 length);
 
   // Communication with Launcher
-  SlippiReplayComm* replayComm;
+  std::unique_ptr<SlippiReplayComm> replayComm;
 
-  // .slp File creation stuff
-  u32 writtenByteCount = 0;
+  // .slp File creation stuff, the actual disk IO happens on the writer thread
+  SlippiReplayWriter m_writer;
+
+  // Optional live stream of the same data to local clients, null when disabled
+  std::unique_ptr<SlippiMirrorServer> m_mirror;
+
+  // Per command timing, written next to the replay at the end of every game when enabled
+  SlippiCommandProfiler m_profiler;
+  std::string m_current_file_path;
 
   // vars for metadata generation
   time_t gameStartTime;
@@ -72,7 +95,10 @@ private:
   void updateMetadataFields(u8* payload, u32 length);
   void configureCommands(u8* payload, u8 length);
   void writeToFile(u8* payload, u32 length, std::string fileOption);
-  std::vector<u8> generateMetadata();
+  static void
+  generateMetadata(SlippiBufferWriter& metadata, time_t startTime, int32_t lastFrame,
+                   const std::unordered_map<u8, std::unordered_map<u8, u32>>& characterUsage,
+                   const std::unordered_map<u8, std::string>& playerNames);
   void createNewFile();
   void closeFile();
   std::string generateFileName();
@@ -80,9 +106,6 @@ private:
 
   // std::ofstream log;
 
-  File::IOFile m_file;
-  std::vector<u8> m_payload;
-
   // replay playback stuff
   void loadFile(std::string path);
   void prepareGameInfo();
@@ -93,8 +116,12 @@ private:
 
   std::unordered_map<u8, std::string> getNetplayNames();
 
-  std::vector<u8> m_read_queue;
-  Slippi::SlippiGame* m_current_game = nullptr;
+  // Big enough for the largest response (game info), allocated once so that building the
+  // per frame responses never allocates
+  static const size_t READ_QUEUE_SIZE = 1024;
+  SlippiBufferWriter m_read_queue{READ_QUEUE_SIZE};
+  std::unique_ptr<Slippi::SlippiGame> m_current_game;
+  SlippiSeekController m_seek;
 
   void TransferByte(u8& byte) override;
 };
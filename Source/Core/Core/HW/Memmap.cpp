@@ -31,6 +31,7 @@
 #include "Core/HW/WII_IPC.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/SnapshotRing.h"
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/PixelEngine.h"
 
@@ -113,6 +114,16 @@ struct LogicalMemoryView
 {
   void* mapped_pointer;
   u32 mapped_size;
+  u32 shm_position;
+  u8* region;
+  u32 region_offset;
+
+  bool operator==(const LogicalMemoryView& other) const
+  {
+    return mapped_pointer == other.mapped_pointer && mapped_size == other.mapped_size &&
+           shm_position == other.shm_position && region == other.region &&
+           region_offset == other.region_offset;
+  }
 };
 
 // Dolphin allocates memory to represent four regions:
@@ -163,6 +174,7 @@ static PhysicalMemoryRegion physical_regions[] = {
 };
 
 static std::vector<LogicalMemoryView> logical_mapped_entries;
+static u32 s_views_version = 0;
 
 void Init()
 {
@@ -191,6 +203,7 @@ void Init()
   }
   g_arena.GrabSHMSegment(mem_size);
   physical_base = Common::MemArena::FindMemoryBase();
+  s_views_version++;
 
   for (PhysicalMemoryRegion& region : physical_regions)
   {
@@ -224,11 +237,7 @@ void Init()
 
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
 {
-  for (auto& entry : logical_mapped_entries)
-  {
-    g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
-  }
-  logical_mapped_entries.clear();
+  std::vector<LogicalMemoryView> entries;
   for (u32 i = 0; i < dbat_table.size(); ++i)
   {
     if (dbat_table[i] & PowerPC::BAT_PHYSICAL_BIT)
@@ -249,30 +258,80 @@ void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
           u32 position = physical_region.shm_position + intersection_start - mapping_address;
           u8* base = logical_base + logical_address + intersection_start - translated_address;
           u32 mapped_size = intersection_end - intersection_start;
-
-          void* mapped_pointer = g_arena.CreateView(position, mapped_size, base);
-          if (!mapped_pointer)
-          {
-            PanicAlert("MemoryMap_Setup: Failed finding a memory base.");
-            exit(0);
-          }
-          logical_mapped_entries.push_back({mapped_pointer, mapped_size});
+          entries.push_back({base, mapped_size, position, *physical_region.out_pointer,
+                             intersection_start - mapping_address});
         }
       }
     }
   }
+
+  // Loading a state always sets up the BATs again, usually with the same mapping. Keeping the
+  // views avoids remapping them and lets snapshot rings keep their write protection
+  if (entries == logical_mapped_entries)
+    return;
+
+  s_views_version++;
+  for (auto& entry : logical_mapped_entries)
+  {
+    g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
+  }
+  logical_mapped_entries.clear();
+  for (LogicalMemoryView& entry : entries)
+  {
+    void* mapped_pointer = g_arena.CreateView(entry.shm_position, entry.mapped_size,
+                                              entry.mapped_pointer);
+    if (!mapped_pointer)
+    {
+      PanicAlert("MemoryMap_Setup: Failed finding a memory base.");
+      exit(0);
+    }
+    entry.mapped_pointer = mapped_pointer;
+    logical_mapped_entries.push_back(entry);
+  }
+}
+
+std::vector<MemoryView> GetMemoryViews()
+{
+  std::vector<MemoryView> views;
+  for (const PhysicalMemoryRegion& region : physical_regions)
+  {
+    if (*region.out_pointer)
+      views.push_back({*region.out_pointer, 0, *region.out_pointer, region.size});
+  }
+
+  for (const LogicalMemoryView& entry : logical_mapped_entries)
+  {
+    if (entry.region)
+    {
+      views.push_back({entry.region, entry.region_offset,
+                       static_cast<u8*>(entry.mapped_pointer), entry.mapped_size});
+    }
+  }
+
+  return views;
+}
+
+u32 GetMemoryViewsVersion()
+{
+  return s_views_version;
 }
 
 void DoState(PointerWrap& p)
 {
+  // Snapshot rings keep their own copy of the memory regions
+  const bool skip_memory = State::SkipMemoryInDoState();
+
   bool wii = SConfig::GetInstance().bWii;
-  p.DoArray(m_pRAM, RAM_SIZE);
-  p.DoArray(m_pL1Cache, L1_CACHE_SIZE);
+  if (!skip_memory)
+  {
+    p.DoArray(m_pRAM, RAM_SIZE);
+    p.DoArray(m_pL1Cache, L1_CACHE_SIZE);
+  }
   p.DoMarker("Memory RAM");
-  if (m_pFakeVMEM)
+  if (m_pFakeVMEM && !skip_memory)
     p.DoArray(m_pFakeVMEM, FAKEVMEM_SIZE);
   p.DoMarker("Memory FakeVMEM");
-  if (wii)
+  if (wii && !skip_memory)
     p.DoArray(m_pEXRAM, EXRAM_SIZE);
   p.DoMarker("Memory EXRAM");
 }
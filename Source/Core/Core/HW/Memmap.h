@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
@@ -66,6 +67,20 @@ void DoState(PointerWrap& p);
 
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table);
 
+// A host mapping of (part of) one of the memory regions above. Each region is mapped once at its
+// physical address, which is also the pointer the region is known by, and parts of it can be
+// mapped again at logical addresses depending on the BATs.
+struct MemoryView
+{
+  u8* region;
+  u32 region_offset;
+  u8* pointer;
+  u32 size;
+};
+std::vector<MemoryView> GetMemoryViews();
+// Changes whenever views are created, even if they end up at the same addresses as before
+u32 GetMemoryViewsVersion();
+
 void Clear();
 
 // Routines to access physically addressed memory, designed for use by
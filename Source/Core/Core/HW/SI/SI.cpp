@@ -20,6 +20,7 @@
 #include "Core/HW/SystemTimers.h"
 #include "Core/Movie.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlaySessionReplay.h"
 #include "Core/NetPlayClient.h"
 #include "Core/Config/MainSettings.h"
 #include "Core/HW/VideoInterface.h"
@@ -430,6 +431,11 @@ void Init()
         AddDevice(SIDEVICE_NONE, i);
       }
     }
+    else if (NetPlay::IsSessionReplayActive())
+    {
+      const bool is_used = NetPlay::GetSessionReplayLog().pad_map[i] > 0;
+      AddDevice(is_used ? SIDEVICE_GC_CONTROLLER : SIDEVICE_NONE, i);
+    }
     else if (!NetPlay::IsNetPlayRunning())
     {
       AddDevice(SConfig::GetInstance().m_SIDevice[i], i);
@@ -18,6 +18,7 @@
 #include "Core/HW/SystemTimers.h"
 #include "Core/Movie.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlaySessionReplay.h"
 #include "InputCommon/GCPadStatus.h"
 
 namespace SerialInterface
@@ -134,6 +135,10 @@ void CSIDevice_GCController::HandleMoviePadStatus(GCPadStatus* pad_status)
   if (NetPlay_GetInput(m_device_number, pad_status))
   {
   }
+  else if (NetPlay::IsSessionReplayActive())
+  {
+    NetPlay::SessionReplayGetInput(m_device_number, pad_status);
+  }
   else if (Movie::IsPlayingInput())
   {
     Movie::PlayController(pad_status, m_device_number);
@@ -47,6 +47,7 @@ IPC_HLE_PERIOD: For the Wii Remote this is the call schedule:
 
 #include <cmath>
 #include <cstdlib>
+#include <optional>
 
 #include "Common/Atomic.h"
 #include "Common/CommonTypes.h"
@@ -91,6 +92,12 @@ static int s_ipc_hle_period;
 // Custom RTC
 static s64 s_localtime_rtc_offset = 0;
 
+// The time the pending throttle event was scheduled with, see SuspendThrottle
+static u32 s_throttle_time = 0;
+static bool s_is_throttle_suspended = false;
+static u32 s_throttle_suspended_time = 0;
+static std::optional<u32> s_throttle_resume_time;
+
 u32 GetTicksPerSecond()
 {
   return s_cpu_core_clock;
@@ -202,9 +209,16 @@ static void ThrottleCallback(u64 last_time, s64 cyclesLate)
 
   u32 time = Common::Timer::GetTimeMs();
 
+  if (s_throttle_resume_time)
+  {
+    last_time = *s_throttle_resume_time;
+    s_throttle_resume_time.reset();
+  }
+
   int diff = (u32)last_time - time;
   const SConfig& config = SConfig::GetInstance();
-  bool frame_limiter = config.m_EmulationSpeed > 0.0f && !Core::GetIsThrottlerTempDisabled();
+  bool frame_limiter = config.m_EmulationSpeed > 0.0f && !Core::GetIsThrottlerTempDisabled() &&
+                       !s_is_throttle_suspended;
   u32 next_event = GetTicksPerSecond() / 1000;
   if (frame_limiter)
   {
@@ -220,7 +234,26 @@ static void ThrottleCallback(u64 last_time, s64 cyclesLate)
     else if (diff > 0)
       Common::SleepCurrentThread(diff);
   }
-  CoreTiming::ScheduleEvent(next_event - cyclesLate, et_Throttle, last_time + 1);
+  s_throttle_time = static_cast<u32>(last_time + 1);
+  CoreTiming::ScheduleEvent(next_event - cyclesLate, et_Throttle, s_throttle_time);
+}
+
+void SuspendThrottle()
+{
+  if (s_is_throttle_suspended)
+    return;
+
+  s_is_throttle_suspended = true;
+  s_throttle_suspended_time = s_throttle_time;
+}
+
+void ResumeThrottle()
+{
+  if (!s_is_throttle_suspended)
+    return;
+
+  s_is_throttle_suspended = false;
+  s_throttle_resume_time = s_throttle_suspended_time;
 }
 
 // split from Init to break a circular dependency between VideoInterface::Init and
@@ -282,7 +315,10 @@ void Init()
   CoreTiming::ScheduleEvent(VideoInterface::GetTicksPerHalfLine(), et_VI);
   CoreTiming::ScheduleEvent(0, et_DSP);
   CoreTiming::ScheduleEvent(s_audio_dma_period, et_AudioDMA);
-  CoreTiming::ScheduleEvent(0, et_Throttle, Common::Timer::GetTimeMs());
+  s_throttle_time = Common::Timer::GetTimeMs();
+  s_is_throttle_suspended = false;
+  s_throttle_resume_time.reset();
+  CoreTiming::ScheduleEvent(0, et_Throttle, s_throttle_time);
 
   CoreTiming::ScheduleEvent(VideoInterface::GetTicksPerField(), et_PatchEngine);
 
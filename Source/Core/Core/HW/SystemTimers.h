@@ -45,6 +45,14 @@ void Init();
 void Shutdown();
 void ChangePPCClock(Mode mode);
 
+// For netplay rollback, which restores an older state and runs the frames since then again, and
+// for fast-forwarding through a replay.
+// While suspended the throttle doesn't wait, and once resumed at the same emulated time as it was
+// suspended at, it continues from the real time it had reached back then instead of the one
+// restored with the state. Only called from the CPU thread.
+void SuspendThrottle();
+void ResumeThrottle();
+
 // Notify timing system that somebody wrote to the decrementer
 void DecrementerSet();
 u32 GetFakeDecrementer();
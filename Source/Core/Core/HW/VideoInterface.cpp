@@ -79,6 +79,9 @@ static u32 s_odd_field_first_hl;   // index first halfline of the odd field
 static u32 s_even_field_last_hl;   // index last halfline of the even field
 static u32 s_odd_field_last_hl;    // index last halfline of the odd field
 
+// Not part of the state, fields that are emulated again after a netplay rollback stay hidden
+static bool s_is_output_suppressed = false;
+
 void DoState(PointerWrap& p)
 {
   p.DoPOD(m_VerticalTimingRegister);
@@ -200,9 +203,15 @@ void Preset(bool _bNTSC)
 
 void Init()
 {
+  s_is_output_suppressed = false;
   Preset(true);
 }
 
+void SetOutputSuppressed(bool suppressed)
+{
+  s_is_output_suppressed = suppressed;
+}
+
 void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 {
   struct MappedVar
@@ -716,7 +725,7 @@ static void BeginField(FieldType field, u64 ticks)
   // frame is scanning out.
   // To correctly handle that case we would need to collate all changes
   // to VI during scanout and delay outputting the frame till then.
-  if (xfbAddr)
+  if (xfbAddr && !s_is_output_suppressed)
     g_video_backend->Video_BeginField(xfbAddr, fbWidth, fbStride, fbHeight, ticks);
 }
 
@@ -357,6 +357,9 @@ u32 GetXFBAddressBottom();
 // Update and draw framebuffer
 void Update(u64 ticks);
 
+// Keeps emulating fields without presenting them. Only called from the CPU thread.
+void SetOutputSuppressed(bool suppressed);
+
 // UpdateInterrupts: check if we have to generate a new VI Interrupt
 void UpdateInterrupts();
 
@@ -16,6 +16,7 @@
 
 #include "Core/MachineContext.h"
 #include "Core/PowerPC/JitInterface.h"
+#include "Core/SnapshotRing.h"
 
 #ifdef __FreeBSD__
 #include <signal.h>
@@ -44,7 +45,10 @@ static LONG NTAPI Handler(PEXCEPTION_POINTERS pPtrs)
     uintptr_t badAddress = (uintptr_t)pPtrs->ExceptionRecord->ExceptionInformation[1];
     CONTEXT* ctx = pPtrs->ContextRecord;
 
-    if (JitInterface::HandleFault(badAddress, ctx))
+    // Writes to pages write protected by a snapshot ring just have to be retried
+    const bool is_write = accessType == 1;
+    if ((is_write && State::HandleSnapshotWriteFault(badAddress)) ||
+        JitInterface::HandleFault(badAddress, ctx))
     {
       return (DWORD)EXCEPTION_CONTINUE_EXECUTION;
     }
@@ -257,6 +261,10 @@ static void sigsegv_handler(int sig, siginfo_t* info, void* raw_context)
 #else
   mcontext_t* ctx = &context->uc_mcontext;
 #endif
+  // Writes to pages write protected by a snapshot ring just have to be retried
+  if (sicode == SEGV_ACCERR && State::HandleSnapshotWriteFault(bad_address))
+    return;
+
   // assume it's not a write
   if (!JitInterface::HandleFault(bad_address,
 #ifdef __APPLE__
@@ -0,0 +1,171 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlayAutoBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Common/Timer.h"
+
+namespace NetPlay
+{
+static constexpr u64 UPDATE_INTERVAL_US = 1000000;
+// Longer gaps between polls are loading screens or stalls, not the usual poll rate
+static constexpr u64 MAX_POLL_PERIOD_US = 100000;
+static constexpr size_t MIN_ARRIVAL_SAMPLES = 60;
+static constexpr size_t MAX_PING_SAMPLES = 30;
+static constexpr u32 SHRINK_UPDATES = 5;
+
+// Value that the given fraction of the samples doesn't exceed
+template <typename Container>
+static double GetQuantile(const Container& samples, double fraction)
+{
+  std::vector<double> sorted(samples.begin(), samples.end());
+  const size_t index = std::min(sorted.size() - 1,
+                                static_cast<size_t>(std::ceil(fraction * (sorted.size() - 1))));
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+
+void AutoBufferController::Reset(bool enabled, double stall_probability)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_is_enabled = enabled;
+  m_stall_probability = std::clamp(stall_probability, 0.0001, 0.5);
+
+  for (auto& arrivals : m_arrivals)
+    arrivals.clear();
+  m_last_update_us = 0;
+  m_updates_below = 0;
+
+  m_polls.store(0);
+  m_last_poll_us.store(0);
+}
+
+void AutoBufferController::OnPoll()
+{
+  if (!m_is_enabled)
+    return;
+
+  const u64 now = Common::Timer::GetTimeUs();
+  const u64 last = m_last_poll_us.load(std::memory_order_relaxed);
+  if (last != 0 && now - last < MAX_POLL_PERIOD_US)
+  {
+    const u32 period = m_poll_period_us.load(std::memory_order_relaxed);
+    m_poll_period_us.store((period * 31 + static_cast<u32>(now - last)) / 32,
+                           std::memory_order_relaxed);
+  }
+
+  m_last_poll_us.store(now, std::memory_order_release);
+  m_polls.fetch_add(1, std::memory_order_release);
+}
+
+void AutoBufferController::OnRemoteInput(int pad, u32 index)
+{
+  if (!m_is_enabled)
+    return;
+
+  // Position of the arrival between the local polls, e.g. 10.5 halfway between the 10th and 11th
+  const u64 now = Common::Timer::GetTimeUs();
+  const u64 polls = m_polls.load(std::memory_order_acquire);
+  const u64 last_poll = m_last_poll_us.load(std::memory_order_acquire);
+  double position = static_cast<double>(polls);
+  if (last_poll != 0 && now > last_poll)
+  {
+    const double period = m_poll_period_us.load(std::memory_order_relaxed);
+    position += std::min(1.0, (now - last_poll) / period);
+  }
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  std::deque<double>& arrivals = m_arrivals.at(pad);
+  arrivals.push_back(position - index);
+  if (arrivals.size() > MAX_SAMPLES)
+    arrivals.pop_front();
+}
+
+void AutoBufferController::OnPing(PlayerId pid, u32 ping_ms)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  std::deque<u32>& pings = m_pings[pid];
+  pings.push_back(ping_ms);
+  if (pings.size() > MAX_PING_SAMPLES)
+    pings.pop_front();
+}
+
+double AutoBufferController::GetMedianPing(PlayerId pid) const
+{
+  const auto it = m_pings.find(pid);
+  if (it == m_pings.end() || it->second.empty())
+    return 0.0;
+
+  return GetQuantile(it->second, 0.5);
+}
+
+double AutoBufferController::GetJitterPolls() const
+{
+  double jitter = 0.0;
+  for (const std::deque<double>& arrivals : m_arrivals)
+  {
+    if (arrivals.size() < MIN_ARRIVAL_SAMPLES)
+      continue;
+
+    jitter = std::max(jitter, GetQuantile(arrivals, 1.0 - m_stall_probability) -
+                                  GetQuantile(arrivals, 0.5));
+  }
+
+  return jitter;
+}
+
+std::optional<u32> AutoBufferController::Update(u32 current_inputs, u32 minimum_inputs,
+                                                PlayerId local_pid,
+                                                const std::vector<PlayerId>& remote_pids,
+                                                bool host_input_authority)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+
+  const u64 now = Common::Timer::GetTimeUs();
+  if (!m_is_enabled || remote_pids.empty() || now - m_last_update_us < UPDATE_INTERVAL_US)
+    return {};
+
+  const bool has_samples =
+      std::any_of(m_arrivals.begin(), m_arrivals.end(), [](const std::deque<double>& arrivals) {
+        return arrivals.size() >= MIN_ARRIVAL_SAMPLES;
+      });
+  if (!has_samples)
+    return {};
+
+  m_last_update_us = now;
+
+  double needed = GetJitterPolls();
+  if (!host_input_authority)
+  {
+    const double local_ping = GetMedianPing(local_pid);
+    double latency_ms = 0.0;
+    for (PlayerId pid : remote_pids)
+      latency_ms = std::max(latency_ms, (local_ping + GetMedianPing(pid)) / 2.0);
+
+    needed += latency_ms * 1000.0 / m_poll_period_us.load(std::memory_order_relaxed);
+  }
+
+  const u32 target = std::max({1u, minimum_inputs, static_cast<u32>(std::ceil(needed))});
+  if (target > current_inputs)
+  {
+    // Stalls are worse than a bit of extra delay, so large gaps close quickly
+    m_updates_below = 0;
+    return current_inputs + std::max(1u, (target - current_inputs) / 2);
+  }
+
+  if (target < current_inputs && ++m_updates_below >= SHRINK_UPDATES)
+  {
+    m_updates_below = 0;
+    return current_inputs - 1;
+  }
+
+  if (target == current_inputs)
+    m_updates_below = 0;
+
+  return {};
+}
+}  // namespace NetPlay
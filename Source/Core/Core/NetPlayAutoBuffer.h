@@ -0,0 +1,78 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/NetPlayProto.h"
+
+namespace NetPlay
+{
+// Picks the pad buffer size automatically, instead of leaving it to the players.
+//
+// The buffer has to cover the time an input takes to reach the other players, and the variation
+// of that time. The former comes from the pings the server measures every second: an input goes
+// from its sender to the server and on to the receiver, so it takes about half the sum of their
+// median round trip times. For the latter, every remote input is compared to the local polls it
+// arrives between. Both sides poll at the same rate, so that difference stays constant except
+// for jitter, without having to know the exact poll rate. The spread between its median and the
+// quantile for the target stall probability is what the buffer has to absorb on top.
+//
+// Jitter is measured on the inputs coming in, while the local buffer delays the inputs going out.
+// Routes are assumed to be symmetric enough for that not to matter.
+//
+// With host input authority, inputs don't have to wait for the other players, but the buffer
+// still decides how many inputs may queue up before the game speeds up to catch up, so only the
+// jitter is used then.
+//
+// To avoid stutters and speed changes, the size changes at most once per second. It grows by
+// half of what is missing, and only shrinks by one input after the smaller size was enough for
+// several updates in a row.
+class AutoBufferController
+{
+public:
+  // Called on the ---GUI--- thread while the game isn't running
+  void Reset(bool enabled, double stall_probability);
+  bool IsEnabled() const { return m_is_enabled.load(std::memory_order_relaxed); }
+
+  // Called on the ---CPU--- thread once per batched poll
+  void OnPoll();
+
+  // Called on the ---NETPLAY--- thread
+  void OnRemoteInput(int pad, u32 index);
+  void OnPing(PlayerId pid, u32 ping_ms);
+  // Returns the new buffer size in inputs if it should change, never less than minimum_inputs.
+  // Rate limited to one update per second
+  std::optional<u32> Update(u32 current_inputs, u32 minimum_inputs, PlayerId local_pid,
+                            const std::vector<PlayerId>& remote_pids, bool host_input_authority);
+
+private:
+  static constexpr size_t MAX_SAMPLES = 300;
+
+  double GetMedianPing(PlayerId pid) const;
+  double GetJitterPolls() const;
+
+  std::mutex m_lock;
+  std::atomic<bool> m_is_enabled{false};
+  double m_stall_probability = 0.01;
+
+  std::array<std::deque<double>, 4> m_arrivals;
+  std::map<PlayerId, std::deque<u32>> m_pings;
+  u64 m_last_update_us = 0;
+  u32 m_updates_below = 0;
+
+  std::atomic<u64> m_polls{0};
+  std::atomic<u64> m_last_poll_us{0};
+  // Time between polls in microseconds, smoothed
+  std::atomic<u32> m_poll_period_us{16683};
+};
+}  // namespace NetPlay
@@ -5,6 +5,7 @@
 #include "Core/NetPlayClient.h"
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstddef>
 #include <cstring>
 #include <fstream>
@@ -16,7 +17,6 @@
 #include <vector>
 #include <cmath>
 
-#include <lzo/lzo1x.h>
 #include <mbedtls/md5.h>
 
 #include "Common/Assert.h"
@@ -50,6 +50,7 @@
 #include "Core/IOS/USB/Bluetooth/BTEmu.h"
 #include "Core/IOS/Uids.h"
 #include "Core/Movie.h"
+#include "Core/NetPlaySaveSync.h"
 #include "Core/PowerPC/PowerPC.h"
 #include "Core/WiiRoot.h"
 #include "InputCommon/GCAdapter.h"
@@ -364,20 +365,69 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
 
   case NP_MSG_PAD_DATA:
   {
+    // Pad data is unreliable, so it can still arrive from the last game
+    u32 game;
+    packet >> game;
+    if (game != m_current_game)
+      break;
+
+    ResetPadReceiveIfNewGame();
+
     while (!packet.endOfPacket())
     {
       PadMapping map;
       packet >> map;
 
-      GCPadStatus pad;
-      packet >> pad.button >> pad.analogA >> pad.analogB >> pad.stickX >> pad.stickY >>
-          pad.substickX >> pad.substickY >> pad.triggerLeft >> pad.triggerRight >> pad.isConnected;
+      PadRecord record;
+      if (!ReadPadRecord(packet, &record))
+      {
+        ERROR_LOG(NETPLAY, "Received invalid pad data");
+        break;
+      }
 
       // Trusting server for good map value (>=0 && <4)
       // add to pad buffer
-      m_pad_buffer.at(map).Push(pad);
-      m_gc_pad_event.Set();
+      PadReceiveState& receive_state = m_pad_receive.at(map);
+      const u32 first_new = receive_state.Next();
+      const bool is_in_order =
+          receive_state.Receive(record, [&](const GCPadStatus& pad, u32 index) {
+            if (!m_pad_buffer.at(map).Push(pad, index))
+              ERROR_LOG(NETPLAY, "Pad %d buffer is full, dropped input %u", map, index);
+            m_auto_buffer.OnRemoteInput(map, index);
+          });
+      m_telemetry.OnPadData(receive_state.Next() - first_new, !is_in_order);
+
+      if (receive_state.ShouldRequestResend(Common::Timer::GetTimeMs()))
+        SendPadResendRequest(map);
+    }
+  }
+  break;
+
+  case NP_MSG_PAD_RESEND:
+  {
+    u32 game;
+    PadMapping map;
+    u32 first;
+    packet >> game >> map >> first;
+    if (game != m_current_game || map < 0 || map >= static_cast<PadMapping>(m_pad_map.size()))
+      break;
+
+    sf::Packet resend_packet;
+    resend_packet << static_cast<MessageId>(NP_MSG_PAD_DATA);
+    resend_packet << game;
+    {
+      std::lock_guard<std::mutex> lk(m_pad_send_history_lock);
+      // Requests after a timeout often find that nothing was lost
+      if (first == m_pad_send_history[map].End())
+        break;
+      if (!m_pad_send_history[map].Encode(map, first, resend_packet))
+      {
+        ERROR_LOG(NETPLAY, "Pad %d inputs from %u requested again are no longer kept", map, first);
+        break;
+      }
     }
+
+    Send(resend_packet);
   }
   break;
 
@@ -477,80 +527,10 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
     {
       std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
       packet >> m_current_game;
-      packet >> m_net_settings.m_CPUthread;
 
       INFO_LOG(NETPLAY, "Start of game %s", m_selected_game.c_str());
 
-      {
-        std::underlying_type_t<PowerPC::CPUCore> core;
-        if (packet >> core)
-          m_net_settings.m_CPUcore = static_cast<PowerPC::CPUCore>(core);
-        else
-          m_net_settings.m_CPUcore = PowerPC::CPUCore::CachedInterpreter;
-      }
-
-      packet >> m_net_settings.m_EnableCheats;
-      packet >> m_net_settings.m_SelectedLanguage;
-      packet >> m_net_settings.m_OverrideGCLanguage;
-      packet >> m_net_settings.m_ProgressiveScan;
-      packet >> m_net_settings.m_PAL60;
-      packet >> m_net_settings.m_DSPEnableJIT;
-      packet >> m_net_settings.m_DSPHLE;
-      packet >> m_net_settings.m_WriteToMemcard;
-      packet >> m_net_settings.m_CopyWiiSave;
-      packet >> m_net_settings.m_OCEnable;
-      packet >> m_net_settings.m_OCFactor;
-      packet >> m_net_settings.m_PollOnSIRead;
-
-      int tmp;
-      packet >> tmp;
-      m_net_settings.m_EXIDevice[0] = static_cast<ExpansionInterface::TEXIDevices>(tmp);
-      packet >> tmp;
-      m_net_settings.m_EXIDevice[1] = static_cast<ExpansionInterface::TEXIDevices>(tmp);
-
-      packet >> m_net_settings.m_EFBAccessEnable;
-      packet >> m_net_settings.m_BBoxEnable;
-      packet >> m_net_settings.m_ForceProgressive;
-      packet >> m_net_settings.m_EFBToTextureEnable;
-      packet >> m_net_settings.m_XFBToTextureEnable;
-      packet >> m_net_settings.m_DisableCopyToVRAM;
-      packet >> m_net_settings.m_ImmediateXFBEnable;
-      packet >> m_net_settings.m_EFBEmulateFormatChanges;
-      packet >> m_net_settings.m_SafeTextureCacheColorSamples;
-      packet >> m_net_settings.m_PerfQueriesEnable;
-      packet >> m_net_settings.m_FPRF;
-      packet >> m_net_settings.m_AccurateNaNs;
-      packet >> m_net_settings.m_SyncOnSkipIdle;
-      packet >> m_net_settings.m_SyncGPU;
-      packet >> m_net_settings.m_SyncGpuMaxDistance;
-      packet >> m_net_settings.m_SyncGpuMinDistance;
-      packet >> m_net_settings.m_SyncGpuOverclock;
-      packet >> m_net_settings.m_JITFollowBranch;
-      packet >> m_net_settings.m_FastDiscSpeed;
-      packet >> m_net_settings.m_MMU;
-      packet >> m_net_settings.m_Fastmem;
-      packet >> m_net_settings.m_SkipIPL;
-      packet >> m_net_settings.m_LoadIPLDump;
-      packet >> m_net_settings.m_VertexRounding;
-      packet >> m_net_settings.m_InternalResolution;
-      packet >> m_net_settings.m_EFBScaledCopy;
-      packet >> m_net_settings.m_FastDepthCalc;
-      packet >> m_net_settings.m_EnablePixelLighting;
-      packet >> m_net_settings.m_WidescreenHack;
-      packet >> m_net_settings.m_ForceFiltering;
-      packet >> m_net_settings.m_MaxAnisotropy;
-      packet >> m_net_settings.m_ForceTrueColor;
-      packet >> m_net_settings.m_DisableCopyFilter;
-      packet >> m_net_settings.m_DisableFog;
-      packet >> m_net_settings.m_ArbitraryMipmapDetection;
-      packet >> m_net_settings.m_ArbitraryMipmapDetectionThreshold;
-      packet >> m_net_settings.m_EnableGPUTextureDecoding;
-      packet >> m_net_settings.m_StrictSettingsSync;
-
-      m_initial_rtc = Common::PacketReadU64(packet);
-
-      packet >> m_net_settings.m_SyncSaveData;
-      packet >> m_net_settings.m_SaveDataRegion;
+      ReadStartGameSettings(packet, &m_net_settings, &m_initial_rtc);
 
       m_net_settings.m_IsHosting = m_local_player->IsHost();
       m_net_settings.m_HostInputAuthority = m_host_input_authority;
@@ -592,8 +572,11 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
       std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
       Player& player = m_players[pid];
       packet >> player.ping;
+      m_auto_buffer.OnPing(pid, player.ping);
+      m_telemetry.OnPing(pid, player.ping);
     }
 
+    UpdateAutoBuffer();
     DisplayPlayersPing();
     m_dialog->Update();
   }
@@ -602,9 +585,11 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
   case NP_MSG_DESYNC_DETECTED:
   {
     int pid_to_blame;
-    u32 frame;
+    u32 first_frame, frame;
+    u32 memory_address, memory_size;
     packet >> pid_to_blame;
-    packet >> frame;
+    packet >> first_frame >> frame;
+    packet >> memory_address >> memory_size;
 
     std::string player = "??";
     std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
@@ -614,9 +599,19 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
         player = it->second.name;
     }
 
-    INFO_LOG(NETPLAY, "Player %s (%d) desynced!", player.c_str(), pid_to_blame);
+    if (memory_size != 0)
+    {
+      INFO_LOG(NETPLAY, "Player %s (%d) desynced between frames %u and %u in memory %08x-%08x!",
+               player.c_str(), pid_to_blame, first_frame, frame, memory_address,
+               memory_address + memory_size);
+    }
+    else
+    {
+      INFO_LOG(NETPLAY, "Player %s (%d) desynced between frames %u and %u!", player.c_str(),
+               pid_to_blame, first_frame, frame);
+    }
 
-    m_dialog->OnDesync(frame, player);
+    m_dialog->OnDesync(first_frame, frame, player, memory_address, memory_size);
   }
   break;
 
@@ -650,9 +645,31 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
       m_sync_save_data_success_count = 0;
 
       if (m_sync_save_data_count == 0)
+      {
         SyncSaveDataResponse(true);
-      else
-        m_dialog->AppendChat(GetStringT("Synchronizing save data..."));
+        break;
+      }
+
+      m_dialog->AppendChat(GetStringT("Synchronizing save data..."));
+      if (m_local_player->IsHost())
+        break;
+
+      u32 key_count;
+      packet >> key_count;
+      std::vector<std::string> keys;
+      for (u32 i = 0; i < key_count && packet; i++)
+      {
+        std::string key;
+        packet >> key;
+        keys.push_back(std::move(key));
+      }
+
+      // The host only sends the blocks that differ from our copies of the last synced saves
+      sf::Packet response_packet;
+      response_packet << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
+      response_packet << static_cast<MessageId>(SYNC_SAVE_DATA_BLOCK_HASHES);
+      WriteSaveBlockHashes(response_packet, GetCachedSaveBlockHashes(keys));
+      Send(response_packet);
     }
     break;
 
@@ -882,11 +899,16 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
   return 0;
 }
 
-void NetPlayClient::Send(const sf::Packet& packet)
+void NetPlayClient::Send(const sf::Packet& packet, u8 channel_id)
 {
-  ENetPacket* epac =
-      enet_packet_create(packet.getData(), packet.getDataSize(), ENET_PACKET_FLAG_RELIABLE);
-  enet_peer_send(m_server, 0, epac);
+  // Peers that only negotiated the default channel get everything on it, reliably
+  if (channel_id >= m_server->channelCount)
+    channel_id = DEFAULT_CHANNEL;
+
+  const u32 flags = channel_id == PAD_DATA_CHANNEL ? 0 : ENET_PACKET_FLAG_RELIABLE;
+  ENetPacket* epac = enet_packet_create(packet.getData(), packet.getDataSize(), flags);
+  if (enet_peer_send(m_server, channel_id, epac) < 0)
+    enet_packet_destroy(epac);
 }
 
 void NetPlayClient::DisplayPlayersPing()
@@ -946,11 +968,11 @@ void NetPlayClient::Disconnect()
   m_server = nullptr;
 }
 
-void NetPlayClient::SendAsync(sf::Packet&& packet)
+void NetPlayClient::SendAsync(sf::Packet&& packet, const u8 channel_id)
 {
   {
     std::lock_guard<std::recursive_mutex> lkq(m_crit.async_queue_write);
-    m_async_queue.Push(std::move(packet));
+    m_async_queue.Push(AsyncQueueEntry{std::move(packet), channel_id});
   }
   ENetUtil::WakeupThread(m_client);
 }
@@ -975,12 +997,16 @@ void NetPlayClient::ThreadFunc()
     int net;
     if (m_traversal_client)
       m_traversal_client->HandleResends();
-    net = enet_host_service(m_client, &netEvent, 250);
+    // Stalled pad data has to be noticed even when nothing else arrives
+    net = enet_host_service(m_client, &netEvent,
+                            m_is_running.IsSet() ? PAD_RESEND_TIMEOUT_MS : 250);
     while (!m_async_queue.Empty())
     {
-      Send(m_async_queue.Front());
+      Send(m_async_queue.Front().packet, m_async_queue.Front().channel_id);
       m_async_queue.Pop();
     }
+    m_telemetry.Update(m_server);
+    RequestStalledPadData();
     if (net > 0)
     {
       sf::Packet rpac;
@@ -1088,15 +1114,6 @@ void NetPlayClient::SendChatMessage(const std::string& msg)
   SendAsync(std::move(packet));
 }
 
-// called from ---CPU--- thread
-void NetPlayClient::AddPadStateToPacket(const int in_game_pad, const GCPadStatus& pad,
-                                        sf::Packet& packet)
-{
-  packet << static_cast<PadMapping>(in_game_pad);
-  packet << pad.button << pad.analogA << pad.analogB << pad.stickX << pad.stickY << pad.substickX
-         << pad.substickY << pad.triggerLeft << pad.triggerRight << pad.isConnected;
-}
-
 // called from ---CPU--- thread
 void NetPlayClient::SendWiimoteState(const int in_game_pad, const NetWiimote& nw)
 {
@@ -1122,6 +1139,87 @@ void NetPlayClient::SendStartGamePacket()
   SendAsync(std::move(packet));
 }
 
+// Reads what follows the game in NP_MSG_START_GAME. Also used for the settings stored in session
+// logs
+void NetPlayClient::ReadStartGameSettings(sf::Packet& packet, NetSettings* settings,
+                                          u64* initial_rtc)
+{
+  packet >> settings->m_CPUthread;
+
+  {
+    std::underlying_type_t<PowerPC::CPUCore> core;
+    if (packet >> core)
+      settings->m_CPUcore = static_cast<PowerPC::CPUCore>(core);
+    else
+      settings->m_CPUcore = PowerPC::CPUCore::CachedInterpreter;
+  }
+
+  packet >> settings->m_EnableCheats;
+  packet >> settings->m_SelectedLanguage;
+  packet >> settings->m_OverrideGCLanguage;
+  packet >> settings->m_ProgressiveScan;
+  packet >> settings->m_PAL60;
+  packet >> settings->m_DSPEnableJIT;
+  packet >> settings->m_DSPHLE;
+  packet >> settings->m_WriteToMemcard;
+  packet >> settings->m_CopyWiiSave;
+  packet >> settings->m_OCEnable;
+  packet >> settings->m_OCFactor;
+  packet >> settings->m_PollOnSIRead;
+
+  int tmp;
+  packet >> tmp;
+  settings->m_EXIDevice[0] = static_cast<ExpansionInterface::TEXIDevices>(tmp);
+  packet >> tmp;
+  settings->m_EXIDevice[1] = static_cast<ExpansionInterface::TEXIDevices>(tmp);
+
+  packet >> settings->m_EFBAccessEnable;
+  packet >> settings->m_BBoxEnable;
+  packet >> settings->m_ForceProgressive;
+  packet >> settings->m_EFBToTextureEnable;
+  packet >> settings->m_XFBToTextureEnable;
+  packet >> settings->m_DisableCopyToVRAM;
+  packet >> settings->m_ImmediateXFBEnable;
+  packet >> settings->m_EFBEmulateFormatChanges;
+  packet >> settings->m_SafeTextureCacheColorSamples;
+  packet >> settings->m_PerfQueriesEnable;
+  packet >> settings->m_FPRF;
+  packet >> settings->m_AccurateNaNs;
+  packet >> settings->m_SyncOnSkipIdle;
+  packet >> settings->m_SyncGPU;
+  packet >> settings->m_SyncGpuMaxDistance;
+  packet >> settings->m_SyncGpuMinDistance;
+  packet >> settings->m_SyncGpuOverclock;
+  packet >> settings->m_JITFollowBranch;
+  packet >> settings->m_FastDiscSpeed;
+  packet >> settings->m_MMU;
+  packet >> settings->m_Fastmem;
+  packet >> settings->m_SkipIPL;
+  packet >> settings->m_LoadIPLDump;
+  packet >> settings->m_VertexRounding;
+  packet >> settings->m_InternalResolution;
+  packet >> settings->m_EFBScaledCopy;
+  packet >> settings->m_FastDepthCalc;
+  packet >> settings->m_EnablePixelLighting;
+  packet >> settings->m_WidescreenHack;
+  packet >> settings->m_ForceFiltering;
+  packet >> settings->m_MaxAnisotropy;
+  packet >> settings->m_ForceTrueColor;
+  packet >> settings->m_DisableCopyFilter;
+  packet >> settings->m_DisableFog;
+  packet >> settings->m_ArbitraryMipmapDetection;
+  packet >> settings->m_ArbitraryMipmapDetectionThreshold;
+  packet >> settings->m_EnableGPUTextureDecoding;
+  packet >> settings->m_StrictSettingsSync;
+
+  *initial_rtc = Common::PacketReadU64(packet);
+
+  packet >> settings->m_SyncSaveData;
+  packet >> settings->m_SaveDataRegion;
+  packet >> settings->m_DesyncHashRegions;
+  packet >> settings->m_DesyncHashBytesPerFrame;
+}
+
 // called from ---GUI--- thread
 void NetPlayClient::SendStopGamePacket()
 {
@@ -1150,8 +1248,42 @@ bool NetPlayClient::StartGame(const std::string& path)
 
   ClearBuffers();
 
+  {
+    std::lock_guard<std::mutex> lk(m_pad_send_history_lock);
+    for (PadSendHistory& history : m_pad_send_history)
+      history.Reset();
+  }
+
   m_first_pad_status_received.fill(false);
 
+  m_rollback.Reset(Config::Get(Config::NETPLAY_ENABLE_ROLLBACK),
+                   static_cast<u32>(std::max(1, Config::Get(Config::NETPLAY_ROLLBACK_FRAMES))));
+  m_auto_buffer.Reset(Config::Get(Config::NETPLAY_AUTO_BUFFER),
+                      Config::Get(Config::NETPLAY_AUTO_BUFFER_STALL_PROBABILITY));
+
+  {
+    std::vector<PlayerId> pids;
+    {
+      std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+      for (const auto& entry : m_players)
+        pids.push_back(entry.first);
+    }
+
+    std::string telemetry_path;
+    if (Config::Get(Config::NETPLAY_WRITE_TELEMETRY))
+    {
+      telemetry_path = File::GetUserPath(D_DUMP_IDX) + "NetPlay" DIR_SEP +
+                       StringFromFormat("Telemetry_%" PRIu64 ".csv",
+                                        Common::Timer::GetLocalTimeSinceJan1970());
+    }
+    m_telemetry.Reset(Config::Get(Config::NETPLAY_SHOW_TELEMETRY), telemetry_path, pids);
+  }
+  // Predicted frames legitimately differ from what the other players run, so the memory can only
+  // be compared without rollback
+  const bool use_rollback = m_rollback.IsEnabled() && !m_host_input_authority;
+  m_state_hasher.Reset(use_rollback ? "" : m_net_settings.m_DesyncHashRegions,
+                       m_net_settings.m_DesyncHashBytesPerFrame);
+
   if (m_dialog->IsRecording())
   {
     if (Movie::IsReadOnly())
@@ -1207,10 +1339,11 @@ void NetPlayClient::SyncSaveDataResponse(const bool success)
 
 bool NetPlayClient::DecompressPacketIntoFile(sf::Packet& packet, const std::string& file_path)
 {
-  u64 file_size = Common::PacketReadU64(packet);
-  ;
+  const std::optional<std::vector<u8>> data = ReadSaveBlob(packet);
+  if (!data)
+    return false;
 
-  if (file_size == 0)
+  if (data->empty())
     return true;
 
   File::IOFile file(file_path, "wb");
@@ -1220,35 +1353,10 @@ bool NetPlayClient::DecompressPacketIntoFile(sf::Packet& packet, const std::stri
     return false;
   }
 
-  std::vector<u8> in_buffer(NETPLAY_LZO_OUT_LEN);
-  std::vector<u8> out_buffer(NETPLAY_LZO_IN_LEN);
-
-  while (true)
+  if (!file.WriteBytes(data->data(), data->size()))
   {
-    lzo_uint32 cur_len = 0;  // number of bytes to read
-    lzo_uint new_len = 0;    // number of bytes to write
-
-    packet >> cur_len;
-    if (!cur_len)
-      break;  // We reached the end of the data stream
-
-    for (size_t j = 0; j < cur_len; j++)
-    {
-      packet >> in_buffer[j];
-    }
-
-    if (lzo1x_decompress(in_buffer.data(), cur_len, out_buffer.data(), &new_len, nullptr) !=
-        LZO_E_OK)
-    {
-      PanicAlertT("Internal LZO Error - decompression failed");
-      return false;
-    }
-
-    if (!file.WriteBytes(out_buffer.data(), new_len))
-    {
-      PanicAlertT("Error writing file: %s", file_path.c_str());
-      return false;
-    }
+    PanicAlertT("Error writing file: %s", file_path.c_str());
+    return false;
   }
 
   return true;
@@ -1256,41 +1364,7 @@ bool NetPlayClient::DecompressPacketIntoFile(sf::Packet& packet, const std::stri
 
 std::optional<std::vector<u8>> NetPlayClient::DecompressPacketIntoBuffer(sf::Packet& packet)
 {
-  u64 size = Common::PacketReadU64(packet);
-  ;
-
-  std::vector<u8> out_buffer(size);
-
-  if (size == 0)
-    return out_buffer;
-
-  std::vector<u8> in_buffer(NETPLAY_LZO_OUT_LEN);
-
-  lzo_uint i = 0;
-  while (true)
-  {
-    lzo_uint32 cur_len = 0;  // number of bytes to read
-    lzo_uint new_len = 0;    // number of bytes to write
-
-    packet >> cur_len;
-    if (!cur_len)
-      break;  // We reached the end of the data stream
-
-    for (size_t j = 0; j < cur_len; j++)
-    {
-      packet >> in_buffer[j];
-    }
-
-    if (lzo1x_decompress(in_buffer.data(), cur_len, &out_buffer[i], &new_len, nullptr) != LZO_E_OK)
-    {
-      PanicAlertT("Internal LZO Error - decompression failed");
-      return {};
-    }
-
-    i += new_len;
-  }
-
-  return out_buffer;
+  return ReadSaveBlob(packet);
 }
 
 // called from ---GUI--- thread
@@ -1340,8 +1414,8 @@ void NetPlayClient::ClearBuffers()
   // clear pad buffers, Clear method isn't thread safe
   for (unsigned int i = 0; i < 4; ++i)
   {
-    while (m_pad_buffer[i].Size())
-      m_pad_buffer[i].Pop();
+    m_pad_buffer[i].Clear();
+    m_pad_buffer[i].ResetWaitStats();
 
     while (m_wiimote_buffer[i].Size())
       m_wiimote_buffer[i].Pop();
@@ -1373,7 +1447,7 @@ void NetPlayClient::OnConnectReady(ENetAddress addr)
   if (m_connection_state == ConnectionState::WaitingForTraversalClientConnectReady)
   {
     m_connection_state = ConnectionState::Connecting;
-    enet_host_connect(m_client, &addr, 0, 0);
+    enet_host_connect(m_client, &addr, 3, 0);
   }
 }
 
@@ -1429,10 +1503,20 @@ bool NetPlayClient::GetNetPads(const int pad_nb, const bool batching, GCPadStatu
   // specific pad arbitrarily. In this case, we poll just that pad
   // and send it.
 
-  if (IsFirstInGamePad(pad_nb) && batching)
+  // In rollback mode the polls are replayed after a rollback, and the local inputs for those
+  // have been sent already
+  const bool use_rollback = m_rollback.IsEnabled() && !m_host_input_authority;
+  if (use_rollback && IsFirstInGamePad(pad_nb) && batching)
+    m_rollback.OnFrame();
+  const bool is_resimulating = use_rollback && m_rollback.IsResimulating();
+
+  if (IsFirstInGamePad(pad_nb) && batching && !is_resimulating)
   {
+    m_auto_buffer.OnPoll();
+
     sf::Packet packet;
     packet << static_cast<MessageId>(NP_MSG_PAD_DATA);
+    packet << m_current_game;
 
     bool send_packet = false;
     const int num_local_pads = NumLocalPads();
@@ -1442,21 +1526,22 @@ bool NetPlayClient::GetNetPads(const int pad_nb, const bool batching, GCPadStatu
     }
 
     if (send_packet)
-      SendAsync(std::move(packet));
+      SendAsync(std::move(packet), PAD_DATA_CHANNEL);
 
     if (m_host_input_authority)
       SendPadHostPoll(-1);
   }
 
-  if (!batching)
+  if (!batching && !is_resimulating)
   {
     int local_pad = InGamePadToLocalPad(pad_nb);
     if (local_pad < 4)
     {
       sf::Packet packet;
       packet << static_cast<MessageId>(NP_MSG_PAD_DATA);
+      packet << m_current_game;
       if (PollLocalPad(local_pad, packet))
-        SendAsync(std::move(packet));
+        SendAsync(std::move(packet), PAD_DATA_CHANNEL);
     }
 
     if (m_host_input_authority)
@@ -1482,19 +1567,27 @@ bool NetPlayClient::GetNetPads(const int pad_nb, const bool batching, GCPadStatu
     }
   }
 
-  // Now, we either use the data pushed earlier, or wait for the
-  // other clients to send it to us
-  while (m_pad_buffer[pad_nb].Size() == 0)
+  if (use_rollback)
   {
-    if (!m_is_running.IsSet())
-    {
+    // Only wait if a wrong prediction could no longer be rolled back
+    if (!m_rollback.CanPredict(pad_nb) && !m_pad_buffer[pad_nb].WaitForInput(m_is_running))
       return false;
-    }
 
-    m_gc_pad_event.Wait();
+    GCPadStatus confirmed;
+    while (m_pad_buffer[pad_nb].Pop(&confirmed))
+      m_rollback.AddConfirmedInput(pad_nb, confirmed);
+
+    *pad_status = m_rollback.GetInput(pad_nb);
   }
+  else
+  {
+    // Now, we either use the data pushed earlier, or wait for the
+    // other clients to send it to us
+    if (!m_pad_buffer[pad_nb].WaitForInput(m_is_running))
+      return false;
 
-  m_pad_buffer[pad_nb].Pop(*pad_status);
+    m_pad_buffer[pad_nb].Pop(pad_status);
+  }
 
   if (Movie::IsRecordingInput())
   {
@@ -1509,6 +1602,24 @@ bool NetPlayClient::GetNetPads(const int pad_nb, const bool batching, GCPadStatu
   return true;
 }
 
+PadBuffer::WaitStats NetPlayClient::GetPadWaitStats(int ingame_pad) const
+{
+  return m_pad_buffer.at(ingame_pad).GetWaitStats();
+}
+
+void NetPlayClient::LogPadWaitStats() const
+{
+  for (int pad = 0; pad < static_cast<int>(m_pad_buffer.size()); pad++)
+  {
+    const PadBuffer::WaitStats stats = GetPadWaitStats(pad);
+    if (stats.waits == 0 || InGamePadToLocalPad(pad) < 4)
+      continue;
+
+    INFO_LOG(NETPLAY, "Waited for pad %d %u times, %.1f ms in total, %.1f ms at most", pad,
+             stats.waits, stats.total_us / 1000.0, stats.max_us / 1000.0);
+  }
+}
+
 u64 NetPlayClient::GetInitialRTCValue() const
 {
   return m_initial_rtc;
@@ -1588,6 +1699,52 @@ bool NetPlayClient::WiimoteUpdate(int _number, u8* data, const u8 size, u8 repor
   return true;
 }
 
+// called from ---NETPLAY--- thread
+void NetPlayClient::ResetPadReceiveIfNewGame()
+{
+  if (m_pad_receive_game == m_current_game)
+    return;
+
+  for (PadReceiveState& receive_state : m_pad_receive)
+    receive_state.Reset();
+  m_pad_receive_game = m_current_game;
+}
+
+// called from ---NETPLAY--- thread
+void NetPlayClient::SendPadResendRequest(const PadMapping map)
+{
+  m_telemetry.OnResendRequest();
+
+  sf::Packet packet;
+  packet << static_cast<MessageId>(NP_MSG_PAD_RESEND);
+  packet << m_current_game << map << m_pad_receive[map].Next();
+  Send(packet);
+}
+
+// called from ---NETPLAY--- thread
+// Asks again for the inputs of pads we are waiting on. The last packet before the sender waits
+// for us may have been lost, and nothing would arrive after it to show that.
+void NetPlayClient::RequestStalledPadData()
+{
+  if (!m_is_running.IsSet())
+    return;
+
+  ResetPadReceiveIfNewGame();
+
+  const u64 now = Common::Timer::GetTimeMs();
+  for (size_t i = 0; i < m_pad_map.size(); i++)
+  {
+    if (m_pad_map[i] <= 0 || m_pad_buffer[i].Size() != 0)
+      continue;
+    // Our own pads only come over the network when the host polls them
+    if (m_pad_map[i] == m_local_player->pid && !m_host_input_authority)
+      continue;
+
+    if (m_pad_receive[i].ShouldRequestResend(now))
+      SendPadResendRequest(static_cast<PadMapping>(i));
+  }
+}
+
 bool NetPlayClient::PollLocalPad(const int local_pad, sf::Packet& packet)
 {
   GCPadStatus pad_status;
@@ -1604,30 +1761,36 @@ bool NetPlayClient::PollLocalPad(const int local_pad, sf::Packet& packet)
   }
 
   const int ingame_pad = LocalPadToInGamePad(local_pad);
-  bool data_added = false;
+
+  std::lock_guard<std::mutex> lk(m_pad_send_history_lock);
+  PadSendHistory& history = m_pad_send_history[ingame_pad];
+  const u32 first_new = history.End();
 
   if (m_host_input_authority)
   {
-    // add to packet
-    AddPadStateToPacket(ingame_pad, pad_status, packet);
-    data_added = true;
+    history.Push(pad_status);
   }
   else
   {
     // adjust the buffer either up or down
     // inserting multiple padstates or dropping states
-    while (m_pad_buffer[ingame_pad].Size() <= ActualBufferSize())
+    // (in rollback mode, inputs already moved into the rollback history count as well)
+    while (m_pad_buffer[ingame_pad].Size() + m_rollback.BufferedInputs(ingame_pad) <=
+           ActualBufferSize())
     {
       // add to buffer
-      m_pad_buffer[ingame_pad].Push(pad_status);
-
-      // add to packet
-      AddPadStateToPacket(ingame_pad, pad_status, packet);
-      data_added = true;
+      if (!m_pad_buffer[ingame_pad].Push(pad_status, history.End()))
+        break;
+      history.Push(pad_status);
     }
   }
 
-  return data_added;
+  if (history.End() == first_new)
+    return false;
+
+  // add to packet, along with the last few inputs in case earlier packets got lost
+  history.Encode(ingame_pad, history.GetRedundantStart(first_new), packet);
+  return true;
 }
 
 void NetPlayClient::SendPadHostPoll(const PadMapping pad_num)
@@ -1674,12 +1837,18 @@ bool NetPlayClient::StopGame()
   m_is_running.Clear();
 
   // stop waiting for input
-  m_gc_pad_event.Set();
+  for (PadBuffer& buffer : m_pad_buffer)
+    buffer.Interrupt();
   m_wii_pad_event.Set();
   m_first_pad_status_received_event.Set();
 
   NetPlay_Disable();
 
+  LogPadWaitStats();
+  m_telemetry.Stop();
+
+  m_rollback.Reset(false, 0);
+
   // stop game
   m_dialog->StopGame();
 
@@ -1697,7 +1866,8 @@ void NetPlayClient::Stop()
   m_is_running.Clear();
 
   // stop waiting for input
-  m_gc_pad_event.Set();
+  for (PadBuffer& buffer : m_pad_buffer)
+    buffer.Interrupt();
   m_wii_pad_event.Set();
   m_first_pad_status_received_event.Set();
 
@@ -1780,14 +1950,28 @@ void NetPlayClient::SendTimeBase()
 {
   std::lock_guard<std::mutex> lk(crit_netplay_client);
 
-  if (netplay_client->m_timebase_frame % 60 == 0)
+  // Re-simulated frames were sent and measured when they first ran. Counting them again would
+  // shift this client's frame numbers against the other players', which the server compares by
+  // number, and inflate the frame statistics.
+  if (netplay_client->m_rollback.IsResimulating())
+    return;
+
+  netplay_client->UpdateFrameTelemetry();
+
+  // With state hashing, every frame covers a different part of memory
+  const u32 frame = netplay_client->m_timebase_frame;
+  const StateHasher& state_hasher = netplay_client->m_state_hasher;
+  if (state_hasher.IsEnabled() || frame % 60 == 0)
   {
     const sf::Uint64 timebase = SystemTimers::GetFakeTimeBase();
+    const StateHashSlice state_hash = state_hasher.HashFrame(frame);
 
     sf::Packet packet;
     packet << static_cast<MessageId>(NP_MSG_TIMEBASE);
     packet << timebase;
-    packet << netplay_client->m_timebase_frame;
+    packet << frame;
+    packet << state_hash.address << state_hash.size;
+    packet << static_cast<sf::Uint64>(state_hash.hash);
 
     netplay_client->SendAsync(std::move(packet));
   }
@@ -1855,6 +2039,57 @@ const PadMappingArray& NetPlayClient::GetWiimoteMapping() const
   return m_wiimote_map;
 }
 
+// called from ---NETPLAY--- thread
+void NetPlayClient::UpdateAutoBuffer()
+{
+  if (!m_is_running.IsSet() || !m_auto_buffer.IsEnabled())
+    return;
+
+  std::vector<PlayerId> remote_pids;
+  for (const PadMapping mapping : m_pad_map)
+  {
+    const PlayerId pid = static_cast<PlayerId>(mapping);
+    if (mapping > 0 && pid != m_local_player->pid &&
+        std::find(remote_pids.begin(), remote_pids.end(), pid) == remote_pids.end())
+    {
+      remote_pids.push_back(pid);
+    }
+  }
+
+  // The buffer size is in hundredths of a frame when polling on SI reads. The host's minimum
+  // applies on top of the local size, so that is where the calculation starts from.
+  const bool poll_on_si_read = Config::Get(Config::MAIN_POLL_ON_SIREAD);
+  const u32 current = ActualBufferSize();
+  u32 minimum = 0;
+  if (!m_host_input_authority)
+    minimum = poll_on_si_read ? m_minimum_buffer_size / 100 : m_minimum_buffer_size;
+  const std::optional<u32> size = m_auto_buffer.Update(current, minimum, m_local_player->pid,
+                                                       remote_pids, m_host_input_authority);
+  if (size)
+    AdjustLocalPadBufferSize(poll_on_si_read ? *size * 100 : *size);
+}
+
+// called from ---CPU--- thread
+void NetPlayClient::UpdateFrameTelemetry()
+{
+  // The remote pad with the fewest inputs buffered is the one that makes the game wait first
+  u32 buffered = 0;
+  bool has_remote_pad = false;
+  u64 total_wait_us = 0;
+  for (size_t pad = 0; pad < m_pad_buffer.size(); pad++)
+  {
+    total_wait_us += m_pad_buffer[pad].GetWaitStats().total_us;
+    if (m_pad_map[pad] <= 0 || m_pad_map[pad] == m_local_player->pid)
+      continue;
+
+    const u32 size = m_pad_buffer[pad].Size();
+    buffered = has_remote_pad ? std::min(buffered, size) : size;
+    has_remote_pad = true;
+  }
+
+  m_telemetry.OnFrame(buffered, total_wait_us);
+}
+
 void NetPlayClient::AdjustLocalPadBufferSize(const unsigned int size)
 {
   m_local_buffer_size = size;
@@ -19,7 +19,13 @@
 #include "Common/Event.h"
 #include "Common/SPSCQueue.h"
 #include "Common/TraversalClient.h"
+#include "Core/NetPlayAutoBuffer.h"
+#include "Core/NetPlayPadBuffer.h"
+#include "Core/NetPlayPadCoding.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlayRollback.h"
+#include "Core/NetPlayStateHash.h"
+#include "Core/NetPlayTelemetry.h"
 #include "InputCommon/GCPadStatus.h"
 
 namespace UICommon
@@ -46,7 +52,10 @@ public:
   virtual void OnMinimumPadBufferChanged(u32 buffer) = 0;
   virtual void OnLocalPadBufferChanged(u32 buffer) = 0;
   virtual void OnHostInputAuthorityChanged(bool enabled) = 0;
-  virtual void OnDesync(u32 frame, const std::string& player) = 0;
+  // The players diverged somewhere from first_frame up to frame. memory_size is 0 if only the
+  // timebases differed, not the hashed memory
+  virtual void OnDesync(u32 first_frame, u32 frame, const std::string& player,
+                        u32 memory_address, u32 memory_size) = 0;
   virtual void OnConnectionLost() = 0;
   virtual void OnConnectionError(const std::string& message) = 0;
   virtual void OnTraversalError(TraversalClient::FailureReason error) = 0;
@@ -85,7 +94,7 @@ class NetPlayClient : public TraversalClientClient
 {
 public:
   void ThreadFunc();
-  void SendAsync(sf::Packet&& packet);
+  void SendAsync(sf::Packet&& packet, u8 channel_id = DEFAULT_CHANNEL);
 
   NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog,
                 const std::string& name, const NetTraversalConfig& traversal_config);
@@ -121,6 +130,7 @@ public:
   int LocalPadToInGamePad(int localPad) const;
 
   static void SendTimeBase();
+  static void ReadStartGameSettings(sf::Packet& packet, NetSettings* settings, u64* initial_rtc);
   bool DoAllPlayersHaveGame();
 
   const PadMappingArray& GetPadMapping() const;
@@ -144,6 +154,9 @@ public:
     return -1;
   }
 
+  // How long the CPU thread was blocked waiting for inputs of the pad in the current game
+  PadBuffer::WaitStats GetPadWaitStats(int ingame_pad) const;
+
   bool IsHostInputAuthority() const { return m_host_input_authority; }
   bool PollLocalPad(int local_pad, sf::Packet& packet);
 
@@ -164,13 +177,24 @@ protected:
     std::recursive_mutex async_queue_write;
   } m_crit;
 
-  Common::SPSCQueue<sf::Packet, false> m_async_queue;
+  Common::SPSCQueue<AsyncQueueEntry, false> m_async_queue;
 
-  std::array<Common::SPSCQueue<GCPadStatus>, 4> m_pad_buffer;
+  std::array<PadBuffer, 4> m_pad_buffer;
   std::array<Common::SPSCQueue<NetWiimote>, 4> m_wiimote_buffer;
 
+  std::array<PadReceiveState, 4> m_pad_receive;
+  u32 m_pad_receive_game = 0;
+  // Inputs of the local pads by in-game pad, also read when they are requested again
+  std::array<PadSendHistory, 4> m_pad_send_history;
+  std::mutex m_pad_send_history_lock;
+
   std::array<bool, 4> m_first_pad_status_received{};
 
+  // Only used for GameCube pads when rollback is enabled and inputs aren't decided by the host
+  RollbackController m_rollback;
+  AutoBufferController m_auto_buffer;
+  NetworkTelemetry m_telemetry;
+
   std::chrono::time_point<std::chrono::steady_clock> m_buffer_under_target_last;
 
   NetPlayUI* m_dialog = nullptr;
@@ -222,16 +246,21 @@ private:
   std::optional<std::vector<u8>> DecompressPacketIntoBuffer(sf::Packet& packet);
 
   void SendPadHostPoll(PadMapping pad_num);
+  void ResetPadReceiveIfNewGame();
+  void SendPadResendRequest(PadMapping map);
+  void RequestStalledPadData();
 
   void UpdateDevices();
-  void AddPadStateToPacket(int in_game_pad, const GCPadStatus& np, sf::Packet& packet);
   void SendWiimoteState(int in_game_pad, const NetWiimote& nw);
   unsigned int OnData(sf::Packet& packet);
-  void Send(const sf::Packet& packet);
+  void Send(const sf::Packet& packet, u8 channel_id = DEFAULT_CHANNEL);
   void Disconnect();
   bool Connect();
   void ComputeMD5(const std::string& file_identifier);
   void DisplayPlayersPing();
+  void LogPadWaitStats() const;
+  void UpdateAutoBuffer();
+  void UpdateFrameTelemetry();
   u32 GetPlayersMaxPing() const;
 
   bool m_is_connected = false;
@@ -246,7 +275,6 @@ private:
   TraversalClient* m_traversal_client = nullptr;
   std::thread m_MD5_thread;
   bool m_should_compute_MD5 = false;
-  Common::Event m_gc_pad_event;
   Common::Event m_wii_pad_event;
   Common::Event m_first_pad_status_received_event;
   u8 m_sync_save_data_count = 0;
@@ -254,6 +282,7 @@ private:
 
   u64 m_initial_rtc = 0;
   u32 m_timebase_frame = 0;
+  StateHasher m_state_hasher;
 };
 
 void NetPlay_Enable(NetPlayClient* const np);
@@ -0,0 +1,145 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlayPadBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Logging/Log.h"
+
+namespace NetPlay
+{
+bool PadBuffer::Push(const GCPadStatus& status, u32 index)
+{
+  const u32 write = m_write.load(std::memory_order_relaxed);
+  if (write - m_read.load(std::memory_order_acquire) == CAPACITY)
+    return false;
+
+  m_entries[write % CAPACITY] = {status, index};
+  m_write.store(write + 1, std::memory_order_release);
+
+  Notify();
+  return true;
+}
+
+u32 PadBuffer::Size() const
+{
+  return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_relaxed);
+}
+
+bool PadBuffer::Pop(GCPadStatus* status)
+{
+  const u32 read = m_read.load(std::memory_order_relaxed);
+  if (read == m_write.load(std::memory_order_acquire))
+    return false;
+
+  const Entry& entry = m_entries[read % CAPACITY];
+  *status = entry.status;
+  if (m_has_next_index && entry.index != m_next_index)
+    ERROR_LOG(NETPLAY, "Got pad input %u, expected input %u", entry.index, m_next_index);
+  m_next_index = entry.index + 1;
+  m_has_next_index = true;
+
+  m_read.store(read + 1, std::memory_order_release);
+  return true;
+}
+
+bool PadBuffer::WaitForInput(const Common::Flag& is_running)
+{
+  if (Size() != 0)
+    return true;
+
+  const auto start = std::chrono::steady_clock::now();
+  bool has_input = false;
+  while (true)
+  {
+    // Read before checking, so a push or interrupt in between ends the wait right away
+    const u32 signal = m_signal.load();
+    has_input = Size() != 0;
+    if (has_input || !is_running.IsSet())
+      break;
+
+    WaitForSignal(signal);
+  }
+
+  const u64 waited_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  m_waits.fetch_add(1, std::memory_order_relaxed);
+  m_wait_total_us.fetch_add(waited_us, std::memory_order_relaxed);
+  if (waited_us > m_wait_max_us.load(std::memory_order_relaxed))
+    m_wait_max_us.store(waited_us, std::memory_order_relaxed);
+
+  return has_input;
+}
+
+void PadBuffer::Clear()
+{
+  m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
+  m_has_next_index = false;
+}
+
+void PadBuffer::Interrupt()
+{
+  Notify();
+}
+
+PadBuffer::WaitStats PadBuffer::GetWaitStats() const
+{
+  WaitStats stats;
+  stats.waits = m_waits.load(std::memory_order_relaxed);
+  stats.total_us = m_wait_total_us.load(std::memory_order_relaxed);
+  stats.max_us = m_wait_max_us.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void PadBuffer::ResetWaitStats()
+{
+  m_waits.store(0, std::memory_order_relaxed);
+  m_wait_total_us.store(0, std::memory_order_relaxed);
+  m_wait_max_us.store(0, std::memory_order_relaxed);
+}
+
+void PadBuffer::Notify()
+{
+  m_signal.fetch_add(1);
+  if (m_sleeping.load() == 0)
+    return;
+
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<u32*>(&m_signal), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+          nullptr, 0);
+#else
+  {
+    // Makes sure the consumer is either waiting already or will see the new signal
+    std::lock_guard<std::mutex> lk(m_sleep_lock);
+  }
+  m_sleep_condvar.notify_all();
+#endif
+}
+
+void PadBuffer::WaitForSignal(u32 signal)
+{
+  m_sleeping.fetch_add(1);
+#ifdef __linux__
+  // Returns right away if the signal doesn't match anymore
+  syscall(SYS_futex, reinterpret_cast<u32*>(&m_signal), FUTEX_WAIT_PRIVATE, signal, nullptr,
+          nullptr, 0);
+#else
+  {
+    std::unique_lock<std::mutex> lk(m_sleep_lock);
+    m_sleep_condvar.wait(lk, [&] { return m_signal.load() != signal; });
+  }
+#endif
+  m_sleeping.fetch_sub(1);
+}
+}  // namespace NetPlay
@@ -0,0 +1,88 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#ifndef __linux__
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Common/Flag.h"
+#include "InputCommon/GCPadStatus.h"
+
+namespace NetPlay
+{
+// Bounded single producer, single consumer queue for the inputs of one GameCube pad. Inputs of
+// remote pads are pushed by the ---NETPLAY--- thread, those of local pads by the ---CPU---
+// thread, and all of them are popped by the ---CPU--- thread.
+//
+// No locks are taken while inputs keep coming. Once the buffer runs dry, the consumer sleeps on a
+// counter that every push bumps (with a futex on Linux and a condition variable elsewhere), and
+// producers only make a system call when the consumer is actually asleep.
+class PadBuffer
+{
+public:
+  struct WaitStats
+  {
+    u32 waits = 0;
+    u64 total_us = 0;
+    u64 max_us = 0;
+  };
+
+  // Called by the producer. Each input is stamped with its index, so the consumer can tell if
+  // any went missing. Returns false if the buffer is full.
+  bool Push(const GCPadStatus& status, u32 index);
+
+  // Called by the consumer
+  u32 Size() const;
+  bool Pop(GCPadStatus* status);
+  // Blocks until an input is available, unless is_running is cleared. Returns false then.
+  bool WaitForInput(const Common::Flag& is_running);
+  // Drops every input. Nothing may pop at the same time
+  void Clear();
+
+  // Wakes up the consumer so it checks is_running again
+  void Interrupt();
+
+  // How long the consumer was blocked in WaitForInput
+  WaitStats GetWaitStats() const;
+  void ResetWaitStats();
+
+private:
+  static constexpr u32 CAPACITY = 1024;
+
+  struct Entry
+  {
+    GCPadStatus status;
+    u32 index;
+  };
+
+  void Notify();
+  void WaitForSignal(u32 signal);
+
+  std::array<Entry, CAPACITY> m_entries{};
+  std::atomic<u32> m_write{0};
+  std::atomic<u32> m_read{0};
+
+  // Bumped by every push and interrupt, the consumer sleeps until it changes
+  std::atomic<u32> m_signal{0};
+  std::atomic<u32> m_sleeping{0};
+#ifndef __linux__
+  std::mutex m_sleep_lock;
+  std::condition_variable m_sleep_condvar;
+#endif
+
+  // Only used by the consumer
+  u32 m_next_index = 0;
+  bool m_has_next_index = false;
+
+  std::atomic<u32> m_waits{0};
+  std::atomic<u64> m_wait_total_us{0};
+  std::atomic<u64> m_wait_max_us{0};
+};
+}  // namespace NetPlay
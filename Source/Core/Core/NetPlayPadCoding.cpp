@@ -0,0 +1,220 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlayPadCoding.h"
+
+#include <algorithm>
+
+namespace NetPlay
+{
+// Enough to cover any gap that is noticed before the next few packets arrive
+static constexpr size_t MAX_SEND_HISTORY = 1024;
+static constexpr u32 MAX_RECORD_INPUTS = 255;
+static constexpr u32 MAX_RUN_LENGTH = 255;
+
+enum : u16
+{
+  PAD_FIELD_BUTTON = 1 << 0,
+  PAD_FIELD_STICK_X = 1 << 1,
+  PAD_FIELD_STICK_Y = 1 << 2,
+  PAD_FIELD_SUBSTICK_X = 1 << 3,
+  PAD_FIELD_SUBSTICK_Y = 1 << 4,
+  PAD_FIELD_TRIGGER_LEFT = 1 << 5,
+  PAD_FIELD_TRIGGER_RIGHT = 1 << 6,
+  PAD_FIELD_ANALOG_A = 1 << 7,
+  PAD_FIELD_ANALOG_B = 1 << 8,
+  PAD_FIELD_IS_CONNECTED = 1 << 9,
+  PAD_FIELD_RUN = 1 << 15,
+};
+
+static u16 GetChangedFields(const GCPadStatus& previous, const GCPadStatus& status)
+{
+  u16 mask = 0;
+  if (status.button != previous.button)
+    mask |= PAD_FIELD_BUTTON;
+  if (status.stickX != previous.stickX)
+    mask |= PAD_FIELD_STICK_X;
+  if (status.stickY != previous.stickY)
+    mask |= PAD_FIELD_STICK_Y;
+  if (status.substickX != previous.substickX)
+    mask |= PAD_FIELD_SUBSTICK_X;
+  if (status.substickY != previous.substickY)
+    mask |= PAD_FIELD_SUBSTICK_Y;
+  if (status.triggerLeft != previous.triggerLeft)
+    mask |= PAD_FIELD_TRIGGER_LEFT;
+  if (status.triggerRight != previous.triggerRight)
+    mask |= PAD_FIELD_TRIGGER_RIGHT;
+  if (status.analogA != previous.analogA)
+    mask |= PAD_FIELD_ANALOG_A;
+  if (status.analogB != previous.analogB)
+    mask |= PAD_FIELD_ANALOG_B;
+  if (status.isConnected != previous.isConnected)
+    mask |= PAD_FIELD_IS_CONNECTED;
+  return mask;
+}
+
+// The status all records are coded against. Default initialization leaves everything but
+// isConnected indeterminate
+static GCPadStatus GetReferenceStatus()
+{
+  GCPadStatus status{};
+  status.isConnected = false;
+  return status;
+}
+
+template <typename T>
+static void ReadField(sf::Packet& packet, u16 mask, u16 field, T& value)
+{
+  if (mask & field)
+    packet >> value;
+}
+
+bool ReadPadRecord(sf::Packet& packet, PadRecord* record)
+{
+  u8 count = 0;
+  if (!(packet >> record->first >> count))
+    return false;
+
+  record->inputs.clear();
+  record->inputs.reserve(count);
+
+  GCPadStatus status = GetReferenceStatus();
+  while (record->inputs.size() < count)
+  {
+    u16 mask = 0;
+    packet >> mask;
+
+    ReadField(packet, mask, PAD_FIELD_BUTTON, status.button);
+    ReadField(packet, mask, PAD_FIELD_STICK_X, status.stickX);
+    ReadField(packet, mask, PAD_FIELD_STICK_Y, status.stickY);
+    ReadField(packet, mask, PAD_FIELD_SUBSTICK_X, status.substickX);
+    ReadField(packet, mask, PAD_FIELD_SUBSTICK_Y, status.substickY);
+    ReadField(packet, mask, PAD_FIELD_TRIGGER_LEFT, status.triggerLeft);
+    ReadField(packet, mask, PAD_FIELD_TRIGGER_RIGHT, status.triggerRight);
+    ReadField(packet, mask, PAD_FIELD_ANALOG_A, status.analogA);
+    ReadField(packet, mask, PAD_FIELD_ANALOG_B, status.analogB);
+    ReadField(packet, mask, PAD_FIELD_IS_CONNECTED, status.isConnected);
+
+    u8 run = 1;
+    if (mask & PAD_FIELD_RUN)
+      packet >> run;
+
+    if (!packet || run == 0 || run > count - record->inputs.size())
+      return false;
+
+    record->inputs.insert(record->inputs.end(), run, status);
+  }
+
+  return true;
+}
+
+void PadSendHistory::Reset()
+{
+  m_inputs.clear();
+  m_base = 0;
+}
+
+void PadSendHistory::Push(const GCPadStatus& status)
+{
+  m_inputs.push_back(status);
+  if (m_inputs.size() > MAX_SEND_HISTORY)
+  {
+    m_inputs.pop_front();
+    m_base++;
+  }
+}
+
+u32 PadSendHistory::GetRedundantStart(u32 first) const
+{
+  return std::max(m_base, first - std::min(first, PAD_DATA_REDUNDANCY));
+}
+
+bool PadSendHistory::Encode(PadMapping pad, u32 first, sf::Packet& packet) const
+{
+  if (first < m_base || first > End())
+    return false;
+
+  u32 index = first;
+  while (index < End())
+  {
+    const u32 record_end = std::min(End(), index + MAX_RECORD_INPUTS);
+    packet << pad << index << static_cast<u8>(record_end - index);
+
+    GCPadStatus previous = GetReferenceStatus();
+    while (index < record_end)
+    {
+      const GCPadStatus& status = m_inputs[index - m_base];
+
+      u32 run = 1;
+      while (index + run < record_end && run < MAX_RUN_LENGTH &&
+             GetChangedFields(status, m_inputs[index + run - m_base]) == 0)
+      {
+        run++;
+      }
+
+      u16 mask = GetChangedFields(previous, status);
+      if (run > 1)
+        mask |= PAD_FIELD_RUN;
+
+      packet << mask;
+      if (mask & PAD_FIELD_BUTTON)
+        packet << status.button;
+      if (mask & PAD_FIELD_STICK_X)
+        packet << status.stickX;
+      if (mask & PAD_FIELD_STICK_Y)
+        packet << status.stickY;
+      if (mask & PAD_FIELD_SUBSTICK_X)
+        packet << status.substickX;
+      if (mask & PAD_FIELD_SUBSTICK_Y)
+        packet << status.substickY;
+      if (mask & PAD_FIELD_TRIGGER_LEFT)
+        packet << status.triggerLeft;
+      if (mask & PAD_FIELD_TRIGGER_RIGHT)
+        packet << status.triggerRight;
+      if (mask & PAD_FIELD_ANALOG_A)
+        packet << status.analogA;
+      if (mask & PAD_FIELD_ANALOG_B)
+        packet << status.analogB;
+      if (mask & PAD_FIELD_IS_CONNECTED)
+        packet << status.isConnected;
+      if (mask & PAD_FIELD_RUN)
+        packet << static_cast<u8>(run);
+
+      previous = status;
+      index += run;
+    }
+  }
+
+  return true;
+}
+
+void PadReceiveState::Reset()
+{
+  m_next = 0;
+  m_is_missing_inputs = false;
+  m_has_requested = false;
+  m_requested = 0;
+  m_progress_time_ms.reset();
+  m_progress_next = 0;
+}
+
+bool PadReceiveState::ShouldRequestResend(u64 now_ms)
+{
+  if (!m_progress_time_ms || m_next != m_progress_next)
+  {
+    m_progress_time_ms = now_ms;
+    m_progress_next = m_next;
+  }
+
+  const bool is_new_gap = m_is_missing_inputs && !(m_has_requested && m_requested == m_next);
+  const bool timed_out = now_ms - *m_progress_time_ms >= PAD_RESEND_TIMEOUT_MS;
+  if (!is_new_gap && !timed_out)
+    return false;
+
+  m_has_requested = true;
+  m_requested = m_next;
+  m_progress_time_ms = now_ms;
+  return true;
+}
+}  // namespace NetPlay
@@ -0,0 +1,110 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <SFML/Network/Packet.hpp>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/NetPlayProto.h"
+#include "InputCommon/GCPadStatus.h"
+
+namespace NetPlay
+{
+// GameCube pad data is sent as NP_MSG_PAD_DATA on PAD_DATA_CHANNEL, which is unreliable and
+// sequenced. After the u32 of the game it belongs to, the message holds one record per pad:
+//
+//   PadMapping pad, u32 index of the first input, u8 input count, inputs
+//
+// Every input starts with a u16 mask of the fields that differ from the previous input of the
+// record (the first one is compared to a zeroed status), followed by those fields. If
+// PAD_FIELD_RUN is set in the mask, a u8 follows with the number of times the input repeats.
+//
+// Records always repeat the last few inputs that were sent before, so a single lost packet is
+// covered by the next one. If more is lost, the receiver asks for the missing inputs with
+// NP_MSG_PAD_RESEND and they are sent again reliably on DEFAULT_CHANNEL. A lost packet is only
+// noticed once a later one arrives, which may never happen if it was the last one before the
+// sender waits for the receiver. So the receiver also asks again whenever no inputs arrived for
+// PAD_RESEND_TIMEOUT_MS, which covers lost requests as well.
+
+// Number of already sent inputs that are included again in every record
+constexpr u32 PAD_DATA_REDUNDANCY = 8;
+constexpr u32 PAD_RESEND_TIMEOUT_MS = 100;
+
+struct PadRecord
+{
+  u32 first = 0;
+  std::vector<GCPadStatus> inputs;
+};
+
+// Reads the rest of a record after its PadMapping. Returns false if the record is malformed
+bool ReadPadRecord(sf::Packet& packet, PadRecord* record);
+
+// Inputs sent for one pad, kept for redundancy and resends
+class PadSendHistory
+{
+public:
+  void Reset();
+  void Push(const GCPadStatus& status);
+
+  // Index the next input will get
+  u32 End() const { return m_base + static_cast<u32>(m_inputs.size()); }
+  // Where a record has to start to include the inputs from first on and the redundant ones
+  u32 GetRedundantStart(u32 first) const;
+
+  // Writes records for the inputs from first on. Returns false if those aren't kept anymore
+  bool Encode(PadMapping pad, u32 first, sf::Packet& packet) const;
+
+private:
+  std::deque<GCPadStatus> m_inputs;
+  u32 m_base = 0;
+};
+
+// Tracks which inputs of one pad have been received
+class PadReceiveState
+{
+public:
+  void Reset();
+  u32 Next() const { return m_next; }
+
+  // Calls add_input(status, index) for every input of the record that wasn't received before.
+  // Returns false if inputs before the record are missing.
+  template <typename Callback>
+  bool Receive(const PadRecord& record, Callback add_input)
+  {
+    if (record.first > m_next)
+    {
+      m_is_missing_inputs = true;
+      return false;
+    }
+
+    for (size_t i = m_next - record.first; i < record.inputs.size(); i++)
+    {
+      add_input(record.inputs[i], m_next);
+      m_next++;
+    }
+
+    m_is_missing_inputs = false;
+    return true;
+  }
+
+  // True when the inputs from Next() on should be requested: once for every gap in the received
+  // inputs, and whenever no new inputs were received for PAD_RESEND_TIMEOUT_MS since the last
+  // input or request.
+  bool ShouldRequestResend(u64 now_ms);
+
+private:
+  u32 m_next = 0;
+  bool m_is_missing_inputs = false;
+  bool m_has_requested = false;
+  u32 m_requested = 0;
+
+  // When m_next last changed or inputs were last requested
+  std::optional<u64> m_progress_time_ms;
+  u32 m_progress_next = 0;
+};
+}  // namespace NetPlay
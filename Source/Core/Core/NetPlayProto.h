@@ -77,6 +77,8 @@ struct NetSettings
   bool m_StrictSettingsSync;
   bool m_SyncSaveData;
   std::string m_SaveDataRegion;
+  std::string m_DesyncHashRegions;
+  u32 m_DesyncHashBytesPerFrame;
   bool m_IsHosting;
   bool m_HostInputAuthority;
 };
@@ -113,6 +115,7 @@ enum
   NP_MSG_MIN_PAD_BUFFER = 0x62,
   NP_MSG_PAD_HOST_POLL = 0x63,
   NP_MSG_PAD_FIRST_RECEIVED = 0x64,
+  NP_MSG_PAD_RESEND = 0x65,
 
   NP_MSG_WIIMOTE_DATA = 0x70,
   NP_MSG_WIIMOTE_MAPPING = 0x71,
@@ -145,6 +148,13 @@ enum
   NP_MSG_SYNC_SAVE_DATA = 0xF1,
 };
 
+enum : u8
+{
+  DEFAULT_CHANNEL,
+  // Unreliable and sequenced, only used for NP_MSG_PAD_DATA
+  PAD_DATA_CHANNEL,
+};
+
 enum
 {
   CON_ERR_SERVER_FULL = 1,
@@ -159,7 +169,8 @@ enum
   SYNC_SAVE_DATA_FAILURE = 2,
   SYNC_SAVE_DATA_RAW = 3,
   SYNC_SAVE_DATA_GCI = 4,
-  SYNC_SAVE_DATA_WII = 5
+  SYNC_SAVE_DATA_WII = 5,
+  SYNC_SAVE_DATA_BLOCK_HASHES = 6
 };
 
 constexpr u32 NETPLAY_LZO_IN_LEN = 1024 * 64;
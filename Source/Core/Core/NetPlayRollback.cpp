@@ -0,0 +1,367 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlayRollback.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/SystemTimers.h"
+#include "Core/HW/VideoInterface.h"
+#include "Core/State.h"
+#include "VideoCommon/OnScreenDisplay.h"
+
+namespace NetPlay
+{
+static const u32 OSD_UPDATE_INTERVAL_MS = 1000;
+
+static CoreTiming::EventType* s_frame_event;
+std::shared_ptr<RollbackController::SharedState> RollbackController::s_frame_state;
+
+static bool IsSamePadStatus(const GCPadStatus& a, const GCPadStatus& b)
+{
+  return a.button == b.button && a.stickX == b.stickX && a.stickY == b.stickY &&
+         a.substickX == b.substickX && a.substickY == b.substickY &&
+         a.triggerLeft == b.triggerLeft && a.triggerRight == b.triggerRight &&
+         a.analogA == b.analogA && a.analogB == b.analogB && a.isConnected == b.isConnected;
+}
+
+static GCPadStatus NeutralPadStatus()
+{
+  GCPadStatus status{};
+  status.stickX = GCPadStatus::MAIN_STICK_CENTER_X;
+  status.stickY = GCPadStatus::MAIN_STICK_CENTER_Y;
+  status.substickX = GCPadStatus::C_STICK_CENTER_X;
+  status.substickY = GCPadStatus::C_STICK_CENTER_Y;
+  return status;
+}
+
+void RollbackController::Init()
+{
+  s_frame_event = CoreTiming::RegisterEvent("NetPlayRollback", OnFrameBoundary);
+}
+
+void RollbackController::Reset(bool enabled, u32 max_frames)
+{
+  m_is_enabled = enabled;
+  m_state->generation.fetch_add(1);
+
+  // The suppressed output and the throttle are reset when emulation starts
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  m_state->max_frames = std::max<u32>(1, max_frames);
+  m_state->pads = {};
+  m_state->frame = 0;
+  m_state->resim_target = 0;
+  m_state->is_resimulating = false;
+  m_state->stats = {};
+  m_state->stats_window_start_ms = Common::Timer::GetTimeMs();
+
+  // The ring write protects emulated memory, so it has to be released with the CPU paused
+  if (m_state->ring)
+  {
+    Core::QueueHostJob(
+        [ring = std::move(m_state->ring)]() mutable {
+          Core::RunAsCPUThread([&] { ring.reset(); });
+        },
+        true);
+  }
+
+  // One more snapshot than frames, the newest one is usually from after the last confirmed input
+  m_state->snapshots.clear();
+  if (enabled)
+    m_state->ring = std::make_shared<State::SnapshotRing>(m_state->max_frames + 1);
+}
+
+void RollbackController::AddConfirmedInput(int pad, const GCPadStatus& status)
+{
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  PadHistory& history = m_state->pads[pad];
+
+  if (!history.predicted.empty())
+  {
+    // Inputs arrive in order, so the first mismatch is also the earliest one
+    if (!history.has_mispredicted && !IsSamePadStatus(history.predicted.front(), status))
+    {
+      history.has_mispredicted = true;
+      history.first_mispredicted = history.ConfirmedEnd();
+    }
+    history.predicted.pop_front();
+  }
+
+  history.confirmed.push_back(status);
+}
+
+bool RollbackController::CanPredict(int pad) const
+{
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  const PadHistory& history = m_state->pads[pad];
+
+  if (history.consumed < history.ConfirmedEnd())
+    return true;
+
+  if (history.consumed - history.ConfirmedEnd() >= m_state->max_frames)
+    return false;
+
+  // There has to be a snapshot to go back to in case the prediction is wrong
+  PollLimits limits = GetRestoreLimits(*m_state);
+  limits[pad] = std::min(limits[pad], history.ConfirmedEnd());
+  return FindSnapshot(*m_state, limits, -1) >= 0;
+}
+
+GCPadStatus RollbackController::GetInput(int pad)
+{
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  PadHistory& history = m_state->pads[pad];
+
+  const u64 index = history.consumed++;
+  if (index < history.ConfirmedEnd())
+    return history.confirmed[index - history.base];
+
+  // Most of the time a player keeps doing what they were doing
+  const GCPadStatus prediction =
+      history.confirmed.empty() ? NeutralPadStatus() : history.confirmed.back();
+  history.predicted.push_back(prediction);
+  return prediction;
+}
+
+void RollbackController::OnFrame()
+{
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  SharedState& state = *m_state;
+
+  state.frame++;
+
+  if (state.is_resimulating && state.frame >= state.resim_target)
+  {
+    state.is_resimulating = false;
+    state.stats.resim_us += Common::Timer::GetTimeUs() - state.resim_start_us;
+  }
+
+  // This is the same emulated time the rollback happened at, so the throttle continues as if the
+  // re-simulated frames had taken no time
+  if (state.is_output_suspended && !state.is_resimulating)
+  {
+    state.is_output_suspended = false;
+    VideoInterface::SetOutputSuppressed(false);
+    SystemTimers::ResumeThrottle();
+  }
+
+  // The pads of this frame are being polled from the VI callback, the event runs once that is
+  // done and nothing but CoreTiming itself is in the middle of something
+  s_frame_state = m_state;
+  CoreTiming::ScheduleEvent(0, s_frame_event, state.generation.load());
+
+  // Drop confirmed inputs that no snapshot can go back to anymore, but keep the newest one
+  // around to base predictions on
+  for (size_t pad = 0; pad < state.pads.size(); pad++)
+  {
+    PadHistory& history = state.pads[pad];
+    u64 needed = history.consumed;
+    for (const SnapshotInfo& snapshot : state.snapshots)
+      needed = std::min(needed, snapshot.consumed[pad]);
+
+    while (history.base < needed && history.confirmed.size() > 1)
+    {
+      history.confirmed.pop_front();
+      history.base++;
+    }
+  }
+
+  UpdateOSD(state);
+}
+
+bool RollbackController::IsResimulating() const
+{
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  return m_state->is_resimulating;
+}
+
+u32 RollbackController::BufferedInputs(int pad) const
+{
+  std::lock_guard<std::mutex> lk(m_state->lock);
+  const PadHistory& history = m_state->pads[pad];
+  return history.consumed < history.ConfirmedEnd() ?
+             static_cast<u32>(history.ConfirmedEnd() - history.consumed) :
+             0;
+}
+
+int RollbackController::FindSnapshot(const SharedState& state, const PollLimits& limits,
+                                     int excluded)
+{
+  int best = -1;
+  for (int i = 0; i < static_cast<int>(state.snapshots.size()); i++)
+  {
+    const SnapshotInfo& snapshot = state.snapshots[i];
+    if (i == excluded)
+      continue;
+
+    bool is_usable = true;
+    for (size_t pad = 0; pad < limits.size(); pad++)
+      is_usable = is_usable && snapshot.consumed[pad] <= limits[pad];
+
+    if (is_usable && (best < 0 || snapshot.frame > state.snapshots[best].frame))
+      best = i;
+  }
+
+  return best;
+}
+
+RollbackController::PollLimits RollbackController::GetRestoreLimits(const SharedState& state)
+{
+  PollLimits limits;
+  for (size_t pad = 0; pad < limits.size(); pad++)
+  {
+    const PadHistory& history = state.pads[pad];
+    if (history.has_mispredicted)
+      limits[pad] = history.first_mispredicted;
+    else if (!history.predicted.empty())
+      limits[pad] = history.ConfirmedEnd();
+    else
+      limits[pad] = std::numeric_limits<u64>::max();
+  }
+
+  return limits;
+}
+
+void RollbackController::OnFrameBoundary(u64 generation, s64 cycles_late)
+{
+  const std::shared_ptr<SharedState> shared = std::move(s_frame_state);
+  if (!shared || shared->generation.load() != generation)
+    return;
+
+  std::lock_guard<std::mutex> lk(shared->lock);
+  const bool has_mispredicted =
+      std::any_of(shared->pads.begin(), shared->pads.end(),
+                  [](const PadHistory& history) { return history.has_mispredicted; });
+
+  if (has_mispredicted)
+    RestoreSnapshot(*shared);
+  else
+    CaptureSnapshot(*shared);
+}
+
+void RollbackController::CaptureSnapshot(SharedState& state)
+{
+  if (!state.ring)
+    return;
+
+  // A full ring drops its oldest snapshot, which must not be the only one that can still undo an
+  // outstanding prediction
+  const bool is_full = state.snapshots.size() == state.ring->Capacity();
+  const PollLimits limits = GetRestoreLimits(state);
+  if (is_full && FindSnapshot(state, limits, -1) >= 0 && FindSnapshot(state, limits, 0) < 0)
+    return;
+
+  if (!state.ring->Save())
+    return;
+
+  if (is_full)
+    state.snapshots.pop_front();
+
+  SnapshotInfo snapshot;
+  snapshot.frame = state.frame;
+  for (size_t pad = 0; pad < state.pads.size(); pad++)
+    snapshot.consumed[pad] = state.pads[pad].consumed;
+  state.snapshots.push_back(snapshot);
+
+  state.stats.snapshot_count++;
+  state.stats.snapshot_us += state.ring->GetLastSaveTimeUs();
+}
+
+void RollbackController::RestoreSnapshot(SharedState& state)
+{
+  const u64 start = Common::Timer::GetTimeUs();
+  const int slot = state.ring ? FindSnapshot(state, GetRestoreLimits(state), -1) : -1;
+  if (slot < 0 || !state.ring->Restore(slot))
+  {
+    // CanPredict should make this impossible, but if it happens the game will desync
+    ERROR_LOG(NETPLAY, "Rollback: no snapshot old enough to correct a misprediction");
+    for (PadHistory& history : state.pads)
+      history.has_mispredicted = false;
+    return;
+  }
+
+  const SnapshotInfo snapshot = state.snapshots[slot];
+
+  // Everything newer was saved with the inputs that just turned out to be wrong, the ring dropped
+  // those as well
+  state.snapshots.resize(slot + 1);
+
+  const u64 depth = state.frame - snapshot.frame;
+  INFO_LOG(NETPLAY, "Rollback: restored frame %llu, %llu frames behind, %u pages in %llu us",
+           (unsigned long long)snapshot.frame, (unsigned long long)depth,
+           state.ring->GetLastPageCount(), (unsigned long long)state.ring->GetLastRestoreTimeUs());
+
+  state.stats.rollbacks++;
+  state.stats.total_depth += depth;
+  state.stats.max_depth = std::max(state.stats.max_depth, depth);
+  state.stats.resim_frames += depth;
+  state.stats.restore_us += state.ring->GetLastRestoreTimeUs();
+
+  // A rollback during re-simulation still has to catch up with the original frame
+  if (!state.is_resimulating)
+  {
+    state.resim_target = state.frame;
+    state.resim_start_us = start;
+  }
+  state.is_resimulating = true;
+  state.frame = snapshot.frame;
+
+  // The frames until then have been shown and paced already. The throttle still has the real time
+  // it reached before the restore, not the one that was just loaded with the state.
+  if (!state.is_output_suspended)
+  {
+    state.is_output_suspended = true;
+    VideoInterface::SetOutputSuppressed(true);
+    SystemTimers::SuspendThrottle();
+  }
+
+  for (size_t pad = 0; pad < state.pads.size(); pad++)
+  {
+    PadHistory& history = state.pads[pad];
+    history.consumed = snapshot.consumed[pad];
+    history.has_mispredicted = false;
+
+    // Predictions made before the snapshot are part of the restored state and still have to be
+    // checked, the later ones will be made again
+    const u64 confirmed_end = history.ConfirmedEnd();
+    if (history.consumed <= confirmed_end)
+      history.predicted.clear();
+    else
+      history.predicted.resize(history.consumed - confirmed_end);
+  }
+}
+
+void RollbackController::UpdateOSD(SharedState& state)
+{
+  const u32 now = Common::Timer::GetTimeMs();
+  if (now - state.stats_window_start_ms < OSD_UPDATE_INTERVAL_MS)
+    return;
+
+  const Stats& stats = state.stats;
+  const double average_depth =
+      stats.rollbacks ? static_cast<double>(stats.total_depth) / stats.rollbacks : 0.0;
+  const double resim_ms_per_frame =
+      stats.resim_frames ? stats.resim_us / 1000.0 / stats.resim_frames : 0.0;
+  const double snapshot_ms =
+      stats.snapshot_count ? stats.snapshot_us / 1000.0 / stats.snapshot_count : 0.0;
+  const double restore_ms = stats.rollbacks ? stats.restore_us / 1000.0 / stats.rollbacks : 0.0;
+
+  OSD::AddTypedMessage(
+      OSD::MessageType::NetPlayRollback,
+      StringFromFormat("Rollbacks: %u, depth avg %.1f max %llu, resim %.2f ms/frame, "
+                       "snapshot %.2f ms, restore %.2f ms",
+                       stats.rollbacks, average_depth, (unsigned long long)stats.max_depth,
+                       resim_ms_per_frame, snapshot_ms, restore_ms),
+      OSD_UPDATE_INTERVAL_MS + 500, OSD::Color::CYAN);
+
+  state.stats = {};
+  state.stats_window_start_ms = now;
+}
+}  // namespace NetPlay
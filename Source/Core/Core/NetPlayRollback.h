@@ -0,0 +1,132 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "Common/CommonTypes.h"
+#include "Core/SnapshotRing.h"
+#include "InputCommon/GCPadStatus.h"
+
+namespace NetPlay
+{
+// Optional rollback mode for GameCube pads. Instead of blocking the CPU thread until every
+// remote pad state for a poll has arrived, the last confirmed state of a pad is repeated as a
+// prediction. A State::SnapshotRing keeps snapshots of the last few frames, and once the real
+// input for a frame turns out to differ from what was predicted, the newest snapshot from before
+// that frame is restored and the game runs forward again unthrottled with the corrected inputs.
+//
+// Inputs are tracked per in-game pad as a count of polls, so the poll index of every pad is
+// stored alongside each snapshot and rewound with it. Snapshots are taken and restored on the CPU
+// thread from a CoreTiming event that runs right after the pads were polled for a frame, so the
+// VI and SI callbacks are never in the middle of something. Re-simulated fields are not
+// presented, and the throttle picks up where it was before the rollback once the game caught up.
+// The input history is shared with the network thread through Reset and guarded by a mutex.
+class RollbackController
+{
+public:
+  // Registers the CoreTiming event, called on the CPU thread when emulation starts
+  static void Init();
+
+  void Reset(bool enabled, u32 max_frames);
+  bool IsEnabled() const { return m_is_enabled; }
+
+  // All called on the CPU thread
+
+  // Authoritative input for the next unconfirmed poll of the pad, in the order they arrive
+  void AddConfirmedInput(int pad, const GCPadStatus& status);
+  // False once the pad is as far ahead of its confirmed inputs as snapshots reach back
+  bool CanPredict(int pad) const;
+  // Input for the next poll of the pad, confirmed if available and predicted otherwise
+  GCPadStatus GetInput(int pad);
+  // Called once per batched poll, before the pads are read
+  void OnFrame();
+  // While re-simulating, all local inputs are already known and must not be polled again
+  bool IsResimulating() const;
+  // Confirmed inputs of the pad that have not been used yet
+  u32 BufferedInputs(int pad) const;
+
+private:
+  struct PadHistory
+  {
+    // Confirmed inputs starting at poll index base
+    std::deque<GCPadStatus> confirmed;
+    u64 base = 0;
+    // Predictions for the polls following the confirmed ones
+    std::deque<GCPadStatus> predicted;
+    u64 consumed = 0;
+    bool has_mispredicted = false;
+    u64 first_mispredicted = 0;
+
+    u64 ConfirmedEnd() const { return base + confirmed.size(); }
+  };
+
+  struct SnapshotInfo
+  {
+    u64 frame = 0;
+    std::array<u64, 4> consumed{};
+  };
+
+  struct Stats
+  {
+    u32 rollbacks = 0;
+    u64 total_depth = 0;
+    u64 max_depth = 0;
+    u64 resim_frames = 0;
+    u64 resim_us = 0;
+    u64 snapshot_count = 0;
+    u64 snapshot_us = 0;
+    u64 restore_us = 0;
+  };
+
+  using PollLimits = std::array<u64, 4>;
+
+  // Shared with the ring release in Reset, which may still be queued after the game stopped
+  struct SharedState
+  {
+    std::mutex lock;
+    u32 max_frames = 0;
+    std::array<PadHistory, 4> pads;
+    std::shared_ptr<State::SnapshotRing> ring;
+    // Same order as the snapshots in the ring
+    std::deque<SnapshotInfo> snapshots;
+    u64 frame = 0;
+
+    // Set up by a restore, cleared by the CPU thread once the game caught up again
+    u64 resim_target = 0;
+    u64 resim_start_us = 0;
+    bool is_resimulating = false;
+    // Only used on the CPU thread, Reset leaves it alone so the output is always resumed
+    bool is_output_suspended = false;
+
+    Stats stats;
+    u32 stats_window_start_ms = 0;
+
+    // Bumped by Reset so events scheduled for a previous game are ignored
+    std::atomic<u32> generation{0};
+  };
+
+  // Newest snapshot taken before any of the pads reached its limit, or -1 if there is none
+  static int FindSnapshot(const SharedState& state, const PollLimits& limits, int excluded);
+  // Limits that a snapshot must respect to be able to undo every prediction made so far
+  static PollLimits GetRestoreLimits(const SharedState& state);
+
+  static void OnFrameBoundary(u64 generation, s64 cycles_late);
+  // Run with the lock held
+  static void CaptureSnapshot(SharedState& state);
+  static void RestoreSnapshot(SharedState& state);
+  static void UpdateOSD(SharedState& state);
+
+  // The state OnFrame scheduled the event for, only accessed on the CPU thread
+  static std::shared_ptr<SharedState> s_frame_state;
+
+  std::shared_ptr<SharedState> m_state = std::make_shared<SharedState>();
+  bool m_is_enabled = false;
+};
+}  // namespace NetPlay
@@ -0,0 +1,339 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlaySaveSync.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <thread>
+#include <lzo/lzo1x.h>
+#include <xxhash.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/MsgHandler.h"
+#include "Common/SFMLHelper.h"
+#include "Common/StringUtil.h"
+#include "Core/NetPlayProto.h"
+
+namespace NetPlay
+{
+// Runs task(i) for every i in [0, count), on as many threads as there are cores
+template <typename Task>
+static void RunInParallel(size_t count, const Task& task)
+{
+  const size_t thread_count =
+      std::min<size_t>(count, std::max(std::thread::hardware_concurrency(), 1u));
+
+  std::atomic<size_t> next{0};
+  const auto worker = [&] {
+    for (size_t i = next++; i < count; i = next++)
+      task(i);
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; i++)
+    threads.emplace_back(worker);
+
+  worker();
+
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+static size_t GetBlockCount(u64 size)
+{
+  return static_cast<size_t>((size + NETPLAY_LZO_IN_LEN - 1) / NETPLAY_LZO_IN_LEN);
+}
+
+static size_t GetBlockSize(u64 size, size_t block)
+{
+  return static_cast<size_t>(std::min<u64>(NETPLAY_LZO_IN_LEN, size - block * NETPLAY_LZO_IN_LEN));
+}
+
+static std::vector<u64> HashBlocks(const std::vector<u8>& data)
+{
+  std::vector<u64> hashes(GetBlockCount(data.size()));
+  for (size_t i = 0; i < hashes.size(); i++)
+    hashes[i] = XXH64(data.data() + i * NETPLAY_LZO_IN_LEN, GetBlockSize(data.size(), i), 0);
+  return hashes;
+}
+
+static std::string GetCachePath(const std::string& key)
+{
+  return File::GetUserPath(D_CACHE_IDX) + "NetPlaySaves" DIR_SEP +
+         StringFromFormat("%016" PRIx64, static_cast<u64>(XXH64(key.data(), key.size(), 0)));
+}
+
+static std::vector<u8> ReadCache(const std::string& key)
+{
+  std::string data;
+  if (!File::ReadFileToString(GetCachePath(key), data))
+    return {};
+
+  return std::vector<u8>(data.begin(), data.end());
+}
+
+static void WriteCache(const std::string& key, const std::vector<u8>& data)
+{
+  const std::string path = GetCachePath(key);
+  if (data.empty())
+  {
+    File::Delete(path);
+    return;
+  }
+
+  // Only costs a full transfer the next time if it fails, so it isn't reported
+  File::CreateFullPath(path);
+  File::IOFile file(path, "wb");
+  if (!file.WriteBytes(data.data(), data.size()))
+    WARN_LOG(NETPLAY, "Failed to cache save data in %s", path.c_str());
+}
+
+void WriteSaveBlockHashes(sf::Packet& packet, const SaveBlockHashes& hashes)
+{
+  packet << static_cast<u32>(hashes.size());
+  for (const auto& entry : hashes)
+  {
+    packet << entry.first << static_cast<u32>(entry.second.size());
+    for (u64 hash : entry.second)
+      packet << sf::Uint64{hash};
+  }
+}
+
+bool ReadSaveBlockHashes(sf::Packet& packet, SaveBlockHashes* hashes)
+{
+  u32 count;
+  packet >> count;
+  for (u32 i = 0; i < count && packet; i++)
+  {
+    std::string key;
+    u32 block_count;
+    packet >> key >> block_count;
+
+    std::vector<u64>& block_hashes = (*hashes)[key];
+    for (u32 j = 0; j < block_count && packet; j++)
+      block_hashes.push_back(Common::PacketReadU64(packet));
+  }
+
+  return static_cast<bool>(packet);
+}
+
+void SaveDataSender::BeginMessage()
+{
+  m_messages.emplace_back();
+  m_messages.back().parts.emplace_back();
+}
+
+bool SaveDataSender::AppendFile(const std::string& key, const std::string& path)
+{
+  File::IOFile file(path, "rb");
+  if (!file)
+  {
+    PanicAlertT("Failed to open file \"%s\".", path.c_str());
+    return false;
+  }
+
+  std::vector<u8> data(file.GetSize());
+  if (!file.ReadBytes(data.data(), data.size()))
+  {
+    PanicAlertT("Error reading file: %s", path.c_str());
+    return false;
+  }
+
+  AppendBuffer(key, std::move(data));
+  return true;
+}
+
+void SaveDataSender::AppendBuffer(const std::string& key, std::vector<u8> data)
+{
+  Blob blob;
+  blob.key = key;
+  blob.data = std::move(data);
+
+  Message& message = m_messages.back();
+  message.blobs.push_back(m_blobs.size());
+  message.parts.emplace_back();
+  m_blobs.push_back(std::move(blob));
+}
+
+bool SaveDataSender::Compress()
+{
+  // Blocks of all blobs are compressed together, as most saves are far smaller than a block
+  std::vector<std::pair<size_t, size_t>> blocks;
+  for (size_t i = 0; i < m_blobs.size(); i++)
+  {
+    Blob& blob = m_blobs[i];
+    blob.size = blob.data.size();
+    blob.hash = XXH64(blob.data.data(), blob.data.size(), 0);
+    blob.block_hashes = HashBlocks(blob.data);
+    blob.blocks.resize(blob.block_hashes.size());
+
+    for (size_t j = 0; j < blob.blocks.size(); j++)
+      blocks.emplace_back(i, j);
+  }
+
+  std::atomic<bool> success{true};
+  RunInParallel(blocks.size(), [&](size_t i) {
+    Blob& blob = m_blobs[blocks[i].first];
+    const size_t block = blocks[i].second;
+
+    std::vector<u8> wrkmem(LZO1X_1_MEM_COMPRESS);
+    std::vector<u8> out_buffer(NETPLAY_LZO_OUT_LEN);
+    lzo_uint out_len = 0;
+    if (lzo1x_1_compress(blob.data.data() + block * NETPLAY_LZO_IN_LEN,
+                         GetBlockSize(blob.data.size(), block), out_buffer.data(), &out_len,
+                         wrkmem.data()) != LZO_E_OK)
+    {
+      success = false;
+      return;
+    }
+
+    blob.blocks[block].assign(reinterpret_cast<const char*>(out_buffer.data()), out_len);
+  });
+
+  if (!success)
+  {
+    PanicAlertT("Internal LZO Error - compression failed");
+    return false;
+  }
+
+  for (Blob& blob : m_blobs)
+  {
+    INFO_LOG(NETPLAY, "Save data %s: %" PRIu64 " bytes in %zu blocks", blob.key.c_str(), blob.size,
+             blob.blocks.size());
+    blob.data = {};
+  }
+
+  return true;
+}
+
+std::vector<std::string> SaveDataSender::GetKeys() const
+{
+  std::vector<std::string> keys;
+  for (const Blob& blob : m_blobs)
+    keys.push_back(blob.key);
+  return keys;
+}
+
+std::vector<sf::Packet> SaveDataSender::BuildPackets(const SaveBlockHashes& known_hashes) const
+{
+  static const std::vector<u64> no_hashes;
+
+  std::vector<sf::Packet> packets;
+  for (const Message& message : m_messages)
+  {
+    sf::Packet packet;
+    for (size_t i = 0; i < message.parts.size(); i++)
+    {
+      const sf::Packet& part = message.parts[i];
+      packet.append(part.getData(), part.getDataSize());
+      if (i == message.blobs.size())
+        break;
+
+      const Blob& blob = m_blobs[message.blobs[i]];
+      const auto known = known_hashes.find(blob.key);
+      const std::vector<u64>& known_blocks =
+          known != known_hashes.end() ? known->second : no_hashes;
+
+      packet << blob.key << sf::Uint64{blob.size} << sf::Uint64{blob.hash};
+      for (size_t j = 0; j < blob.blocks.size(); j++)
+      {
+        const bool is_known = j < known_blocks.size() && known_blocks[j] == blob.block_hashes[j];
+        packet << (is_known ? std::string() : blob.blocks[j]);
+      }
+    }
+
+    packets.push_back(std::move(packet));
+  }
+
+  return packets;
+}
+
+SaveBlockHashes GetCachedSaveBlockHashes(const std::vector<std::string>& keys)
+{
+  SaveBlockHashes hashes;
+  for (const std::string& key : keys)
+  {
+    const std::vector<u8> data = ReadCache(key);
+    if (!data.empty())
+      hashes[key] = HashBlocks(data);
+  }
+  return hashes;
+}
+
+std::optional<std::vector<u8>> ReadSaveBlob(sf::Packet& packet)
+{
+  std::string key;
+  packet >> key;
+  const u64 size = Common::PacketReadU64(packet);
+  const u64 hash = Common::PacketReadU64(packet);
+
+  // Every block takes at least the four bytes of its length, which bounds the size before
+  // anything gets allocated for it
+  const size_t block_count = GetBlockCount(size);
+  if (!packet || block_count > packet.getDataSize() / sizeof(u32))
+  {
+    PanicAlertT("Received invalid save data");
+    return {};
+  }
+
+  std::vector<std::string> blocks(block_count);
+  for (std::string& block : blocks)
+    packet >> block;
+
+  if (!packet)
+  {
+    PanicAlertT("Received invalid save data");
+    return {};
+  }
+
+  std::vector<u8> data(size);
+  std::vector<u8> cached;
+  if (std::any_of(blocks.begin(), blocks.end(), [](const auto& block) { return block.empty(); }))
+    cached = ReadCache(key);
+
+  std::atomic<bool> decompressed{true};
+  RunInParallel(block_count, [&](size_t i) {
+    const size_t offset = i * NETPLAY_LZO_IN_LEN;
+    const size_t block_size = GetBlockSize(size, i);
+    const std::string& block = blocks[i];
+
+    if (block.empty())
+    {
+      // A cached copy that's too short is caught by the hash below
+      if (cached.size() >= offset + block_size)
+        std::copy_n(cached.begin() + offset, block_size, data.begin() + offset);
+      return;
+    }
+
+    lzo_uint new_len = block_size;
+    if (lzo1x_decompress_safe(reinterpret_cast<const u8*>(block.data()), block.size(),
+                              data.data() + offset, &new_len, nullptr) != LZO_E_OK ||
+        new_len != block_size)
+    {
+      decompressed = false;
+    }
+  });
+
+  if (!decompressed)
+  {
+    PanicAlertT("Internal LZO Error - decompression failed");
+    return {};
+  }
+
+  // Also catches a cached copy that changed since its hashes were sent
+  if (XXH64(data.data(), data.size(), 0) != hash)
+  {
+    PanicAlertT("Received invalid save data");
+    return {};
+  }
+
+  WriteCache(key, data);
+  return data;
+}
+}  // namespace NetPlay
@@ -0,0 +1,85 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <SFML/Network/Packet.hpp>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace NetPlay
+{
+// Save data is synced as blobs, each named by a key that doesn't depend on where the host or the
+// clients keep the data. A blob is split into blocks of NETPLAY_LZO_IN_LEN bytes which are
+// compressed separately, so both ends can work on them in parallel. On the wire a blob is
+//
+//   string key, u64 size, u64 XXH64 of the data, then for each block a string holding the
+//   compressed block, or an empty string if the client already has that block
+//
+// Clients keep a copy of the last data they received for every key. When the host announces a
+// sync with the list of keys, each client reports the XXH64 of every block of its copies, and only
+// gets sent the blocks that differ.
+
+// Block hashes of the cached copies by key
+using SaveBlockHashes = std::map<std::string, std::vector<u64>>;
+
+void WriteSaveBlockHashes(sf::Packet& packet, const SaveBlockHashes& hashes);
+bool ReadSaveBlockHashes(sf::Packet& packet, SaveBlockHashes* hashes);
+
+// Save data messages of the host, which get their blocks filled in for each client
+class SaveDataSender
+{
+public:
+  // Starts a new message. Everything written with operator<< or appended goes into it
+  void BeginMessage();
+
+  template <typename T>
+  SaveDataSender& operator<<(const T& value)
+  {
+    m_messages.back().parts.back() << value;
+    return *this;
+  }
+
+  bool AppendFile(const std::string& key, const std::string& path);
+  void AppendBuffer(const std::string& key, std::vector<u8> data);
+
+  // Compresses the blocks of all the appended data. Called once everything has been appended
+  bool Compress();
+
+  std::vector<std::string> GetKeys() const;
+  std::vector<sf::Packet> BuildPackets(const SaveBlockHashes& known_hashes) const;
+
+private:
+  struct Blob
+  {
+    std::string key;
+    std::vector<u8> data;
+    u64 size = 0;
+    u64 hash = 0;
+    std::vector<u64> block_hashes;
+    std::vector<std::string> blocks;
+  };
+
+  // Blobs go between the parts, so there's always one more part than there are blobs
+  struct Message
+  {
+    std::vector<sf::Packet> parts;
+    std::vector<size_t> blobs;
+  };
+
+  std::vector<Message> m_messages;
+  std::vector<Blob> m_blobs;
+};
+
+// Called on the client when the host announces a sync
+SaveBlockHashes GetCachedSaveBlockHashes(const std::vector<std::string>& keys);
+
+// Reads a blob written by SaveDataSender, taking the blocks that weren't sent from the cached copy.
+// The cached copy is then replaced by the result.
+std::optional<std::vector<u8>> ReadSaveBlob(sf::Packet& packet);
+}  // namespace NetPlay
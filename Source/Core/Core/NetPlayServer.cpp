@@ -17,7 +17,6 @@
 #include <unordered_set>
 #include <vector>
 
-#include <lzo/lzo1x.h>
 
 #include "Common/CommonPaths.h"
 #include "Common/ENetUtil.h"
@@ -27,6 +26,7 @@
 #include "Common/MsgHandler.h"
 #include "Common/SFMLHelper.h"
 #include "Common/StringUtil.h"
+#include "Common/Timer.h"
 #include "Common/UPnP.h"
 #include "Common/Version.h"
 #include "Core/Config/MainSettings.h"
@@ -39,6 +39,7 @@
 #include "Core/HW/WiiSaveStructs.h"
 #include "Core/IOS/FS/FileSystem.h"
 #include "Core/NetPlayClient.h"  //for NetPlayUI
+#include "Core/NetPlaySpectator.h"
 #include "DiscIO/Enums.h"
 #include "InputCommon/GCPadStatus.h"
 #include "UICommon/GameFile.h"
@@ -121,6 +122,19 @@ NetPlayServer::NetPlayServer(const u16 port, const bool forward_port,
   if (m_server != nullptr)
   {
     is_connected = true;
+
+    // Spectators get the session log records of every game, see NetPlaySpectator.h
+    if (const u16 spectator_port = Config::Get(Config::NETPLAY_SPECTATOR_PORT))
+    {
+      m_spectator_relay = std::make_unique<SpectatorRelay>(
+          spectator_port, Config::Get(Config::NETPLAY_SPECTATOR_MAX_VIEWERS),
+          Config::Get(Config::NETPLAY_SPECTATOR_DELAY));
+      if (m_spectator_relay->IsListening())
+        m_session_log.SetRelay(m_spectator_relay.get());
+      else
+        m_spectator_relay.reset();
+    }
+
     m_do_loop = true;
     m_thread = std::thread(&NetPlayServer::ThreadFunc, this);
 
@@ -150,11 +164,14 @@ void NetPlayServer::ThreadFunc()
       m_update_pings = false;
     }
 
+    RequestStalledPadData();
+
     ENetEvent netEvent;
     int net;
     if (m_traversal_client)
       m_traversal_client->HandleResends();
-    net = enet_host_service(m_server, &netEvent, 1000);
+    // Stalled pad data has to be noticed even when nothing else arrives
+    net = enet_host_service(m_server, &netEvent, m_is_running ? PAD_RESEND_TIMEOUT_MS : 1000);
     while (!m_async_queue.Empty())
     {
       {
@@ -397,6 +414,7 @@ unsigned int NetPlayServer::OnDisconnect(const Client& player)
       {
         std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
         m_is_running = false;
+        m_session_log.End();
 
         sf::Packet spac;
         spac << (MessageId)NP_MSG_DISABLE_GAME;
@@ -564,11 +582,17 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
   case NP_MSG_PAD_DATA:
   {
     // if this is pad data from the last game still being received, ignore it
-    if (player.current_game != m_current_game)
+    u32 game;
+    packet >> game;
+    if (player.current_game != m_current_game || game != m_current_game)
       break;
 
-    sf::Packet spac;
-    spac << static_cast<MessageId>(NP_MSG_PAD_DATA);
+    ResetPadDataIfNewGame();
+
+    // Inputs are sent on to the other clients starting at these, if any came in
+    std::array<u32, 4> first_new;
+    for (size_t i = 0; i < first_new.size(); i++)
+      first_new[i] = m_pad_history[i].End();
 
     while (!packet.endOfPacket())
     {
@@ -582,30 +606,82 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
         return 1;
       }
 
-      GCPadStatus pad;
-      packet >> pad.button >> pad.analogA >> pad.analogB >> pad.stickX >> pad.stickY >>
-          pad.substickX >> pad.substickY >> pad.triggerLeft >> pad.triggerRight >> pad.isConnected;
+      PadRecord record;
+      if (!ReadPadRecord(packet, &record))
+        return 1;
 
-      if (m_host_input_authority)
-      {
-        m_last_pad_status[map] = pad;
+      PadReceiveState& receive_state = m_pad_receive[map];
+      receive_state.Receive(record, [&](const GCPadStatus& pad, u32) {
+        if (m_host_input_authority)
+        {
+          m_last_pad_status[map] = pad;
 
-        if (!m_first_pad_status_received[map])
+          if (!m_first_pad_status_received[map])
+          {
+            m_first_pad_status_received[map] = true;
+            SendFirstReceivedToHost(map, true);
+          }
+        }
+        else
         {
-          m_first_pad_status_received[map] = true;
-          SendFirstReceivedToHost(map, true);
+          m_pad_history[map].Push(pad);
         }
-      }
-      else
+      });
+
+      if (receive_state.ShouldRequestResend(Common::Timer::GetTimeMs()))
+        SendPadResendRequest(player.socket, map);
+    }
+
+    if (!m_host_input_authority)
+    {
+      sf::Packet spac;
+      spac << static_cast<MessageId>(NP_MSG_PAD_DATA);
+      spac << m_current_game;
+
+      bool send_packet = false;
+      for (size_t i = 0; i < m_pad_history.size(); i++)
       {
-        spac << map << pad.button << pad.analogA << pad.analogB << pad.stickX << pad.stickY
-             << pad.substickX << pad.substickY << pad.triggerLeft << pad.triggerRight
-             << pad.isConnected;
+        const PadSendHistory& history = m_pad_history[i];
+        if (history.End() == first_new[i])
+          continue;
+
+        history.Encode(static_cast<PadMapping>(i), history.GetRedundantStart(first_new[i]), spac);
+        send_packet = true;
       }
+
+      if (send_packet)
+        SendToClients(spac, player.pid, PAD_DATA_CHANNEL);
+
+      m_session_log.LogInputs(m_pad_data_game, m_pad_history);
     }
+  }
+  break;
 
-    if (!m_host_input_authority)
-      SendToClients(spac, player.pid);
+  case NP_MSG_PAD_RESEND:
+  {
+    u32 game;
+    PadMapping map;
+    u32 first;
+    packet >> game >> map >> first;
+    if (game != m_current_game || map < 0 || map >= static_cast<PadMapping>(m_pad_map.size()))
+      break;
+
+    ResetPadDataIfNewGame();
+
+    // Requests after a timeout often find that nothing was lost
+    if (first == m_pad_history[map].End())
+      break;
+
+    sf::Packet spac;
+    spac << static_cast<MessageId>(NP_MSG_PAD_DATA);
+    spac << game;
+    if (!m_pad_history[map].Encode(map, first, spac))
+    {
+      ERROR_LOG(NETPLAY, "Pad %d inputs from %u requested again are no longer kept", map, first);
+      break;
+    }
+
+    Send(player.socket, spac);
   }
   break;
 
@@ -614,8 +690,17 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
     PadMapping pad_num;
     packet >> pad_num;
 
+    ResetPadDataIfNewGame();
+
     sf::Packet spac;
     spac << static_cast<MessageId>(NP_MSG_PAD_DATA);
+    spac << m_current_game;
+
+    const auto add_pad = [&](PadMapping map) {
+      PadSendHistory& history = m_pad_history[map];
+      history.Push(m_last_pad_status[map]);
+      history.Encode(map, history.GetRedundantStart(history.End() - 1), spac);
+    };
 
     if (pad_num < 0)
     {
@@ -624,21 +709,16 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
         if (m_pad_map[i] == -1)
           continue;
 
-        const GCPadStatus& pad = m_last_pad_status[i];
-        spac << static_cast<PadMapping>(i) << pad.button << pad.analogA << pad.analogB << pad.stickX
-             << pad.stickY << pad.substickX << pad.substickY << pad.triggerLeft << pad.triggerRight
-             << pad.isConnected;
+        add_pad(static_cast<PadMapping>(i));
       }
     }
     else if (m_pad_map.at(pad_num) != -1)
     {
-      const GCPadStatus& pad = m_last_pad_status[pad_num];
-      spac << pad_num << pad.button << pad.analogA << pad.analogB << pad.stickX << pad.stickY
-           << pad.substickX << pad.substickY << pad.triggerLeft << pad.triggerRight
-           << pad.isConnected;
+      add_pad(pad_num);
     }
 
-    SendToClients(spac);
+    SendToClients(spac, 0, PAD_DATA_CHANNEL);
+    m_session_log.LogInputs(m_pad_data_game, m_pad_history);
   }
   break;
 
@@ -706,6 +786,7 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
       break;
 
     m_is_running = false;
+    m_session_log.End();
 
     // tell clients to stop game
     sf::Packet spac;
@@ -744,44 +825,23 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
 
   case NP_MSG_TIMEBASE:
   {
-    u64 timebase = Common::PacketReadU64(packet);
+    FrameCheck check;
+    check.pid = player.pid;
+    check.timebase = Common::PacketReadU64(packet);
     u32 frame;
     packet >> frame;
+    packet >> check.state_hash.address >> check.state_hash.size;
+    check.state_hash.hash = Common::PacketReadU64(packet);
 
-    if (m_desync_detected)
-      break;
-
-    std::vector<std::pair<PlayerId, u64>>& timebases = m_timebase_by_frame[frame];
-    timebases.emplace_back(player.pid, timebase);
-    if (timebases.size() >= m_players.size())
+    std::vector<FrameCheck>& checks = m_timebase_by_frame[frame];
+    checks.push_back(check);
+    if (checks.size() >= m_players.size())
     {
       // we have all records for this frame
+      m_session_log.LogFrame(frame, checks);
+      if (!m_desync_detected)
+        CheckForDesync(frame, checks);
 
-      if (!std::all_of(timebases.begin(), timebases.end(), [&](std::pair<PlayerId, u64> pair) {
-            return pair.second == timebases[0].second;
-          }))
-      {
-        int pid_to_blame = -1;
-        for (auto pair : timebases)
-        {
-          if (std::all_of(timebases.begin(), timebases.end(), [&](std::pair<PlayerId, u64> other) {
-                return other.first == pair.first || other.second != pair.second;
-              }))
-          {
-            // we are the only outlier
-            pid_to_blame = pair.first;
-            break;
-          }
-        }
-
-        sf::Packet spac;
-        spac << (MessageId)NP_MSG_DESYNC_DETECTED;
-        spac << pid_to_blame;
-        spac << frame;
-        SendToClients(spac);
-
-        m_desync_detected = true;
-      }
       m_timebase_by_frame.erase(frame);
     }
   }
@@ -850,6 +910,21 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, Client& player)
     }
     break;
 
+    case SYNC_SAVE_DATA_BLOCK_HASHES:
+    {
+      SaveBlockHashes known_hashes;
+      if (!ReadSaveBlockHashes(packet, &known_hashes))
+        return 1;
+
+      std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
+      if (m_start_pending)
+      {
+        for (const sf::Packet& pac : m_save_data.BuildPackets(known_hashes))
+          Send(player.socket, pac);
+      }
+    }
+    break;
+
     case SYNC_SAVE_DATA_FAILURE:
     {
       m_dialog->AppendChat(
@@ -980,6 +1055,8 @@ bool NetPlayServer::StartGame()
 {
   m_timebase_by_frame.clear();
   m_desync_detected = false;
+  m_first_unverified_frame = 0;
+  m_first_unverified_frame_by_address.clear();
   std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
   m_current_game = Common::Timer::GetTimeMs();
 
@@ -994,67 +1071,89 @@ bool NetPlayServer::StartGame()
   const std::string region = SConfig::GetDirectoryForRegion(
       SConfig::ToGameCubeRegion(m_dialog->FindGameFile(m_selected_game)->GetRegion()));
 
+  // Everything that follows the game in NP_MSG_START_GAME, also stored in session logs
+  sf::Packet settings;
+  settings << m_settings.m_CPUthread;
+  settings << static_cast<std::underlying_type_t<PowerPC::CPUCore>>(m_settings.m_CPUcore);
+  settings << m_settings.m_EnableCheats;
+  settings << m_settings.m_SelectedLanguage;
+  settings << m_settings.m_OverrideGCLanguage;
+  settings << m_settings.m_ProgressiveScan;
+  settings << m_settings.m_PAL60;
+  settings << m_settings.m_DSPEnableJIT;
+  settings << m_settings.m_DSPHLE;
+  settings << m_settings.m_WriteToMemcard;
+  settings << m_settings.m_CopyWiiSave;
+  settings << m_settings.m_OCEnable;
+  settings << m_settings.m_OCFactor;
+  settings << m_settings.m_PollOnSIRead;
+  settings << m_settings.m_EXIDevice[0];
+  settings << m_settings.m_EXIDevice[1];
+  settings << m_settings.m_EFBAccessEnable;
+  settings << m_settings.m_BBoxEnable;
+  settings << m_settings.m_ForceProgressive;
+  settings << m_settings.m_EFBToTextureEnable;
+  settings << m_settings.m_XFBToTextureEnable;
+  settings << m_settings.m_DisableCopyToVRAM;
+  settings << m_settings.m_ImmediateXFBEnable;
+  settings << m_settings.m_EFBEmulateFormatChanges;
+  settings << m_settings.m_SafeTextureCacheColorSamples;
+  settings << m_settings.m_PerfQueriesEnable;
+  settings << m_settings.m_FPRF;
+  settings << m_settings.m_AccurateNaNs;
+  settings << m_settings.m_SyncOnSkipIdle;
+  settings << m_settings.m_SyncGPU;
+  settings << m_settings.m_SyncGpuMaxDistance;
+  settings << m_settings.m_SyncGpuMinDistance;
+  settings << m_settings.m_SyncGpuOverclock;
+  settings << m_settings.m_JITFollowBranch;
+  settings << m_settings.m_FastDiscSpeed;
+  settings << m_settings.m_MMU;
+  settings << m_settings.m_Fastmem;
+  settings << m_settings.m_SkipIPL;
+  settings << m_settings.m_LoadIPLDump;
+  settings << m_settings.m_VertexRounding;
+  settings << m_settings.m_InternalResolution;
+  settings << m_settings.m_EFBScaledCopy;
+  settings << m_settings.m_FastDepthCalc;
+  settings << m_settings.m_EnablePixelLighting;
+  settings << m_settings.m_WidescreenHack;
+  settings << m_settings.m_ForceFiltering;
+  settings << m_settings.m_MaxAnisotropy;
+  settings << m_settings.m_ForceTrueColor;
+  settings << m_settings.m_DisableCopyFilter;
+  settings << m_settings.m_DisableFog;
+  settings << m_settings.m_ArbitraryMipmapDetection;
+  settings << m_settings.m_ArbitraryMipmapDetectionThreshold;
+  settings << m_settings.m_EnableGPUTextureDecoding;
+  settings << m_settings.m_StrictSettingsSync;
+  settings << initial_rtc;
+  settings << m_settings.m_SyncSaveData;
+  settings << region;
+  settings << m_settings.m_DesyncHashRegions;
+  settings << m_settings.m_DesyncHashBytesPerFrame;
+
+  if (Config::Get(Config::NETPLAY_WRITE_SESSION_LOG))
+  {
+    const std::string path = File::GetUserPath(D_DUMP_IDX) + "NetPlay" DIR_SEP +
+                             StringFromFormat("Session_%" PRIu64 ".npsl",
+                                              Common::Timer::GetLocalTimeSinceJan1970());
+    m_session_log.Open(path, m_current_game, m_selected_game, m_pad_map, settings);
+  }
+  else if (m_spectator_relay)
+  {
+    m_session_log.Open("", m_current_game, m_selected_game, m_pad_map, settings);
+  }
+  else
+  {
+    m_session_log.Close();
+  }
+
   // tell clients to start game
   sf::Packet spac;
   spac << static_cast<MessageId>(NP_MSG_START_GAME);
   spac << m_current_game;
-  spac << m_settings.m_CPUthread;
-  spac << static_cast<std::underlying_type_t<PowerPC::CPUCore>>(m_settings.m_CPUcore);
-  spac << m_settings.m_EnableCheats;
-  spac << m_settings.m_SelectedLanguage;
-  spac << m_settings.m_OverrideGCLanguage;
-  spac << m_settings.m_ProgressiveScan;
-  spac << m_settings.m_PAL60;
-  spac << m_settings.m_DSPEnableJIT;
-  spac << m_settings.m_DSPHLE;
-  spac << m_settings.m_WriteToMemcard;
-  spac << m_settings.m_CopyWiiSave;
-  spac << m_settings.m_OCEnable;
-  spac << m_settings.m_OCFactor;
-  spac << m_settings.m_PollOnSIRead;
-  spac << m_settings.m_EXIDevice[0];
-  spac << m_settings.m_EXIDevice[1];
-  spac << m_settings.m_EFBAccessEnable;
-  spac << m_settings.m_BBoxEnable;
-  spac << m_settings.m_ForceProgressive;
-  spac << m_settings.m_EFBToTextureEnable;
-  spac << m_settings.m_XFBToTextureEnable;
-  spac << m_settings.m_DisableCopyToVRAM;
-  spac << m_settings.m_ImmediateXFBEnable;
-  spac << m_settings.m_EFBEmulateFormatChanges;
-  spac << m_settings.m_SafeTextureCacheColorSamples;
-  spac << m_settings.m_PerfQueriesEnable;
-  spac << m_settings.m_FPRF;
-  spac << m_settings.m_AccurateNaNs;
-  spac << m_settings.m_SyncOnSkipIdle;
-  spac << m_settings.m_SyncGPU;
-  spac << m_settings.m_SyncGpuMaxDistance;
-  spac << m_settings.m_SyncGpuMinDistance;
-  spac << m_settings.m_SyncGpuOverclock;
-  spac << m_settings.m_JITFollowBranch;
-  spac << m_settings.m_FastDiscSpeed;
-  spac << m_settings.m_MMU;
-  spac << m_settings.m_Fastmem;
-  spac << m_settings.m_SkipIPL;
-  spac << m_settings.m_LoadIPLDump;
-  spac << m_settings.m_VertexRounding;
-  spac << m_settings.m_InternalResolution;
-  spac << m_settings.m_EFBScaledCopy;
-  spac << m_settings.m_FastDepthCalc;
-  spac << m_settings.m_EnablePixelLighting;
-  spac << m_settings.m_WidescreenHack;
-  spac << m_settings.m_ForceFiltering;
-  spac << m_settings.m_MaxAnisotropy;
-  spac << m_settings.m_ForceTrueColor;
-  spac << m_settings.m_DisableCopyFilter;
-  spac << m_settings.m_DisableFog;
-  spac << m_settings.m_ArbitraryMipmapDetection;
-  spac << m_settings.m_ArbitraryMipmapDetectionThreshold;
-  spac << m_settings.m_EnableGPUTextureDecoding;
-  spac << m_settings.m_StrictSettingsSync;
-  spac << initial_rtc;
-  spac << m_settings.m_SyncSaveData;
-  spac << region;
+  spac.append(settings.getData(), settings.getDataSize());
 
   SendAsyncToClients(std::move(spac));
 
@@ -1096,20 +1195,35 @@ bool NetPlayServer::SyncSaveData()
     save_count++;
   }
 
-  {
-    sf::Packet pac;
-    pac << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
-    pac << static_cast<MessageId>(SYNC_SAVE_DATA_NOTIFY);
-    pac << save_count;
+  SaveDataSender save_data;
+  if (save_count != 0 && !PrepareSaveData(*game, wii_save, &save_data))
+    return false;
 
-    SendAsyncToClients(std::move(pac));
+  const std::vector<std::string> keys = save_data.GetKeys();
+  {
+    std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
+    m_save_data = std::move(save_data);
   }
 
-  if (save_count == 0)
-    return true;
+  // Clients answer with the hashes of their cached copies, see NetPlaySaveSync.h
+  sf::Packet pac;
+  pac << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
+  pac << static_cast<MessageId>(SYNC_SAVE_DATA_NOTIFY);
+  pac << save_count;
+  pac << static_cast<u32>(keys.size());
+  for (const std::string& key : keys)
+    pac << key;
+
+  SendAsyncToClients(std::move(pac));
+  return true;
+}
 
+bool NetPlayServer::PrepareSaveData(const UICommon::GameFile& game, bool wii_save,
+                                    SaveDataSender* save_data)
+{
+  constexpr size_t exi_device_count = 2;
   const std::string region =
-      SConfig::GetDirectoryForRegion(SConfig::ToGameCubeRegion(game->GetRegion()));
+      SConfig::GetDirectoryForRegion(SConfig::ToGameCubeRegion(game.GetRegion()));
 
   for (size_t i = 0; i < exi_device_count; i++)
   {
@@ -1123,29 +1237,29 @@ bool NetPlayServer::SyncSaveData()
       MemoryCard::CheckPath(path, region, is_slot_a);
 
       bool mc251;
-      IniFile gameIni = SConfig::LoadGameIni(game->GetGameID(), game->GetRevision());
+      IniFile gameIni = SConfig::LoadGameIni(game.GetGameID(), game.GetRevision());
       gameIni.GetOrCreateSection("Core")->Get("MemoryCard251", &mc251, false);
 
       if (mc251)
         path.insert(path.find_last_of('.'), ".251");
 
-      sf::Packet pac;
-      pac << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
-      pac << static_cast<MessageId>(SYNC_SAVE_DATA_RAW);
-      pac << is_slot_a << region << mc251;
+      save_data->BeginMessage();
+      *save_data << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
+      *save_data << static_cast<MessageId>(SYNC_SAVE_DATA_RAW);
+      *save_data << is_slot_a << region << mc251;
 
+      const std::string key =
+          "GC/" + region + (is_slot_a ? "/A" : "/B") + (mc251 ? ".251" : "") + ".raw";
       if (File::Exists(path))
       {
-        if (!CompressFileIntoPacket(path, pac))
+        if (!save_data->AppendFile(key, path))
           return false;
       }
       else
       {
         // No file, so we'll say the size is 0
-        pac << sf::Uint64{0};
+        save_data->AppendBuffer(key, {});
       }
-
-      SendAsyncToClients(std::move(pac));
     }
     else if (SConfig::GetInstance().m_EXIDevice[i] ==
              ExpansionInterface::EXIDEVICE_MEMORYCARDFOLDER)
@@ -1153,40 +1267,43 @@ bool NetPlayServer::SyncSaveData()
       const std::string path = File::GetUserPath(D_GCUSER_IDX) + region + DIR_SEP +
                                StringFromFormat("Card %c", is_slot_a ? 'A' : 'B');
 
-      sf::Packet pac;
-      pac << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
-      pac << static_cast<MessageId>(SYNC_SAVE_DATA_GCI);
-      pac << is_slot_a;
+      save_data->BeginMessage();
+      *save_data << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
+      *save_data << static_cast<MessageId>(SYNC_SAVE_DATA_GCI);
+      *save_data << is_slot_a;
 
       if (File::IsDirectory(path))
       {
         std::vector<std::string> files =
-            GCMemcardDirectory::GetFileNamesForGameID(path + DIR_SEP, game->GetGameID());
+            GCMemcardDirectory::GetFileNamesForGameID(path + DIR_SEP, game.GetGameID());
 
-        pac << static_cast<u8>(files.size());
+        *save_data << static_cast<u8>(files.size());
 
         for (const std::string& file : files)
         {
-          pac << file.substr(file.find_last_of('/') + 1);
-          if (!CompressFileIntoPacket(file, pac))
+          const std::string file_name = file.substr(file.find_last_of('/') + 1);
+          *save_data << file_name;
+          if (!save_data->AppendFile(
+                  "GCI/" + region + (is_slot_a ? "/A/" : "/B/") + file_name, file))
+          {
             return false;
+          }
         }
       }
       else
       {
-        pac << static_cast<u8>(0);
+        *save_data << static_cast<u8>(0);
       }
-
-      SendAsyncToClients(std::move(pac));
     }
   }
 
   if (wii_save)
   {
     const auto configured_fs = IOS::HLE::FS::MakeFileSystem(IOS::HLE::FS::Location::Configured);
-    const auto save = WiiSave::MakeNandStorage(configured_fs.get(), game->GetTitleID());
+    const auto save = WiiSave::MakeNandStorage(configured_fs.get(), game.GetTitleID());
 
-    sf::Packet pac;
+    save_data->BeginMessage();
+    SaveDataSender& pac = *save_data;
     pac << static_cast<MessageId>(NP_MSG_SYNC_SAVE_DATA);
     pac << static_cast<MessageId>(SYNC_SAVE_DATA_WII);
 
@@ -1227,8 +1344,11 @@ bool NetPlayServer::SyncSaveData()
         if (file.type == WiiSave::Storage::SaveFile::Type::File)
         {
           const std::optional<std::vector<u8>>& data = *file.data;
-          if (!data || !CompressBufferIntoPacket(*data, pac))
+          if (!data)
             return false;
+
+          pac.AppendBuffer(StringFromFormat("Wii/%016" PRIx64, game.GetTitleID()) + file.path,
+                           *data);
         }
       }
     }
@@ -1236,173 +1356,166 @@ bool NetPlayServer::SyncSaveData()
     {
       pac << false;  // save does not exist
     }
-
-    SendAsyncToClients(std::move(pac));
   }
 
-  return true;
+  return save_data->Compress();
 }
 
-bool NetPlayServer::CompressFileIntoPacket(const std::string& file_path, sf::Packet& packet)
+void NetPlayServer::SendFirstReceivedToHost(const PadMapping map, const bool state)
 {
-  File::IOFile file(file_path, "rb");
-  if (!file)
-  {
-    PanicAlertT("Failed to open file \"%s\".", file_path.c_str());
-    return false;
-  }
+  sf::Packet pac;
+  pac << static_cast<MessageId>(NP_MSG_PAD_FIRST_RECEIVED);
+  pac << map;
+  pac << state;
+  Send(m_players.at(1).socket, pac);
+}
 
-  const sf::Uint64 size = file.GetSize();
-  packet << size;
+u64 NetPlayServer::GetInitialNetPlayRTC() const
+{
+  const auto& config = SConfig::GetInstance();
 
-  if (size == 0)
-    return true;
+  if (config.bEnableCustomRTC)
+    return config.m_customRTCValue;
 
-  std::vector<u8> in_buffer(NETPLAY_LZO_IN_LEN);
-  std::vector<u8> out_buffer(NETPLAY_LZO_OUT_LEN);
-  std::vector<u8> wrkmem(LZO1X_1_MEM_COMPRESS);
+  return Common::Timer::GetLocalTimeSinceJan1970();
+}
 
-  lzo_uint i = 0;
-  while (true)
+// called from multiple threads
+void NetPlayServer::SendToClients(const sf::Packet& packet, const PlayerId skip_pid,
+                                  const u8 channel_id)
+{
+  for (auto& p : m_players)
   {
-    lzo_uint32 cur_len = 0;  // number of bytes to read
-    lzo_uint out_len = 0;    // number of bytes to write
-
-    if ((i + NETPLAY_LZO_IN_LEN) >= size)
-    {
-      cur_len = static_cast<lzo_uint32>(size - i);
-    }
-    else
-    {
-      cur_len = NETPLAY_LZO_IN_LEN;
-    }
-
-    if (cur_len <= 0)
-      break;  // EOF
-
-    if (!file.ReadBytes(in_buffer.data(), cur_len))
-    {
-      PanicAlertT("Error reading file: %s", file_path.c_str());
-      return false;
-    }
-
-    if (lzo1x_1_compress(in_buffer.data(), cur_len, out_buffer.data(), &out_len, wrkmem.data()) !=
-        LZO_E_OK)
-    {
-      PanicAlertT("Internal LZO Error - compression failed");
-      return false;
-    }
-
-    // The size of the data to write is 'out_len'
-    packet << static_cast<u32>(out_len);
-    for (size_t j = 0; j < out_len; j++)
+    if (p.second.pid && p.second.pid != skip_pid)
     {
-      packet << out_buffer[j];
+      Send(p.second.socket, packet, channel_id);
     }
-
-    if (cur_len != NETPLAY_LZO_IN_LEN)
-      break;
-
-    i += cur_len;
   }
-
-  // Mark end of data
-  packet << static_cast<u32>(0);
-
-  return true;
 }
 
-bool NetPlayServer::CompressBufferIntoPacket(const std::vector<u8>& in_buffer, sf::Packet& packet)
+void NetPlayServer::Send(ENetPeer* socket, const sf::Packet& packet, u8 channel_id)
 {
-  const sf::Uint64 size = in_buffer.size();
-  packet << size;
-
-  if (size == 0)
-    return true;
-
-  std::vector<u8> out_buffer(NETPLAY_LZO_OUT_LEN);
-  std::vector<u8> wrkmem(LZO1X_1_MEM_COMPRESS);
+  // Peers that only negotiated the default channel get everything on it, reliably
+  if (channel_id >= socket->channelCount)
+    channel_id = DEFAULT_CHANNEL;
+
+  const u32 flags = channel_id == PAD_DATA_CHANNEL ? 0 : ENET_PACKET_FLAG_RELIABLE;
+  ENetPacket* epac = enet_packet_create(packet.getData(), packet.getDataSize(), flags);
+  if (enet_peer_send(socket, channel_id, epac) < 0)
+    enet_packet_destroy(epac);
+}
 
-  lzo_uint i = 0;
-  while (true)
+// Called from ---NETPLAY--- thread once every player reported the frame
+void NetPlayServer::CheckForDesync(u32 frame, const std::vector<FrameCheck>& checks)
+{
+  // The memory can only be compared if everyone hashed the same slice of it
+  const StateHashSlice& first_hash = checks[0].state_hash;
+  const bool compare_memory =
+      first_hash.size != 0 &&
+      std::all_of(checks.begin(), checks.end(), [&](const FrameCheck& other) {
+        return other.state_hash.address == first_hash.address &&
+               other.state_hash.size == first_hash.size;
+      });
+  const auto matches = [&](const FrameCheck& a, const FrameCheck& b) {
+    return a.timebase == b.timebase && (!compare_memory || a.state_hash.hash == b.state_hash.hash);
+  };
+
+  if (std::all_of(checks.begin(), checks.end(),
+                  [&](const FrameCheck& other) { return matches(other, checks[0]); }))
   {
-    lzo_uint32 cur_len = 0;  // number of bytes to read
-    lzo_uint out_len = 0;    // number of bytes to write
-
-    if ((i + NETPLAY_LZO_IN_LEN) >= size)
-    {
-      cur_len = static_cast<lzo_uint32>(size - i);
-    }
-    else
-    {
-      cur_len = NETPLAY_LZO_IN_LEN;
-    }
-
-    if (cur_len <= 0)
-      break;  // end of buffer
-
-    if (lzo1x_1_compress(&in_buffer[i], cur_len, out_buffer.data(), &out_len, wrkmem.data()) !=
-        LZO_E_OK)
+    m_first_unverified_frame = frame + 1;
+    if (compare_memory)
+      m_first_unverified_frame_by_address[first_hash.address] = frame + 1;
+  }
+  else
+  {
+    int pid_to_blame = -1;
+    for (const FrameCheck& candidate : checks)
     {
-      PanicAlertT("Internal LZO Error - compression failed");
-      return false;
+      if (std::all_of(checks.begin(), checks.end(), [&](const FrameCheck& other) {
+            return other.pid == candidate.pid || !matches(other, candidate);
+          }))
+      {
+        // we are the only outlier
+        pid_to_blame = candidate.pid;
+        break;
+      }
     }
 
-    // The size of the data to write is 'out_len'
-    packet << static_cast<u32>(out_len);
-    for (size_t j = 0; j < out_len; j++)
+    // Point at the memory if that's what differs rather than only the timebase. Each slice is
+    // only hashed once per pass over the regions, so the players' memory may have diverged at
+    // any frame since this slice last matched, not necessarily at this one.
+    const bool memory_differs =
+        compare_memory &&
+        std::any_of(checks.begin(), checks.end(), [&](const FrameCheck& other) {
+          return other.state_hash.hash != first_hash.hash;
+        });
+    const u32 memory_address = memory_differs ? first_hash.address : 0;
+    const u32 memory_size = memory_differs ? first_hash.size : 0;
+
+    u32 first_frame = m_first_unverified_frame;
+    if (memory_differs)
     {
-      packet << out_buffer[j];
+      const auto it = m_first_unverified_frame_by_address.find(first_hash.address);
+      first_frame = it != m_first_unverified_frame_by_address.end() ? it->second : 0;
     }
 
-    if (cur_len != NETPLAY_LZO_IN_LEN)
-      break;
+    sf::Packet spac;
+    spac << (MessageId)NP_MSG_DESYNC_DETECTED;
+    spac << pid_to_blame;
+    spac << first_frame << frame;
+    spac << memory_address << memory_size;
+    SendToClients(spac);
 
-    i += cur_len;
+    m_desync_detected = true;
   }
-
-  // Mark end of data
-  packet << static_cast<u32>(0);
-
-  return true;
 }
 
-void NetPlayServer::SendFirstReceivedToHost(const PadMapping map, const bool state)
+// Pad data is only handled on the ---NETPLAY--- thread, so it is reset there once the first
+// message of a new game comes in
+void NetPlayServer::SendPadResendRequest(ENetPeer* socket, PadMapping map)
 {
-  sf::Packet pac;
-  pac << static_cast<MessageId>(NP_MSG_PAD_FIRST_RECEIVED);
-  pac << map;
-  pac << state;
-  Send(m_players.at(1).socket, pac);
+  sf::Packet spac;
+  spac << static_cast<MessageId>(NP_MSG_PAD_RESEND);
+  spac << m_current_game << map << m_pad_receive[map].Next();
+  Send(socket, spac);
 }
 
-u64 NetPlayServer::GetInitialNetPlayRTC() const
+// Asks again for the inputs of pads that haven't sent any for a while. The last packet before a
+// client waits for the others may have been lost, and nothing would arrive after it to show that.
+void NetPlayServer::RequestStalledPadData()
 {
-  const auto& config = SConfig::GetInstance();
+  std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
+  if (!m_is_running)
+    return;
 
-  if (config.bEnableCustomRTC)
-    return config.m_customRTCValue;
+  ResetPadDataIfNewGame();
 
-  return Common::Timer::GetLocalTimeSinceJan1970();
-}
-
-// called from multiple threads
-void NetPlayServer::SendToClients(const sf::Packet& packet, const PlayerId skip_pid)
-{
-  for (auto& p : m_players)
+  const u64 now = Common::Timer::GetTimeMs();
+  for (size_t i = 0; i < m_pad_map.size(); i++)
   {
-    if (p.second.pid && p.second.pid != skip_pid)
-    {
-      Send(p.second.socket, packet);
-    }
+    if (m_pad_map[i] <= 0)
+      continue;
+
+    auto player = m_players.find(m_pad_map[i]);
+    if (player == m_players.end() || player->second.current_game != m_current_game)
+      continue;
+
+    if (m_pad_receive[i].ShouldRequestResend(now))
+      SendPadResendRequest(player->second.socket, static_cast<PadMapping>(i));
   }
 }
 
-void NetPlayServer::Send(ENetPeer* socket, const sf::Packet& packet)
+void NetPlayServer::ResetPadDataIfNewGame()
 {
-  ENetPacket* epac =
-      enet_packet_create(packet.getData(), packet.getDataSize(), ENET_PACKET_FLAG_RELIABLE);
-  enet_peer_send(socket, 0, epac);
+  if (m_pad_data_game == m_current_game)
+    return;
+
+  for (PadReceiveState& receive_state : m_pad_receive)
+    receive_state.Reset();
+  for (PadSendHistory& history : m_pad_history)
+    history.Reset();
+  m_pad_data_game = m_current_game;
 }
 
 void NetPlayServer::KickPlayer(PlayerId player)
@@ -17,12 +17,22 @@
 #include "Common/SPSCQueue.h"
 #include "Common/Timer.h"
 #include "Common/TraversalClient.h"
+#include "Core/NetPlayPadCoding.h"
 #include "Core/NetPlayProto.h"
+#include "Core/NetPlaySaveSync.h"
+#include "Core/NetPlaySessionLog.h"
+#include "Core/NetPlayStateHash.h"
 #include "InputCommon/GCPadStatus.h"
 
+namespace UICommon
+{
+class GameFile;
+}
+
 namespace NetPlay
 {
 class NetPlayUI;
+class SpectatorRelay;
 enum class PlayerGameStatus;
 
 class NetPlayServer : public TraversalClientClient
@@ -97,14 +107,18 @@ public:
 
 private:
   bool SyncSaveData();
-  bool CompressFileIntoPacket(const std::string& file_path, sf::Packet& packet);
-  bool CompressBufferIntoPacket(const std::vector<u8>& in_buffer, sf::Packet& packet);
+  bool PrepareSaveData(const UICommon::GameFile& game, bool wii_save, SaveDataSender* save_data);
   void SendFirstReceivedToHost(PadMapping map, bool state);
 
   u64 GetInitialNetPlayRTC() const;
 
-  void SendToClients(const sf::Packet& packet, const PlayerId skip_pid = 0);
-  void Send(ENetPeer* socket, const sf::Packet& packet);
+  void SendToClients(const sf::Packet& packet, const PlayerId skip_pid = 0,
+                     u8 channel_id = DEFAULT_CHANNEL);
+  void Send(ENetPeer* socket, const sf::Packet& packet, u8 channel_id = DEFAULT_CHANNEL);
+  void ResetPadDataIfNewGame();
+  void SendPadResendRequest(ENetPeer* socket, PadMapping map);
+  void RequestStalledPadData();
+  void CheckForDesync(u32 frame, const std::vector<FrameCheck>& checks);
   unsigned int OnConnect(ENetPeer* socket);
   unsigned int OnDisconnect(const Client& player);
   unsigned int OnData(sf::Packet& packet, Client& player);
@@ -128,17 +142,31 @@ private:
   PadMappingArray m_pad_map;
   PadMappingArray m_wiimote_map;
   unsigned int m_save_data_synced_players = 0;
+  SaveDataSender m_save_data;
   bool m_start_pending = false;
   bool m_host_input_authority = false;
 
   std::map<PlayerId, Client> m_players;
 
-  std::unordered_map<u32, std::vector<std::pair<PlayerId, u64>>> m_timebase_by_frame;
+  std::unordered_map<u32, std::vector<FrameCheck>> m_timebase_by_frame;
   bool m_desync_detected;
+  // Every frame before these was reported the same by all players, for the timebase and for the
+  // memory hashed at each address. A difference found later arose at or after that frame.
+  u32 m_first_unverified_frame = 0;
+  std::unordered_map<u32, u32> m_first_unverified_frame_by_address;
 
   std::array<GCPadStatus, 4> m_last_pad_status{};
   std::array<bool, 4> m_first_pad_status_received{};
 
+  // Inputs received for each pad and the ones sent on to the other clients
+  std::array<PadReceiveState, 4> m_pad_receive;
+  std::array<PadSendHistory, 4> m_pad_history;
+  u32 m_pad_data_game = 0;
+
+  // Declared first, so the session log is destroyed before the relay it writes to
+  std::unique_ptr<SpectatorRelay> m_spectator_relay;
+  SessionLogWriter m_session_log;
+
   struct
   {
     std::recursive_mutex game;
@@ -0,0 +1,344 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlaySessionLog.h"
+
+#include <algorithm>
+#include <lzo/lzo1x.h>
+
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/SFMLHelper.h"
+#include "Common/Version.h"
+#include "Core/NetPlayClient.h"
+#include "Core/NetPlaySpectator.h"
+
+namespace NetPlay
+{
+bool SessionLogWriter::Open(const std::string& path, u32 game, const std::string& game_name,
+                            const PadMappingArray& pad_map, const sf::Packet& settings)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_file.Close();
+  m_is_open = false;
+
+  if (!path.empty())
+  {
+    File::CreateFullPath(path);
+    if (!m_file.Open(path, "wb"))
+    {
+      ERROR_LOG(NETPLAY, "Failed to open session log %s", path.c_str());
+      return false;
+    }
+
+    sf::Packet start;
+    start << SESSION_LOG_MAGIC << SESSION_LOG_VERSION;
+    m_file.WriteBytes(start.getData(), start.getDataSize());
+    INFO_LOG(NETPLAY, "Writing session log to %s", path.c_str());
+  }
+
+  m_is_open = true;
+  m_game = game;
+  m_logged_end.fill(0);
+
+  sf::Packet header;
+  header << Common::git_commit << game_name;
+  for (PadMapping mapping : pad_map)
+    header << mapping;
+  header.append(settings.getData(), settings.getDataSize());
+  WriteRecord(SessionLogRecord::Header, header);
+  return true;
+}
+
+void SessionLogWriter::Close()
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_file.Close();
+  m_is_open = false;
+}
+
+void SessionLogWriter::End()
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (!m_is_open)
+    return;
+
+  WriteRecord(SessionLogRecord::End, sf::Packet());
+  m_file.Close();
+  m_is_open = false;
+}
+
+void SessionLogWriter::SetRelay(SpectatorRelay* relay)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_relay = relay;
+}
+
+void SessionLogWriter::LogInputs(u32 game, const std::array<PadSendHistory, 4>& histories)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (!m_is_open || game != m_game)
+    return;
+
+  sf::Packet body;
+  for (size_t i = 0; i < histories.size(); i++)
+  {
+    const PadSendHistory& history = histories[i];
+    if (history.End() <= m_logged_end[i])
+      continue;
+
+    if (!history.Encode(static_cast<PadMapping>(i), m_logged_end[i], body))
+    {
+      ERROR_LOG(NETPLAY, "Pad %zu inputs from %u are no longer kept for the session log", i,
+                m_logged_end[i]);
+    }
+    m_logged_end[i] = history.End();
+  }
+
+  if (body.getDataSize() != 0)
+    WriteRecord(SessionLogRecord::Inputs, body);
+}
+
+void SessionLogWriter::LogFrame(u32 frame, const std::vector<FrameCheck>& checks)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (!m_is_open || checks.empty())
+    return;
+
+  // Everyone hashes the same slice unless the data is bogus, so it's only stored once
+  const StateHashSlice& slice = checks[0].state_hash;
+
+  sf::Packet body;
+  body << frame << slice.address << slice.size << static_cast<u8>(checks.size());
+  for (const FrameCheck& check : checks)
+  {
+    body << check.pid << static_cast<sf::Uint64>(check.timebase)
+         << static_cast<sf::Uint64>(check.state_hash.hash);
+  }
+
+  WriteRecord(SessionLogRecord::Frame, body);
+}
+
+void SessionLogWriter::WriteRecord(SessionLogRecord type, const sf::Packet& body)
+{
+  const sf::Packet record = MakeSessionLogRecord(type, body);
+  if (m_file.IsOpen())
+    m_file.WriteBytes(record.getData(), record.getDataSize());
+  if (m_relay)
+    m_relay->AddRecord(type, static_cast<const u8*>(record.getData()), record.getDataSize());
+}
+
+sf::Packet MakeSessionLogRecord(SessionLogRecord type, const sf::Packet& body)
+{
+  sf::Packet record;
+  record << static_cast<u8>(type) << static_cast<u32>(body.getDataSize());
+  record.append(body.getData(), body.getDataSize());
+  return record;
+}
+
+sf::Packet EncodeSessionKeyframe(const SessionKeyframe& keyframe)
+{
+  std::vector<u8> compressed(keyframe.state.size() + keyframe.state.size() / 16 + 64 + 3);
+  std::vector<u8> wrkmem(LZO1X_1_MEM_COMPRESS);
+  lzo_uint compressed_size = 0;
+  lzo1x_1_compress(keyframe.state.data(), keyframe.state.size(), compressed.data(),
+                   &compressed_size, wrkmem.data());
+
+  sf::Packet body;
+  body << keyframe.frame;
+  for (u32 next_input : keyframe.next_input)
+    body << next_input;
+  body << static_cast<u32>(keyframe.state.size()) << static_cast<u32>(compressed_size);
+  body.append(compressed.data(), compressed_size);
+  return body;
+}
+
+static bool ReadHeader(sf::Packet& packet, SessionLog* log)
+{
+  packet >> log->revision >> log->game_name;
+  for (PadMapping& mapping : log->pad_map)
+    packet >> mapping;
+
+  NetPlayClient::ReadStartGameSettings(packet, &log->settings, &log->initial_rtc);
+  return static_cast<bool>(packet);
+}
+
+static bool ReadInputs(sf::Packet& packet, SessionLog* log)
+{
+  while (!packet.endOfPacket())
+  {
+    PadMapping pad;
+    PadRecord record;
+    packet >> pad;
+    if (!packet || pad < 0 || pad >= static_cast<PadMapping>(log->inputs.size()) ||
+        !ReadPadRecord(packet, &record))
+    {
+      return false;
+    }
+
+    std::vector<GCPadStatus>& inputs = log->inputs[pad];
+    if (record.first > inputs.size())
+    {
+      ERROR_LOG(NETPLAY, "Session log is missing inputs %zu to %u of pad %d", inputs.size(),
+                record.first, pad);
+      inputs.resize(record.first);
+    }
+
+    const size_t known = inputs.size() - record.first;
+    if (known < record.inputs.size())
+      inputs.insert(inputs.end(), record.inputs.begin() + known, record.inputs.end());
+  }
+
+  return true;
+}
+
+static bool ReadFrame(sf::Packet& packet, SessionLog* log)
+{
+  u32 frame;
+  StateHashSlice slice;
+  u8 count;
+  packet >> frame >> slice.address >> slice.size >> count;
+
+  std::vector<FrameCheck>& checks = log->frames[frame];
+  for (u8 i = 0; i < count && packet; i++)
+  {
+    FrameCheck check;
+    packet >> check.pid;
+    check.timebase = Common::PacketReadU64(packet);
+    check.state_hash = slice;
+    check.state_hash.hash = Common::PacketReadU64(packet);
+    checks.push_back(check);
+  }
+
+  return static_cast<bool>(packet);
+}
+
+// Savestates are far smaller, this only guards against bogus sizes
+static constexpr u32 MAX_KEYFRAME_STATE_SIZE = 0x20000000;
+
+static bool ReadKeyframe(const u8* body, u32 body_size, SessionLog* log)
+{
+  sf::Packet packet;
+  packet.append(body, std::min<u32>(body_size, 7 * sizeof(u32)));
+
+  SessionKeyframe keyframe;
+  u32 state_size, compressed_size;
+  packet >> keyframe.frame;
+  for (u32& next_input : keyframe.next_input)
+    packet >> next_input;
+  packet >> state_size >> compressed_size;
+  if (!packet || compressed_size != body_size - 7 * sizeof(u32) ||
+      state_size > MAX_KEYFRAME_STATE_SIZE)
+  {
+    return false;
+  }
+
+  keyframe.state.resize(state_size);
+  lzo_uint new_size = state_size;
+  if (lzo1x_decompress_safe(body + 7 * sizeof(u32), compressed_size, keyframe.state.data(),
+                            &new_size, nullptr) != LZO_E_OK ||
+      new_size != state_size)
+  {
+    return false;
+  }
+
+  log->keyframe = std::move(keyframe);
+  return true;
+}
+
+size_t SplitSessionLogRecords(const u8* data, size_t size,
+                              std::vector<SessionLogRecordView>* records)
+{
+  constexpr size_t RECORD_HEADER_SIZE = sizeof(u8) + sizeof(u32);
+  size_t offset = 0;
+  while (size - offset >= RECORD_HEADER_SIZE)
+  {
+    sf::Packet record_header;
+    record_header.append(data + offset, RECORD_HEADER_SIZE);
+    u8 type;
+    u32 body_size;
+    record_header >> type >> body_size;
+    if (size - offset - RECORD_HEADER_SIZE < body_size)
+      break;
+
+    SessionLogRecordView record;
+    record.type = static_cast<SessionLogRecord>(type);
+    record.body = data + offset + RECORD_HEADER_SIZE;
+    record.body_size = body_size;
+    record.data = data + offset;
+    record.size = RECORD_HEADER_SIZE + body_size;
+    records->push_back(record);
+
+    offset += record.size;
+  }
+
+  return offset;
+}
+
+bool ReadSessionLogRecord(const SessionLogRecordView& record, SessionLog* log)
+{
+  // Keyframes are too large to copy into a packet first
+  if (record.type == SessionLogRecord::Keyframe)
+    return ReadKeyframe(record.body, record.body_size, log);
+
+  sf::Packet body;
+  body.append(record.body, record.body_size);
+
+  switch (record.type)
+  {
+  case SessionLogRecord::Header:
+    return ReadHeader(body, log);
+  case SessionLogRecord::Inputs:
+    return ReadInputs(body, log);
+  case SessionLogRecord::Frame:
+    return ReadFrame(body, log);
+  case SessionLogRecord::End:
+    log->has_ended = true;
+    return true;
+  default:
+    // Unknown records are skipped, so newer ones can be added without a new version
+    return true;
+  }
+}
+
+bool ReadSessionLog(const std::string& path, SessionLog* log)
+{
+  std::string data;
+  if (!File::ReadFileToString(path, data))
+    return false;
+
+  sf::Packet start;
+  u32 magic = 0, version = 0;
+  start.append(data.data(), std::min<size_t>(data.size(), 8));
+  start >> magic >> version;
+  if (!start || magic != SESSION_LOG_MAGIC || version != SESSION_LOG_VERSION)
+  {
+    ERROR_LOG(NETPLAY, "%s is not a supported session log", path.c_str());
+    return false;
+  }
+
+  *log = SessionLog();
+
+  std::vector<SessionLogRecordView> records;
+  const u8* const records_start = reinterpret_cast<const u8*>(data.data()) + 8;
+  const size_t records_size = SplitSessionLogRecords(records_start, data.size() - 8, &records);
+  if (records_size != data.size() - 8)
+    WARN_LOG(NETPLAY, "Session log %s ends in the middle of a record", path.c_str());
+
+  bool has_header = false;
+  for (const SessionLogRecordView& record : records)
+  {
+    if (!ReadSessionLogRecord(record, log))
+    {
+      ERROR_LOG(NETPLAY, "Session log %s has a malformed record at %zu", path.c_str(),
+                static_cast<size_t>(record.data - records_start) + 8);
+      return false;
+    }
+
+    has_header |= record.type == SessionLogRecord::Header;
+  }
+
+  return has_header;
+}
+}  // namespace NetPlay
@@ -0,0 +1,142 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <SFML/Network/Packet.hpp>
+#include <array>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Core/NetPlayPadCoding.h"
+#include "Core/NetPlayProto.h"
+#include "Core/NetPlayStateHash.h"
+#include "InputCommon/GCPadStatus.h"
+
+namespace NetPlay
+{
+// A session log records what the server relayed during a netplay game, so a desync can be
+// reproduced afterwards with DolphinNoGUI --netplay_replay. The same records are streamed to
+// spectators, see NetPlaySpectator.h.
+//
+// The file starts with SESSION_LOG_MAGIC and SESSION_LOG_VERSION as u32s, followed by records.
+// Each record is a u8 SessionLogRecord, a u32 size and that many bytes of body:
+//
+//   Header    string revision, string game, PadMappingArray pad map, then the settings as they
+//             follow the game in NP_MSG_START_GAME
+//   Inputs    pad records as in NP_MSG_PAD_DATA, with the same delta coding
+//   Frame     u32 frame, u32 address and u32 size of the hashed memory, u8 player count, then
+//             PlayerId, u64 timebase and u64 memory hash for each player
+//   Keyframe  u32 frame, u32 next input of each pad, u32 size of the savestate, then the
+//             savestate compressed with LZO as a string. Only made by spectators
+//   End       empty, the game was stopped
+//
+// All values are in network byte order, as written by sf::Packet.
+
+constexpr u32 SESSION_LOG_MAGIC = 0x4C53504E;  // "NPSL"
+constexpr u32 SESSION_LOG_VERSION = 1;
+
+enum class SessionLogRecord : u8
+{
+  Header = 0,
+  Inputs = 1,
+  Frame = 2,
+  Keyframe = 3,
+  End = 4,
+};
+
+class SpectatorRelay;
+
+// What a player reported for the end of a frame
+struct FrameCheck
+{
+  PlayerId pid;
+  u64 timebase;
+  StateHashSlice state_hash;
+};
+
+class SessionLogWriter
+{
+public:
+  // Called on the ---GUI--- thread when a game starts. Closes the previous log. With an empty
+  // path, the records only go to the relay
+  bool Open(const std::string& path, u32 game, const std::string& game_name,
+            const PadMappingArray& pad_map, const sf::Packet& settings);
+  void Close();
+  // Marks the end of the game and closes the log
+  void End();
+  // Every record is also passed to the relay from then on
+  void SetRelay(SpectatorRelay* relay);
+
+  // Called on the ---NETPLAY--- thread
+
+  // Logs the inputs added to the histories since the last call
+  void LogInputs(u32 game, const std::array<PadSendHistory, 4>& histories);
+  // Logs the reports of every player for the frame
+  void LogFrame(u32 frame, const std::vector<FrameCheck>& checks);
+
+private:
+  void WriteRecord(SessionLogRecord type, const sf::Packet& body);
+
+  std::mutex m_lock;
+  SpectatorRelay* m_relay = nullptr;
+  bool m_is_open = false;
+  File::IOFile m_file;
+  u32 m_game = 0;
+  std::array<u32, 4> m_logged_end{};
+};
+
+// Lets a spectator start from the middle of a game
+struct SessionKeyframe
+{
+  u32 frame = 0;
+  std::array<u32, 4> next_input{};
+  std::vector<u8> state;
+};
+
+struct SessionLog
+{
+  std::string revision;
+  std::string game_name;
+  PadMappingArray pad_map{};
+  NetSettings settings{};
+  u64 initial_rtc = 0;
+
+  // Inputs of each in-game pad in the order they were polled
+  std::array<std::vector<GCPadStatus>, 4> inputs;
+  std::map<u32, std::vector<FrameCheck>> frames;
+
+  std::optional<SessionKeyframe> keyframe;
+  bool has_ended = false;
+};
+
+// A complete record within a buffer
+struct SessionLogRecordView
+{
+  SessionLogRecord type;
+  const u8* body;
+  u32 body_size;
+  // The whole record, including type and size
+  const u8* data;
+  size_t size;
+};
+
+// Returns the number of bytes taken by the complete records at the start of the data
+size_t SplitSessionLogRecords(const u8* data, size_t size,
+                              std::vector<SessionLogRecordView>* records);
+sf::Packet MakeSessionLogRecord(SessionLogRecord type, const sf::Packet& body);
+// Adds the contents of the record to the log. Returns false if it's malformed
+bool ReadSessionLogRecord(const SessionLogRecordView& record, SessionLog* log);
+
+sf::Packet EncodeSessionKeyframe(const SessionKeyframe& keyframe);
+
+// Returns false if the file isn't a readable session log. A log cut off at the end, e.g. because
+// the host crashed, is read up to the last complete record.
+bool ReadSessionLog(const std::string& path, SessionLog* log);
+}  // namespace NetPlay
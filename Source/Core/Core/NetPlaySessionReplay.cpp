@@ -0,0 +1,362 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlaySessionReplay.h"
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Version.h"
+#include "Core/Core.h"
+#include "Core/HW/SystemTimers.h"
+#include "Core/Host.h"
+#include "Core/NetPlayStateHash.h"
+#include "Core/State.h"
+#include "VideoCommon/OnScreenDisplay.h"
+
+namespace NetPlay
+{
+// A live replay runs unthrottled while it has more inputs than this left for a pad
+static constexpr size_t CATCH_UP_INPUTS = 120;
+
+static bool s_is_active = false;
+static bool s_is_live = false;
+static StateHasher s_state_hasher;
+
+// Records are only added to the log during live replays, but it's always accessed with the lock
+// held. The header fields don't change after the start, so GetSessionReplayLog skips it.
+static std::mutex s_log_lock;
+static std::condition_variable s_log_changed;
+static SessionLog s_log;
+static bool s_live_ended = false;
+
+// Only used on the ---CPU--- thread while the game runs, or while it's paused by a host job
+static std::array<size_t, 4> s_next_input{};
+static u32 s_frame = 0;
+static bool s_is_keyframe_requested = false;
+static bool s_has_reported_divergence = false;
+
+static u32 s_keyframe_interval = 0;
+static std::function<void(const SessionKeyframe&)> s_keyframe_sink;
+
+static std::mutex s_result_lock;
+static bool s_is_finished = false;
+static bool s_found_divergence = false;
+static std::string s_summary;
+
+static void Finish(bool found_divergence, const std::string& summary)
+{
+  {
+    std::lock_guard<std::mutex> lk(s_result_lock);
+    if (s_is_finished)
+      return;
+
+    s_is_finished = true;
+    s_found_divergence = found_divergence;
+    s_summary = summary;
+  }
+
+  NOTICE_LOG(NETPLAY, "Session replay: %s", summary.c_str());
+  Host_Message(HostMessageID::WMUserStop);
+}
+
+static std::string DescribePlayers(const std::vector<PlayerId>& pids)
+{
+  std::vector<std::string> names;
+  for (PlayerId pid : pids)
+    names.push_back(StringFromFormat("%u", pid));
+
+  return (pids.size() == 1 ? "player " : "players ") + JoinStrings(names, ", ");
+}
+
+static void Start(SessionLog log, bool is_live)
+{
+  if (log.revision != Common::git_commit)
+  {
+    WARN_LOG(NETPLAY, "Session log was written by revision %s, the replay may not match",
+             log.revision.c_str());
+  }
+
+  NOTICE_LOG(NETPLAY, "%s a session of %s", is_live ? "Spectating" : "Replaying",
+             log.game_name.c_str());
+  s_state_hasher.Reset(log.settings.m_DesyncHashRegions, log.settings.m_DesyncHashBytesPerFrame);
+  s_next_input.fill(0);
+  s_frame = 0;
+  s_is_keyframe_requested = false;
+  s_has_reported_divergence = false;
+
+  {
+    std::lock_guard<std::mutex> lk(s_log_lock);
+    s_log = std::move(log);
+    s_live_ended = false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(s_result_lock);
+    s_is_finished = false;
+    s_found_divergence = false;
+    s_summary = "The replay didn't reach any logged frame";
+  }
+
+  s_is_live = is_live;
+  s_is_active = true;
+}
+
+bool StartSessionReplay(const std::string& path)
+{
+  SessionLog log;
+  if (!ReadSessionLog(path, &log))
+    return false;
+
+  Start(std::move(log), false);
+  return true;
+}
+
+void StartLiveSessionReplay(SessionLog log)
+{
+  Start(std::move(log), true);
+}
+
+void AddSessionReplayRecord(const SessionLogRecordView& record)
+{
+  {
+    std::lock_guard<std::mutex> lk(s_log_lock);
+    if (s_live_ended)
+      return;
+
+    if (record.type == SessionLogRecord::Header)
+    {
+      INFO_LOG(NETPLAY, "Spectated game ended, the host started another one");
+      s_live_ended = true;
+    }
+    else if (!ReadSessionLogRecord(record, &s_log))
+    {
+      ERROR_LOG(NETPLAY, "Spectated game has a malformed record");
+      s_live_ended = true;
+    }
+    else
+    {
+      s_live_ended = s_log.has_ended;
+    }
+  }
+
+  s_log_changed.notify_all();
+}
+
+void EndLiveSessionReplay()
+{
+  {
+    std::lock_guard<std::mutex> lk(s_log_lock);
+    s_live_ended = true;
+  }
+
+  s_log_changed.notify_all();
+}
+
+void SetSessionReplayKeyframeSink(u32 interval, std::function<void(const SessionKeyframe&)> sink)
+{
+  s_keyframe_interval = interval;
+  s_keyframe_sink = std::move(sink);
+}
+
+void StopSessionReplay()
+{
+  EndLiveSessionReplay();
+  Core::SetIsThrottlerTempDisabled(false);
+
+  s_is_active = false;
+  s_is_live = false;
+  s_keyframe_sink = nullptr;
+
+  std::lock_guard<std::mutex> lk(s_log_lock);
+  s_log = SessionLog();
+}
+
+bool IsSessionReplayActive()
+{
+  return s_is_active;
+}
+
+const SessionLog& GetSessionReplayLog()
+{
+  return s_log;
+}
+
+bool SessionReplayGetInput(int pad, GCPadStatus* status)
+{
+  std::unique_lock<std::mutex> lk(s_log_lock);
+  if (pad < 0 || pad >= static_cast<int>(s_log.inputs.size()) || s_log.pad_map[pad] <= 0)
+    return false;
+
+  const std::vector<GCPadStatus>& inputs = s_log.inputs[pad];
+  if (s_is_live)
+  {
+    s_log_changed.wait(lk, [&] { return s_next_input[pad] < inputs.size() || s_live_ended; });
+    Core::SetIsThrottlerTempDisabled(inputs.size() - s_next_input[pad] > CATCH_UP_INPUTS);
+  }
+
+  if (s_next_input[pad] >= inputs.size())
+  {
+    if (s_is_live)
+      Finish(false, StringFromFormat("The spectated game ended at frame %u", s_frame));
+    else
+      Finish(false, StringFromFormat("Reached the end of the inputs at frame %u without finding a "
+                                     "divergence",
+                                     s_frame));
+
+    // The game keeps polling until it's stopped
+    *status = inputs.empty() ? GCPadStatus{} : inputs.back();
+    return true;
+  }
+
+  *status = inputs[s_next_input[pad]++];
+  return true;
+}
+
+static void LoadKeyframe()
+{
+  if (!s_is_active || Core::GetState() == Core::State::Uninitialized)
+    return;
+
+  Core::RunAsCPUThread([] {
+    std::lock_guard<std::mutex> lk(s_log_lock);
+    if (!s_log.keyframe)
+      return;
+
+    SessionKeyframe& keyframe = *s_log.keyframe;
+    State::LoadFromBufferForNetPlay(keyframe.state);
+    s_frame = keyframe.frame;
+    for (size_t i = 0; i < s_next_input.size(); i++)
+      s_next_input[i] = keyframe.next_input[i];
+
+    NOTICE_LOG(NETPLAY, "Started from the keyframe at frame %u", keyframe.frame);
+    s_log.keyframe.reset();
+  });
+}
+
+static void SaveKeyframe()
+{
+  if (!s_is_active || Core::GetState() == Core::State::Uninitialized)
+    return;
+
+  SessionKeyframe keyframe;
+  Core::RunAsCPUThread([&] {
+    keyframe.frame = s_frame;
+    for (size_t i = 0; i < s_next_input.size(); i++)
+      keyframe.next_input[i] = static_cast<u32>(s_next_input[i]);
+    State::SaveToBuffer(keyframe.state);
+  });
+
+  if (s_keyframe_sink)
+    s_keyframe_sink(keyframe);
+}
+
+static void ReportDivergence(const std::string& summary)
+{
+  if (!s_is_live)
+  {
+    Finish(true, summary);
+    return;
+  }
+
+  // A spectator keeps watching, it just can't be trusted to show what the players see anymore
+  if (s_has_reported_divergence)
+    return;
+
+  s_has_reported_divergence = true;
+  WARN_LOG(NETPLAY, "Spectating: %s", summary.c_str());
+  OSD::AddMessage("The spectated game diverged from the players, see the log for details",
+                  OSD::Duration::VERY_LONG, OSD::Color::RED);
+}
+
+void SessionReplayFrameUpdate()
+{
+  const u32 frame = s_frame++;
+
+  std::unique_lock<std::mutex> lk(s_log_lock);
+  if (s_log.keyframe && !s_is_keyframe_requested)
+  {
+    s_is_keyframe_requested = true;
+    Core::QueueHostJob(LoadKeyframe);
+  }
+  else if (s_keyframe_sink && s_keyframe_interval != 0 && !s_log.keyframe && frame != 0 &&
+           frame % s_keyframe_interval == 0)
+  {
+    Core::QueueHostJob(SaveKeyframe);
+  }
+
+  const auto it = s_log.frames.find(frame);
+  if (it == s_log.frames.end() || it->second.empty())
+    return;
+
+  const std::vector<FrameCheck> checks = std::move(it->second);
+  s_log.frames.erase(it);
+  lk.unlock();
+
+  const StateHashSlice& logged_hash = checks[0].state_hash;
+
+  FrameCheck replay;
+  replay.pid = 0;
+  replay.timebase = SystemTimers::GetFakeTimeBase();
+  replay.state_hash = s_state_hasher.HashFrame(frame);
+
+  const bool compare_memory = logged_hash.size != 0 &&
+                              replay.state_hash.address == logged_hash.address &&
+                              replay.state_hash.size == logged_hash.size;
+  const auto matches = [&](const FrameCheck& a, const FrameCheck& b) {
+    return a.timebase == b.timebase && (!compare_memory || a.state_hash.hash == b.state_hash.hash);
+  };
+
+  std::vector<PlayerId> matching, differing;
+  bool players_agree = true;
+  bool memory_differs = false;
+  for (const FrameCheck& check : checks)
+  {
+    (matches(check, replay) ? matching : differing).push_back(check.pid);
+    players_agree &= matches(check, checks[0]);
+    memory_differs |= compare_memory && (check.state_hash.hash != replay.state_hash.hash ||
+                                         check.state_hash.hash != logged_hash.hash);
+  }
+
+  if (players_agree && differing.empty())
+    return;
+
+  const std::string what =
+      memory_differs ? StringFromFormat("memory %08x-%08x", logged_hash.address,
+                                        logged_hash.address + logged_hash.size) :
+                       "timebase";
+
+  std::string summary;
+  if (matching.empty())
+  {
+    summary = StringFromFormat("Frame %u: the replay's %s differs from every player. Check that "
+                               "the save data matches the host's",
+                               frame, what.c_str());
+  }
+  else
+  {
+    summary = StringFromFormat("Frame %u: the replay's %s matches %s and differs from %s", frame,
+                               what.c_str(), DescribePlayers(matching).c_str(),
+                               DescribePlayers(differing).c_str());
+  }
+
+  ReportDivergence(summary);
+}
+
+std::string GetSessionReplaySummary()
+{
+  std::lock_guard<std::mutex> lk(s_result_lock);
+  return s_summary;
+}
+
+bool HasSessionReplayFoundDivergence()
+{
+  std::lock_guard<std::mutex> lk(s_result_lock);
+  return s_found_divergence;
+}
+}  // namespace NetPlay
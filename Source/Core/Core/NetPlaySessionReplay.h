@@ -0,0 +1,47 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "Core/NetPlaySessionLog.h"
+#include "InputCommon/GCPadStatus.h"
+
+namespace NetPlay
+{
+// Runs a game again from a session log, with the settings of the netplay host and the logged
+// inputs in place of the local controllers. At the end of every frame the replay checks the
+// timebase and hashes the memory just like the players did, and compares the result to what they
+// reported. It stops at the first frame where any of that differs, either between the players or
+// between the players and the replay, and reports which players it agrees with. Save data isn't
+// part of the log, so it has to match what the host used.
+//
+// A live replay is fed the records of a game while it's still being played, which is how
+// spectators watch. The CPU waits for inputs that haven't arrived yet, runs unthrottled while
+// it's far behind, and only logs a divergence instead of stopping.
+
+// Called before booting. Returns false if the log can't be read
+bool StartSessionReplay(const std::string& path);
+// Called before booting, with a log that has at least the header
+void StartLiveSessionReplay(SessionLog log);
+// Called on any thread while a live replay runs. A new header or an end record ends it
+void AddSessionReplayRecord(const SessionLogRecordView& record);
+// No more records will be added, e.g. because the connection was lost
+void EndLiveSessionReplay();
+// Saves a keyframe every interval frames of the replay and passes it to the sink from a host job
+void SetSessionReplayKeyframeSink(u32 interval, std::function<void(const SessionKeyframe&)> sink);
+void StopSessionReplay();
+bool IsSessionReplayActive();
+const SessionLog& GetSessionReplayLog();
+
+// Called on the ---CPU--- thread
+bool SessionReplayGetInput(int pad, GCPadStatus* status);
+void SessionReplayFrameUpdate();
+
+// Outcome of the replay so far
+std::string GetSessionReplaySummary();
+bool HasSessionReplayFoundDivergence();
+}  // namespace NetPlay
@@ -0,0 +1,321 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlaySpectator.h"
+
+#include <memory>
+
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
+#include "Core/Config/NetplaySettings.h"
+#include "Core/NetPlaySessionReplay.h"
+
+namespace NetPlay
+{
+static constexpr u32 BATCH_INTERVAL_MS = 250;
+
+SpectatorRelay::SpectatorRelay(u16 port, u32 max_viewers, u32 delay_ms) : m_delay_ms(delay_ms)
+{
+  ENetAddress address;
+  address.host = ENET_HOST_ANY;
+  address.port = port;
+  m_host = enet_host_create(&address, max_viewers, 1, 0, 0);
+  if (!m_host)
+  {
+    ERROR_LOG(NETPLAY, "Failed to listen for spectators on port %u", port);
+    return;
+  }
+
+  INFO_LOG(NETPLAY, "Listening for spectators on port %u", port);
+  m_do_loop.Set();
+  m_thread = std::thread(&SpectatorRelay::ThreadFunc, this);
+}
+
+SpectatorRelay::~SpectatorRelay()
+{
+  if (m_thread.joinable())
+  {
+    m_do_loop.Clear();
+    m_thread.join();
+  }
+
+  if (m_host)
+    enet_host_destroy(m_host);
+}
+
+void SpectatorRelay::AddRecord(SessionLogRecord type, const u8* data, size_t size)
+{
+  TimedRecord record;
+  record.time_ms = Common::Timer::GetTimeMs();
+  record.data.assign(data, data + size);
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  switch (type)
+  {
+  case SessionLogRecord::Header:
+    m_game++;
+    m_header = std::move(record);
+    m_keyframe.clear();
+    m_records.clear();
+    break;
+  case SessionLogRecord::Keyframe:
+    m_keyframe = std::move(record.data);
+    break;
+  default:
+    m_records.push_back(std::move(record));
+    break;
+  }
+}
+
+void SpectatorRelay::ThreadFunc()
+{
+  Common::SetCurrentThreadName("SpectatorRelay");
+
+  u32 last_batch_ms = Common::Timer::GetTimeMs();
+  while (m_do_loop.IsSet())
+  {
+    const u32 elapsed_ms = Common::Timer::GetTimeMs() - last_batch_ms;
+    if (elapsed_ms >= BATCH_INTERVAL_MS)
+    {
+      SendBatches();
+      last_batch_ms += elapsed_ms;
+      continue;
+    }
+
+    ENetEvent event;
+    if (enet_host_service(m_host, &event, BATCH_INTERVAL_MS - elapsed_ms) <= 0)
+      continue;
+
+    switch (event.type)
+    {
+    case ENET_EVENT_TYPE_CONNECT:
+      INFO_LOG(NETPLAY, "Spectator connected, %zu watching", m_viewers.size() + 1);
+      m_viewers[event.peer] = Viewer();
+      break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+      m_viewers.erase(event.peer);
+      INFO_LOG(NETPLAY, "Spectator disconnected, %zu watching", m_viewers.size());
+      break;
+    case ENET_EVENT_TYPE_RECEIVE:
+      // Spectators don't send anything
+      enet_packet_destroy(event.packet);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void SpectatorRelay::SendBatches()
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+
+  const u32 now_ms = Common::Timer::GetTimeMs();
+  const auto is_due = [&](const TimedRecord& record) {
+    return now_ms - record.time_ms >= m_delay_ms;
+  };
+
+  if (m_game == 0 || !is_due(m_header))
+    return;
+
+  for (auto& entry : m_viewers)
+  {
+    Viewer& viewer = entry.second;
+    std::vector<u8> batch;
+
+    // Viewers that just connected start with the header and the newest keyframe
+    if (viewer.game != m_game)
+    {
+      viewer.game = m_game;
+      viewer.next_record = 0;
+      batch.insert(batch.end(), m_header.data.begin(), m_header.data.end());
+      batch.insert(batch.end(), m_keyframe.begin(), m_keyframe.end());
+    }
+
+    for (; viewer.next_record < m_records.size() && is_due(m_records[viewer.next_record]);
+         viewer.next_record++)
+    {
+      const std::vector<u8>& data = m_records[viewer.next_record].data;
+      batch.insert(batch.end(), data.begin(), data.end());
+    }
+
+    if (batch.empty())
+      continue;
+
+    ENetPacket* packet = enet_packet_create(batch.data(), batch.size(), ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(entry.first, 0, packet);
+  }
+
+  enet_host_flush(m_host);
+}
+
+static ENetHost* s_client = nullptr;
+static std::thread s_thread;
+static Common::Flag s_is_receiving;
+static std::unique_ptr<SpectatorRelay> s_relay;
+
+static void ForEachRecord(const ENetPacket* packet,
+                          const std::function<bool(const SessionLogRecordView&)>& on_record)
+{
+  std::vector<SessionLogRecordView> records;
+  if (SplitSessionLogRecords(packet->data, packet->dataLength, &records) != packet->dataLength)
+    ERROR_LOG(NETPLAY, "Received a batch with an incomplete record");
+
+  for (const SessionLogRecordView& record : records)
+  {
+    if (s_relay)
+      s_relay->AddRecord(record.type, record.data, record.size);
+
+    if (!on_record(record))
+      break;
+  }
+}
+
+static void ReceiveThreadFunc()
+{
+  Common::SetCurrentThreadName("Spectator");
+
+  while (s_is_receiving.IsSet())
+  {
+    ENetEvent event;
+    if (enet_host_service(s_client, &event, BATCH_INTERVAL_MS) <= 0)
+      continue;
+
+    if (event.type == ENET_EVENT_TYPE_DISCONNECT)
+    {
+      NOTICE_LOG(NETPLAY, "Lost the connection to the spectated game");
+      EndLiveSessionReplay();
+      return;
+    }
+
+    if (event.type == ENET_EVENT_TYPE_RECEIVE)
+    {
+      ForEachRecord(event.packet, [](const SessionLogRecordView& record) {
+        AddSessionReplayRecord(record);
+        return true;
+      });
+      enet_packet_destroy(event.packet);
+    }
+  }
+}
+
+static void AddKeyframeToRelay(const SessionKeyframe& keyframe)
+{
+  const sf::Packet record =
+      MakeSessionLogRecord(SessionLogRecord::Keyframe, EncodeSessionKeyframe(keyframe));
+  s_relay->AddRecord(SessionLogRecord::Keyframe, static_cast<const u8*>(record.getData()),
+                     record.getDataSize());
+  INFO_LOG(NETPLAY, "Relaying a keyframe of frame %u, %zu bytes", keyframe.frame,
+           record.getDataSize());
+}
+
+bool StartSpectating(const std::string& address, u16 port, u16 relay_port,
+                     const std::function<bool()>& keep_waiting)
+{
+  if (enet_initialize() != 0)
+    return false;
+
+  ENetAddress upstream_address;
+  upstream_address.port = port;
+  s_client = enet_host_create(nullptr, 1, 1, 0, 0);
+  if (!s_client || enet_address_set_host(&upstream_address, address.c_str()) != 0 ||
+      !enet_host_connect(s_client, &upstream_address, 1, 0))
+  {
+    ERROR_LOG(NETPLAY, "Failed to connect to %s:%u", address.c_str(), port);
+    StopSpectating();
+    return false;
+  }
+
+  if (relay_port != 0)
+  {
+    s_relay = std::make_unique<SpectatorRelay>(
+        relay_port, Config::Get(Config::NETPLAY_SPECTATOR_MAX_VIEWERS), 0);
+    if (!s_relay->IsListening())
+      s_relay.reset();
+  }
+
+  // Everything from the start of the game comes at once, and only then the replay can start
+  SessionLog log;
+  bool has_header = false;
+  bool is_valid = true;
+  while (!has_header && is_valid)
+  {
+    ENetEvent event;
+    if (!keep_waiting())
+    {
+      is_valid = false;
+    }
+    else if (enet_host_service(s_client, &event, BATCH_INTERVAL_MS) <= 0)
+    {
+      continue;
+    }
+    else if (event.type == ENET_EVENT_TYPE_CONNECT)
+    {
+      NOTICE_LOG(NETPLAY, "Connected to %s:%u, waiting for a game", address.c_str(), port);
+    }
+    else if (event.type == ENET_EVENT_TYPE_DISCONNECT)
+    {
+      ERROR_LOG(NETPLAY, "Lost the connection to %s:%u", address.c_str(), port);
+      is_valid = false;
+    }
+    else if (event.type == ENET_EVENT_TYPE_RECEIVE)
+    {
+      ForEachRecord(event.packet, [&](const SessionLogRecordView& record) {
+        // Records of a game that was already running when the spectator connected are skipped
+        if (record.type == SessionLogRecord::Header)
+        {
+          log = SessionLog();
+          has_header = true;
+        }
+
+        is_valid = !has_header || ReadSessionLogRecord(record, &log);
+        return is_valid;
+      });
+      enet_packet_destroy(event.packet);
+    }
+  }
+
+  if (!is_valid)
+  {
+    StopSpectating();
+    return false;
+  }
+
+  StartLiveSessionReplay(std::move(log));
+  if (s_relay)
+  {
+    SetSessionReplayKeyframeSink(Config::Get(Config::NETPLAY_SPECTATOR_KEYFRAME_INTERVAL),
+                                 AddKeyframeToRelay);
+  }
+
+  s_is_receiving.Set();
+  s_thread = std::thread(ReceiveThreadFunc);
+  return true;
+}
+
+void StopSpectating()
+{
+  if (s_thread.joinable())
+  {
+    s_is_receiving.Clear();
+    s_thread.join();
+  }
+
+  EndLiveSessionReplay();
+  SetSessionReplayKeyframeSink(0, nullptr);
+  s_relay.reset();
+
+  if (s_client)
+  {
+    enet_host_destroy(s_client);
+    s_client = nullptr;
+  }
+}
+
+bool IsSpectating()
+{
+  return s_client != nullptr;
+}
+}  // namespace NetPlay
@@ -0,0 +1,83 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <enet/enet.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Flag.h"
+#include "Core/NetPlaySessionLog.h"
+
+namespace NetPlay
+{
+// Spectators watch a netplay game by replaying the session log records of the host as they come
+// in, see NetPlaySessionReplay.h. The host streams them from its own port, separate from the
+// players, and every spectator can relay the stream on to more spectators in turn, so the
+// players' connection only carries the stream once for each spectator that connects to the host.
+//
+// The relay of the host holds every record back for a delay, so spectators can't be used to see
+// what the other players are doing. Records are sent in batches a few times per second, and a
+// spectator joining late gets everything from the start of the game. Relaying spectators also
+// save a keyframe of their own replay every so often, so spectators connecting to them start
+// from there instead of catching up on the whole game.
+
+// Serves the records of the current game to spectators
+class SpectatorRelay
+{
+public:
+  SpectatorRelay(u16 port, u32 max_viewers, u32 delay_ms);
+  ~SpectatorRelay();
+
+  bool IsListening() const { return m_host != nullptr; }
+
+  // Takes a complete record. A header starts a new game, and a keyframe replaces the previous one
+  void AddRecord(SessionLogRecord type, const u8* data, size_t size);
+
+private:
+  struct TimedRecord
+  {
+    u32 time_ms;
+    std::vector<u8> data;
+  };
+
+  struct Viewer
+  {
+    u32 game = 0;
+    size_t next_record = 0;
+  };
+
+  void ThreadFunc();
+  void SendBatches();
+
+  ENetHost* m_host = nullptr;
+  std::thread m_thread;
+  Common::Flag m_do_loop;
+  const u32 m_delay_ms;
+
+  std::mutex m_lock;
+  // Counts the headers, so viewers of a previous game get the new one from the start
+  u32 m_game = 0;
+  TimedRecord m_header;
+  std::vector<u8> m_keyframe;
+  std::vector<TimedRecord> m_records;
+
+  // Only used on the relay thread
+  std::map<ENetPeer*, Viewer> m_viewers;
+};
+
+// Connects to the relay of a host or another spectator and waits for a game to start, for as
+// long as keep_waiting returns true. Then starts a live session replay of it. With a relay port,
+// the stream is relayed on to other spectators as well
+bool StartSpectating(const std::string& address, u16 port, u16 relay_port,
+                     const std::function<bool()>& keep_waiting);
+void StopSpectating();
+bool IsSpectating();
+}  // namespace NetPlay
@@ -0,0 +1,90 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlayStateHash.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <xxhash.h>
+
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Core/HW/Memmap.h"
+
+namespace NetPlay
+{
+static constexpr u32 MIN_BYTES_PER_FRAME = 0x1000;
+
+static bool ParseHexAddress(const std::string& str, u64* address)
+{
+  const std::string trimmed = StripSpaces(str);
+  if (trimmed.empty())
+    return false;
+
+  char* end = nullptr;
+  *address = std::strtoull(trimmed.c_str(), &end, 16);
+  return *end == '\0' && *address <= 0x100000000ull;
+}
+
+// Host memory backing the range, or nullptr if it isn't all in one of the RAM banks
+static const u8* GetRangePointer(u32 address, u32 size)
+{
+  const u64 physical = address & 0x3FFFFFFF;
+  if (physical + size <= Memory::REALRAM_SIZE)
+    return Memory::m_pRAM ? Memory::m_pRAM + physical : nullptr;
+
+  const u64 exram_offset = physical & 0x0FFFFFFF;
+  if ((physical >> 28) == 0x1 && exram_offset + size <= Memory::EXRAM_SIZE)
+    return Memory::m_pEXRAM ? Memory::m_pEXRAM + exram_offset : nullptr;
+
+  return nullptr;
+}
+
+void StateHasher::Reset(const std::string& regions, u32 bytes_per_frame)
+{
+  m_slices.clear();
+  bytes_per_frame = std::max(bytes_per_frame, MIN_BYTES_PER_FRAME);
+
+  for (const std::string& region : SplitString(regions, ','))
+  {
+    if (StripSpaces(region).empty())
+      continue;
+
+    const std::vector<std::string> bounds = SplitString(region, '-');
+    u64 start, end;
+    if (bounds.size() != 2 || !ParseHexAddress(bounds[0], &start) ||
+        !ParseHexAddress(bounds[1], &end) || start >= end)
+    {
+      ERROR_LOG(NETPLAY, "Invalid desync hash region \"%s\"", region.c_str());
+      m_slices.clear();
+      return;
+    }
+
+    for (u64 address = start; address < end; address += bytes_per_frame)
+    {
+      StateHashSlice slice;
+      slice.address = static_cast<u32>(address);
+      slice.size = static_cast<u32>(std::min<u64>(bytes_per_frame, end - address));
+      m_slices.push_back(slice);
+    }
+  }
+}
+
+StateHashSlice StateHasher::HashFrame(u32 frame) const
+{
+  if (m_slices.empty())
+    return {};
+
+  StateHashSlice slice = m_slices[frame % m_slices.size()];
+  const u8* pointer = GetRangePointer(slice.address, slice.size);
+  if (!pointer)
+  {
+    // E.g. a MEM2 region on a GameCube game, the other players skip it as well
+    return {};
+  }
+
+  slice.hash = XXH64(pointer, slice.size, 0);
+  return slice;
+}
+}  // namespace NetPlay
@@ -0,0 +1,46 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace NetPlay
+{
+// Hash of a part of the emulated memory at the end of a frame
+struct StateHashSlice
+{
+  u32 address = 0;
+  // 0 if nothing was hashed for the frame
+  u32 size = 0;
+  u64 hash = 0;
+};
+
+// Hashes the emulated memory so the server can tell where players' game states diverged, not
+// only that their timebases did.
+//
+// Hashing all of the configured memory every frame would take too long, so the regions are cut
+// into slices of at most bytes_per_frame, and one slice is hashed per frame with XXH64, going
+// round-robin. Which slice belongs to a frame only depends on the frame number, so every player
+// hashes the same bytes. A divergence is caught at most one pass over the regions after it
+// happened, so it can only be placed between the frame its slice was last hashed and the frame it
+// was found in. The slice narrows down the address.
+class StateHasher
+{
+public:
+  // Regions are a comma separated list of hex address ranges with an exclusive end, like
+  // "80000000-81800000". Hashing is disabled if the list is empty or invalid.
+  void Reset(const std::string& regions, u32 bytes_per_frame);
+  bool IsEnabled() const { return !m_slices.empty(); }
+
+  // Called on the ---CPU--- thread
+  StateHashSlice HashFrame(u32 frame) const;
+
+private:
+  std::vector<StateHashSlice> m_slices;
+};
+}  // namespace NetPlay
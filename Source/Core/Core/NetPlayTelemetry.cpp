@@ -0,0 +1,242 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/NetPlayTelemetry.h"
+
+#include <algorithm>
+
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "VideoCommon/OnScreenDisplay.h"
+
+namespace NetPlay
+{
+static constexpr u32 SAMPLE_INTERVAL_MS = 1000;
+
+static double Percent(u64 part, u64 whole)
+{
+  return whole ? part * 100.0 / whole : 0.0;
+}
+
+// One character per value, from ' ' for nothing to '@' for max_value or more
+static std::string DrawGraph(const std::vector<double>& values, double max_value)
+{
+  static constexpr char LEVELS[] = " .:-=+*#%@";
+  static constexpr int TOP_LEVEL = sizeof(LEVELS) - 2;
+
+  std::string graph;
+  for (double value : values)
+  {
+    const int level = max_value > 0 ? static_cast<int>(value / max_value * TOP_LEVEL + 0.5) : 0;
+    graph += LEVELS[std::clamp(level, 0, TOP_LEVEL)];
+  }
+  return graph;
+}
+
+void NetworkTelemetry::Reset(bool show_graph, const std::string& csv_path,
+                             const std::vector<PlayerId>& pids)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_csv.Close();
+  m_is_active = show_graph || !csv_path.empty();
+  m_show_graph = show_graph;
+  m_pids = pids;
+  m_start_ms = Common::Timer::GetTimeMs();
+  m_last_sample_ms = m_start_ms;
+  m_last_packets_lost = 0;
+  m_last_total_wait_us = 0;
+  m_frames = 0;
+  m_counts = {};
+  m_pings.clear();
+  m_history.clear();
+
+  if (csv_path.empty())
+    return;
+
+  File::CreateFullPath(csv_path);
+  if (!m_csv.Open(csv_path, "w"))
+  {
+    ERROR_LOG(NETPLAY, "Failed to open %s for writing telemetry", csv_path.c_str());
+    return;
+  }
+
+  std::string header = "time_ms,frames";
+  for (PlayerId pid : m_pids)
+    header += StringFromFormat(",ping_ms_p%u", pid);
+  header += ",link_rtt_ms,link_rtt_variance_ms,link_loss_percent,retransmits,inputs,"
+            "ahead_of_missing,resend_requests,buffer_min,buffer_average,buffer_max,"
+            "stalled_frames,stall_ms,max_stall_ms\n";
+  m_csv.WriteBytes(header.data(), header.size());
+  INFO_LOG(NETPLAY, "Writing telemetry to %s", csv_path.c_str());
+}
+
+void NetworkTelemetry::Stop()
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_is_active = false;
+  m_csv.Close();
+}
+
+void NetworkTelemetry::OnFrame(u32 buffered_inputs, u64 total_wait_us)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (!m_is_active)
+    return;
+
+  const u64 wait_us = total_wait_us - std::min(total_wait_us, m_last_total_wait_us);
+  m_last_total_wait_us = total_wait_us;
+
+  m_frames++;
+  Counts& counts = m_counts;
+  counts.min_buffered =
+      counts.frames ? std::min(counts.min_buffered, buffered_inputs) : buffered_inputs;
+  counts.max_buffered = std::max(counts.max_buffered, buffered_inputs);
+  counts.total_buffered += buffered_inputs;
+  counts.frames++;
+
+  if (wait_us != 0)
+  {
+    counts.stalled_frames++;
+    counts.stall_us += wait_us;
+    counts.max_stall_us = std::max(counts.max_stall_us, wait_us);
+  }
+}
+
+void NetworkTelemetry::OnPadData(u32 new_inputs, bool is_ahead_of_missing)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_counts.inputs += new_inputs;
+  if (is_ahead_of_missing)
+    m_counts.ahead_of_missing++;
+}
+
+void NetworkTelemetry::OnResendRequest()
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_counts.resend_requests++;
+}
+
+void NetworkTelemetry::OnPing(PlayerId pid, u32 ping_ms)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  std::deque<u32>& pings = m_pings[pid];
+  pings.push_back(ping_ms);
+  if (pings.size() > HISTORY_SIZE)
+    pings.pop_front();
+}
+
+void NetworkTelemetry::Update(const ENetPeer* server)
+{
+  std::lock_guard<std::mutex> lk(m_lock);
+  const u32 now_ms = Common::Timer::GetTimeMs();
+  if (!m_is_active || now_ms - m_last_sample_ms < SAMPLE_INTERVAL_MS)
+    return;
+
+  m_last_sample_ms = now_ms;
+
+  // ENet counts every reliable packet that has to be sent again, but starts over every few seconds
+  const u32 packets_lost = server->packetsLost;
+  const u32 retransmits =
+      packets_lost >= m_last_packets_lost ? packets_lost - m_last_packets_lost : packets_lost;
+  m_last_packets_lost = packets_lost;
+
+  Sample sample;
+  sample.link_rtt_ms = server->roundTripTime;
+  sample.stall_ms = m_counts.stall_us / 1000.0;
+  sample.buffer_average =
+      m_counts.frames ? static_cast<double>(m_counts.total_buffered) / m_counts.frames : 0.0;
+  m_history.push_back(sample);
+  if (m_history.size() > HISTORY_SIZE)
+    m_history.pop_front();
+
+  if (m_csv)
+    WriteCSVRow(now_ms, server, retransmits);
+  if (m_show_graph)
+    ShowGraph(server, retransmits);
+
+  m_counts = {};
+}
+
+void NetworkTelemetry::WriteCSVRow(u32 now_ms, const ENetPeer* server, u32 retransmits)
+{
+  const Sample& sample = m_history.back();
+  const Counts& counts = m_counts;
+
+  std::string row = StringFromFormat("%u,%llu", now_ms - m_start_ms,
+                                     static_cast<unsigned long long>(m_frames));
+  for (PlayerId pid : m_pids)
+  {
+    const auto it = m_pings.find(pid);
+    row += it != m_pings.end() && !it->second.empty() ?
+               StringFromFormat(",%u", it->second.back()) :
+               ",";
+  }
+
+  row += StringFromFormat(",%u,%u,%.2f,%u,%u,%u,%u,%u,%.2f,%u,%u,%.3f,%.3f\n", sample.link_rtt_ms,
+                          server->roundTripTimeVariance,
+                          Percent(server->packetLoss, ENET_PEER_PACKET_LOSS_SCALE), retransmits,
+                          counts.inputs, counts.ahead_of_missing, counts.resend_requests,
+                          counts.min_buffered, sample.buffer_average, counts.max_buffered,
+                          counts.stalled_frames, sample.stall_ms, counts.max_stall_us / 1000.0);
+
+  // Flushed every time, so the file is complete up to the last second if the emulator crashes
+  m_csv.WriteBytes(row.data(), row.size());
+  m_csv.Flush();
+}
+
+void NetworkTelemetry::ShowGraph(const ENetPeer* server, u32 retransmits)
+{
+  const Sample& sample = m_history.back();
+  const Counts& counts = m_counts;
+
+  std::vector<std::string> pings;
+  for (const auto& entry : m_pings)
+  {
+    if (entry.second.empty())
+      continue;
+
+    std::vector<u32> sorted(entry.second.begin(), entry.second.end());
+    std::sort(sorted.begin(), sorted.end());
+    const u32 median = sorted[sorted.size() / 2];
+    const u32 quantile_95 = sorted[((sorted.size() - 1) * 95 + 99) / 100];
+    pings.push_back(StringFromFormat("P%u %u ms (median %u, 95%% %u, max %u)", entry.first,
+                                     entry.second.back(), median, quantile_95, sorted.back()));
+  }
+
+  std::vector<double> rtts, stalls, buffers;
+  for (const Sample& past : m_history)
+  {
+    rtts.push_back(past.link_rtt_ms);
+    stalls.push_back(past.stall_ms);
+    buffers.push_back(past.buffer_average);
+  }
+
+  // Scaled to the highest value shown, but flat lines stay at the bottom
+  const double max_rtt = std::max(*std::max_element(rtts.begin(), rtts.end()), 10.0);
+  const double max_stall = std::max(*std::max_element(stalls.begin(), stalls.end()), 10.0);
+  const double max_buffer = std::max(*std::max_element(buffers.begin(), buffers.end()), 1.0);
+
+  std::string text = "Ping: " + JoinStrings(pings, ", ") + "\n";
+  text += StringFromFormat("Host link: %u ms +-%u, %.1f%% loss, %u resent | Inputs: %u, %u "
+                           "ahead of missing ones, %u requested again\n",
+                           server->roundTripTime, server->roundTripTimeVariance,
+                           Percent(server->packetLoss, ENET_PEER_PACKET_LOSS_SCALE), retransmits,
+                           counts.inputs, counts.ahead_of_missing, counts.resend_requests);
+  text += StringFromFormat("Buffered: %u-%u inputs, %.1f on average | Waited in %u of %u frames, "
+                           "%.1f ms in total, %.1f ms at most\n",
+                           counts.min_buffered, counts.max_buffered, sample.buffer_average,
+                           counts.stalled_frames, counts.frames, sample.stall_ms,
+                           counts.max_stall_us / 1000.0);
+  text += StringFromFormat("RTT    %4.0f ms |%s|\n", max_rtt, DrawGraph(rtts, max_rtt).c_str());
+  text += StringFromFormat("Waited %4.0f ms |%s|\n", max_stall,
+                           DrawGraph(stalls, max_stall).c_str());
+  text += StringFromFormat("Buffer %4.0f    |%s|", max_buffer,
+                           DrawGraph(buffers, max_buffer).c_str());
+
+  OSD::AddTypedMessage(OSD::MessageType::NetPlayTelemetry, text,
+                       SAMPLE_INTERVAL_MS + OSD::Duration::SHORT / 2, OSD::Color::CYAN);
+}
+}  // namespace NetPlay
@@ -0,0 +1,96 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <enet/enet.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Core/NetPlayProto.h"
+
+namespace NetPlay
+{
+// Measures how well the network keeps up while a netplay game runs, beyond the ping the server
+// reports. Once per second the numbers of the last second are turned into a sample:
+//
+// - the ping of every player, as measured by the server, and its distribution over the last
+//   minute
+// - round trip time, round trip time variance, loss and retransmits of reliable packets on the
+//   connection to the host, as ENet sees them
+// - GameCube inputs received, pad data that arrived ahead of inputs that are still missing
+//   (lost or reordered), and how often the missing inputs were requested again
+// - how many inputs of the remote pads were buffered at each frame
+// - how long the ---CPU--- thread waited for inputs, per frame
+//
+// The last minute of samples can be shown as a graph on screen, and every sample can be written
+// to a CSV file to look into a session afterwards.
+class NetworkTelemetry
+{
+public:
+  // Called on the ---GUI--- thread while the game isn't running. Without a path, no CSV is written
+  void Reset(bool show_graph, const std::string& csv_path, const std::vector<PlayerId>& pids);
+  // Called when the game stops
+  void Stop();
+
+  // Called on the ---CPU--- thread once per frame, with the inputs buffered for the remote pad that
+  // has the fewest, and the total time spent waiting for inputs so far
+  void OnFrame(u32 buffered_inputs, u64 total_wait_us);
+
+  // Called on the ---NETPLAY--- thread
+  void OnPadData(u32 new_inputs, bool is_ahead_of_missing);
+  void OnResendRequest();
+  void OnPing(PlayerId pid, u32 ping_ms);
+  // Takes a sample once per second
+  void Update(const ENetPeer* server);
+
+private:
+  static constexpr size_t HISTORY_SIZE = 60;
+
+  struct Counts
+  {
+    u32 frames = 0;
+    u32 stalled_frames = 0;
+    u64 stall_us = 0;
+    u64 max_stall_us = 0;
+    u32 min_buffered = 0;
+    u32 max_buffered = 0;
+    u64 total_buffered = 0;
+    u32 inputs = 0;
+    u32 ahead_of_missing = 0;
+    u32 resend_requests = 0;
+  };
+
+  struct Sample
+  {
+    u32 link_rtt_ms = 0;
+    double stall_ms = 0;
+    double buffer_average = 0;
+  };
+
+  void WriteCSVRow(u32 now_ms, const ENetPeer* server, u32 retransmits);
+  void ShowGraph(const ENetPeer* server, u32 retransmits);
+
+  std::mutex m_lock;
+  bool m_is_active = false;
+  bool m_show_graph = false;
+  File::IOFile m_csv;
+  std::vector<PlayerId> m_pids;
+  u32 m_start_ms = 0;
+  u32 m_last_sample_ms = 0;
+  u32 m_last_packets_lost = 0;
+  u64 m_last_total_wait_us = 0;
+  u64 m_frames = 0;
+  // Of the current second
+  Counts m_counts;
+
+  std::map<PlayerId, std::deque<u32>> m_pings;
+  std::deque<Sample> m_history;
+};
+}  // namespace NetPlay
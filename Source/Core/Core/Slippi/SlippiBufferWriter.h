@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "Common/BitUtils.h"
+#include "Common/CommonTypes.h"
+#include "Common/Logging/Log.h"
+#include "Common/Swap.h"
+
+// Serializes big endian values into a buffer that is allocated up front, so building a response
+// doesn't allocate as long as it fits. Writes past the capacity grow the buffer instead of losing
+// data, and log a warning since the initial capacity should then be raised.
+class SlippiBufferWriter
+{
+public:
+  explicit SlippiBufferWriter(size_t capacity) : m_buffer(capacity) {}
+
+  void Clear() { m_size = 0; }
+  bool Empty() const { return m_size == 0; }
+  size_t Size() const { return m_size; }
+  size_t Capacity() const { return m_buffer.size(); }
+  const u8* Data() const { return m_buffer.data(); }
+
+  void WriteU8(u8 value)
+  {
+    Reserve(1);
+    m_buffer[m_size++] = value;
+  }
+
+  void WriteU16(u16 value) { WriteSwapped(Common::swap16(value)); }
+  void WriteU32(u32 value) { WriteSwapped(Common::swap32(value)); }
+  void WriteS32(s32 value) { WriteU32(static_cast<u32>(value)); }
+  void WriteFloat(float value) { WriteU32(Common::BitCast<u32>(value)); }
+
+  void WriteBytes(const void* data, size_t length)
+  {
+    Reserve(length);
+    std::memcpy(m_buffer.data() + m_size, data, length);
+    m_size += length;
+  }
+
+  void WriteBytes(std::initializer_list<u8> bytes) { WriteBytes(bytes.begin(), bytes.size()); }
+
+  void Fill(u8 value, size_t count)
+  {
+    Reserve(count);
+    std::memset(m_buffer.data() + m_size, value, count);
+    m_size += count;
+  }
+
+private:
+  template <typename T>
+  void WriteSwapped(T swapped_value)
+  {
+    WriteBytes(&swapped_value, sizeof(T));
+  }
+
+  void Reserve(size_t length)
+  {
+    if (m_size + length <= m_buffer.size())
+      return;
+
+    WARN_LOG(EXPANSIONINTERFACE, "SlippiBufferWriter: growing past its capacity of %zu bytes",
+             m_buffer.size());
+    m_buffer.resize(std::max(m_buffer.size() * 2, m_size + length));
+  }
+
+  std::vector<u8> m_buffer;
+  size_t m_size = 0;
+};
@@ -0,0 +1,157 @@
+#include "SlippiCommandProfiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include "Common/PerformanceCounter.h"
+#endif
+
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/MathUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "VideoCommon/OnScreenDisplay.h"
+
+static const u32 OSD_UPDATE_INTERVAL_MS = 1000;
+
+using Histogram = std::array<u32, SlippiCommandProfiler::HISTOGRAM_BUCKETS>;
+
+// Upper bound of the histogram bucket that the given fraction of calls falls into
+static u64 EstimatePercentile(const Histogram& hist, u64 count, double fraction)
+{
+  u64 threshold = std::max<u64>(1, static_cast<u64>(count * fraction));
+  u64 seen = 0;
+  for (size_t i = 0; i < hist.size(); i++)
+  {
+    seen += hist[i];
+    if (seen >= threshold)
+      return static_cast<u64>(2ULL << i);
+  }
+
+  return static_cast<u64>(2ULL << (hist.size() - 1));
+}
+
+SlippiCommandProfiler::SlippiCommandProfiler()
+{
+  u64 frequency = 0;
+  QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+  m_ns_per_tick = frequency ? 1e9 / frequency : 0.0;
+
+  Reset();
+}
+
+u64 SlippiCommandProfiler::GetTicks()
+{
+  u64 ticks = 0;
+  QueryPerformanceCounter((LARGE_INTEGER*)&ticks);
+  return ticks;
+}
+
+void SlippiCommandProfiler::Record(size_t index, u64 start_ticks)
+{
+  u64 elapsed_ns = static_cast<u64>((GetTicks() - start_ticks) * m_ns_per_tick);
+
+  Stat& stat = m_stats[index];
+  stat.count++;
+  stat.total_ns += elapsed_ns;
+  stat.max_ns = std::max(stat.max_ns, elapsed_ns);
+
+  size_t bucket = elapsed_ns ? std::min<size_t>(IntLog2(elapsed_ns), HISTOGRAM_BUCKETS - 1) : 0;
+  stat.histogram[bucket]++;
+
+  if (index == DMA_WRITE_INDEX || index == DMA_READ_INDEX)
+    m_current_frame_ns += elapsed_ns;
+}
+
+void SlippiCommandProfiler::MarkFrame(s32 frame)
+{
+  if (!m_is_enabled || frame == m_current_frame)
+    return;
+
+  m_current_frame = frame;
+
+  m_window_ns += m_current_frame_ns;
+  m_window_worst_frame_ns = std::max(m_window_worst_frame_ns, m_current_frame_ns);
+  m_window_frames++;
+  m_current_frame_ns = 0;
+
+  UpdateOSD();
+}
+
+void SlippiCommandProfiler::UpdateOSD()
+{
+  u64 now = Common::Timer::GetTimeMs();
+  if (now - m_window_start_ms < OSD_UPDATE_INTERVAL_MS)
+    return;
+
+  double average_us = m_window_ns / 1000.0 / std::max<u32>(1, m_window_frames);
+  OSD::AddTypedMessage(OSD::MessageType::SlippiProfile,
+                       StringFromFormat("Slippi EXI: %.1f us/frame, worst frame %.1f us",
+                                        average_us, m_window_worst_frame_ns / 1000.0),
+                       OSD_UPDATE_INTERVAL_MS + 500, OSD::Color::CYAN);
+
+  m_window_start_ms = now;
+  m_window_ns = 0;
+  m_window_worst_frame_ns = 0;
+  m_window_frames = 0;
+}
+
+void SlippiCommandProfiler::Reset()
+{
+  for (Stat& stat : m_stats)
+    stat = {};
+
+  m_current_frame_ns = 0;
+  m_window_ns = 0;
+  m_window_worst_frame_ns = 0;
+  m_window_frames = 0;
+  m_window_start_ms = Common::Timer::GetTimeMs();
+}
+
+bool SlippiCommandProfiler::WriteCSV(const std::string& path) const
+{
+  File::CreateFullPath(path);
+  File::IOFile f(path, "w");
+  if (!f)
+  {
+    ERROR_LOG(EXPANSIONINTERFACE, "Failed to write Slippi command profile to %s", path.c_str());
+    return false;
+  }
+
+  fprintf(f.GetHandle(), "command,count,total_ns,mean_ns,max_ns,p50_ns,p99_ns");
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    fprintf(f.GetHandle(), ",lt_%" PRIu64 "ns", static_cast<u64>(2ULL << i));
+  fprintf(f.GetHandle(), "\n");
+
+  for (size_t index = 0; index < STAT_COUNT; index++)
+  {
+    const Stat& stat = m_stats[index];
+    if (stat.count == 0)
+      continue;
+
+    std::string name;
+    if (index == DMA_WRITE_INDEX)
+      name = "DMAWrite";
+    else if (index == DMA_READ_INDEX)
+      name = "DMARead";
+    else
+      name = StringFromFormat("0x%02x", static_cast<u32>(index));
+
+    fprintf(f.GetHandle(), "%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                           ",%" PRIu64,
+            name.c_str(), stat.count, stat.total_ns, stat.total_ns / stat.count, stat.max_ns,
+            EstimatePercentile(stat.histogram, stat.count, 0.5),
+            EstimatePercentile(stat.histogram, stat.count, 0.99));
+    for (u32 bucket : stat.histogram)
+      fprintf(f.GetHandle(), ",%u", bucket);
+    fprintf(f.GetHandle(), "\n");
+  }
+
+  return true;
+}
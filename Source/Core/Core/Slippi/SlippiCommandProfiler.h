@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+// Measures how long the Slippi EXI device spends handling each command, using the same
+// performance counter as the JIT block profiler. For every command byte it keeps a call count,
+// the total and worst time and a histogram with power of two nanosecond buckets.
+//
+// While enabled, the time spent per emulated frame is summarized on screen once a second, and
+// the full table can be written out as CSV to compare runs. When disabled the only cost is a
+// flag check per command.
+class SlippiCommandProfiler
+{
+public:
+  // Histogram bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds
+  static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+  SlippiCommandProfiler();
+
+  void SetEnabled(bool enabled) { m_is_enabled = enabled; }
+  bool IsEnabled() const { return m_is_enabled; }
+
+  // Returns the timestamp to pass to the Record functions, or 0 if profiling is disabled
+  u64 Start() const { return m_is_enabled ? GetTicks() : 0; }
+  void RecordCommand(u8 command, u64 start_ticks)
+  {
+    if (m_is_enabled)
+      Record(command, start_ticks);
+  }
+  void RecordDMAWrite(u64 start_ticks)
+  {
+    if (m_is_enabled)
+      Record(DMA_WRITE_INDEX, start_ticks);
+  }
+  void RecordDMARead(u64 start_ticks)
+  {
+    if (m_is_enabled)
+      Record(DMA_READ_INDEX, start_ticks);
+  }
+
+  // Game frame the device is currently handling. Time is attributed to frames by the whole DMA
+  // calls, so commands are not counted twice
+  void MarkFrame(s32 frame);
+
+  void Reset();
+  bool WriteCSV(const std::string& path) const;
+
+private:
+  static constexpr size_t DMA_WRITE_INDEX = 256;
+  static constexpr size_t DMA_READ_INDEX = 257;
+  static constexpr size_t STAT_COUNT = 258;
+
+  struct Stat
+  {
+    u64 count;
+    u64 total_ns;
+    u64 max_ns;
+    std::array<u32, HISTOGRAM_BUCKETS> histogram;
+  };
+
+  static u64 GetTicks();
+  void Record(size_t index, u64 start_ticks);
+  void UpdateOSD();
+
+  bool m_is_enabled = false;
+  double m_ns_per_tick;
+  std::array<Stat, STAT_COUNT> m_stats;
+
+  // Per frame totals for the on screen summary
+  s32 m_current_frame = 0;
+  u64 m_current_frame_ns = 0;
+  u64 m_window_ns = 0;
+  u64 m_window_worst_frame_ns = 0;
+  u32 m_window_frames = 0;
+  u64 m_window_start_ms = 0;
+};
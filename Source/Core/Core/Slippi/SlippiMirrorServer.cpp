@@ -0,0 +1,201 @@
+#include "SlippiMirrorServer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+
+SlippiMirrorServer::SlippiMirrorServer(u16 port) : m_port(port)
+{
+  for (size_t i = 0; i < QUEUE_SIZE; i++)
+  {
+    m_batches[i].data.reserve(BUFFER_RESERVE_SIZE);
+    m_free_queue.TryPush(&m_batches[i]);
+  }
+
+  m_pending = &m_batches[QUEUE_SIZE];
+  m_pending->data.reserve(BUFFER_RESERVE_SIZE);
+
+  m_thread = std::thread([this] { ThreadLoop(); });
+}
+
+SlippiMirrorServer::~SlippiMirrorServer()
+{
+  m_shutdown.Set();
+  m_wakeup.Set();
+  m_thread.join();
+}
+
+void SlippiMirrorServer::StartGame()
+{
+  // The network thread splits the batch there, so this never has to wait for a free batch. If
+  // several games start before the batch gets submitted, only the last one is caught up with.
+  m_pending->game_start = m_pending->data.size();
+}
+
+void SlippiMirrorServer::Write(const u8* payload, u32 length)
+{
+  m_pending->data.insert(m_pending->data.end(), payload, payload + length);
+}
+
+void SlippiMirrorServer::Submit()
+{
+  if (m_pending->data.empty() && !m_pending->game_start)
+    return;
+
+  // Same scheme as the replay writer: if no batch is free the network thread is behind, keep
+  // accumulating into the pending batch rather than blocking emulation
+  if (m_free_queue.Empty())
+    return;
+
+  m_submit_queue.TryPush(m_pending);
+  m_free_queue.Pop(m_pending);
+  m_wakeup.Set();
+}
+
+void SlippiMirrorServer::ThreadLoop()
+{
+  Common::SetCurrentThreadName("Slippi Mirror Server");
+
+  // Batches still get drained if we can't listen so the CPU thread never backs up
+  m_listener.setBlocking(false);
+  m_is_listening = m_listener.listen(m_port, sf::IpAddress::LocalHost) == sf::Socket::Done;
+  if (m_is_listening)
+    NOTICE_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Listening on port %u", m_port);
+  else
+    ERROR_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Failed to listen on port %u", m_port);
+
+  while (!m_shutdown.IsSet())
+  {
+    // Wake up right away when a batch is submitted. Otherwise poll for new clients, or retry
+    // sooner if a client still has a backlog that didn't fit in its socket buffer
+    bool has_backlog = std::any_of(m_clients.begin(), m_clients.end(),
+                                   [](const Client& c) { return c.sent < c.backlog.size(); });
+    m_wakeup.WaitFor(std::chrono::milliseconds(has_backlog ? 1 : 50));
+
+    AcceptClients();
+    DrainBatches();
+    SendToClients();
+  }
+
+  m_clients.clear();
+  m_listener.close();
+}
+
+void SlippiMirrorServer::AcceptClients()
+{
+  while (m_is_listening)
+  {
+    auto socket = std::make_unique<sf::TcpSocket>();
+    if (m_listener.accept(*socket) != sf::Socket::Done)
+      break;
+
+    socket->setBlocking(false);
+    INFO_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Client connected from port %u",
+             socket->getRemotePort());
+
+    // Catch the client up with the game in progress
+    Client client;
+    client.socket = std::move(socket);
+    client.backlog = m_game_data;
+    client.is_waiting_for_game = !m_has_game_data;
+    if (client.is_waiting_for_game)
+      INFO_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Client will be sent the next game");
+    m_clients.push_back(std::move(client));
+  }
+}
+
+void SlippiMirrorServer::DrainBatches()
+{
+  Batch* batch;
+  while (m_submit_queue.Pop(batch))
+  {
+    const u8* data = batch->data.data();
+    const size_t size = batch->data.size();
+    const size_t game_start = batch->game_start.value_or(0);
+    if (batch->game_start)
+    {
+      m_game_data.clear();
+      m_has_game_data = true;
+    }
+
+    for (Client& client : m_clients)
+    {
+      if (client.is_waiting_for_game && !batch->game_start)
+        continue;
+
+      const size_t start = client.is_waiting_for_game ? game_start : 0;
+      client.backlog.insert(client.backlog.end(), data + start, data + size);
+      client.is_waiting_for_game = false;
+    }
+    AppendGameData(data + game_start, size - game_start);
+
+    batch->game_start.reset();
+    batch->data.clear();
+    m_free_queue.TryPush(batch);
+  }
+}
+
+void SlippiMirrorServer::AppendGameData(const u8* data, size_t size)
+{
+  if (!m_has_game_data)
+    return;
+
+  // A client catching up with more than this would be dropped right away anyway
+  if (m_game_data.size() + size > MAX_CLIENT_BACKLOG)
+  {
+    WARN_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Clients connecting during the rest of this "
+                                 "game will only be sent the next one");
+    std::vector<u8>().swap(m_game_data);
+    m_has_game_data = false;
+    return;
+  }
+
+  m_game_data.insert(m_game_data.end(), data, data + size);
+}
+
+void SlippiMirrorServer::SendToClients()
+{
+  for (auto it = m_clients.begin(); it != m_clients.end();)
+  {
+    Client& client = *it;
+
+    sf::Socket::Status status = sf::Socket::Done;
+    if (client.sent < client.backlog.size())
+    {
+      size_t sent = 0;
+      size_t remaining = client.backlog.size() - client.sent;
+      status = client.socket->send(&client.backlog[client.sent], remaining, sent);
+      client.sent += sent;
+    }
+
+    if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+    {
+      INFO_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Client disconnected");
+      it = m_clients.erase(it);
+      continue;
+    }
+
+    if (client.backlog.size() - client.sent > MAX_CLIENT_BACKLOG)
+    {
+      WARN_LOG(EXPANSIONINTERFACE, "SlippiMirrorServer: Dropping client that fell too far behind");
+      it = m_clients.erase(it);
+      continue;
+    }
+
+    // Drop what has been sent so the backlog doesn't grow for the whole game
+    if (client.sent == client.backlog.size())
+    {
+      client.backlog.clear();
+      client.sent = 0;
+    }
+    else if (client.sent > client.backlog.size() / 2)
+    {
+      client.backlog.erase(client.backlog.begin(), client.backlog.begin() + client.sent);
+      client.sent = 0;
+    }
+
+    ++it;
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/Flag.h"
+#include "Common/SPSCQueue.h"
+
+// Streams the raw Slippi EXI command payloads (the same bytes that end up in the raw element of
+// the .slp file) to local TCP clients such as broadcast overlays, without a round trip through the
+// disk. Payloads are batched per DMA on the CPU thread and sent from a dedicated network thread.
+//
+// Clients that connect mid-game first receive everything sent since the start of the current
+// game, so they can always parse the stream from the payload sizes event onwards. A client that
+// can't keep up is disconnected once its backlog grows past MAX_CLIENT_BACKLOG. That's also as
+// much of the current game as is kept for catching up, clients connecting later than that wait
+// for the next game to start.
+class SlippiMirrorServer
+{
+public:
+  explicit SlippiMirrorServer(u16 port);
+  ~SlippiMirrorServer();
+
+  // These must only be called from a single (emulation) thread
+  void StartGame();
+  void Write(const u8* payload, u32 length);
+  void Submit();
+
+private:
+  static constexpr size_t QUEUE_SIZE = 64;
+  static constexpr size_t BUFFER_RESERVE_SIZE = 16 * 1024;
+  static constexpr size_t MAX_CLIENT_BACKLOG = 8 * 1024 * 1024;
+
+  struct Batch
+  {
+    // Where in data the next game starts, if it does in this batch
+    std::optional<size_t> game_start;
+    std::vector<u8> data;
+  };
+
+  struct Client
+  {
+    std::unique_ptr<sf::TcpSocket> socket;
+    std::vector<u8> backlog;
+    size_t sent = 0;
+    // Connected too late to catch up with the current game
+    bool is_waiting_for_game = false;
+  };
+
+  void ThreadLoop();
+  void AcceptClients();
+  void DrainBatches();
+  void AppendGameData(const u8* data, size_t size);
+  void SendToClients();
+
+  // One more batch than ring slots so that the CPU thread always owns a pending batch
+  std::array<Batch, QUEUE_SIZE + 1> m_batches;
+  Common::FixedSPSCQueue<Batch*, QUEUE_SIZE> m_submit_queue;
+  Common::FixedSPSCQueue<Batch*, QUEUE_SIZE> m_free_queue;
+  Batch* m_pending;
+
+  std::thread m_thread;
+  Common::Event m_wakeup;
+  Common::Flag m_shutdown;
+
+  // Only touched by the network thread
+  u16 m_port;
+  sf::TcpListener m_listener;
+  bool m_is_listening = false;
+  std::vector<Client> m_clients;
+  // Everything since the current game started, unless that was more than MAX_CLIENT_BACKLOG
+  std::vector<u8> m_game_data;
+  bool m_has_game_data = true;
+};
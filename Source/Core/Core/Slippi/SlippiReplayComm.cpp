@@ -1,42 +1,125 @@
 #include "SlippiReplayComm.h"
-#include "Common/FileUtil.h"
 
+#include <chrono>
+
+#include "Common/FileUtil.h"
 #include "Common/Logging/LogManager.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "Core/ConfigManager.h"
 
+// How often the background thread checks the config file for changes
+static const std::chrono::milliseconds POLL_INTERVAL(50);
+
 SlippiReplayComm::SlippiReplayComm()
 {
   WARN_LOG(EXPANSIONINTERFACE, "SlippiReplayComm: Using playback config path: %s",
            SConfig::GetInstance().m_strSlippiInput.c_str());
   configFilePath = SConfig::GetInstance().m_strSlippiInput.c_str();
+
+  // Pick up whatever is in the file right away so the first replay doesn't wait a poll interval
+  checkConfigFile();
+
+  m_thread = std::thread([this] { pollThread(); });
 }
 
 SlippiReplayComm::~SlippiReplayComm()
 {
+  m_shutdown.Set();
+  m_wakeup.Set();
+  m_thread.join();
 }
 
-bool SlippiReplayComm::isReplayReady()
+void SlippiReplayComm::pollThread()
 {
-  std::string replayFilePath;
-  File::ReadFileToString(configFilePath, replayFilePath);
+  Common::SetCurrentThreadName("Slippi Replay Comm");
+
+  while (!m_shutdown.IsSet())
+  {
+    m_wakeup.WaitFor(POLL_INTERVAL);
+    checkConfigFile();
+  }
+}
+
+void SlippiReplayComm::checkConfigFile()
+{
+  std::string contents;
+  File::ReadFileToString(configFilePath, contents);
+
+  if (contents == previousConfigContents)
+    return;
+
+  previousConfigContents = contents;
+
+  std::deque<std::string> replays;
+  std::string seekLine;
+  for (const std::string& line : SplitString(contents, '\n'))
+  {
+    std::string entry = StripSpaces(line);
+    if (entry.empty())
+      continue;
+
+    if (StringBeginsWith(entry, "seek "))
+      seekLine = entry;
+    else
+      replays.push_back(entry);
+  }
+
+  // Only a change of the seek target, don't restart playback for it
+  if (!seekLine.empty() && seekLine != previousSeekLine)
+  {
+    int32_t frame;
+    if (TryParse(StripSpaces(seekLine.substr(5)), &frame))
+    {
+      m_seek_frame.store(frame, std::memory_order_relaxed);
+      m_has_seek_request.store(true, std::memory_order_release);
+    }
+  }
+  previousSeekLine = seekLine;
 
   // TODO: This logic for detecting a new replay isn't quite good enough
   // TODO: wont work in the case where someone tries to load the same
   // TODO: replay twice in a row
-  bool isNewReplay = replayFilePath != previousReplayLoaded;
-  bool isReplay = !!replayFilePath.length();
+  if (replays.empty() || replays == previousReplays)
+    return;
+
+  previousReplays = replays;
+
+  INFO_LOG(EXPANSIONINTERFACE, "SlippiReplayComm: Received %zu replay(s) to play back",
+           replays.size());
 
-  return isReplay && isNewReplay;
-  // return true;
+  std::lock_guard<std::mutex> lk(m_queue_lock);
+  m_queue = std::move(replays);
+  m_generation.fetch_add(1, std::memory_order_acq_rel);
+  m_has_queued_replay.store(true, std::memory_order_release);
+}
+
+bool SlippiReplayComm::getSeekRequest(int32_t* frame)
+{
+  if (!m_has_seek_request.exchange(false, std::memory_order_acquire))
+    return false;
+
+  *frame = m_seek_frame.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool SlippiReplayComm::isReplayReady()
+{
+  return m_has_queued_replay.load(std::memory_order_acquire);
 }
 
 std::string SlippiReplayComm::getReplay()
 {
-  std::string replayFilePath;
-  File::ReadFileToString(configFilePath, replayFilePath);
+  std::lock_guard<std::mutex> lk(m_queue_lock);
+  if (m_queue.empty())
+    return "";
+
+  // Read the generation under the lock so it always matches the queue it came from
+  m_loaded_generation = m_generation.load(std::memory_order_acquire);
 
-  previousReplayLoaded = replayFilePath;
+  std::string replayFilePath = std::move(m_queue.front());
+  m_queue.pop_front();
+  m_has_queued_replay.store(!m_queue.empty(), std::memory_order_release);
 
   return replayFilePath;
-  // return "C:/Dolphin/FM-v5.9-Slippi-r10-Win/Slippi/Console/file1.bin";
 }
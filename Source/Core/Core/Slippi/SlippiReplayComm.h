@@ -1,16 +1,60 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
 
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/Flag.h"
+
+// Watches the playback config file written by the launcher on a background thread. The file
+// contains one replay path per line; every time the list changes, the listed replays replace
+// the queue of replays to play back-to-back. A line of the form "seek <frame>" asks playback to
+// jump to the given frame of the current replay. The emulation thread only ever looks at
+// in-memory state, no file is touched on the frame hot path.
 class SlippiReplayComm
 {
 public:
   SlippiReplayComm();
   ~SlippiReplayComm();
+
+  // A queued replay is waiting to be loaded
   bool isReplayReady();
+
+  // Pops the next queued replay
   std::string getReplay();
 
+  // Bumped every time the launcher requests a new set of replays. Playback of a replay should be
+  // cut short once this no longer matches the generation it was loaded from
+  u32 getGeneration() const { return m_generation.load(std::memory_order_acquire); }
+  u32 getLoadedGeneration() const { return m_loaded_generation; }
+
+  // Returns true (once) if a new seek target was written to the config file
+  bool getSeekRequest(int32_t* frame);
+
 private:
+  void pollThread();
+  void checkConfigFile();
+
   std::string configFilePath;
-  std::string previousReplayLoaded;
+  std::string previousConfigContents;
+  std::string previousSeekLine;
+  std::deque<std::string> previousReplays;
+
+  std::thread m_thread;
+  Common::Event m_wakeup;
+  Common::Flag m_shutdown;
+
+  std::mutex m_queue_lock;
+  std::deque<std::string> m_queue;
+
+  std::atomic<u32> m_generation{0};
+  std::atomic<bool> m_has_queued_replay{false};
+  u32 m_loaded_generation = 0;
+
+  std::atomic<bool> m_has_seek_request{false};
+  std::atomic<int32_t> m_seek_frame{0};
 };
@@ -0,0 +1,324 @@
+#include "SlippiReplayWriter.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#include <share.h>
+#endif
+
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
+
+// Offset of the raw element length inside the header below
+static const u32 RAW_SIZE_OFFSET = 11;
+
+// Compressed blocks are written once they hold this much event data or once their oldest data
+// has waited this long, whichever comes first. Bigger blocks compress better, the age limit
+// bounds how far behind someone following the file can be
+static const size_t COMPRESSED_BLOCK_SIZE = 64 * 1024;
+static const u64 MAX_BLOCK_AGE_US = 1000 * 1000;
+
+SlippiReplayWriter::SlippiReplayWriter()
+{
+  for (size_t i = 0; i < QUEUE_SIZE; i++)
+  {
+    m_jobs[i].data.reserve(BUFFER_RESERVE_SIZE);
+    m_free_queue.TryPush(&m_jobs[i]);
+  }
+
+  m_pending = &m_jobs[QUEUE_SIZE];
+  m_pending->data.reserve(BUFFER_RESERVE_SIZE);
+
+  m_thread = std::thread([this] { ThreadLoop(); });
+}
+
+SlippiReplayWriter::~SlippiReplayWriter()
+{
+  SubmitBlocking();
+
+  m_shutdown.Set();
+  m_wakeup.Set();
+  m_thread.join();
+}
+
+void SlippiReplayWriter::OpenFile(const std::string& path, bool compress)
+{
+  EndPendingFile();
+  m_pending->open_path = path;
+  m_pending->compress = compress;
+  m_is_file_open = true;
+}
+
+void SlippiReplayWriter::Write(const u8* payload, u32 length)
+{
+  if (!m_is_file_open)
+    return;
+
+  m_pending->data.insert(m_pending->data.end(), payload, payload + length);
+}
+
+void SlippiReplayWriter::CloseFile(FinalizeFunction finalize)
+{
+  if (!m_is_file_open)
+    return;
+
+  EndPendingFile();
+  m_pending->finalize = std::move(finalize);
+  m_is_file_open = false;
+}
+
+// Marks where the data of the current file ends in the pending job
+void SlippiReplayWriter::EndPendingFile()
+{
+  // A job only has room for one file change. Nothing was written to the file opened in it yet if
+  // it also gets closed, and only if the writer thread is a whole ring behind.
+  if (!m_pending->open_path.empty())
+    SubmitBlocking();
+
+  if (!m_pending->HasFileEnd())
+    m_pending->file_end = m_pending->data.size();
+}
+
+void SlippiReplayWriter::Submit()
+{
+  if (m_pending->data.empty() && !m_pending->HasFileEnd())
+    return;
+
+  TrySubmit();
+}
+
+bool SlippiReplayWriter::TrySubmit()
+{
+  // Data that stays pending because the ring is full has waited since the first attempt
+  if (m_pending->submit_time_us == 0)
+    m_pending->submit_time_us = Common::Timer::GetTimeUs();
+
+  // There is always one job more than there are ring slots, so if a free job is available the
+  // submit ring is guaranteed to have room
+  if (m_free_queue.Empty())
+    return false;
+
+  m_submit_queue.TryPush(m_pending);
+  m_free_queue.Pop(m_pending);
+  m_wakeup.Set();
+
+  u32 depth = m_submit_queue.Size();
+  if (depth > m_max_queue_depth.load(std::memory_order_relaxed))
+    m_max_queue_depth.store(depth, std::memory_order_relaxed);
+
+  return true;
+}
+
+void SlippiReplayWriter::SubmitBlocking()
+{
+  while (!TrySubmit())
+  {
+    m_wakeup.Set();
+    Common::SleepCurrentThread(1);
+  }
+}
+
+SlippiReplayWriter::Stats SlippiReplayWriter::GetStats() const
+{
+  Stats stats;
+  stats.queue_depth = m_submit_queue.Size();
+  stats.max_queue_depth = m_max_queue_depth.load(std::memory_order_relaxed);
+  stats.max_write_latency_us = m_max_write_latency_us.load(std::memory_order_relaxed);
+  stats.bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void SlippiReplayWriter::ResetStats()
+{
+  m_max_queue_depth.store(0, std::memory_order_relaxed);
+  m_max_write_latency_us.store(0, std::memory_order_relaxed);
+  m_bytes_written.store(0, std::memory_order_relaxed);
+}
+
+void SlippiReplayWriter::ThreadLoop()
+{
+  Common::SetCurrentThreadName("Slippi Replay Writer");
+
+  while (true)
+  {
+    // A partially filled compressed block still needs to go out in time if no more data comes
+    if (m_encoder.pendingSize() != 0)
+      m_wakeup.WaitFor(std::chrono::microseconds(MAX_BLOCK_AGE_US));
+    else
+      m_wakeup.Wait();
+
+    // Drain everything that has been queued and flush once for the whole batch. Jobs come in
+    // the order they were submitted, so the first one has waited the longest
+    u64 oldest_submit_time_us = 0;
+    Job* job;
+    while (m_submit_queue.Pop(job))
+    {
+      if (oldest_submit_time_us == 0)
+        oldest_submit_time_us = job->submit_time_us;
+
+      ProcessJob(*job);
+
+      job->data.clear();
+      job->file_end = 0;
+      job->finalize = nullptr;
+      job->open_path.clear();
+      job->compress = false;
+      job->submit_time_us = 0;
+      m_free_queue.TryPush(job);
+    }
+
+    if (m_file && m_is_compressed && m_encoder.pendingSize() != 0)
+    {
+      u64 age = Common::Timer::GetTimeUs() - m_block_start_us;
+      if (m_encoder.pendingSize() >= COMPRESSED_BLOCK_SIZE || age >= MAX_BLOCK_AGE_US)
+        WriteBlock();
+    }
+
+    if (m_file)
+      m_file.Flush();
+
+    if (oldest_submit_time_us != 0)
+    {
+      const u64 latency = Common::Timer::GetTimeUs() - oldest_submit_time_us;
+      if (latency > m_max_write_latency_us.load(std::memory_order_relaxed))
+        m_max_write_latency_us.store(latency, std::memory_order_relaxed);
+    }
+
+    if (m_shutdown.IsSet() && m_submit_queue.Empty())
+      break;
+  }
+
+  // Keep whatever was written if the game never ended
+  if (m_file)
+    CloseUnfinishedFile();
+}
+
+void SlippiReplayWriter::ProcessJob(Job& job)
+{
+  const size_t file_end = job.HasFileEnd() ? job.file_end : job.data.size();
+  WriteData(job.data.data(), file_end);
+
+  if (job.finalize)
+    FinalizeFile(job.finalize);
+
+  if (!job.open_path.empty())
+    OpenNewFile(job.open_path, job.compress);
+
+  WriteData(job.data.data() + file_end, job.data.size() - file_end);
+}
+
+void SlippiReplayWriter::OpenNewFile(const std::string& path, bool compress)
+{
+  if (m_file)
+    CloseUnfinishedFile();
+
+  File::CreateFullPath(path);
+
+#ifdef _WIN32
+  m_file = File::IOFile(path, "wb", _SH_DENYWR);
+#else
+  m_file = File::IOFile(path, "wb");
+#endif
+
+  if (!m_file)
+    ERROR_LOG(EXPANSIONINTERFACE, "Failed to create replay file %s.", path.c_str());
+
+  m_raw_size = 0;
+  m_is_compressed = compress;
+  m_encoder.reset();
+
+  if (m_is_compressed)
+  {
+    m_block_bytes.clear();
+    Slippi::writeCompressedHeader(m_block_bytes);
+    WriteToFile(m_block_bytes.data(), m_block_bytes.size());
+  }
+  else
+  {
+    // Start ubjson file and prepare the "raw" element that game
+    // data output will be dumped into. The size of the raw output will
+    // be initialized to 0 until all of the data has been received
+    static const u8 header[] = {'{', 'U', 3, 'r', 'a', 'w', '[', '$', 'U', '#', 'l', 0, 0, 0, 0};
+    WriteToFile(header, sizeof(header));
+  }
+}
+
+void SlippiReplayWriter::WriteData(const u8* data, size_t length)
+{
+  if (!m_file || length == 0)
+    return;
+
+  if (m_is_compressed)
+  {
+    if (m_encoder.pendingSize() == 0)
+      m_block_start_us = Common::Timer::GetTimeUs();
+    m_encoder.appendEvents(data, length);
+  }
+  else
+  {
+    WriteToFile(data, length);
+  }
+
+  m_raw_size += static_cast<u32>(length);
+}
+
+void SlippiReplayWriter::FinalizeFile(const FinalizeFunction& finalize)
+{
+  if (!m_file)
+    return;
+
+  // This option indicates we are done sending over body
+  m_closing_bytes.Clear();
+  finalize(m_closing_bytes, m_raw_size);
+
+  if (m_is_compressed)
+  {
+    // The metadata gets a block of its own, there is no raw size to patch
+    WriteBlock();
+    m_block_bytes.clear();
+    Slippi::writeCompressedBlock(Slippi::BLOCK_TYPE_METADATA, m_closing_bytes.Data(),
+                                 m_closing_bytes.Size(), m_block_bytes);
+    WriteToFile(m_block_bytes.data(), m_block_bytes.size());
+  }
+  else
+  {
+    WriteToFile(m_closing_bytes.Data(), m_closing_bytes.Size());
+
+    // Write the number of bytes for the raw output
+    u8 size_bytes[4] = {static_cast<u8>(m_raw_size >> 24), static_cast<u8>(m_raw_size >> 16),
+                        static_cast<u8>(m_raw_size >> 8), static_cast<u8>(m_raw_size)};
+    m_file.Seek(RAW_SIZE_OFFSET, SEEK_SET);
+    m_file.WriteBytes(size_bytes, sizeof(size_bytes));
+  }
+
+  m_file.Close();
+}
+
+void SlippiReplayWriter::CloseUnfinishedFile()
+{
+  if (m_is_compressed)
+    WriteBlock();
+
+  m_file.Close();
+}
+
+void SlippiReplayWriter::WriteBlock()
+{
+  m_block_bytes.clear();
+  m_encoder.finishBlock(m_block_bytes);
+  WriteToFile(m_block_bytes.data(), m_block_bytes.size());
+}
+
+void SlippiReplayWriter::WriteToFile(const u8* data, size_t length)
+{
+  if (length == 0)
+    return;
+
+  if (!m_file.WriteBytes(data, length))
+    ERROR_LOG(EXPANSIONINTERFACE, "Failed to write data to file.");
+
+  m_bytes_written.fetch_add(length, std::memory_order_relaxed);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/File.h"
+#include "Common/Flag.h"
+#include "Common/SPSCQueue.h"
+#include "Core/Slippi/SlippiBufferWriter.h"
+
+#include <SlippiCompression.h>
+
+// Writes .slp replay files on a dedicated thread so a slow disk never stalls the CPU thread.
+// Payloads are appended into a pooled buffer on the CPU thread and handed off in batches through
+// a fixed size lock-free ring. Opening, flushing, patching the raw size into the header and
+// writing the metadata all happen on the writer thread.
+//
+// Files can optionally be written in SlippiLib's compressed format instead. Events are then
+// delta coded and gathered into blocks, which get compressed and written once they are big or old
+// enough so that in progress games can still be followed from the file.
+class SlippiReplayWriter
+{
+public:
+  // Runs on the writer thread once all raw data has been written. Receives the size of the raw
+  // element and writes the bytes that complete the UBJSON document.
+  using FinalizeFunction = std::function<void(SlippiBufferWriter& out, u32 raw_size)>;
+
+  struct Stats
+  {
+    u32 queue_depth;
+    u32 max_queue_depth;
+    // From the first attempt to submit data until the writer thread has written and flushed it.
+    // Compressed data counts as written once it is in the encoder, blocks wait on purpose
+    u64 max_write_latency_us;
+    u64 bytes_written;
+  };
+
+  SlippiReplayWriter();
+  ~SlippiReplayWriter();
+
+  // These must only be called from a single (emulation) thread. Opening and closing files only
+  // takes effect on the writer thread once the pending data gets submitted.
+  void OpenFile(const std::string& path, bool compress);
+  void Write(const u8* payload, u32 length);
+  void CloseFile(FinalizeFunction finalize);
+
+  // Hands everything written so far to the writer thread without blocking. If the ring is full
+  // the data stays in the pending buffer and goes out with the next submission.
+  void Submit();
+
+  bool IsFileOpen() const { return m_is_file_open; }
+  Stats GetStats() const;
+  void ResetStats();
+
+private:
+  static constexpr size_t QUEUE_SIZE = 64;
+  static constexpr size_t BUFFER_RESERVE_SIZE = 16 * 1024;
+  // Enough for the metadata of any regular game, the buffer grows for anything bigger
+  static constexpr size_t METADATA_BUFFER_SIZE = 4 * 1024;
+
+  // The data before file_end goes to the file that is open when the job gets processed. That file
+  // is then finalized if finalize is set, and the rest of the data goes to open_path if that's set
+  struct Job
+  {
+    std::vector<u8> data;
+    size_t file_end = 0;
+    FinalizeFunction finalize;
+    std::string open_path;
+    bool compress = false;
+    u64 submit_time_us = 0;
+
+    bool HasFileEnd() const { return finalize || !open_path.empty(); }
+  };
+
+  bool TrySubmit();
+  void SubmitBlocking();
+  void EndPendingFile();
+  void ThreadLoop();
+  void ProcessJob(Job& job);
+  void OpenNewFile(const std::string& path, bool compress);
+  void WriteData(const u8* data, size_t length);
+  void FinalizeFile(const FinalizeFunction& finalize);
+  void CloseUnfinishedFile();
+  void WriteBlock();
+  void WriteToFile(const u8* data, size_t length);
+
+  // One more job than ring slots so that the CPU thread always owns a pending job
+  std::array<Job, QUEUE_SIZE + 1> m_jobs;
+  Common::FixedSPSCQueue<Job*, QUEUE_SIZE> m_submit_queue;
+  Common::FixedSPSCQueue<Job*, QUEUE_SIZE> m_free_queue;
+  Job* m_pending;
+  bool m_is_file_open = false;
+
+  std::thread m_thread;
+  Common::Event m_wakeup;
+  Common::Flag m_shutdown;
+
+  // Only touched by the writer thread
+  File::IOFile m_file;
+  u32 m_raw_size = 0;
+  bool m_is_compressed = false;
+  Slippi::ReplayEncoder m_encoder;
+  std::vector<u8> m_block_bytes;
+  u64 m_block_start_us = 0;
+  SlippiBufferWriter m_closing_bytes{METADATA_BUFFER_SIZE};
+
+  std::atomic<u32> m_max_queue_depth{0};
+  std::atomic<u64> m_max_write_latency_us{0};
+  std::atomic<u64> m_bytes_written{0};
+};
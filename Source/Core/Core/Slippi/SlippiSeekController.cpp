@@ -0,0 +1,150 @@
+#include "SlippiSeekController.h"
+
+#include <iterator>
+
+#include "Common/Logging/Log.h"
+#include "Common/Timer.h"
+#include "Core/Core.h"
+#include "Core/HW/SystemTimers.h"
+#include "Core/State.h"
+
+void SlippiSeekController::Reset()
+{
+  CancelSeek();
+  m_has_played_frame = false;
+
+  u32 generation = m_state->generation.fetch_add(1) + 1;
+  Core::QueueHostJob([state = m_state, generation] {
+    if (state->generation.load() != generation)
+      return;
+
+    state->snapshots.clear();
+    state->snapshot_bytes = 0;
+    state->snapshot_interval.store(INITIAL_SNAPSHOT_INTERVAL);
+  });
+}
+
+void SlippiSeekController::OnFramePlayed(s32 frame)
+{
+  m_state->last_played_frame.store(frame);
+
+  if (m_is_seeking && frame >= m_seek_target)
+  {
+    INFO_LOG(EXPANSIONINTERFACE, "SlippiSeekController: Reached seek target %d", frame);
+    CancelSeek();
+  }
+
+  // The very first frame always gets a snapshot so that every frame can be seeked to
+  if (!m_has_played_frame)
+  {
+    m_has_played_frame = true;
+    m_next_snapshot_frame = frame;
+  }
+
+  if (frame < m_next_snapshot_frame || m_state->is_snapshot_pending.load())
+    return;
+
+  m_next_snapshot_frame = frame + m_state->snapshot_interval.load();
+  m_state->is_snapshot_pending.store(true);
+
+  u32 generation = m_state->generation.load();
+  Core::QueueHostJob([state = m_state, generation] { CaptureSnapshot(*state, generation); });
+}
+
+void SlippiSeekController::Seek(s32 target_frame)
+{
+  if (!m_has_played_frame)
+    return;
+
+  INFO_LOG(EXPANSIONINTERFACE, "SlippiSeekController: Seeking to frame %d", target_frame);
+
+  m_is_seeking = true;
+  m_seek_target = target_frame;
+  // Not Core::SetIsThrottlerTempDisabled, which the hotkey handling of the frontends overwrites
+  SystemTimers::SuspendThrottle();
+
+  u32 generation = m_state->generation.load();
+  Core::QueueHostJob(
+      [state = m_state, generation, target_frame] {
+        RestoreSnapshot(*state, generation, target_frame);
+      });
+}
+
+void SlippiSeekController::CancelSeek()
+{
+  if (!m_is_seeking)
+    return;
+
+  SystemTimers::ResumeThrottle();
+  m_is_seeking = false;
+}
+
+void SlippiSeekController::CaptureSnapshot(HostState& state, u32 generation)
+{
+  if (state.generation.load() == generation && Core::GetState() != Core::State::Uninitialized)
+  {
+    u64 start = Common::Timer::GetTimeUs();
+
+    // The CPU is paused while the state is saved, so the frame read here matches the snapshot
+    std::vector<u8> buffer;
+    s32 frame = 0;
+    Core::RunAsCPUThread([&] {
+      frame = state.last_played_frame.load();
+      State::SaveToBuffer(buffer);
+    });
+
+    std::vector<u8>& snapshot = state.snapshots[frame];
+    state.snapshot_bytes += buffer.size();
+    state.snapshot_bytes -= snapshot.size();
+    snapshot = std::move(buffer);
+
+    INFO_LOG(EXPANSIONINTERFACE, "SlippiSeekController: Captured snapshot at frame %d in %llu us",
+             frame, (unsigned long long)(Common::Timer::GetTimeUs() - start));
+
+    while (state.snapshot_bytes > MAX_SNAPSHOT_BYTES && state.snapshots.size() > 1)
+    {
+      // Keep the first snapshot and every other one after it
+      auto it = std::next(state.snapshots.begin());
+      while (it != state.snapshots.end())
+      {
+        state.snapshot_bytes -= it->second.size();
+        it = state.snapshots.erase(it);
+        if (it != state.snapshots.end())
+          ++it;
+      }
+
+      state.snapshot_interval.store(state.snapshot_interval.load() * 2);
+    }
+  }
+
+  state.is_snapshot_pending.store(false);
+}
+
+void SlippiSeekController::RestoreSnapshot(HostState& state, u32 generation, s32 target_frame)
+{
+  if (state.generation.load() != generation || state.snapshots.empty() ||
+      Core::GetState() == Core::State::Uninitialized)
+  {
+    return;
+  }
+
+  // Closest snapshot at or before the target
+  auto it = state.snapshots.upper_bound(target_frame);
+  if (it != state.snapshots.begin())
+    --it;
+
+  // Seeking a bit forward is cheaper by just fast-forwarding from where we are
+  s32 current_frame = state.last_played_frame.load();
+  if (target_frame >= current_frame && it->first <= current_frame)
+    return;
+
+  u64 start = Common::Timer::GetTimeUs();
+  Core::RunAsCPUThread([&] {
+    State::LoadFromBuffer(it->second);
+    state.last_played_frame.store(it->first);
+  });
+
+  INFO_LOG(EXPANSIONINTERFACE,
+           "SlippiSeekController: Restored snapshot at frame %d for target %d in %llu us",
+           it->first, target_frame, (unsigned long long)(Common::Timer::GetTimeUs() - start));
+}
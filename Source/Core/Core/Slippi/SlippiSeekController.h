@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Lets replay playback jump to arbitrary frames. While a replay plays, savestates are captured
+// into memory at regular frame intervals. Seeking restores the closest snapshot at or before the
+// target frame and then fast-forwards (throttling disabled) until the game requests the target.
+//
+// The replay data itself needs no extra index for this, SlippiGame already stores frames densely
+// by frame number so any parsed frame can be served directly after a restore.
+//
+// Savestates are taken and loaded from host jobs so that the CPU is paused at a clean point
+// rather than in the middle of the EXI transfer that requested them. The snapshot map is only
+// ever touched from those jobs.
+class SlippiSeekController
+{
+public:
+  // Called on the CPU thread
+  void Reset();
+  void OnFramePlayed(s32 frame);
+  void Seek(s32 target_frame);
+  void CancelSeek();
+  bool IsSeeking() const { return m_is_seeking; }
+
+private:
+  // Snapshots are thinned out (dropping every other one and doubling the interval) once they take
+  // up more memory than this, so memory use stays bounded no matter how long the replay is. A full
+  // savestate is about 40 MiB.
+  static const size_t MAX_SNAPSHOT_BYTES = 256 * 1024 * 1024;
+  static const s32 INITIAL_SNAPSHOT_INTERVAL = 600;
+
+  // Shared with the host jobs, which may still be queued when the device goes away
+  struct HostState
+  {
+    std::map<s32, std::vector<u8>> snapshots;
+    size_t snapshot_bytes = 0;
+
+    std::atomic<s32> last_played_frame{0};
+    std::atomic<s32> snapshot_interval{INITIAL_SNAPSHOT_INTERVAL};
+    std::atomic<bool> is_snapshot_pending{false};
+
+    // Bumped by Reset so jobs queued for a previous replay are ignored
+    std::atomic<u32> generation{0};
+  };
+
+  static void CaptureSnapshot(HostState& state, u32 generation);
+  static void RestoreSnapshot(HostState& state, u32 generation, s32 target_frame);
+
+  std::shared_ptr<HostState> m_state = std::make_shared<HostState>();
+
+  // CPU thread only
+  bool m_is_seeking = false;
+  s32 m_seek_target = 0;
+  s32 m_next_snapshot_frame = 0;
+  bool m_has_played_frame = false;
+};
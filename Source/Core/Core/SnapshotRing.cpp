@@ -0,0 +1,522 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/SnapshotRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Logging/Log.h"
+#include "Common/Timer.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+#include "Core/State.h"
+
+// Write faults can only be caught where MemTools installs a process wide handler. The Mach
+// exception handler used on macOS by default only covers the CPU thread.
+#if defined(_WIN32) ||                                                                             \
+    (defined(_POSIX_VERSION) && !defined(_M_GENERIC) &&                                           \
+     (!defined(__APPLE__) || defined(USE_SIGACTION_ON_APPLE)))
+#define HAS_WRITE_FAULT_TRACKING
+#endif
+
+namespace State
+{
+static bool s_skip_memory = false;
+
+namespace
+{
+struct TrackedRegion
+{
+  u8* pointer;
+  u32 size;
+  std::vector<u8> shadow;
+  std::unique_ptr<std::atomic<u8>[]> dirty;
+  // Scratch space for Restore
+  std::vector<u8> touched;
+};
+
+struct TrackedView
+{
+  u8* pointer;
+  u32 size;
+  u32 region;
+  u32 region_offset;
+
+  bool operator<(const TrackedView& other) const { return pointer < other.pointer; }
+};
+
+using TrackedViews = std::vector<TrackedView>;
+
+struct Tracker
+{
+  SnapshotSource* source;
+  u32 page_size;
+  bool use_write_faults;
+  std::vector<TrackedRegion> regions;
+  // Sorted by pointer, so the fault handler can search them. The handler may run on any thread at
+  // any time, so the views are never changed but replaced, and the replaced ones are only freed
+  // once tracking stops.
+  std::atomic<const TrackedViews*> views{nullptr};
+  std::vector<std::unique_ptr<const TrackedViews>> view_arrays;
+  u32 views_version;
+};
+
+class EmulatedSnapshotSource final : public SnapshotSource
+{
+public:
+  std::vector<Memory::MemoryView> GetViews() override
+  {
+    std::vector<Memory::MemoryView> views = Memory::GetMemoryViews();
+
+    // ARAM isn't part of the memory map, its only view is its own allocation. On the Wii it is
+    // EXRAM and part of the memory map
+    if (!SConfig::GetInstance().bWii && DSP::GetARAMPtr())
+      views.push_back({DSP::GetARAMPtr(), 0, DSP::GetARAMPtr(), DSP::ARAM_SIZE});
+
+    return views;
+  }
+
+  u32 GetViewsVersion() override { return Memory::GetMemoryViewsVersion(); }
+
+  // The exception handler is only installed for fastmem
+  bool IsExceptionHandlerInstalled() override { return SConfig::GetInstance().bFastmem; }
+
+  void SaveState(std::vector<u8>& buffer) override
+  {
+    s_skip_memory = true;
+    SaveToBuffer(buffer);
+    s_skip_memory = false;
+  }
+
+  void LoadState(std::vector<u8>& buffer) override
+  {
+    s_skip_memory = true;
+    LoadFromBufferForNetPlay(buffer);
+    s_skip_memory = false;
+  }
+};
+}  // namespace
+
+static std::unique_ptr<Tracker> s_tracker;
+// What the fault handler looks at, only set while the views are write protected
+static std::atomic<Tracker*> s_fault_tracker{nullptr};
+
+static u32 GetHostPageSize()
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return static_cast<u32>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Unlike Common::WriteProtectMemory this may fail quietly, the views may already be gone when
+// tracking stops after the emulation shut down
+static bool SetWritable(u8* pointer, size_t size, bool writable)
+{
+#if defined(_WIN32)
+  DWORD old_protect;
+  return VirtualProtect(pointer, size, writable ? PAGE_READWRITE : PAGE_READONLY, &old_protect) !=
+         0;
+#elif defined(HAS_WRITE_FAULT_TRACKING)
+  return mprotect(pointer, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ) == 0;
+#else
+  return false;
+#endif
+}
+
+static const TrackedViews& GetViews(const Tracker& tracker)
+{
+  return *tracker.views.load();
+}
+
+static void SetRegionWritable(Tracker& tracker, u32 region, u32 first_page, u32 page_count,
+                              bool writable, bool primary_view_only)
+{
+  const u32 start = first_page * tracker.page_size;
+  const u32 end = start + page_count * tracker.page_size;
+  for (const TrackedView& view : GetViews(tracker))
+  {
+    if (view.region != region)
+      continue;
+    if (primary_view_only && view.pointer != tracker.regions[region].pointer)
+      continue;
+
+    const u32 overlap_start = std::max(start, view.region_offset);
+    const u32 overlap_end = std::min(end, view.region_offset + view.size);
+    if (overlap_start < overlap_end)
+    {
+      SetWritable(view.pointer + (overlap_start - view.region_offset),
+                  overlap_end - overlap_start, writable);
+    }
+  }
+}
+
+static void SetAllViewsWritable(Tracker& tracker, bool writable)
+{
+  for (const TrackedView& view : GetViews(tracker))
+    SetWritable(view.pointer, view.size, writable);
+}
+
+// Clears the dirty bits of a run of pages and then write protects it again. Clearing them first
+// means that a write from another thread in between faults and sets the bit again, rather than
+// having the bit wiped after the handler lifted the protection.
+static void ProtectDirtyRun(Tracker& tracker, u32 region, u32 first_page, u32 page_count)
+{
+  for (u32 page = first_page; page < first_page + page_count; page++)
+    tracker.regions[region].dirty[page].exchange(0);
+  SetRegionWritable(tracker, region, first_page, page_count, false, false);
+}
+
+static void ProtectAllViews(Tracker& tracker)
+{
+  for (TrackedRegion& region : tracker.regions)
+  {
+    for (u32 page = 0; page < region.size / tracker.page_size; page++)
+      region.dirty[page].exchange(0);
+  }
+  SetAllViewsWritable(tracker, false);
+}
+
+// Calls callback(first_page, page_count) for every run of consecutive pages that are set
+template <typename IsSet, typename Callback>
+static void ForEachPageRun(u32 page_count, IsSet is_set, Callback callback)
+{
+  u32 page = 0;
+  while (page < page_count)
+  {
+    if (!is_set(page))
+    {
+      page++;
+      continue;
+    }
+
+    const u32 first = page;
+    while (page < page_count && is_set(page))
+      page++;
+    callback(first, page - first);
+  }
+}
+
+// Returns true if the views were created again since the last call. They are not write
+// protected then, so writes may have gone by unnoticed
+static bool UpdateViews(Tracker& tracker)
+{
+  const u32 version = tracker.source->GetViewsVersion();
+  if (version == tracker.views_version && tracker.views.load())
+    return false;
+
+  auto views = std::make_unique<TrackedViews>();
+  for (const Memory::MemoryView& view : tracker.source->GetViews())
+  {
+    for (u32 i = 0; i < tracker.regions.size(); i++)
+    {
+      if (tracker.regions[i].pointer == view.region)
+        views->push_back({view.pointer, view.size, i, view.region_offset});
+    }
+  }
+  std::sort(views->begin(), views->end());
+
+  tracker.views.store(views.get());
+  tracker.view_arrays.push_back(std::move(views));
+  tracker.views_version = version;
+  return true;
+}
+
+static bool StartTracking(SnapshotSource* source)
+{
+  if (s_tracker)
+  {
+    ERROR_LOG(CORE, "SnapshotRing: another snapshot ring is already active");
+    return false;
+  }
+
+  auto tracker = std::make_unique<Tracker>();
+  tracker->source = source;
+  tracker->page_size = GetHostPageSize();
+#ifdef HAS_WRITE_FAULT_TRACKING
+  tracker->use_write_faults = source->IsExceptionHandlerInstalled();
+#else
+  tracker->use_write_faults = false;
+#endif
+  tracker->views_version = 0;
+
+  std::vector<std::pair<u8*, u32>> regions;
+  for (const Memory::MemoryView& view : source->GetViews())
+  {
+    if (view.pointer == view.region && view.region_offset == 0)
+      regions.emplace_back(view.region, view.size);
+  }
+
+  for (const auto& region : regions)
+  {
+    TrackedRegion tracked;
+    tracked.pointer = region.first;
+    tracked.size = region.second;
+    tracked.shadow.assign(region.first, region.first + region.second);
+
+    const u32 page_count = region.second / tracker->page_size;
+    tracked.dirty = std::make_unique<std::atomic<u8>[]>(page_count);
+    for (u32 page = 0; page < page_count; page++)
+      tracked.dirty[page].store(0, std::memory_order_relaxed);
+
+    tracker->regions.push_back(std::move(tracked));
+  }
+
+  UpdateViews(*tracker);
+
+  if (tracker->use_write_faults)
+  {
+    SetAllViewsWritable(*tracker, false);
+    s_fault_tracker.store(tracker.get());
+  }
+
+  INFO_LOG(CORE, "SnapshotRing: tracking %zu memory regions through %zu views, %s",
+           tracker->regions.size(), GetViews(*tracker).size(),
+           tracker->use_write_faults ? "using write faults" : "comparing every page");
+
+  s_tracker = std::move(tracker);
+  return true;
+}
+
+static void StopTracking()
+{
+  if (!s_tracker)
+    return;
+
+  if (s_tracker->use_write_faults)
+    SetAllViewsWritable(*s_tracker, true);
+
+  s_fault_tracker.store(nullptr);
+  s_tracker.reset();
+}
+
+SnapshotRing::SnapshotRing(size_t capacity, std::unique_ptr<SnapshotSource> source)
+    : m_source(source ? std::move(source) : std::make_unique<EmulatedSnapshotSource>()),
+      m_slots(std::max<size_t>(1, capacity))
+{
+}
+
+SnapshotRing::~SnapshotRing()
+{
+  if (m_is_tracking)
+    StopTracking();
+}
+
+bool SnapshotRing::Save()
+{
+  const u64 start = Common::Timer::GetTimeUs();
+
+  if (!m_is_tracking)
+  {
+    if (!StartTracking(m_source.get()))
+      return false;
+    m_is_tracking = true;
+  }
+
+  Tracker& tracker = *s_tracker;
+  const bool check_all_pages = UpdateViews(tracker) || !tracker.use_write_faults;
+
+  if (m_count == m_slots.size())
+  {
+    m_first = (m_first + 1) % m_slots.size();
+    m_count--;
+  }
+
+  Snapshot& snapshot = GetSlot(m_count);
+  snapshot.pages.clear();
+  snapshot.page_data.clear();
+
+  // Pages are write protected again before they are copied, so writes from other threads that
+  // happen during the copy are caught for the next snapshot.
+  if (tracker.use_write_faults && check_all_pages)
+    ProtectAllViews(tracker);
+
+  const u32 page_size = tracker.page_size;
+  for (u32 region_index = 0; region_index < tracker.regions.size(); region_index++)
+  {
+    TrackedRegion& region = tracker.regions[region_index];
+    const u32 page_count = region.size / page_size;
+
+    const auto save_page = [&](u32 page) {
+      const u8* current = region.pointer + page * page_size;
+      u8* shadow = &region.shadow[page * page_size];
+      if (std::memcmp(current, shadow, page_size) == 0)
+        return;
+
+      snapshot.pages.push_back({region_index, page});
+      snapshot.page_data.insert(snapshot.page_data.end(), shadow, shadow + page_size);
+      std::memcpy(shadow, current, page_size);
+    };
+
+    if (check_all_pages)
+    {
+      for (u32 page = 0; page < page_count; page++)
+        save_page(page);
+      continue;
+    }
+
+    ForEachPageRun(
+        page_count, [&](u32 page) { return region.dirty[page].load() != 0; },
+        [&](u32 first, u32 count) {
+          ProtectDirtyRun(tracker, region_index, first, count);
+          for (u32 page = first; page < first + count; page++)
+            save_page(page);
+        });
+  }
+
+  m_source->SaveState(snapshot.state);
+
+  m_count++;
+  m_last_page_count = static_cast<u32>(snapshot.pages.size());
+  m_last_save_us = Common::Timer::GetTimeUs() - start;
+  return true;
+}
+
+bool SnapshotRing::Restore(size_t index)
+{
+  if (!m_is_tracking || index >= m_count)
+    return false;
+
+  const u64 start = Common::Timer::GetTimeUs();
+  Tracker& tracker = *s_tracker;
+  const bool check_all_pages = UpdateViews(tracker) || !tracker.use_write_faults;
+  const u32 page_size = tracker.page_size;
+
+  // Everything that changed since the newest snapshot or is stored in a newer snapshot than the
+  // requested one has to be written
+  for (TrackedRegion& region : tracker.regions)
+  {
+    const u32 page_count = region.size / page_size;
+    region.touched.assign(page_count, 0);
+    for (u32 page = 0; page < page_count; page++)
+    {
+      if (!check_all_pages && !region.dirty[page].load(std::memory_order_relaxed))
+        continue;
+
+      if (std::memcmp(region.pointer + page * page_size, &region.shadow[page * page_size],
+                      page_size) != 0)
+      {
+        region.touched[page] = 1;
+      }
+    }
+  }
+
+  for (size_t i = index + 1; i < m_count; i++)
+  {
+    for (const SavedPage& saved : GetSlot(i).pages)
+      tracker.regions[saved.region].touched[saved.page] = 1;
+  }
+
+  u32 written_pages = 0;
+  for (u32 region_index = 0; region_index < tracker.regions.size(); region_index++)
+  {
+    TrackedRegion& region = tracker.regions[region_index];
+    const u32 page_count = region.size / page_size;
+
+    if (tracker.use_write_faults)
+    {
+      ForEachPageRun(
+          page_count, [&](u32 page) { return region.touched[page] != 0; },
+          [&](u32 first, u32 count) {
+            SetRegionWritable(tracker, region_index, first, count, true, true);
+          });
+    }
+
+    // Back to the newest snapshot
+    for (u32 page = 0; page < page_count; page++)
+    {
+      if (!region.touched[page])
+        continue;
+
+      std::memcpy(region.pointer + page * page_size, &region.shadow[page * page_size], page_size);
+      written_pages++;
+    }
+  }
+
+  // Then step back one snapshot at a time
+  for (size_t i = m_count - 1; i > index; i--)
+  {
+    const Snapshot& snapshot = GetSlot(i);
+    for (size_t j = 0; j < snapshot.pages.size(); j++)
+    {
+      TrackedRegion& region = tracker.regions[snapshot.pages[j].region];
+      const u32 offset = snapshot.pages[j].page * page_size;
+      const u8* data = &snapshot.page_data[j * page_size];
+      std::memcpy(region.pointer + offset, data, page_size);
+      std::memcpy(&region.shadow[offset], data, page_size);
+    }
+  }
+
+  m_source->LoadState(GetSlot(index).state);
+
+  // Loading the state may have mapped the BATs differently, the new views aren't protected then.
+  // Otherwise only the pages written since the newest snapshot or by the restore are writable
+  if (tracker.use_write_faults && (UpdateViews(tracker) || check_all_pages))
+  {
+    ProtectAllViews(tracker);
+  }
+  else if (tracker.use_write_faults)
+  {
+    for (u32 region_index = 0; region_index < tracker.regions.size(); region_index++)
+    {
+      TrackedRegion& region = tracker.regions[region_index];
+      ForEachPageRun(
+          region.size / page_size,
+          [&](u32 page) { return region.touched[page] || region.dirty[page].load(); },
+          [&](u32 first, u32 count) { ProtectDirtyRun(tracker, region_index, first, count); });
+    }
+  }
+
+  m_count = index + 1;
+  m_last_page_count = written_pages;
+  m_last_restore_us = Common::Timer::GetTimeUs() - start;
+  return true;
+}
+
+bool SkipMemoryInDoState()
+{
+  return s_skip_memory;
+}
+
+bool HandleSnapshotWriteFault(uintptr_t address)
+{
+  Tracker* tracker = s_fault_tracker.load();
+  if (!tracker)
+    return false;
+
+  // Last view starting at or before the address
+  const TrackedViews& views = GetViews(*tracker);
+  auto it = std::upper_bound(views.begin(), views.end(), address,
+                             [](uintptr_t value, const TrackedView& view) {
+                               return value < reinterpret_cast<uintptr_t>(view.pointer);
+                             });
+  if (it == views.begin())
+    return false;
+  --it;
+
+  const uintptr_t offset_in_view = address - reinterpret_cast<uintptr_t>(it->pointer);
+  if (offset_in_view >= it->size)
+    return false;
+
+  const u32 page = static_cast<u32>((it->region_offset + offset_in_view) / tracker->page_size);
+  tracker->regions[it->region].dirty[page].store(1);
+
+  u8* page_pointer = it->pointer + (page * tracker->page_size - it->region_offset);
+  return SetWritable(page_pointer, tracker->page_size, true);
+}
+}  // namespace State
@@ -0,0 +1,109 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/Memmap.h"
+
+namespace State
+{
+// What a snapshot ring tracks. Each memory region has to have a view of all of it at the region's
+// own address, other views of it may come and go.
+class SnapshotSource
+{
+public:
+  virtual ~SnapshotSource() = default;
+
+  virtual std::vector<Memory::MemoryView> GetViews() = 0;
+  // Has to change whenever views were created again, as that drops their write protection
+  virtual u32 GetViewsVersion() = 0;
+  // Whether the exception handler in MemTools is installed to catch writes
+  virtual bool IsExceptionHandlerInstalled() = 0;
+
+  // Everything else in a snapshot
+  virtual void SaveState(std::vector<u8>& buffer) = 0;
+  virtual void LoadState(std::vector<u8>& buffer) = 0;
+};
+
+// In-memory snapshots that are cheap enough to take every frame, e.g. for netplay rollback.
+//
+// Emulated memory (RAM, the locked L1 cache, FakeVMEM, EXRAM and ARAM) is nearly all of a
+// savestate, but only a small part of it changes from one frame to the next. So instead of going
+// through DoState, the ring keeps a shadow copy of every memory region as it was at the newest
+// snapshot. With fastmem, the regions are write protected after each snapshot and the first
+// write to a page is caught by the exception handler in MemTools, which marks the page as dirty
+// and lifts the protection again. Without it, every page is compared to the shadow copy instead.
+//
+// Saving stores the previous contents of each changed page in the new snapshot and updates the
+// shadow copy. Restoring reverts the pages changed since the newest snapshot and then applies
+// the stored pages from newest to oldest until the requested snapshot is reached. Everything
+// else still goes through DoState, minus the memory regions.
+//
+// Only one ring tracks memory at a time. Save, Restore and the destructor have to be called on
+// the CPU thread or while the CPU is paused.
+class SnapshotRing
+{
+public:
+  // Without a source, the ring snapshots the emulated system
+  explicit SnapshotRing(size_t capacity, std::unique_ptr<SnapshotSource> source = nullptr);
+  ~SnapshotRing();
+
+  SnapshotRing(const SnapshotRing&) = delete;
+  SnapshotRing& operator=(const SnapshotRing&) = delete;
+
+  // Snapshots are indexed from the oldest (0) to the newest (Size() - 1)
+  size_t Size() const { return m_count; }
+  size_t Capacity() const { return m_slots.size(); }
+
+  // Takes a new snapshot, dropping the oldest one if the ring is full
+  bool Save();
+  // Restores a snapshot and drops every snapshot newer than it
+  bool Restore(size_t index);
+
+  u64 GetLastSaveTimeUs() const { return m_last_save_us; }
+  u64 GetLastRestoreTimeUs() const { return m_last_restore_us; }
+  // Number of pages copied by the last Save or Restore
+  u32 GetLastPageCount() const { return m_last_page_count; }
+
+private:
+  struct SavedPage
+  {
+    u32 region;
+    u32 page;
+  };
+
+  struct Snapshot
+  {
+    // Page contents as of the previous snapshot, in the same order as pages
+    std::vector<SavedPage> pages;
+    std::vector<u8> page_data;
+    std::vector<u8> state;
+  };
+
+  Snapshot& GetSlot(size_t index) { return m_slots[(m_first + index) % m_slots.size()]; }
+
+  std::unique_ptr<SnapshotSource> m_source;
+  std::vector<Snapshot> m_slots;
+  size_t m_first = 0;
+  size_t m_count = 0;
+  bool m_is_tracking = false;
+
+  u64 m_last_save_us = 0;
+  u64 m_last_restore_us = 0;
+  u32 m_last_page_count = 0;
+};
+
+// True while a snapshot ring saves or restores the rest of the state
+bool SkipMemoryInDoState();
+
+// Called from the exception handler. Returns true if the fault was a write to a page of a memory
+// region tracked by a snapshot ring, in which case the write can be retried.
+bool HandleSnapshotWriteFault(uintptr_t address);
+}  // namespace State
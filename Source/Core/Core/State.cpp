@@ -207,6 +207,11 @@ void LoadFromBuffer(std::vector<u8>& buffer)
     return;
   }
 
+  LoadFromBufferForNetPlay(buffer);
+}
+
+void LoadFromBufferForNetPlay(std::vector<u8>& buffer)
+{
   Core::RunAsCPUThread([&] {
     u8* ptr = &buffer[0];
     PointerWrap p(&ptr, PointerWrap::MODE_READ);
@@ -49,6 +49,9 @@ void LoadAs(const std::string& filename);
 
 void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
+// Skips the netplay check. Only for netplay rollback, which restores the same inputs on every
+// client and so can't cause a desync
+void LoadFromBufferForNetPlay(std::vector<u8>& buffer);
 
 void LoadLastSaved(int i = 1);
 void SaveFirstSaved();
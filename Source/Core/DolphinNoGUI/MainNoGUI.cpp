@@ -16,6 +16,7 @@
 #include "Common/Flag.h"
 #include "Common/Logging/LogManager.h"
 #include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
 
 #include "Core/Analytics.h"
 #include "Core/Boot/Boot.h"
@@ -25,6 +26,8 @@
 #include "Core/Host.h"
 #include "Core/IOS/IOS.h"
 #include "Core/IOS/STM/STM.h"
+#include "Core/NetPlaySessionReplay.h"
+#include "Core/NetPlaySpectator.h"
 #include "Core/State.h"
 
 #include "UICommon/CommandLineParse.h"
@@ -370,6 +373,18 @@ static Platform* GetPlatform()
 int main(int argc, char* argv[])
 {
   auto parser = CommandLineParse::CreateParser(CommandLineParse::ParserOptions::OmitGUIOptions);
+  parser->add_option("--netplay_replay")
+      .action("store")
+      .metavar("<file>")
+      .help("Replay a netplay session log and report the first frame that diverges");
+  parser->add_option("--netplay_spectate")
+      .action("store")
+      .metavar("<host:port>")
+      .help("Watch the netplay game of a host, or of another spectator that relays it");
+  parser->add_option("--netplay_relay_port")
+      .action("store")
+      .metavar("<port>")
+      .help("While spectating, relay the game to other spectators on this port");
   optparse::Values& options = CommandLineParse::ParseArguments(parser.get(), argc, argv);
   std::vector<std::string> args = parser->args();
 
@@ -433,6 +448,32 @@ int main(int argc, char* argv[])
 
   DolphinAnalytics::Instance()->ReportDolphinStart("nogui");
 
+  const bool is_session_replay = options.is_set("netplay_replay");
+  if (is_session_replay &&
+      !NetPlay::StartSessionReplay(static_cast<const char*>(options.get("netplay_replay"))))
+  {
+    fprintf(stderr, "Could not read the netplay session log\n");
+    return 1;
+  }
+
+  const bool is_spectating = options.is_set("netplay_spectate");
+  if (is_spectating)
+  {
+    const std::string address = static_cast<const char*>(options.get("netplay_spectate"));
+    const size_t colon = address.find_last_of(':');
+    u16 port = 0;
+    u16 relay_port = 0;
+    if (colon == std::string::npos || !TryParse(address.substr(colon + 1), &port) ||
+        (options.is_set("netplay_relay_port") &&
+         !TryParse(static_cast<const char*>(options.get("netplay_relay_port")), &relay_port)) ||
+        !NetPlay::StartSpectating(address.substr(0, colon), port, relay_port,
+                                  [] { return !s_shutdown_requested.IsSet(); }))
+    {
+      fprintf(stderr, "Could not spectate %s\n", address.c_str());
+      return 1;
+    }
+  }
+
   if (!BootManager::BootCore(std::move(boot)))
   {
     fprintf(stderr, "Could not boot the specified file\n");
@@ -451,6 +492,10 @@ int main(int argc, char* argv[])
 
   if (s_running.IsSet())
     platform->MainLoop();
+
+  // The CPU may be waiting for inputs of the spectated game
+  if (is_spectating)
+    NetPlay::StopSpectating();
   Core::Stop();
 
   Core::Shutdown();
@@ -459,5 +504,19 @@ int main(int argc, char* argv[])
 
   delete platform;
 
+  if (is_spectating)
+  {
+    printf("%s\n", NetPlay::GetSessionReplaySummary().c_str());
+    NetPlay::StopSessionReplay();
+  }
+
+  if (is_session_replay)
+  {
+    printf("%s\n", NetPlay::GetSessionReplaySummary().c_str());
+    const bool found_divergence = NetPlay::HasSessionReplayFoundDivergence();
+    NetPlay::StopSessionReplay();
+    return found_divergence ? 2 : 0;
+  }
+
   return 0;
 }
@@ -205,7 +205,7 @@ void HacksWidget::AddDescriptions()
   static const char TR_ACCUARCY_DESCRIPTION[] = QT_TR_NOOP(
       "The \"Safe\" setting eliminates the likelihood of the GPU missing texture updates "
       "from RAM.\nLower accuracies cause in-game text to appear garbled in certain "
-      "games.\n\nIf unsure, use the rightmost value.");
+      "games.\n\nIf unsure, use the leftmost value.");
 
   static const char TR_STORE_XFB_TO_TEXTURE_DESCRIPTION[] = QT_TR_NOOP(
       "Stores XFB Copies exclusively on the GPU, bypassing system memory. Causes graphical defects "
@@ -27,6 +27,7 @@
 #include <QToolButton>
 #include <QTimer>
 
+#include <algorithm>
 #include <sstream>
 
 #include "Common/CommonPaths.h"
@@ -499,6 +500,9 @@ void NetPlayDialog::OnStart()
   settings.m_EnableGPUTextureDecoding = Config::Get(Config::GFX_ENABLE_GPU_TEXTURE_DECODING);
   settings.m_StrictSettingsSync = m_strict_settings_sync_box->isChecked();
   settings.m_SyncSaveData = m_sync_save_data_box->isChecked();
+  settings.m_DesyncHashRegions = Config::Get(Config::NETPLAY_DESYNC_HASH_REGIONS);
+  settings.m_DesyncHashBytesPerFrame =
+      static_cast<u32>(std::max(0, Config::Get(Config::NETPLAY_DESYNC_HASH_BYTES_PER_FRAME)));
 
   // Unload GameINI to restore things to normal
   Config::RemoveLayer(Config::LayerType::GlobalGame);
@@ -971,8 +975,30 @@ void NetPlayDialog::OnHostInputAuthorityChanged(bool enabled)
   }
 }
 
-void NetPlayDialog::OnDesync(u32 frame, const std::string& player)
+void NetPlayDialog::OnDesync(u32 first_frame, u32 frame, const std::string& player,
+                             u32 memory_address, u32 memory_size)
 {
+  if (memory_size != 0)
+  {
+    DisplayMessage(tr("Possible desync detected: %1 might have desynced between frames %2 and "
+                      "%3, memory 0x%4-0x%5 differs")
+                       .arg(QString::fromStdString(player), QString::number(first_frame),
+                            QString::number(frame))
+                       .arg(memory_address, 8, 16, QLatin1Char('0'))
+                       .arg(memory_address + memory_size, 8, 16, QLatin1Char('0')),
+                   "red", OSD::Duration::VERY_LONG);
+    return;
+  }
+
+  if (first_frame != frame)
+  {
+    DisplayMessage(tr("Possible desync detected: %1 might have desynced between frames %2 and %3")
+                       .arg(QString::fromStdString(player), QString::number(first_frame),
+                            QString::number(frame)),
+                   "red", OSD::Duration::VERY_LONG);
+    return;
+  }
+
   DisplayMessage(tr("Possible desync detected: %1 might have desynced at frame %2")
                      .arg(QString::fromStdString(player), QString::number(frame)),
                  "red", OSD::Duration::VERY_LONG);
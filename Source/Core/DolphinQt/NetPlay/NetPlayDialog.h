@@ -62,7 +62,8 @@ public:
   void OnMinimumPadBufferChanged(u32 buffer) override;
   void OnLocalPadBufferChanged(u32 buffer) override;
   void OnHostInputAuthorityChanged(bool enabled) override;
-  void OnDesync(u32 frame, const std::string& player) override;
+  void OnDesync(u32 first_frame, u32 frame, const std::string& player, u32 memory_address,
+                u32 memory_size) override;
   void OnConnectionLost() override;
   void OnConnectionError(const std::string& message) override;
   void OnTraversalError(TraversalClient::FailureReason error) override;
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+#include "Common/CommonTypes.h"
 #include "VideoCommon/GeometryShaderGen.h"
 #include "VideoCommon/NativeVertexFormat.h"
 #include "VideoCommon/PixelShaderGen.h"
@@ -80,6 +85,26 @@ struct GXUberPipelineUid
   bool operator!=(const GXUberPipelineUid& rhs) const { return !operator==(rhs); }
 };
 
+// Hashes the same bytes the UIDs compare with memcmp(), eight at a time. Pipelines are looked up
+// every draw call, so this has to be cheap rather than strong.
+template <typename Uid>
+size_t HashPipelineUid(const Uid& uid)
+{
+  const u8* bytes = reinterpret_cast<const u8*>(&uid);
+  u64 hash = sizeof(Uid);
+  size_t offset = 0;
+  for (; offset + sizeof(u64) <= sizeof(Uid); offset += sizeof(u64))
+  {
+    u64 word;
+    std::memcpy(&word, bytes + offset, sizeof(word));
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 32;
+  }
+  for (; offset < sizeof(Uid); offset++)
+    hash = (hash ^ bytes[offset]) * 0x100000001B3ULL;
+  return static_cast<size_t>(hash ^ (hash >> 29));
+}
+
 // Disk cache of pipeline UIDs. We can't use the whole UID as a type as it contains pointers.
 // This structure is safe to save to disk, and should be compiler/platform independent.
 #pragma pack(push, 1)
@@ -93,6 +118,53 @@ struct SerializedGXPipelineUid
   u32 depth_state_bits;
   u32 blending_state_bits;
 };
+
+// How a pipeline was used in earlier sessions of the game, saved with its UID so the pipelines
+// that are most likely to be needed next can be compiled first.
+struct GXPipelineUsage
+{
+  static constexpr u32 NEVER_USED = 0xFFFFFFFF;
+
+  // Number of sessions the pipeline was used in.
+  u32 session_count = 0;
+  // Milliseconds into a session the pipeline was first needed, at the earliest.
+  u32 first_use_ms = NEVER_USED;
+  // When the pipeline was first seen, in seconds since 1970.
+  u64 first_seen_time = 0;
+};
+
+struct SerializedGXPipelineUsage
+{
+  SerializedGXPipelineUid uid;
+  GXPipelineUsage usage;
+};
 #pragma pack(pop)
 
 }  // namespace VideoCommon
+
+namespace std
+{
+template <>
+struct hash<VideoCommon::GXPipelineUid>
+{
+  using argument_type = VideoCommon::GXPipelineUid;
+  using result_type = size_t;
+
+  result_type operator()(const argument_type& uid) const noexcept
+  {
+    return VideoCommon::HashPipelineUid(uid);
+  }
+};
+
+template <>
+struct hash<VideoCommon::GXUberPipelineUid>
+{
+  using argument_type = VideoCommon::GXUberPipelineUid;
+  using result_type = size_t;
+
+  result_type operator()(const argument_type& uid) const noexcept
+  {
+    return VideoCommon::HashPipelineUid(uid);
+  }
+};
+}  // namespace std
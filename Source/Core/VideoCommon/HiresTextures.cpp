@@ -6,7 +6,9 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstring>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -19,16 +21,13 @@
 #include "Common/File.h"
 #include "Common/FileSearch.h"
 #include "Common/FileUtil.h"
-#include "Common/Flag.h"
 #include "Common/Hash.h"
 #include "Common/Image.h"
 #include "Common/Logging/Log.h"
-#include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
 #include "Common/Swap.h"
 #include "Common/Thread.h"
 #include "Common/Timer.h"
-#include "Core/Config/GraphicsSettings.h"
 #include "Core/ConfigManager.h"
 #include "VideoCommon/OnScreenDisplay.h"
 #include "VideoCommon/VideoConfig.h"
@@ -39,15 +38,115 @@ struct DiskTexture
   bool has_arbitrary_mipmaps;
 };
 
+struct CachedTexture
+{
+  std::shared_ptr<HiresTexture> texture;
+  size_t size;
+  // Position in s_lruTextures, which only loaded textures have
+  std::list<std::string>::iterator lru_position;
+};
+
+struct LoadRequest
+{
+  std::string base_filename;
+  u32 width;
+  u32 height;
+};
+
 static std::unordered_map<std::string, DiskTexture> s_textureMap;
-static std::unordered_map<std::string, std::shared_ptr<HiresTexture>> s_textureCache;
+
+// Textures which are loaded or being loaded, and ones which failed to load so they aren't retried.
+// Loaded textures are evicted in least recently used order once they exceed the memory budget.
+static std::unordered_map<std::string, CachedTexture> s_textureCache;
+static std::list<std::string> s_lruTextures;
+static size_t s_textureCacheSize;
+static size_t s_textureCacheBudget;
 static std::mutex s_textureCacheMutex;
-static Common::Flag s_textureCacheAbortLoading;
 
-static std::thread s_prefetcher;
+// Textures the texture cache is waiting for go before the ones being prefetched.
+static std::vector<LoadRequest> s_loadRequests;
+static std::vector<std::string> s_prefetchQueue;
+static u32 s_prefetchesInFlight;
+static bool s_prefetching;
+static u32 s_prefetchStartTime;
+
+static std::vector<std::thread> s_loaderThreads;
+static std::condition_variable s_loadQueued;
+static bool s_loaderExit;
 
 static const std::string s_format_prefix = "tex1_";
 
+static void StopLoaderThreads()
+{
+  {
+    std::lock_guard<std::mutex> lk(s_textureCacheMutex);
+    s_loaderExit = true;
+  }
+  s_loadQueued.notify_all();
+
+  for (std::thread& thread : s_loaderThreads)
+    thread.join();
+  s_loaderThreads.clear();
+  s_loaderExit = false;
+}
+
+// Must be called with s_textureCacheMutex held.
+static void EvictTextures()
+{
+  // The most recently used texture is kept even if it exceeds the budget on its own, or the
+  // texture cache would keep asking for it.
+  while (s_textureCacheSize > s_textureCacheBudget && s_lruTextures.size() > 1)
+  {
+    auto iter = s_textureCache.find(s_lruTextures.back());
+    s_textureCacheSize -= iter->second.size;
+    s_textureCache.erase(iter);
+    s_lruTextures.pop_back();
+  }
+}
+
+// Must be called with s_textureCacheMutex held.
+static void UpdatePrefetchProgress()
+{
+  if (!s_prefetching)
+    return;
+
+  const double size_mb = s_textureCacheSize / (1024.0 * 1024.0);
+  if (!s_prefetchQueue.empty() && s_textureCacheSize >= s_textureCacheBudget)
+  {
+    // Textures are still loaded when they are used, evicting the least recently used ones.
+    s_prefetchQueue.clear();
+    s_prefetching = false;
+    OSD::AddMessage(
+        StringFromFormat("Custom Textures prefetching stopped after %.1f MB, memory budget is full",
+                         size_mb),
+        10000);
+  }
+  else if (s_prefetchQueue.empty() && s_prefetchesInFlight == 0)
+  {
+    s_prefetching = false;
+    const u32 stoptime = Common::Timer::GetTimeMs();
+    OSD::AddMessage(StringFromFormat("Custom Textures loaded, %.1f MB in %.1f s", size_mb,
+                                     (stoptime - s_prefetchStartTime) / 1000.0),
+                    10000);
+  }
+}
+
+void HiresTexture::ClearCache()
+{
+  // Anyone still waiting for a texture keeps using the native one.
+  for (auto& entry : s_textureCache)
+  {
+    if (entry.second.texture->IsLoading())
+      entry.second.texture->m_load_state = LoadState::Failed;
+  }
+  s_textureCache.clear();
+  s_lruTextures.clear();
+  s_textureCacheSize = 0;
+  s_loadRequests.clear();
+  s_prefetchQueue.clear();
+  s_prefetching = false;
+}
+
 void HiresTexture::Init()
 {
   Update();
@@ -55,36 +154,25 @@ void HiresTexture::Init()
 
 void HiresTexture::Shutdown()
 {
-  if (s_prefetcher.joinable())
-  {
-    s_textureCacheAbortLoading.Set();
-    s_prefetcher.join();
-  }
+  StopLoaderThreads();
 
+  std::lock_guard<std::mutex> lk(s_textureCacheMutex);
   s_textureMap.clear();
-  s_textureCache.clear();
+  ClearCache();
 }
 
 void HiresTexture::Update()
 {
-  if (s_prefetcher.joinable())
-  {
-    s_textureCacheAbortLoading.Set();
-    s_prefetcher.join();
-  }
+  StopLoaderThreads();
 
   if (!g_ActiveConfig.bHiresTextures)
   {
+    std::lock_guard<std::mutex> lk(s_textureCacheMutex);
     s_textureMap.clear();
-    s_textureCache.clear();
+    ClearCache();
     return;
   }
 
-  if (!g_ActiveConfig.bCacheHiresTextures)
-  {
-    s_textureCache.clear();
-  }
-
   const std::string& game_id = SConfig::GetInstance().GetGameID();
   const std::string texture_directory = GetTextureDirectory(game_id);
   const std::vector<std::string> extensions{".png", ".dds"};
@@ -109,88 +197,128 @@ void HiresTexture::Update()
     }
   }
 
-  if (g_ActiveConfig.bCacheHiresTextures)
+  std::lock_guard<std::mutex> lk(s_textureCacheMutex);
+
+  // Remove cached but deleted textures, and ones which failed to load so they are retried.
+  auto iter = s_textureCache.begin();
+  while (iter != s_textureCache.end())
   {
-    // remove cached but deleted textures
-    auto iter = s_textureCache.begin();
-    while (iter != s_textureCache.end())
+    HiresTexture& texture = *iter->second.texture;
+    if (texture.m_load_state == LoadState::Failed ||
+        s_textureMap.find(iter->first) == s_textureMap.end())
     {
-      if (s_textureMap.find(iter->first) == s_textureMap.end())
+      if (texture.IsLoaded())
       {
-        iter = s_textureCache.erase(iter);
+        s_textureCacheSize -= iter->second.size;
+        s_lruTextures.erase(iter->second.lru_position);
       }
-      else
+      texture.m_load_state = LoadState::Failed;
+      iter = s_textureCache.erase(iter);
+    }
+    else
+    {
+      iter++;
+    }
+  }
+  s_loadRequests.erase(std::remove_if(s_loadRequests.begin(), s_loadRequests.end(),
+                                      [](const LoadRequest& request) {
+                                        return s_textureCache.find(request.base_filename) ==
+                                               s_textureCache.end();
+                                      }),
+                       s_loadRequests.end());
+
+  s_textureCacheBudget = g_ActiveConfig.GetHiresTextureMemoryBudget();
+  EvictTextures();
+
+  s_prefetchQueue.clear();
+  if (g_ActiveConfig.bCacheHiresTextures)
+  {
+    for (const auto& entry : s_textureMap)
+    {
+      if (entry.first.find("_mip") == std::string::npos &&
+          s_textureCache.find(entry.first) == s_textureCache.end())
       {
-        iter++;
+        s_prefetchQueue.push_back(entry.first);
       }
     }
-
-    s_textureCacheAbortLoading.Clear();
-    s_prefetcher = std::thread(Prefetch);
   }
+  s_prefetching = !s_prefetchQueue.empty();
+  s_prefetchStartTime = Common::Timer::GetTimeMs();
+
+  for (u32 i = 0; i < g_ActiveConfig.GetHiresTextureLoaderThreads(); i++)
+    s_loaderThreads.emplace_back(LoaderThread);
 }
 
-void HiresTexture::Prefetch()
+void HiresTexture::LoaderThread()
 {
-  Common::SetCurrentThreadName("Prefetcher");
-
-  size_t size_sum = 0;
-  size_t sys_mem = Common::MemPhysical();
-  size_t recommended_min_mem = 2 * size_t(1024 * 1024 * 1024);
-  // keep 2GB memory for system stability if system RAM is 4GB+ - use half of memory in other cases
-  size_t max_mem =
-      (sys_mem / 2 < recommended_min_mem) ? (sys_mem / 2) : (sys_mem - recommended_min_mem);
-  u32 starttime = Common::Timer::GetTimeMs();
-  for (const auto& entry : s_textureMap)
+  Common::SetCurrentThreadName("Custom texture loader");
+
+  std::unique_lock<std::mutex> lk(s_textureCacheMutex);
+  while (true)
   {
-    const std::string& base_filename = entry.first;
+    s_loadQueued.wait(lk, [] {
+      return s_loaderExit || !s_loadRequests.empty() ||
+             (!s_prefetchQueue.empty() && s_textureCacheSize < s_textureCacheBudget);
+    });
+    if (s_loaderExit)
+      return;
 
-    if (base_filename.find("_mip") == std::string::npos)
+    // The newest requests are for textures which are the most likely to still be on screen.
+    LoadRequest request;
+    const bool prefetch = s_loadRequests.empty();
+    if (prefetch)
     {
-      std::unique_lock<std::mutex> lk(s_textureCacheMutex);
-
-      auto iter = s_textureCache.find(base_filename);
-      if (iter == s_textureCache.end())
-      {
-        // unlock while loading a texture. This may result in a race condition where
-        // we'll load a texture twice, but it reduces the stuttering a lot.
-        lk.unlock();
-        std::unique_ptr<HiresTexture> texture = Load(base_filename, 0, 0);
-        lk.lock();
-        if (texture)
-        {
-          std::shared_ptr<HiresTexture> ptr(std::move(texture));
-          iter = s_textureCache.insert(iter, std::make_pair(base_filename, ptr));
-        }
-      }
-      if (iter != s_textureCache.end())
+      request = {std::move(s_prefetchQueue.back()), 0, 0};
+      s_prefetchQueue.pop_back();
+      if (s_textureCache.find(request.base_filename) != s_textureCache.end())
       {
-        for (const Level& l : iter->second->m_levels)
-          size_sum += l.data.size();
+        UpdatePrefetchProgress();
+        continue;
       }
-    }
 
-    if (s_textureCacheAbortLoading.IsSet())
+      s_textureCache.emplace(request.base_filename,
+                             CachedTexture{std::shared_ptr<HiresTexture>(new HiresTexture()), 0,
+                                           s_lruTextures.end()});
+      s_prefetchesInFlight++;
+    }
+    else
     {
-      return;
+      request = std::move(s_loadRequests.back());
+      s_loadRequests.pop_back();
     }
 
-    if (size_sum > max_mem)
-    {
-      Config::SetCurrent(Config::GFX_HIRES_TEXTURES, false);
+    // Loading textures only ever adds to the cache, and only loaded textures are evicted, so the
+    // entry stays while the lock is released.
+    CachedTexture& cached = s_textureCache.at(request.base_filename);
+    const std::shared_ptr<HiresTexture> texture = cached.texture;
+    lk.unlock();
+    std::unique_ptr<HiresTexture> loaded =
+        Load(request.base_filename, request.width, request.height);
+    lk.lock();
 
-      OSD::AddMessage(
-          StringFromFormat(
-              "Custom Textures prefetching after %.1f MB aborted, not enough RAM available",
-              size_sum / (1024.0 * 1024.0)),
-          10000);
-      return;
+    if (loaded)
+    {
+      texture->m_levels = std::move(loaded->m_levels);
+      texture->m_has_arbitrary_mipmaps = loaded->m_has_arbitrary_mipmaps;
+      for (const Level& l : texture->m_levels)
+        cached.size += l.data.size();
+
+      // Prefetched textures weren't used yet, so they go first when the memory is needed.
+      cached.lru_position = s_lruTextures.insert(
+          prefetch ? s_lruTextures.end() : s_lruTextures.begin(), request.base_filename);
+      s_textureCacheSize += cached.size;
+      texture->m_load_state = LoadState::Loaded;
+      EvictTextures();
     }
+    else
+    {
+      texture->m_load_state = LoadState::Failed;
+    }
+
+    if (prefetch)
+      s_prefetchesInFlight--;
+    UpdatePrefetchProgress();
   }
-  u32 stoptime = Common::Timer::GetTimeMs();
-  OSD::AddMessage(StringFromFormat("Custom Textures loaded, %.1f MB in %.1f s",
-                                   size_sum / (1024.0 * 1024.0), (stoptime - starttime) / 1000.0),
-                  10000);
 }
 
 std::string HiresTexture::GenBaseName(const u8* texture, size_t texture_size, const u8* tlut,
@@ -286,22 +414,29 @@ std::shared_ptr<HiresTexture> HiresTexture::Search(const u8* texture, size_t tex
 {
   std::string base_filename =
       GenBaseName(texture, texture_size, tlut, tlut_size, width, height, format, has_mipmaps);
+  if (base_filename.empty())
+    return nullptr;
 
   std::lock_guard<std::mutex> lk(s_textureCacheMutex);
 
   auto iter = s_textureCache.find(base_filename);
   if (iter != s_textureCache.end())
   {
-    return iter->second;
-  }
-
-  std::shared_ptr<HiresTexture> ptr(Load(base_filename, width, height));
+    CachedTexture& cached = iter->second;
+    if (cached.texture->m_load_state == LoadState::Failed)
+      return nullptr;
 
-  if (ptr && g_ActiveConfig.bCacheHiresTextures)
-  {
-    s_textureCache[base_filename] = ptr;
+    if (cached.texture->IsLoaded())
+      s_lruTextures.splice(s_lruTextures.begin(), s_lruTextures, cached.lru_position);
+    return cached.texture;
   }
 
+  // Can't use make_shared due to private constructor.
+  std::shared_ptr<HiresTexture> ptr(new HiresTexture());
+  s_textureCache.emplace(base_filename, CachedTexture{ptr, 0, s_lruTextures.end()});
+  s_loadRequests.push_back({std::move(base_filename), width, height});
+  s_loadQueued.notify_one();
+
   return ptr;
 }
 
@@ -448,6 +583,16 @@ HiresTexture::~HiresTexture()
 {
 }
 
+bool HiresTexture::IsLoading() const
+{
+  return m_load_state == LoadState::Loading;
+}
+
+bool HiresTexture::IsLoaded() const
+{
+  return m_load_state == LoadState::Loaded;
+}
+
 AbstractTextureFormat HiresTexture::GetFormat() const
 {
   return m_levels.at(0).format;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,6 +21,9 @@ public:
   static void Update();
   static void Shutdown();
 
+  // Custom textures are loaded by worker threads, so this never waits for one. If the texture is
+  // still loading, it is returned anyway and the native texture should be used in its place until
+  // IsLoaded() is true. Returns null if there is no custom texture or it failed to load.
   static std::shared_ptr<HiresTexture> Search(const u8* texture, size_t texture_size,
                                               const u8* tlut, size_t tlut_size, u32 width,
                                               u32 height, TextureFormat format, bool has_mipmaps);
@@ -32,6 +36,10 @@ public:
 
   ~HiresTexture();
 
+  bool IsLoading() const;
+  // Only loaded textures have any levels.
+  bool IsLoaded() const;
+
   AbstractTextureFormat GetFormat() const;
   bool HasArbitraryMipmaps() const;
 
@@ -46,15 +54,25 @@ public:
   std::vector<Level> m_levels;
 
 private:
+  enum class LoadState
+  {
+    Loading,
+    Loaded,
+    Failed
+  };
+
   static std::unique_ptr<HiresTexture> Load(const std::string& base_filename, u32 width,
                                             u32 height);
   static bool LoadDDSTexture(HiresTexture* tex, const std::string& filename);
   static bool LoadDDSTexture(Level& level, const std::string& filename, u32 mip_level);
   static bool LoadTexture(Level& level, const std::vector<u8>& buffer);
-  static void Prefetch();
+  static void LoaderThread();
+  // Must be called with the cache locked and the loader threads stopped.
+  static void ClearCache();
 
   static std::string GetTextureDirectory(const std::string& game_id);
 
   HiresTexture() {}
-  bool m_has_arbitrary_mipmaps;
+  std::atomic<LoadState> m_load_state{LoadState::Loading};
+  bool m_has_arbitrary_mipmaps = false;
 };
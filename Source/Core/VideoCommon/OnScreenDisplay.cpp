@@ -65,7 +65,7 @@ void DrawMessages()
         it = s_messages.erase(it);
       else
         ++it;
-      top += 15;
+      top += 15 * static_cast<int>(1 + std::count(msg.m_str.begin(), msg.m_str.end(), '\n'));
     }
   }
 }
@@ -24,6 +24,9 @@ enum class MessageType
 {
   NetPlayPing,
   NetPlayBuffer,
+  NetPlayRollback,
+  NetPlayTelemetry,
+  SlippiProfile,
 
   // This entry must be kept last so that persistent typed messages are
   // displayed before other messages
@@ -4,9 +4,14 @@
 
 #include "VideoCommon/ShaderCache.h"
 
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
 #include "Common/Assert.h"
 #include "Common/FileUtil.h"
 #include "Common/MsgHandler.h"
+#include "Common/Timer.h"
 #include "Core/ConfigManager.h"
 #include "Core/Host.h"
 
@@ -20,6 +25,29 @@ std::unique_ptr<VideoCommon::ShaderCache> g_shader_cache;
 
 namespace VideoCommon
 {
+namespace
+{
+// UID caches from before the usage of the pipelines was saved with them.
+constexpr u32 UID_CACHE_FILE_MAGIC = 0x44495550;    // PUID
+constexpr u32 USAGE_CACHE_FILE_MAGIC = 0x45535550;  // PUSE
+constexpr size_t CACHE_HEADER_SIZE = sizeof(u32) + sizeof(u32);
+
+SerializedGXPipelineUid SerializeGXPipelineUid(const GXPipelineUid& config)
+{
+  // Convert to disk format. Ensure all padding bytes are zero.
+  SerializedGXPipelineUid disk_uid;
+  std::memset(&disk_uid, 0, sizeof(disk_uid));
+  disk_uid.vertex_decl = config.vertex_format->GetVertexDeclaration();
+  disk_uid.vs_uid = config.vs_uid;
+  disk_uid.gs_uid = config.gs_uid;
+  disk_uid.ps_uid = config.ps_uid;
+  disk_uid.rasterization_state_bits = config.rasterization_state.hex;
+  disk_uid.depth_state_bits = config.depth_state.hex;
+  disk_uid.blending_state_bits = config.blending_state.hex;
+  return disk_uid;
+}
+}  // Anonymous namespace
+
 ShaderCache::ShaderCache() = default;
 ShaderCache::~ShaderCache() = default;
 
@@ -29,6 +57,7 @@ bool ShaderCache::Initialize()
   m_host_config = ShaderHostConfig::GetCurrent();
   m_efb_depth_format = FramebufferManagerBase::GetEFBDepthFormat();
   m_efb_multisamples = g_ActiveConfig.iMultisamples;
+  m_session_start_ms = Common::Timer::GetTimeMs();
 
   // Create the async compiler, and start the worker threads.
   m_async_shader_compiler = g_renderer->CreateAsyncShaderCompiler();
@@ -105,16 +134,24 @@ void ShaderCache::Shutdown()
 const AbstractPipeline* ShaderCache::GetPipelineForUid(const GXPipelineUid& uid)
 {
   auto it = m_gx_pipeline_cache.find(uid);
-  if (it != m_gx_pipeline_cache.end() && !it->second.second)
-    return it->second.first.get();
+  if (it != m_gx_pipeline_cache.end() && !it->second.pending)
+  {
+    MarkPipelineUsed(it->second);
+    return it->second.pipeline.get();
+  }
 
   const bool exists_in_cache = it != m_gx_pipeline_cache.end();
   std::unique_ptr<AbstractPipeline> pipeline;
   std::optional<AbstractPipelineConfig> pipeline_config = GetGXPipelineConfig(uid);
   if (pipeline_config)
     pipeline = g_renderer->CreatePipeline(*pipeline_config);
+
+  GXPipeline& entry = m_gx_pipeline_cache[uid];
+  if (!exists_in_cache)
+    entry.usage.first_seen_time = Common::Timer::GetTimeSinceJan1970();
+  MarkPipelineUsed(entry);
   if (g_ActiveConfig.bShaderCache && !exists_in_cache)
-    AppendGXPipelineUID(uid);
+    AppendGXPipelineUID(uid, GetUsageWithSession(entry));
   return InsertGXPipeline(uid, std::move(pipeline));
 }
 
@@ -123,14 +160,19 @@ std::optional<const AbstractPipeline*> ShaderCache::GetPipelineForUidAsync(const
   auto it = m_gx_pipeline_cache.find(uid);
   if (it != m_gx_pipeline_cache.end())
   {
-    // .second is the pending flag, i.e. compiling in the background.
-    if (!it->second.second)
-      return it->second.first.get();
+    MarkPipelineUsed(it->second);
+
+    // The pending flag means it is compiling in the background.
+    if (!it->second.pending)
+      return it->second.pipeline.get();
     else
       return {};
   }
 
-  AppendGXPipelineUID(uid);
+  GXPipeline& entry = m_gx_pipeline_cache[uid];
+  entry.usage.first_seen_time = Common::Timer::GetTimeSinceJan1970();
+  MarkPipelineUsed(entry);
+  AppendGXPipelineUID(uid, GetUsageWithSession(entry));
   QueuePipelineCompile(uid, COMPILE_PRIORITY_ONDEMAND_PIPELINE);
   return {};
 }
@@ -247,12 +289,43 @@ void ShaderCache::ClearShaderCaches()
 
 void ShaderCache::CompileMissingPipelines()
 {
-  // Queue all uids with a null pipeline for compilation.
-  for (auto& it : m_gx_pipeline_cache)
+  // Queue all uids with a null pipeline for compilation, the ones most likely to be needed next
+  // first. Pipelines used in most sessions of the game, such as those of its menus and the levels
+  // that are played the most, come first, in the order they were needed in. The pipelines of
+  // content that is seen less often follow, again in the order they were needed in, and newer
+  // pipelines before older ones.
+  struct MissingPipeline
   {
-    if (!it.second.second)
-      QueuePipelineCompile(it.first, COMPILE_PRIORITY_SHADERCACHE_PIPELINE);
+    const GXPipelineUid* uid;
+    GXPipelineUsage usage;
+  };
+  std::vector<MissingPipeline> missing_pipelines;
+  u32 max_session_count = 0;
+  for (const auto& it : m_gx_pipeline_cache)
+  {
+    if (it.second.pending)
+      continue;
+
+    missing_pipelines.push_back({&it.first, GetUsageWithSession(it.second)});
+    max_session_count = std::max(max_session_count, missing_pipelines.back().usage.session_count);
   }
+
+  const auto get_order = [max_session_count](const MissingPipeline& pipeline) {
+    const bool is_common = static_cast<u64>(pipeline.usage.session_count) * 4 >= max_session_count;
+    return std::make_tuple(!is_common, pipeline.usage.first_use_ms,
+                           ~pipeline.usage.first_seen_time);
+  };
+  std::sort(missing_pipelines.begin(), missing_pipelines.end(),
+            [&](const MissingPipeline& a, const MissingPipeline& b) {
+              return get_order(a) < get_order(b);
+            });
+
+  // The shaders of a pipeline are queued with its priority, so every pipeline gets its own to
+  // keep the shaders of the likely ones from waiting behind those of all the others.
+  u32 priority = COMPILE_PRIORITY_SHADERCACHE_PIPELINE;
+  for (const MissingPipeline& pipeline : missing_pipelines)
+    QueuePipelineCompile(*pipeline.uid, priority++);
+
   for (auto& it : m_gx_uber_pipeline_cache)
   {
     if (!it.second.second)
@@ -265,8 +338,8 @@ void ShaderCache::InvalidateCachedPipelines()
   // Set the pending flag to false, and destroy the pipeline.
   for (auto& it : m_gx_pipeline_cache)
   {
-    it.second.first.reset();
-    it.second.second = false;
+    it.second.pipeline.reset();
+    it.second.pending = false;
   }
   for (auto& it : m_gx_uber_pipeline_cache)
   {
@@ -530,11 +603,11 @@ const AbstractPipeline* ShaderCache::InsertGXPipeline(const GXPipelineUid& confi
                                                       std::unique_ptr<AbstractPipeline> pipeline)
 {
   auto& entry = m_gx_pipeline_cache[config];
-  entry.second = false;
-  if (!entry.first && pipeline)
-    entry.first = std::move(pipeline);
+  entry.pending = false;
+  if (!entry.pipeline && pipeline)
+    entry.pipeline = std::move(pipeline);
 
-  return entry.first.get();
+  return entry.pipeline.get();
 }
 
 const AbstractPipeline*
@@ -551,85 +624,93 @@ ShaderCache::InsertGXUberPipeline(const GXUberPipelineUid& config,
 
 void ShaderCache::LoadPipelineUIDCache()
 {
-  constexpr u32 CACHE_FILE_MAGIC = 0x44495550;  // PUID
-  constexpr size_t CACHE_HEADER_SIZE = sizeof(u32) + sizeof(u32);
-  std::string filename =
+  m_gx_pipeline_uid_cache_filename =
       File::GetUserPath(D_CACHE_IDX) + SConfig::GetInstance().GetGameID() + ".uidcache";
-  if (m_gx_pipeline_uid_cache_file.Open(filename, "rb+"))
+
+  // If an existing case exists, validate the version before reading entries.
+  File::IOFile file(m_gx_pipeline_uid_cache_filename, "rb");
+  u32 existing_magic;
+  u32 existing_version;
+  if (file.ReadBytes(&existing_magic, sizeof(existing_magic)) &&
+      file.ReadBytes(&existing_version, sizeof(existing_version)) &&
+      (existing_magic == USAGE_CACHE_FILE_MAGIC || existing_magic == UID_CACHE_FILE_MAGIC) &&
+      existing_version == GX_PIPELINE_UID_VERSION)
   {
-    // If an existing case exists, validate the version before reading entries.
-    u32 existing_magic;
-    u32 existing_version;
-    bool uid_file_valid = false;
-    if (m_gx_pipeline_uid_cache_file.ReadBytes(&existing_magic, sizeof(existing_magic)) &&
-        m_gx_pipeline_uid_cache_file.ReadBytes(&existing_version, sizeof(existing_version)) &&
-        existing_magic == CACHE_FILE_MAGIC && existing_version == GX_PIPELINE_UID_VERSION)
+    // Older caches only hold the UIDs, which are the start of each record. Their pipelines are
+    // read as never used, and the file is converted when it is rewritten below.
+    const size_t record_size = existing_magic == USAGE_CACHE_FILE_MAGIC ?
+                                   sizeof(SerializedGXPipelineUsage) :
+                                   sizeof(SerializedGXPipelineUid);
+
+    // Ensure the expected size matches the actual size of the file. If it doesn't, it means
+    // the cache file may be corrupted, and we should not proceed with loading potentially
+    // garbage or invalid UIDs.
+    const u64 file_size = file.GetSize();
+    const size_t uid_count = static_cast<size_t>(file_size - CACHE_HEADER_SIZE) / record_size;
+    if (file_size == uid_count * record_size + CACHE_HEADER_SIZE)
     {
-      // Ensure the expected size matches the actual size of the file. If it doesn't, it means
-      // the cache file may be corrupted, and we should not proceed with loading potentially
-      // garbage or invalid UIDs.
-      const u64 file_size = m_gx_pipeline_uid_cache_file.GetSize();
-      const size_t uid_count =
-          static_cast<size_t>(file_size - CACHE_HEADER_SIZE) / sizeof(SerializedGXPipelineUid);
-      const size_t expected_size = uid_count * sizeof(SerializedGXPipelineUid) + CACHE_HEADER_SIZE;
-      uid_file_valid = file_size == expected_size;
-      if (uid_file_valid)
+      for (size_t i = 0; i < uid_count; i++)
       {
-        for (size_t i = 0; i < uid_count; i++)
-        {
-          SerializedGXPipelineUid serialized_uid;
-          if (m_gx_pipeline_uid_cache_file.ReadBytes(&serialized_uid, sizeof(serialized_uid)))
-          {
-            // This just adds the pipeline to the map, it is compiled later.
-            AddSerializedGXPipelineUID(serialized_uid);
-          }
-          else
-          {
-            uid_file_valid = false;
-            break;
-          }
-        }
-      }
+        SerializedGXPipelineUsage record;
+        if (!file.ReadBytes(&record, record_size))
+          break;
 
-      // We open the file for reading and writing, so we must seek to the end before writing.
-      if (uid_file_valid)
-        uid_file_valid = m_gx_pipeline_uid_cache_file.Seek(expected_size, SEEK_SET);
+        // This just adds the pipeline to the map, it is compiled later.
+        AddSerializedGXPipelineUID(record.uid, record.usage);
+      }
     }
-
-    // If the file is invalid, close it. We re-open and truncate it below.
-    if (!uid_file_valid)
-      m_gx_pipeline_uid_cache_file.Close();
   }
+  file.Close();
 
-  // If the file is not open, it means it was either corrupted or didn't exist.
-  if (!m_gx_pipeline_uid_cache_file.IsOpen())
-  {
-    if (m_gx_pipeline_uid_cache_file.Open(filename, "wb"))
-    {
-      // Write the version identifier.
-      m_gx_pipeline_uid_cache_file.WriteBytes(&CACHE_FILE_MAGIC, sizeof(GX_PIPELINE_UID_VERSION));
-      m_gx_pipeline_uid_cache_file.WriteBytes(&GX_PIPELINE_UID_VERSION,
-                                              sizeof(GX_PIPELINE_UID_VERSION));
-
-      // Write any current UIDs out to the file.
-      // This way, if we load a UID cache where the data was incomplete (e.g. Dolphin crashed),
-      // we don't lose the existing UIDs which were previously at the beginning.
-      for (const auto& it : m_gx_pipeline_cache)
-        AppendGXPipelineUID(it.first);
-    }
-  }
+  // Write the UIDs we read back out in the current format, and keep the file open to append new
+  // ones. This way, if we load a UID cache where the data was incomplete (e.g. Dolphin crashed),
+  // we don't lose the existing UIDs which were previously at the beginning.
+  if (WritePipelineUIDCache(m_gx_pipeline_uid_cache_filename))
+    m_gx_pipeline_uid_cache_file.Open(m_gx_pipeline_uid_cache_filename, "ab");
 
   INFO_LOG(VIDEO, "Read %u pipeline UIDs from %s",
-           static_cast<unsigned>(m_gx_pipeline_cache.size()), filename.c_str());
+           static_cast<unsigned>(m_gx_pipeline_cache.size()),
+           m_gx_pipeline_uid_cache_filename.c_str());
 }
 
 void ShaderCache::ClosePipelineUIDCache()
 {
-  // This is left as a method in case we need to append extra data to the file in the future.
+  if (!m_gx_pipeline_uid_cache_file.IsOpen())
+    return;
+
+  // Rewrite the whole file, so the usage of this session is saved for the pipelines we already
+  // knew about as well.
   m_gx_pipeline_uid_cache_file.Close();
+  WritePipelineUIDCache(m_gx_pipeline_uid_cache_filename);
+}
+
+bool ShaderCache::WritePipelineUIDCache(const std::string& filename)
+{
+  // Write to a temporary file first, so that failing halfway doesn't lose the existing cache.
+  const std::string temp_filename = filename + ".tmp";
+  File::IOFile file(temp_filename, "wb");
+  bool success = file.WriteBytes(&USAGE_CACHE_FILE_MAGIC, sizeof(USAGE_CACHE_FILE_MAGIC)) &&
+                 file.WriteBytes(&GX_PIPELINE_UID_VERSION, sizeof(GX_PIPELINE_UID_VERSION));
+  for (auto it = m_gx_pipeline_cache.begin(); success && it != m_gx_pipeline_cache.end(); ++it)
+  {
+    SerializedGXPipelineUsage record;
+    record.uid = SerializeGXPipelineUid(it->first);
+    record.usage = GetUsageWithSession(it->second);
+    success = file.WriteBytes(&record, sizeof(record));
+  }
+  file.Close();
+
+  if (!success || !File::Rename(temp_filename, filename))
+  {
+    WARN_LOG(VIDEO, "Writing pipeline UID cache %s failed.", filename.c_str());
+    File::Delete(temp_filename);
+    return false;
+  }
+  return true;
 }
 
-void ShaderCache::AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid)
+void ShaderCache::AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid,
+                                             const GXPipelineUsage& usage)
 {
   GXPipelineUid real_uid = {};
   real_uid.vertex_format = VertexLoaderManager::GetOrCreateMatchingFormat(uid.vertex_decl);
@@ -646,31 +727,43 @@ void ShaderCache::AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid)
 
   // Flag it as empty with a null pipeline object, for later compilation.
   auto& entry = m_gx_pipeline_cache[real_uid];
-  entry.second = false;
+  entry.pending = false;
+  entry.usage = usage;
 }
 
-void ShaderCache::AppendGXPipelineUID(const GXPipelineUid& config)
+void ShaderCache::AppendGXPipelineUID(const GXPipelineUid& config, const GXPipelineUsage& usage)
 {
   if (!m_gx_pipeline_uid_cache_file.IsOpen())
     return;
 
-  // Convert to disk format. Ensure all padding bytes are zero.
-  SerializedGXPipelineUid disk_uid;
-  std::memset(&disk_uid, 0, sizeof(disk_uid));
-  disk_uid.vertex_decl = config.vertex_format->GetVertexDeclaration();
-  disk_uid.vs_uid = config.vs_uid;
-  disk_uid.gs_uid = config.gs_uid;
-  disk_uid.ps_uid = config.ps_uid;
-  disk_uid.rasterization_state_bits = config.rasterization_state.hex;
-  disk_uid.depth_state_bits = config.depth_state.hex;
-  disk_uid.blending_state_bits = config.blending_state.hex;
-  if (!m_gx_pipeline_uid_cache_file.WriteBytes(&disk_uid, sizeof(disk_uid)))
+  // The usage is saved as it will be at the end of the session, in case we don't get there.
+  SerializedGXPipelineUsage record;
+  record.uid = SerializeGXPipelineUid(config);
+  record.usage = usage;
+  if (!m_gx_pipeline_uid_cache_file.WriteBytes(&record, sizeof(record)))
   {
     WARN_LOG(VIDEO, "Writing pipeline UID to cache failed, closing file.");
     m_gx_pipeline_uid_cache_file.Close();
   }
 }
 
+void ShaderCache::MarkPipelineUsed(GXPipeline& entry) const
+{
+  if (!entry.session_first_use_ms)
+    entry.session_first_use_ms = Common::Timer::GetTimeMs() - m_session_start_ms;
+}
+
+GXPipelineUsage ShaderCache::GetUsageWithSession(const GXPipeline& entry) const
+{
+  GXPipelineUsage usage = entry.usage;
+  if (entry.session_first_use_ms)
+  {
+    usage.session_count++;
+    usage.first_use_ms = std::min(usage.first_use_ms, *entry.session_first_use_ms);
+  }
+  return usage;
+}
+
 void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority)
 {
   class VertexShaderWorkItem final : public AsyncShaderCompiler::WorkItem
@@ -854,7 +947,7 @@ void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
 
   auto wi = m_async_shader_compiler->CreateWorkItem<PipelineWorkItem>(this, uid, priority);
   m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
-  m_gx_pipeline_cache[uid].second = true;
+  m_gx_pipeline_cache[uid].pending = true;
 }
 
 void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 priority)
@@ -105,8 +105,10 @@ private:
                                            std::unique_ptr<AbstractPipeline> pipeline);
   const AbstractPipeline* InsertGXUberPipeline(const GXUberPipelineUid& config,
                                                std::unique_ptr<AbstractPipeline> pipeline);
-  void AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid);
-  void AppendGXPipelineUID(const GXPipelineUid& config);
+  void AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid,
+                                  const GXPipelineUsage& usage);
+  bool WritePipelineUIDCache(const std::string& filename);
+  void AppendGXPipelineUID(const GXPipelineUid& config, const GXPipelineUsage& usage);
 
   // ASync Compiler Methods
   void QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority);
@@ -152,11 +154,27 @@ private:
   ShaderModuleCache<UberShader::VertexShaderUid> m_uber_vs_cache;
   ShaderModuleCache<UberShader::PixelShaderUid> m_uber_ps_cache;
 
-  // GX Pipeline Caches - .first - pipeline, .second - pending
-  std::map<GXPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>> m_gx_pipeline_cache;
-  std::map<GXUberPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>>
+  // GX Pipeline Caches
+  struct GXPipeline
+  {
+    std::unique_ptr<AbstractPipeline> pipeline;
+    bool pending = false;
+
+    // Usage in earlier sessions, from the UID cache.
+    GXPipelineUsage usage;
+    // Milliseconds into this session the pipeline was first needed, if it was.
+    std::optional<u32> session_first_use_ms;
+  };
+  void MarkPipelineUsed(GXPipeline& entry) const;
+  GXPipelineUsage GetUsageWithSession(const GXPipeline& entry) const;
+
+  std::unordered_map<GXPipelineUid, GXPipeline> m_gx_pipeline_cache;
+  // .first - pipeline, .second - pending
+  std::unordered_map<GXUberPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>>
       m_gx_uber_pipeline_cache;
   File::IOFile m_gx_pipeline_uid_cache_file;
+  std::string m_gx_pipeline_uid_cache_filename;
+  u32 m_session_start_ms = 0;
 };
 
 }  // namespace VideoCommon
@@ -8,6 +8,7 @@
 
 #include "Common/StringUtil.h"
 #include "VideoCommon/Statistics.h"
+#include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VideoConfig.h"
 
@@ -68,6 +69,18 @@ std::string Statistics::ToString()
   str += StringFromFormat("Uniform streamed: %i kB\n", stats.thisFrame.bytesUniformStreamed / 1024);
   str += StringFromFormat("Vertex Loaders: %i\n", stats.numVertexLoaders);
 
+  for (size_t i = 0; i < stats.textureDecodes.size(); i++)
+  {
+    const Statistics::TextureDecodes& decodes = stats.textureDecodes[i];
+    if (decodes.numLevels == 0)
+      continue;
+
+    str += StringFromFormat(
+        "%s decoded: %i levels, %.1f MTexels, %.1f ms (%.1f ms waited)\n",
+        TexDecoder_GetFormatName(static_cast<TextureFormat>(i)), decodes.numLevels,
+        decodes.numTexels / 1000000.0, decodes.decodeTimeUs / 1000.0, decodes.waitTimeUs / 1000.0);
+  }
+
   std::string vertex_list = VertexLoaderManager::VertexLoadersToString();
 
   // TODO : at some point text1 just becomes too huge and overflows, we can't even read the added
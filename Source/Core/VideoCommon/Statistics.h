@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <array>
 #include <string>
 
+#include "Common/CommonTypes.h"
+
 struct Statistics
 {
   int numPixelShadersCreated;
@@ -19,6 +22,18 @@ struct Statistics
 
   int numVertexLoaders;
 
+  // Texture levels decoded on the CPU, by texture format
+  struct TextureDecodes
+  {
+    int numLevels;
+    u64 numTexels;
+    // Summed over all the threads decoding
+    u64 decodeTimeUs;
+    // Time the GPU thread spent on decoding, including waiting for other threads
+    u64 waitTimeUs;
+  };
+  std::array<TextureDecodes, 16> textureDecodes;
+
   float proj_0, proj_1, proj_2, proj_3, proj_4, proj_5;
   float gproj_0, gproj_1, gproj_2, gproj_3, gproj_4, gproj_5;
   float gproj_6, gproj_7, gproj_8, gproj_9, gproj_10, gproj_11, gproj_12, gproj_13, gproj_14,
@@ -84,6 +84,8 @@ TextureCacheBase::TextureCacheBase()
 
   Common::SetHash64Function();
 
+  decode_pool.ResizeWorkerThreads(g_ActiveConfig.GetTextureDecoderThreads());
+
   InvalidateAllBindPoints();
 }
 
@@ -95,12 +97,9 @@ void TextureCacheBase::Invalidate()
     bound_textures[i] = nullptr;
   }
 
-  for (auto& tex : textures_by_address)
-  {
-    delete tex.second;
-  }
-  textures_by_address.clear();
-  textures_by_hash.clear();
+  textures_by_address.ForEach([](TCacheEntry* entry) { delete entry; });
+  textures_by_address.Clear();
+  textures_by_hash.Clear();
 
   texture_pool.clear();
 }
@@ -116,7 +115,9 @@ TextureCacheBase::~TextureCacheBase()
 void TextureCacheBase::OnConfigChanged(VideoConfig& config)
 {
   if (config.bHiresTextures != backup_config.hires_textures ||
-      config.bCacheHiresTextures != backup_config.cache_hires_textures)
+      config.bCacheHiresTextures != backup_config.cache_hires_textures ||
+      config.iHiresTextureLoaderThreads != backup_config.hires_texture_loader_threads ||
+      config.iHiresTextureMemoryBudget != backup_config.hires_texture_memory_budget)
   {
     HiresTexture::Update();
   }
@@ -144,51 +145,46 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
       PanicAlert("Failed to recompile one or more texture conversion shaders.");
   }
 
+  decode_pool.ResizeWorkerThreads(config.GetTextureDecoderThreads());
+
   SetBackupConfig(config);
 }
 
 void TextureCacheBase::Cleanup(int _frameCount)
 {
-  TexAddrCache::iterator iter = textures_by_address.begin();
-  TexAddrCache::iterator tcend = textures_by_address.end();
-  while (iter != tcend)
+  std::vector<TCacheEntry*> entries;
+  entries.reserve(textures_by_address.Size());
+  textures_by_address.ForEach([&](TCacheEntry* entry) { entries.push_back(entry); });
+
+  for (TCacheEntry* entry : entries)
   {
-    if (iter->second->tmem_only)
+    if (entry->tmem_only)
     {
-      iter = InvalidateTexture(iter);
+      InvalidateTexture(entry);
     }
-    else if (iter->second->frameCount == FRAMECOUNT_INVALID)
+    else if (entry->frameCount == FRAMECOUNT_INVALID)
     {
-      iter->second->frameCount = _frameCount;
-      ++iter;
+      entry->frameCount = _frameCount;
     }
-    else if (_frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount)
+    else if (_frameCount > TEXTURE_KILL_THRESHOLD + entry->frameCount)
     {
-      if (iter->second->IsCopy())
+      if (entry->IsCopy())
       {
         // Only remove EFB copies when they wouldn't be used anymore(changed hash), because EFB
         // copies living on the
         // host GPU are unrecoverable. Perform this check only every TEXTURE_KILL_THRESHOLD for
         // performance reasons
-        if ((_frameCount - iter->second->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
-            iter->second->hash != iter->second->CalculateHash())
-        {
-          iter = InvalidateTexture(iter);
-        }
-        else
+        if ((_frameCount - entry->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
+            entry->hash != entry->CalculateHash())
         {
-          ++iter;
+          InvalidateTexture(entry);
         }
       }
       else
       {
-        iter = InvalidateTexture(iter);
+        InvalidateTexture(entry);
       }
     }
-    else
-    {
-      ++iter;
-    }
   }
 
   TexPool::iterator iter2 = texture_pool.begin();
@@ -228,6 +224,8 @@ void TextureCacheBase::SetBackupConfig(const VideoConfig& config)
   backup_config.texfmt_overlay_center = config.bTexFmtOverlayCenter;
   backup_config.hires_textures = config.bHiresTextures;
   backup_config.cache_hires_textures = config.bCacheHiresTextures;
+  backup_config.hires_texture_loader_threads = config.iHiresTextureLoaderThreads;
+  backup_config.hires_texture_memory_budget = config.iHiresTextureMemoryBudget;
   backup_config.stereo_3d = config.stereo_mode != StereoMode::Off;
   backup_config.efb_mono_depth = config.bStereoEFBMonoDepth;
   backup_config.gpu_texture_decoding = config.bEnableGPUTextureDecoding;
@@ -256,7 +254,7 @@ TextureCacheBase::ApplyPaletteToEntry(TCacheEntry* entry, u8* palette, TLUTForma
   decoded_entry->may_have_overlapping_textures = entry->may_have_overlapping_textures;
 
   ConvertTexture(decoded_entry, entry, palette, tlutfmt);
-  textures_by_address.emplace(entry->addr, decoded_entry);
+  textures_by_address.Insert(decoded_entry);
 
   return decoded_entry;
 }
@@ -326,10 +324,9 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
 
   u32 numBlocksX = (entry_to_update->native_width + block_width - 1) / block_width;
 
-  auto iter = FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes);
-  while (iter.first != iter.second)
+  for (TCacheEntry* entry :
+       FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes))
   {
-    TCacheEntry* entry = iter.first->second;
     if (entry != entry_to_update && entry->IsCopy() && !entry->tmem_only &&
         entry->references.count(entry_to_update) == 0 &&
         entry->OverlapsMemoryRange(entry_to_update->addr, entry_to_update->size_in_bytes) &&
@@ -351,7 +348,6 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
           }
           else
           {
-            ++iter.first;
             continue;
           }
         }
@@ -424,7 +420,7 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
         {
           // Remove the temporary converted texture, it won't be used anywhere else
           // TODO: It would be nice to convert and copy in one step, but this code path isn't common
-          InvalidateTexture(GetTexCacheIter(entry));
+          InvalidateTexture(entry);
         }
         else
         {
@@ -437,11 +433,9 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
       else
       {
         // If the hash does not match, this EFB copy will not be used for anything, so remove it
-        iter.first = InvalidateTexture(iter.first);
-        continue;
+        InvalidateTexture(entry);
       }
     }
-    ++iter.first;
   }
   return entry_to_update;
 }
@@ -635,7 +629,13 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::Load(const u32 stage)
   // if this stage was not invalidated by changes to texture registers, keep the current texture
   if (IsValidBindPoint(stage) && bound_textures[stage])
   {
-    return bound_textures[stage];
+    // A placeholder is only replaced when it is looked up, which a texture that stays bound
+    // otherwise never is. Unbinding it lets the lookup below invalidate it.
+    const TCacheEntry* entry = bound_textures[stage];
+    if (!entry->pending_hires_tex || entry->pending_hires_tex->IsLoading())
+      return bound_textures[stage];
+
+    valid_bind_points.reset(stage);
   }
 
   const FourTexUnits& tex = bpmem.tex[stage >> 2];
@@ -795,20 +795,22 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   // For efb copies, the entry created in CopyRenderTargetToTexture always has to be used, or else
   // it was
   // done in vain.
-  auto iter_range = textures_by_address.equal_range(address);
-  TexAddrCache::iterator iter = iter_range.first;
-  TexAddrCache::iterator oldest_entry = iter;
+  //
+  // The entries at the address are looked up again after every invalidation, which removes the
+  // invalidated entry from them.
+  TCacheEntry* oldest_entry = nullptr;
   int temp_frameCount = 0x7fffffff;
-  TexAddrCache::iterator unconverted_copy = textures_by_address.end();
+  TCacheEntry* unconverted_copy = nullptr;
 
-  while (iter != iter_range.second)
+  size_t entry_index = 0;
+  while (entry_index < textures_by_address.AtAddress(address).size())
   {
-    TCacheEntry* entry = iter->second;
+    TCacheEntry* entry = textures_by_address.AtAddress(address)[entry_index];
 
     // Skip entries that are only left in our texture cache for the tmem cache emulation
     if (entry->tmem_only)
     {
-      ++iter;
+      ++entry_index;
       continue;
     }
 
@@ -839,7 +841,7 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
         // perform the conversion later.  Currently, we only convert EFB copies to
         // palette textures; we could do other conversions if it proved to be
         // beneficial.
-        unconverted_copy = iter;
+        unconverted_copy = entry;
       }
       else
       {
@@ -847,7 +849,8 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
         // never be useful again.  It's theoretically possible for a game to do
         // something weird where the copy could become useful in the future, but in
         // practice it doesn't happen.
-        iter = InvalidateTexture(iter);
+        if (!InvalidateTexture(entry))
+          ++entry_index;
         continue;
       }
     }
@@ -858,9 +861,12 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
           entry->native_levels >= tex_levels && entry->native_width == nativeW &&
           entry->native_height == nativeH)
       {
-        entry = DoPartialTextureUpdates(iter->second, &texMem[tlutaddr], tlutfmt);
+        if (!IsPendingHiresTextureLoaded(entry))
+          return DoPartialTextureUpdates(entry, &texMem[tlutaddr], tlutfmt);
 
-        return entry;
+        if (!InvalidateTexture(entry))
+          ++entry_index;
+        continue;
       }
     }
 
@@ -875,15 +881,15 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
         !entry->IsCopy() && !(isPaletteTexture && entry->base_hash == base_hash))
     {
       temp_frameCount = entry->frameCount;
-      oldest_entry = iter;
+      oldest_entry = entry;
     }
-    ++iter;
+    ++entry_index;
   }
 
-  if (unconverted_copy != textures_by_address.end())
+  if (unconverted_copy)
   {
     TCacheEntry* decoded_entry =
-        ApplyPaletteToEntry(unconverted_copy->second, &texMem[tlutaddr], tlutfmt);
+        ApplyPaletteToEntry(unconverted_copy, &texMem[tlutaddr], tlutfmt);
 
     if (decoded_entry)
     {
@@ -900,20 +906,18 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   if (textureCacheSafetyColorSampleSize == 0 ||
       std::max(texture_size, palette_size) <= (u32)textureCacheSafetyColorSampleSize * 8)
   {
-    auto hash_range = textures_by_hash.equal_range(full_hash);
-    TexHashCache::iterator hash_iter = hash_range.first;
-    while (hash_iter != hash_range.second)
+    for (TCacheEntry* entry : textures_by_hash.Find(full_hash))
     {
-      TCacheEntry* entry = hash_iter->second;
       // All parameters, except the address, need to match here
       if (entry->format == full_format && entry->native_levels >= tex_levels &&
           entry->native_width == nativeW && entry->native_height == nativeH)
       {
-        entry = DoPartialTextureUpdates(hash_iter->second, &texMem[tlutaddr], tlutfmt);
+        if (!IsPendingHiresTextureLoaded(entry))
+          return DoPartialTextureUpdates(entry, &texMem[tlutaddr], tlutfmt);
 
-        return entry;
+        InvalidateTexture(entry);
+        break;
       }
-      ++hash_iter;
     }
   }
 
@@ -925,11 +929,16 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   }
 
   std::shared_ptr<HiresTexture> hires_tex;
+  std::shared_ptr<HiresTexture> pending_hires_tex;
   if (g_ActiveConfig.bHiresTextures)
   {
     hires_tex = HiresTexture::Search(src_data, texture_size, &texMem[tlutaddr], palette_size, width,
                                      height, texformat, use_mipmaps);
 
+    // The native texture is used until the custom one is loaded.
+    if (hires_tex && !hires_tex->IsLoaded())
+      pending_hires_tex = std::move(hires_tex);
+
     if (hires_tex)
     {
       const auto& level = hires_tex->m_levels[0];
@@ -946,6 +955,8 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   // how many levels the allocated texture shall have
   const u32 texLevels = hires_tex ? (u32)hires_tex->m_levels.size() : tex_levels;
 
+  const bool decode_rgba8_from_tmem = from_tmem && texformat == TextureFormat::RGBA8;
+
   // We can decode on the GPU if it is a supported format and the flag is enabled.
   // Currently we don't decode RGBA8 textures from Tmem, as that would require copying from both
   // banks, and if we're doing an copy we may as well just do the whole thing on the CPU, since
@@ -953,7 +964,7 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   // shader, however.
   bool decode_on_gpu = !hires_tex && g_ActiveConfig.UseGPUTextureDecoding() &&
                        g_texture_cache->SupportsGPUTextureDecode(texformat, tlutfmt) &&
-                       !(from_tmem && texformat == TextureFormat::RGBA8);
+                       !decode_rgba8_from_tmem;
 
   // create the entry/texture
   TextureConfig config;
@@ -1012,10 +1023,12 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
 
       CheckTempSize(total_texture_size);
       dst_buffer = temp;
-      if (!(texformat == TextureFormat::RGBA8 && from_tmem))
+
+      // The levels are only queued here, and uploaded once the mipmaps have been queued as well.
+      if (!decode_rgba8_from_tmem)
       {
-        TexDecoder_Decode(dst_buffer, src_data, expandedWidth, expandedHeight, texformat, tlut,
-                          tlutfmt);
+        decode_pool.QueueLevel(dst_buffer, src_data, expandedWidth, expandedHeight, texformat,
+                               tlut, tlutfmt);
       }
       else
       {
@@ -1024,30 +1037,28 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
                                        expandedHeight);
       }
 
-      entry->texture->Load(0, width, height, expandedWidth, dst_buffer, decoded_texture_size);
-
-      arbitrary_mip_detector.AddLevel(width, height, expandedWidth, dst_buffer);
-
       dst_buffer += decoded_texture_size;
     }
   }
 
-  iter = textures_by_address.emplace(address, entry);
+  entry->SetGeneralParameters(address, texture_size, full_format, false);
+  entry->SetDimensions(nativeW, nativeH, tex_levels);
+  entry->SetHashes(base_hash, full_hash);
+
+  textures_by_address.Insert(entry);
   if (textureCacheSafetyColorSampleSize == 0 ||
       std::max(texture_size, palette_size) <= (u32)textureCacheSafetyColorSampleSize * 8)
   {
-    entry->textures_by_hash_iter = textures_by_hash.emplace(full_hash, entry);
+    textures_by_hash.Insert(full_hash, entry);
+    entry->textures_by_hash_key = full_hash;
   }
-
-  entry->SetGeneralParameters(address, texture_size, full_format, false);
-  entry->SetDimensions(nativeW, nativeH, tex_levels);
-  entry->SetHashes(base_hash, full_hash);
   entry->is_custom_tex = hires_tex != nullptr;
+  entry->pending_hires_tex = std::move(pending_hires_tex);
   entry->memory_stride = entry->BytesPerRow();
   entry->SetNotCopy();
 
   std::string basename = "";
-  if (g_ActiveConfig.bDumpTextures && !hires_tex)
+  if (g_ActiveConfig.bDumpTextures && !hires_tex && !entry->pending_hires_tex)
   {
     basename = HiresTexture::GenBaseName(src_data, texture_size, &texMem[tlutaddr], palette_size,
                                          width, height, texformat, use_mipmaps, true);
@@ -1097,18 +1108,37 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
       {
         // No need to call CheckTempSize here, as the whole buffer is preallocated at the beginning
         size_t decoded_mip_size = expanded_mip_width * sizeof(u32) * expanded_mip_height;
-        TexDecoder_Decode(dst_buffer, mip_src_data, expanded_mip_width, expanded_mip_height,
-                          texformat, tlut, tlutfmt);
-        entry->texture->Load(level, mip_width, mip_height, expanded_mip_width, dst_buffer,
-                             decoded_mip_size);
-
-        arbitrary_mip_detector.AddLevel(mip_width, mip_height, expanded_mip_width, dst_buffer);
-
+        decode_pool.QueueLevel(dst_buffer, mip_src_data, expanded_mip_width, expanded_mip_height,
+                               texformat, tlut, tlutfmt);
         dst_buffer += decoded_mip_size;
       }
 
       mip_src_data += mip_size;
     }
+
+    // Upload each level as soon as it is decoded, while the pool keeps decoding the later ones.
+    // The entry is only returned once all of them are done.
+    if (!decode_on_gpu)
+    {
+      u8* level_data = temp;
+      for (u32 level = 0; level != texLevels; ++level)
+      {
+        const u32 mip_width = CalculateLevelSize(width, level);
+        const u32 mip_height = CalculateLevelSize(height, level);
+        const u32 expanded_mip_width = Common::AlignUp(mip_width, bsw);
+        const u32 expanded_mip_height = Common::AlignUp(mip_height, bsh);
+        const size_t decoded_mip_size = expanded_mip_width * sizeof(u32) * expanded_mip_height;
+
+        if (level != 0 || !decode_rgba8_from_tmem)
+          decode_pool.WaitForNextLevel();
+        entry->texture->Load(level, mip_width, mip_height, expanded_mip_width, level_data,
+                             decoded_mip_size);
+
+        arbitrary_mip_detector.AddLevel(mip_width, mip_height, expanded_mip_width, level_data);
+
+        level_data += decoded_mip_size;
+      }
+    }
   }
 
   entry->has_arbitrary_mips = hires_tex ? hires_tex->HasArbitraryMipmaps() :
@@ -1123,9 +1153,9 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   }
 
   INCSTAT(stats.numTexturesUploaded);
-  SETSTAT(stats.numTexturesAlive, textures_by_address.size());
+  SETSTAT(stats.numTexturesAlive, textures_by_address.Size());
 
-  entry = DoPartialTextureUpdates(iter->second, &texMem[tlutaddr], tlutfmt);
+  entry = DoPartialTextureUpdates(entry, &texMem[tlutaddr], tlutfmt);
 
   return entry;
 }
@@ -1265,12 +1295,10 @@ std::optional<TextureLookupInformation> TextureCacheBase::ComputeTextureInformat
 TextureCacheBase::TCacheEntry*
 TextureCacheBase::GetXFBFromCache(const TextureLookupInformation& tex_info)
 {
-  auto iter_range = textures_by_address.equal_range(tex_info.address);
-  TexAddrCache::iterator iter = iter_range.first;
-
-  while (iter != iter_range.second)
+  size_t entry_index = 0;
+  while (entry_index < textures_by_address.AtAddress(tex_info.address).size())
   {
-    TCacheEntry* entry = iter->second;
+    TCacheEntry* entry = textures_by_address.AtAddress(tex_info.address)[entry_index];
 
     if ((entry->is_xfb_copy || entry->format.texfmt == TextureFormat::XFB) &&
         entry->native_width == tex_info.native_width &&
@@ -1286,12 +1314,13 @@ TextureCacheBase::GetXFBFromCache(const TextureLookupInformation& tex_info)
         // At this point, we either have an xfb copy that has changed its hash
         // or an xfb created by stitching or from memory that has been changed
         // we are safe to invalidate this
-        iter = InvalidateTexture(iter);
+        if (!InvalidateTexture(entry))
+          ++entry_index;
         continue;
       }
     }
 
-    ++iter;
+    ++entry_index;
   }
 
   return nullptr;
@@ -1313,10 +1342,9 @@ bool TextureCacheBase::LoadTextureFromOverlappingTextures(TCacheEntry* entry_to_
   // instead, which would reduce the amount of copying work here.
   std::vector<TCacheEntry*> candidates;
 
-  auto iter = FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes);
-  while (iter.first != iter.second)
+  for (TCacheEntry* entry :
+       FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes))
   {
-    TCacheEntry* entry = iter.first->second;
     if (entry != entry_to_update && entry->IsCopy() && !entry->tmem_only &&
         entry->references.count(entry_to_update) == 0 &&
         entry->OverlapsMemoryRange(entry_to_update->addr, entry_to_update->size_in_bytes) &&
@@ -1329,11 +1357,9 @@ bool TextureCacheBase::LoadTextureFromOverlappingTextures(TCacheEntry* entry_to_
       else
       {
         // If the hash does not match, this EFB copy will not be used for anything, so remove it
-        iter.first = InvalidateTexture(iter.first);
-        continue;
+        InvalidateTexture(entry);
       }
     }
-    ++iter.first;
   }
 
   std::sort(candidates.begin(), candidates.end(),
@@ -1430,7 +1456,7 @@ bool TextureCacheBase::LoadTextureFromOverlappingTextures(TCacheEntry* entry_to_
     {
       // Remove the temporary converted texture, it won't be used anywhere else
       // TODO: It would be nice to convert and copy in one step, but this code path isn't common
-      InvalidateTexture(GetTexCacheIter(entry));
+      InvalidateTexture(entry);
     }
     else
     {
@@ -1461,15 +1487,16 @@ TextureCacheBase::CreateNormalTexture(const TextureLookupInformation& tex_info)
   if (!entry)
     return nullptr;
 
-  textures_by_address.emplace(tex_info.address, entry);
+  entry->SetGeneralParameters(tex_info.address, tex_info.total_bytes, tex_info.full_format, false);
+  textures_by_address.Insert(entry);
   if (tex_info.texture_cache_safety_color_sample_size == 0 ||
       std::max(tex_info.total_bytes, tex_info.palette_size) <=
           (u32)tex_info.texture_cache_safety_color_sample_size * 8)
   {
-    entry->textures_by_hash_iter = textures_by_hash.emplace(tex_info.full_hash, entry);
+    textures_by_hash.Insert(tex_info.full_hash, entry);
+    entry->textures_by_hash_key = tex_info.full_hash;
   }
 
-  entry->SetGeneralParameters(tex_info.address, tex_info.total_bytes, tex_info.full_format, false);
   entry->SetDimensions(tex_info.native_width, tex_info.native_height, tex_info.computed_levels);
   entry->SetHashes(tex_info.base_hash, tex_info.full_hash);
   entry->is_custom_tex = false;
@@ -1477,7 +1504,7 @@ TextureCacheBase::CreateNormalTexture(const TextureLookupInformation& tex_info)
   entry->SetNotCopy();
 
   INCSTAT(stats.numTexturesUploaded);
-  SETSTAT(stats.numTexturesAlive, textures_by_address.size());
+  SETSTAT(stats.numTexturesAlive, textures_by_address.Size());
 
   return entry;
 }
@@ -1754,11 +1781,8 @@ void TextureCacheBase::CopyRenderTargetToTexture(
   // as our efb copy are marked to check them for partial texture updates.
   // TODO: The logic to detect overlapping strided efb copies is not 100% accurate.
   bool strided_efb_copy = dstStride != bytes_per_row;
-  auto iter = FindOverlappingTextures(dstAddr, covered_range);
-  while (iter.first != iter.second)
+  for (TCacheEntry* entry : FindOverlappingTextures(dstAddr, covered_range))
   {
-    TCacheEntry* entry = iter.first->second;
-
     if (entry->addr == dstAddr && entry->is_xfb_copy)
     {
       for (auto& reference : entry->references)
@@ -1775,7 +1799,7 @@ void TextureCacheBase::CopyRenderTargetToTexture(
           (!strided_efb_copy && entry->size_in_bytes == overlap_range) ||
           (strided_efb_copy && entry->size_in_bytes == overlap_range && entry->addr == dstAddr))
       {
-        iter.first = InvalidateTexture(iter.first);
+        InvalidateTexture(entry);
         continue;
       }
       entry->may_have_overlapping_textures = true;
@@ -1795,13 +1819,12 @@ void TextureCacheBase::CopyRenderTargetToTexture(
 
       // Do not load textures by hash, if they were at least partly overwritten by an efb copy.
       // In this case, comparing the hash is not enough to check, if two textures are identical.
-      if (entry->textures_by_hash_iter != textures_by_hash.end())
+      if (entry->textures_by_hash_key)
       {
-        textures_by_hash.erase(entry->textures_by_hash_iter);
-        entry->textures_by_hash_iter = textures_by_hash.end();
+        textures_by_hash.Erase(*entry->textures_by_hash_key, entry);
+        entry->textures_by_hash_key.reset();
       }
     }
-    ++iter.first;
   }
 
   if (copy_to_vram)
@@ -1857,7 +1880,7 @@ void TextureCacheBase::CopyRenderTargetToTexture(
                              0);
       }
 
-      textures_by_address.emplace(dstAddr, entry);
+      textures_by_address.Insert(entry);
     }
   }
 }
@@ -1914,7 +1937,6 @@ TextureCacheBase::TCacheEntry* TextureCacheBase::AllocateCacheEntry(const Textur
     return nullptr;
   }
   TCacheEntry* cacheEntry = new TCacheEntry(std::move(texture));
-  cacheEntry->textures_by_hash_iter = textures_by_hash.end();
   cacheEntry->id = last_entry_id++;
   return cacheEntry;
 }
@@ -1955,51 +1977,20 @@ TextureCacheBase::FindMatchingTextureFromPool(const TextureConfig& config)
   return matching_iter != range.second ? matching_iter : texture_pool.end();
 }
 
-TextureCacheBase::TexAddrCache::iterator
-TextureCacheBase::GetTexCacheIter(TextureCacheBase::TCacheEntry* entry)
-{
-  auto iter_range = textures_by_address.equal_range(entry->addr);
-  TexAddrCache::iterator iter = iter_range.first;
-  while (iter != iter_range.second)
-  {
-    if (iter->second == entry)
-    {
-      return iter;
-    }
-    ++iter;
-  }
-  return textures_by_address.end();
-}
-
-std::pair<TextureCacheBase::TexAddrCache::iterator, TextureCacheBase::TexAddrCache::iterator>
+std::vector<TextureCacheBase::TCacheEntry*>
 TextureCacheBase::FindOverlappingTextures(u32 addr, u32 size_in_bytes)
 {
-  // We index by the starting address only, so there is no way to query all textures
-  // which end after the given addr. But the GC textures have a limited size, so we
-  // look for all textures which have a start address bigger than addr minus the maximal
-  // texture size. But this yields false-positives which must be checked later on.
-
-  // 1024 x 1024 texel times 8 nibbles per texel
-  constexpr u32 max_texture_size = 1024 * 1024 * 4;
-  u32 lower_addr = addr > max_texture_size ? addr - max_texture_size : 0;
-  auto begin = textures_by_address.lower_bound(lower_addr);
-  auto end = textures_by_address.upper_bound(addr + size_in_bytes);
-
-  return std::make_pair(begin, end);
+  // The index finds the textures on the memory pages of the range. But those yield
+  // false-positives which must be checked later on.
+  return textures_by_address.FindOverlapping(addr, size_in_bytes);
 }
 
-TextureCacheBase::TexAddrCache::iterator
-TextureCacheBase::InvalidateTexture(TexAddrCache::iterator iter)
+bool TextureCacheBase::InvalidateTexture(TCacheEntry* entry)
 {
-  if (iter == textures_by_address.end())
-    return textures_by_address.end();
-
-  TCacheEntry* entry = iter->second;
-
-  if (entry->textures_by_hash_iter != textures_by_hash.end())
+  if (entry->textures_by_hash_key)
   {
-    textures_by_hash.erase(entry->textures_by_hash_iter);
-    entry->textures_by_hash_iter = textures_by_hash.end();
+    textures_by_hash.Erase(*entry->textures_by_hash_key, entry);
+    entry->textures_by_hash_key.reset();
   }
 
   for (size_t i = 0; i < bound_textures.size(); ++i)
@@ -2010,14 +2001,26 @@ TextureCacheBase::InvalidateTexture(TexAddrCache::iterator iter)
     if (bound_textures[i] == entry && IsValidBindPoint(static_cast<u32>(i)))
     {
       bound_textures[i]->tmem_only = true;
-      return ++iter;
+      return false;
     }
   }
 
   auto config = entry->texture->GetConfig();
   texture_pool.emplace(config, TexPoolEntry(std::move(entry->texture)));
 
-  return textures_by_address.erase(iter);
+  textures_by_address.Erase(entry);
+  return true;
+}
+
+bool TextureCacheBase::IsPendingHiresTextureLoaded(TCacheEntry* entry)
+{
+  if (!entry->pending_hires_tex || entry->pending_hires_tex->IsLoading())
+    return false;
+
+  // If it failed to load, the native texture is kept.
+  const bool loaded = entry->pending_hires_tex->IsLoaded();
+  entry->pending_hires_tex.reset();
+  return loaded;
 }
 
 u32 TextureCacheBase::TCacheEntry::BytesPerRow() const
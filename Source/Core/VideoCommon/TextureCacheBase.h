@@ -13,14 +13,18 @@
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "VideoCommon/AbstractTexture.h"
 #include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureCacheIndex.h"
 #include "VideoCommon/TextureConfig.h"
+#include "VideoCommon/TextureDecodePool.h"
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VideoCommon.h"
 
+class HiresTexture;
 struct VideoConfig;
 
 struct TextureAndTLUTFormat
@@ -131,6 +135,10 @@ public:
     bool is_xfb_copy = false;
     u64 id;
 
+    // The custom texture which was still loading when this entry was created, with the native
+    // texture in its place. The entry is replaced once the custom texture is loaded.
+    std::shared_ptr<HiresTexture> pending_hires_tex;
+
     bool reference_changed = false;  // used by xfb to determine when a reference xfb changed
 
     unsigned int native_width,
@@ -140,9 +148,8 @@ public:
     // used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
     int frameCount = FRAMECOUNT_INVALID;
 
-    // Keep an iterator to the entry in textures_by_hash, so it does not need to be searched when
-    // removing the cache entry
-    std::multimap<u64, TCacheEntry*>::iterator textures_by_hash_iter;
+    // The key of the entry in textures_by_hash, if it's in there
+    std::optional<u64> textures_by_hash_key;
 
     // This is used to keep track of both:
     //   * efb copies used by this partially updated texture
@@ -298,8 +305,8 @@ private:
     int frameCount = FRAMECOUNT_INVALID;
     TexPoolEntry(std::unique_ptr<AbstractTexture> tex) : texture(std::move(tex)) {}
   };
-  using TexAddrCache = std::multimap<u32, TCacheEntry*>;
-  using TexHashCache = std::multimap<u64, TCacheEntry*>;
+  using TexAddrCache = TextureAddressIndex<TCacheEntry>;
+  using TexHashCache = FlatMultiMap<u64, TCacheEntry*>;
   using TexPool = std::unordered_multimap<TextureConfig, TexPoolEntry>;
 
   void SetBackupConfig(const VideoConfig& config);
@@ -315,12 +322,10 @@ private:
   TCacheEntry* AllocateCacheEntry(const TextureConfig& config);
   std::unique_ptr<AbstractTexture> AllocateTexture(const TextureConfig& config);
   TexPool::iterator FindMatchingTextureFromPool(const TextureConfig& config);
-  TexAddrCache::iterator GetTexCacheIter(TCacheEntry* entry);
 
-  // Return all possible overlapping textures. As addr+size of the textures is not
-  // indexed, this may return false positives.
-  std::pair<TexAddrCache::iterator, TexAddrCache::iterator>
-  FindOverlappingTextures(u32 addr, u32 size_in_bytes);
+  // Return all possible overlapping textures, sorted by address. As textures are only indexed by
+  // the pages they cover, this may return false positives.
+  std::vector<TCacheEntry*> FindOverlappingTextures(u32 addr, u32 size_in_bytes);
 
   virtual void CopyEFBToCacheEntry(TCacheEntry* entry, bool is_depth_copy,
                                    const EFBRectangle& src_rect, bool scale_by_half,
@@ -328,8 +333,12 @@ private:
                                    bool clamp_top, bool clamp_bottom,
                                    const CopyFilterCoefficientArray& filter_coefficients) = 0;
 
-  // Removes and unlinks texture from texture cache and returns it to the pool
-  TexAddrCache::iterator InvalidateTexture(TexAddrCache::iterator t_iter);
+  // Removes and unlinks texture from texture cache and returns it to the pool. Returns false if
+  // the texture is kept for the tmem cache emulation instead
+  bool InvalidateTexture(TCacheEntry* entry);
+
+  // Whether the custom texture the entry was waiting for got loaded, so it should be replaced.
+  static bool IsPendingHiresTextureLoaded(TCacheEntry* entry);
 
   void UninitializeXFBMemory(u8* dst, u32 stride, u32 bytes_per_row, u32 num_blocks_y);
 
@@ -344,6 +353,8 @@ private:
   TexPool texture_pool;
   u64 last_entry_id = 0;
 
+  TextureDecodePool decode_pool;
+
   // Backup configuration values
   struct BackupConfig
   {
@@ -352,6 +363,8 @@ private:
     bool texfmt_overlay_center;
     bool hires_textures;
     bool cache_hires_textures;
+    int hires_texture_loader_threads;
+    int hires_texture_memory_budget;
     bool copy_cache_enable;
     bool stereo_3d;
     bool efb_mono_depth;
@@ -0,0 +1,246 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Hash table that maps every key to the values inserted with it, in the order they were inserted.
+//
+// Slots are kept in one array and probed linearly, so finding the slot of a key rarely leaves the
+// cache line of its home slot. The values of a key are in an allocation of their own though, so
+// reading them is a second access. Removing a key shifts the following slots of its run back
+// instead of leaving a tombstone, so runs never get longer than the keys in them require.
+//
+// References returned by Find are invalidated by any Insert or Erase.
+template <typename Key, typename Value>
+class FlatMultiMap
+{
+public:
+  const std::vector<Value>& Find(Key key) const
+  {
+    if (m_slots.empty())
+      return s_no_values;
+
+    for (size_t i = GetHome(key);; i = (i + 1) & m_mask)
+    {
+      const Slot& slot = m_slots[i];
+      if (slot.values.empty())
+        return s_no_values;
+      if (slot.key == key)
+        return slot.values;
+    }
+  }
+
+  void Insert(Key key, Value value)
+  {
+    // Kept at most half full, which keeps the runs short
+    if ((m_used_slots + 1) * 2 > m_slots.size())
+      Rehash(std::max<size_t>(16, m_slots.size() * 2));
+
+    size_t i = GetHome(key);
+    while (!m_slots[i].values.empty() && m_slots[i].key != key)
+      i = (i + 1) & m_mask;
+
+    Slot& slot = m_slots[i];
+    if (slot.values.empty())
+    {
+      slot.key = key;
+      m_used_slots++;
+    }
+    slot.values.push_back(std::move(value));
+    m_size++;
+  }
+
+  // Removes the first value equal to the given one. Returns false if there is none
+  bool Erase(Key key, const Value& value)
+  {
+    if (m_slots.empty())
+      return false;
+
+    size_t i = GetHome(key);
+    while (!m_slots[i].values.empty() && m_slots[i].key != key)
+      i = (i + 1) & m_mask;
+
+    std::vector<Value>& values = m_slots[i].values;
+    const auto it = std::find(values.begin(), values.end(), value);
+    if (it == values.end())
+      return false;
+
+    values.erase(it);
+    m_size--;
+    if (values.empty())
+    {
+      m_used_slots--;
+      FillHole(i);
+    }
+    return true;
+  }
+
+  template <typename Function>
+  void ForEach(Function function) const
+  {
+    for (const Slot& slot : m_slots)
+    {
+      for (const Value& value : slot.values)
+        function(value);
+    }
+  }
+
+  void Clear()
+  {
+    m_slots.clear();
+    m_mask = 0;
+    m_used_slots = 0;
+    m_size = 0;
+  }
+
+  // Number of values
+  size_t Size() const { return m_size; }
+
+private:
+  struct Slot
+  {
+    Key key{};
+    // Empty if the slot is free
+    std::vector<Value> values;
+  };
+
+  size_t GetHome(Key key) const
+  {
+    // Fibonacci hashing. Texture addresses are 32 byte aligned, so the low bits alone would only
+    // use every 32nd slot
+    return static_cast<size_t>((static_cast<u64>(key) * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask;
+  }
+
+  void Rehash(size_t slot_count)
+  {
+    std::vector<Slot> old_slots = std::move(m_slots);
+    m_slots = std::vector<Slot>(slot_count);
+    m_mask = slot_count - 1;
+
+    for (Slot& old_slot : old_slots)
+    {
+      if (old_slot.values.empty())
+        continue;
+
+      size_t i = GetHome(old_slot.key);
+      while (!m_slots[i].values.empty())
+        i = (i + 1) & m_mask;
+      m_slots[i] = std::move(old_slot);
+    }
+  }
+
+  // Moves slots after the freed one back, as long as that doesn't put them before their home slot
+  void FillHole(size_t hole)
+  {
+    for (size_t i = (hole + 1) & m_mask; !m_slots[i].values.empty(); i = (i + 1) & m_mask)
+    {
+      const size_t home = GetHome(m_slots[i].key);
+      if (((i - home) & m_mask) < ((i - hole) & m_mask))
+        continue;
+
+      m_slots[hole].key = m_slots[i].key;
+      m_slots[hole].values.swap(m_slots[i].values);
+      hole = i;
+    }
+  }
+
+  static const std::vector<Value> s_no_values;
+
+  std::vector<Slot> m_slots;
+  size_t m_mask = 0;
+  size_t m_used_slots = 0;
+  size_t m_size = 0;
+};
+
+template <typename Key, typename Value>
+const std::vector<Value> FlatMultiMap<Key, Value>::s_no_values;
+
+// Index of the texture cache entries by their start address, and by the memory pages they cover,
+// so entries overlapping a range of memory can be found without looking at the entries around
+// it. Entry needs the members addr, size_in_bytes and id, and the first two mustn't change while
+// the entry is in the index.
+template <typename Entry>
+class TextureAddressIndex
+{
+public:
+  // Large enough that most textures fit in a page or two, small enough that a page doesn't hold
+  // too many unrelated textures
+  static constexpr u32 PAGE_SHIFT = 14;
+
+  void Insert(Entry* entry)
+  {
+    m_by_address.Insert(entry->addr, entry);
+    ForEachPage(entry->addr, entry->size_in_bytes,
+                [&](u32 page) { m_by_page.Insert(page, entry); });
+  }
+
+  void Erase(Entry* entry)
+  {
+    if (!m_by_address.Erase(entry->addr, entry))
+      return;
+
+    ForEachPage(entry->addr, entry->size_in_bytes,
+                [&](u32 page) { m_by_page.Erase(page, entry); });
+  }
+
+  // Entries starting at the address, in the order they were inserted. The reference is only valid
+  // until the index is changed
+  const std::vector<Entry*>& AtAddress(u32 address) const { return m_by_address.Find(address); }
+
+  // Entries on the pages of the range, sorted by address and then by id. They still have to be
+  // checked for an actual overlap.
+  std::vector<Entry*> FindOverlapping(u32 address, u32 size) const
+  {
+    std::vector<Entry*> result;
+    const u32 first_page = address >> PAGE_SHIFT;
+    ForEachPage(address, size, [&](u32 page) {
+      // Entries covering several of the pages are only taken from the first of them
+      for (Entry* entry : m_by_page.Find(page))
+      {
+        if (std::max(entry->addr >> PAGE_SHIFT, first_page) == page)
+          result.push_back(entry);
+      }
+    });
+
+    std::sort(result.begin(), result.end(), [](const Entry* a, const Entry* b) {
+      return a->addr != b->addr ? a->addr < b->addr : a->id < b->id;
+    });
+    return result;
+  }
+
+  template <typename Function>
+  void ForEach(Function function) const
+  {
+    m_by_address.ForEach(function);
+  }
+
+  void Clear()
+  {
+    m_by_address.Clear();
+    m_by_page.Clear();
+  }
+
+  size_t Size() const { return m_by_address.Size(); }
+
+private:
+  // Empty entries still get a page, so they are found at their address
+  template <typename Function>
+  static void ForEachPage(u32 address, u32 size, Function function)
+  {
+    const u32 last_address = address + std::max(size, 1u) - 1;
+    const u32 last_page = (last_address < address ? 0xFFFFFFFF : last_address) >> PAGE_SHIFT;
+    for (u32 page = address >> PAGE_SHIFT; page <= last_page; page++)
+      function(page);
+  }
+
+  FlatMultiMap<u32, Entry*> m_by_address;
+  FlatMultiMap<u32, Entry*> m_by_page;
+};
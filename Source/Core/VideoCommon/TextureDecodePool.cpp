@@ -0,0 +1,143 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/TextureDecodePool.h"
+
+#include <algorithm>
+
+#include "Common/Align.h"
+#include "Common/Assert.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
+#include "VideoCommon/Statistics.h"
+
+// Smaller levels aren't split, as handing a tile to another thread costs more than decoding it.
+constexpr u32 MIN_TILE_TEXELS = 32 * 1024;
+
+TextureDecodePool::TextureDecodePool() = default;
+
+TextureDecodePool::~TextureDecodePool()
+{
+  StopWorkerThreads();
+}
+
+void TextureDecodePool::ResizeWorkerThreads(u32 num_worker_threads)
+{
+  if (m_worker_threads.size() == num_worker_threads)
+    return;
+
+  StopWorkerThreads();
+  for (u32 i = 0; i < num_worker_threads; i++)
+    m_worker_threads.emplace_back(&TextureDecodePool::WorkerThreadRun, this);
+}
+
+void TextureDecodePool::StopWorkerThreads()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_exit = true;
+  }
+  m_tiles_queued.notify_all();
+
+  for (std::thread& thread : m_worker_threads)
+    thread.join();
+  m_worker_threads.clear();
+  m_exit = false;
+}
+
+void TextureDecodePool::QueueLevel(u8* dst, const u8* src, u32 width, u32 height,
+                                   TextureFormat format, const u8* tlut, TLUTFormat tlut_format)
+{
+  // The heights of the tiles have to be multiples of the block height, which the level's is.
+  u32 rows_per_tile = std::max(height, 1u);
+  if (!m_worker_threads.empty())
+  {
+    const u32 block_height = TexDecoder_GetBlockHeightInTexels(format);
+    rows_per_tile = Common::AlignUp(std::max(MIN_TILE_TEXELS / std::max(width, 1u), 1u),
+                                    block_height);
+  }
+  const u32 tile_count = Common::AlignUp(height, rows_per_tile) / rows_per_tile;
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_levels.push_back({dst, src, width, height, format, tlut, tlut_format, tile_count, 0, 0});
+    Level* level = &m_levels.back();
+    for (u32 row = 0; row < height; row += rows_per_tile)
+      m_tiles.push_back({level, row, std::min(rows_per_tile, height - row)});
+  }
+
+  // The thread waiting for the level decodes a tile of it, so single tile levels don't need to
+  // wake anyone up.
+  if (tile_count > 1)
+    m_tiles_queued.notify_all();
+}
+
+void TextureDecodePool::WaitForNextLevel()
+{
+  const u64 start_time = Common::Timer::GetTimeUs();
+  std::unique_lock<std::mutex> lock(m_lock);
+  ASSERT(!m_levels.empty());
+  Level& level = m_levels.front();
+  while (level.tiles_done != level.tile_count)
+  {
+    // Help out with the level rather than wait. The tiles of earlier levels are done, so if there
+    // are any of this level left, they are at the front.
+    if (!m_tiles.empty() && m_tiles.front().level == &level)
+    {
+      const Tile tile = m_tiles.front();
+      m_tiles.pop_front();
+      DecodeTile(tile, lock);
+    }
+    else
+    {
+      m_tile_done.wait(lock);
+    }
+  }
+
+  const Level done_level = level;
+  m_levels.pop_front();
+  lock.unlock();
+
+  TexDecoder_DrawOverlay(done_level.dst, done_level.width, done_level.height, done_level.format);
+
+  Statistics::TextureDecodes& decodes =
+      stats.textureDecodes[static_cast<size_t>(done_level.format) & 15];
+  decodes.numLevels++;
+  decodes.numTexels += static_cast<u64>(done_level.width) * done_level.height;
+  decodes.decodeTimeUs += done_level.decode_time_us;
+  decodes.waitTimeUs += Common::Timer::GetTimeUs() - start_time;
+}
+
+void TextureDecodePool::WorkerThreadRun()
+{
+  Common::SetCurrentThreadName("Texture decoder");
+
+  std::unique_lock<std::mutex> lock(m_lock);
+  while (true)
+  {
+    m_tiles_queued.wait(lock, [this] { return m_exit || !m_tiles.empty(); });
+    if (m_exit)
+      return;
+
+    const Tile tile = m_tiles.front();
+    m_tiles.pop_front();
+    DecodeTile(tile, lock);
+  }
+}
+
+void TextureDecodePool::DecodeTile(const Tile& tile, std::unique_lock<std::mutex>& lock)
+{
+  Level& level = *tile.level;
+  lock.unlock();
+
+  const u64 start_time = Common::Timer::GetTimeUs();
+  TexDecoder_DecodeRows(level.dst, level.src, level.width, tile.first_row, tile.row_count,
+                        level.format, level.tlut, level.tlut_format);
+  const u64 decode_time = Common::Timer::GetTimeUs() - start_time;
+
+  lock.lock();
+  level.decode_time_us += decode_time;
+  if (++level.tiles_done == level.tile_count)
+    m_tile_done.notify_all();
+}
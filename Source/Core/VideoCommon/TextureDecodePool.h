@@ -0,0 +1,80 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// Decodes texture levels on the CPU with a pool of worker threads. Each level is split into tiles
+// of whole block rows, which the workers decode in the order they were queued. The thread waiting
+// for a level decodes tiles of it too, so levels still get decoded without any workers.
+//
+// Levels are waited for in the order they were queued, so the levels of a texture can be queued
+// at once and then uploaded one by one while the later ones are still being decoded.
+class TextureDecodePool
+{
+public:
+  TextureDecodePool();
+  ~TextureDecodePool();
+
+  // Must not be called while levels are queued.
+  void ResizeWorkerThreads(u32 num_worker_threads);
+  void StopWorkerThreads();
+
+  // The source, destination and palette must stay valid until the level was waited for.
+  void QueueLevel(u8* dst, const u8* src, u32 width, u32 height, TextureFormat format,
+                  const u8* tlut, TLUTFormat tlut_format);
+
+  // Blocks until the oldest level that wasn't waited for yet is decoded.
+  void WaitForNextLevel();
+
+private:
+  struct Level
+  {
+    u8* dst;
+    const u8* src;
+    u32 width;
+    u32 height;
+    TextureFormat format;
+    const u8* tlut;
+    TLUTFormat tlut_format;
+    u32 tile_count;
+
+    // Protected by m_lock
+    u32 tiles_done;
+    u64 decode_time_us;
+  };
+
+  struct Tile
+  {
+    Level* level;
+    u32 first_row;
+    u32 row_count;
+  };
+
+  void WorkerThreadRun();
+
+  // Decodes the tile and marks it as done. Must be called with the lock held, which it releases
+  // while decoding.
+  void DecodeTile(const Tile& tile, std::unique_lock<std::mutex>& lock);
+
+  std::vector<std::thread> m_worker_threads;
+
+  std::mutex m_lock;
+  std::condition_variable m_tiles_queued;
+  std::condition_variable m_tile_done;
+  bool m_exit = false;
+
+  // Levels that weren't waited for yet, and tiles nobody has started decoding, oldest first.
+  // A deque keeps the levels in place while tiles point to them.
+  std::deque<Level> m_levels;
+  std::deque<Tile> m_tiles;
+};
@@ -110,6 +110,11 @@ TextureFormat TexDecoder_GetEFBCopyBaseFormat(EFBCopyFormat format);
 
 void TexDecoder_Decode(u8* dst, const u8* src, int width, int height, TextureFormat texformat,
                        const u8* tlut, TLUTFormat tlutfmt);
+// Decodes the rows first_row to first_row + row_count of a texture, which have to be multiples of
+// the block height. Doesn't draw the format overlay, as it needs the whole texture.
+void TexDecoder_DecodeRows(u8* dst, const u8* src, int width, int first_row, int row_count,
+                           TextureFormat texformat, const u8* tlut, TLUTFormat tlutfmt);
+void TexDecoder_DrawOverlay(u8* dst, int width, int height, TextureFormat texformat);
 void TexDecoder_DecodeRGBA8FromTmem(u8* dst, const u8* src_ar, const u8* src_gb, int width,
                                     int height);
 void TexDecoder_DecodeTexel(u8* dst, const u8* src, int s, int t, int imageWidth,
@@ -118,6 +123,7 @@ void TexDecoder_DecodeTexelRGBA8FromTmem(u8* dst, const u8* src_ar, const u8* sr
                                          int imageWidth);
 
 void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center);
+const char* TexDecoder_GetFormatName(TextureFormat texformat);
 
 /* Internal method, implemented by TextureDecoder_Generic and TextureDecoder_x64. */
 void _TexDecoder_DecodeImpl(u32* dst, const u8* src, int width, int height, TextureFormat texformat,
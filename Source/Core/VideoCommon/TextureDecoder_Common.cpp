@@ -328,8 +328,16 @@ static const char* texfmt[] = {
     "0x3F",
 };
 
-static void TexDecoder_DrawOverlay(u8* dst, int width, int height, TextureFormat texformat)
+const char* TexDecoder_GetFormatName(TextureFormat texformat)
 {
+  return texfmt[static_cast<int>(texformat) & 15];
+}
+
+void TexDecoder_DrawOverlay(u8* dst, int width, int height, TextureFormat texformat)
+{
+  if (!TexFmt_Overlay_Enable)
+    return;
+
   int w = std::min(width, 40);
   int h = std::min(height, 10);
 
@@ -375,9 +383,18 @@ void TexDecoder_Decode(u8* dst, const u8* src, int width, int height, TextureFor
                        const u8* tlut, TLUTFormat tlutfmt)
 {
   _TexDecoder_DecodeImpl((u32*)dst, src, width, height, texformat, tlut, tlutfmt);
+  TexDecoder_DrawOverlay(dst, width, height, texformat);
+}
 
-  if (TexFmt_Overlay_Enable)
-    TexDecoder_DrawOverlay(dst, width, height, texformat);
+void TexDecoder_DecodeRows(u8* dst, const u8* src, int width, int first_row, int row_count,
+                           TextureFormat texformat, const u8* tlut, TLUTFormat tlutfmt)
+{
+  // Each row of blocks is stored after the previous one, so it can be decoded on its own.
+  const int block_height = TexDecoder_GetBlockHeightInTexels(texformat);
+  const int block_row_size = TexDecoder_GetTextureSizeInBytes(width, block_height, texformat);
+  _TexDecoder_DecodeImpl(reinterpret_cast<u32*>(dst) + first_row * width,
+                         src + first_row / block_height * block_row_size, width, row_count,
+                         texformat, tlut, tlutfmt);
 }
 
 static inline u32 DecodePixel_IA8(u16 val)
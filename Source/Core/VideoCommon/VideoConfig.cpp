@@ -6,6 +6,7 @@
 
 #include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
+#include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
 #include "Core/Config/GraphicsSettings.h"
 #include "Core/ConfigManager.h"
@@ -77,6 +78,8 @@ void VideoConfig::Refresh()
   bDumpTextures = Config::Get(Config::GFX_DUMP_TEXTURES);
   bHiresTextures = Config::Get(Config::GFX_HIRES_TEXTURES);
   bCacheHiresTextures = Config::Get(Config::GFX_CACHE_HIRES_TEXTURES);
+  iHiresTextureLoaderThreads = Config::Get(Config::GFX_HIRES_TEXTURE_LOADER_THREADS);
+  iHiresTextureMemoryBudget = Config::Get(Config::GFX_HIRES_TEXTURE_MEMORY_BUDGET);
   bDumpEFBTarget = Config::Get(Config::GFX_DUMP_EFB_TARGET);
   bDumpXFBTarget = Config::Get(Config::GFX_DUMP_XFB_TARGET);
   bDumpFramesAsImages = Config::Get(Config::GFX_DUMP_FRAMES_AS_IMAGES);
@@ -107,6 +110,7 @@ void VideoConfig::Refresh()
   iShaderCompilationMode = Config::Get(Config::GFX_SHADER_COMPILATION_MODE);
   iShaderCompilerThreads = Config::Get(Config::GFX_SHADER_COMPILER_THREADS);
   iShaderPrecompilerThreads = Config::Get(Config::GFX_SHADER_PRECOMPILER_THREADS);
+  iTextureDecoderThreads = Config::Get(Config::GFX_TEXTURE_DECODER_THREADS);
 
   bZComploc = Config::Get(Config::GFX_SW_ZCOMPLOC);
   bZFreeze = Config::Get(Config::GFX_SW_ZFREEZE);
@@ -216,3 +220,35 @@ u32 VideoConfig::GetShaderPrecompilerThreads() const
   else
     return GetNumAutoShaderCompilerThreads();
 }
+
+u32 VideoConfig::GetTextureDecoderThreads() const
+{
+  if (iTextureDecoderThreads >= 0)
+    return static_cast<u32>(iTextureDecoderThreads);
+
+  // Automatic number. We use clamp(cpus - 2, 0, 3), as the CPU and GPU threads are busy already,
+  // and the GPU thread decodes as well.
+  return static_cast<u32>(std::min(std::max(cpu_info.num_cores - 2, 0), 3));
+}
+
+u32 VideoConfig::GetHiresTextureLoaderThreads() const
+{
+  // Lookups never load custom textures themselves, so there has to be at least one loader.
+  if (iHiresTextureLoaderThreads >= 0)
+    return static_cast<u32>(std::max(iHiresTextureLoaderThreads, 1));
+
+  // Automatic number. Loading is mostly PNG decoding, so we use clamp(cpus - 2, 1, 4).
+  return static_cast<u32>(std::min(std::max(cpu_info.num_cores - 2, 1), 4));
+}
+
+size_t VideoConfig::GetHiresTextureMemoryBudget() const
+{
+  if (iHiresTextureMemoryBudget > 0)
+    return static_cast<size_t>(iHiresTextureMemoryBudget) * 1024 * 1024;
+
+  // Automatic budget. Keep 2GB memory for system stability if system RAM is 4GB+, and use half of
+  // the memory in other cases.
+  const size_t sys_mem = Common::MemPhysical();
+  const size_t recommended_min_mem = 2 * size_t(1024 * 1024 * 1024);
+  return (sys_mem / 2 < recommended_min_mem) ? (sys_mem / 2) : (sys_mem - recommended_min_mem);
+}
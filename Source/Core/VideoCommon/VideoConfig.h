@@ -95,6 +95,9 @@ struct VideoConfig final
   bool bDumpTextures;
   bool bHiresTextures;
   bool bCacheHiresTextures;
+  // -1 uses an automatic number of loader threads, 0 an automatic memory budget in MB.
+  int iHiresTextureLoaderThreads;
+  int iHiresTextureMemoryBudget;
   bool bDumpEFBTarget;
   bool bDumpXFBTarget;
   bool bDumpFramesAsImages;
@@ -171,6 +174,10 @@ struct VideoConfig final
   int iShaderCompilerThreads;
   int iShaderPrecompilerThreads;
 
+  // Number of threads decoding textures on the CPU, besides the GPU thread.
+  // -1 uses an automatic number based on the CPU threads.
+  int iTextureDecoderThreads;
+
   // Static config per API
   // TODO: Move this out of VideoConfig
   struct
@@ -235,6 +242,9 @@ struct VideoConfig final
   bool UsingUberShaders() const;
   u32 GetShaderCompilerThreads() const;
   u32 GetShaderPrecompilerThreads() const;
+  u32 GetTextureDecoderThreads() const;
+  u32 GetHiresTextureLoaderThreads() const;
+  size_t GetHiresTextureMemoryBudget() const;
 };
 
 extern VideoConfig g_Config;
@@ -0,0 +1,254 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Measures how fast the Slippi EXI device builds its CMD_READ_FRAME responses, once the way it
+// did before with a temporary std::vector for every value and once with SlippiBufferWriter. The
+// frames come from replays, or are made up when none are given.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <SlippiGame.h>
+
+#include "Common/BitUtils.h"
+#include "Common/CommonTypes.h"
+#include "Core/Slippi/SlippiBufferWriter.h"
+
+// Same as in CEXISlippi
+static const size_t READ_QUEUE_SIZE = 1024;
+static const size_t CHARACTER_DATA_SIZE = 49;
+
+// About eight minutes of a two player game
+static const s32 SYNTHETIC_FRAME_COUNT = 8 * 60 * 60;
+
+// The helpers CEXISlippi used before SlippiBufferWriter
+static std::vector<u8> uint32ToVector(u32 num)
+{
+  u8 byte0 = num >> 24;
+  u8 byte1 = (num & 0xFF0000) >> 16;
+  u8 byte2 = (num & 0xFF00) >> 8;
+  u8 byte3 = num & 0xFF;
+
+  return std::vector<u8>({byte0, byte1, byte2, byte3});
+}
+
+static void appendWordToBuffer(std::vector<u8>* buf, u32 word)
+{
+  auto wordVector = uint32ToVector(word);
+  buf->insert(buf->end(), wordVector.begin(), wordVector.end());
+}
+
+static u32 FloatBits(float value)
+{
+  return Common::BitCast<u32>(value);
+}
+
+static void BuildFrameWithVectors(const Slippi::FrameData& frame, std::vector<u8>& read_queue)
+{
+  read_queue.clear();
+  read_queue.push_back(1);
+
+  for (u8 port = 0; port < Slippi::PLAYER_SLOT_COUNT; port++)
+  {
+    for (int is_follower = 0; is_follower < 2; is_follower++)
+    {
+      const auto& exists = is_follower ? frame.hasFollower : frame.hasPlayer;
+      if (!exists[port])
+      {
+        read_queue.insert(read_queue.end(), CHARACTER_DATA_SIZE, 0);
+        continue;
+      }
+
+      // The player was copied before it was written out as well
+      const Slippi::PlayerFrameData data = (is_follower ? frame.followers : frame.players)[port];
+      appendWordToBuffer(&read_queue, data.randomSeed);
+      appendWordToBuffer(&read_queue, FloatBits(data.joystickX));
+      appendWordToBuffer(&read_queue, FloatBits(data.joystickY));
+      appendWordToBuffer(&read_queue, FloatBits(data.cstickX));
+      appendWordToBuffer(&read_queue, FloatBits(data.cstickY));
+      appendWordToBuffer(&read_queue, FloatBits(data.trigger));
+      appendWordToBuffer(&read_queue, data.buttons);
+      appendWordToBuffer(&read_queue, FloatBits(data.locationX));
+      appendWordToBuffer(&read_queue, FloatBits(data.locationY));
+      appendWordToBuffer(&read_queue, FloatBits(data.facingDirection));
+      appendWordToBuffer(&read_queue, (u32)data.animation);
+      read_queue.push_back(data.joystickXRaw);
+      appendWordToBuffer(&read_queue, FloatBits(data.percent));
+    }
+  }
+}
+
+static void BuildFrameWithWriter(const Slippi::FrameData& frame, SlippiBufferWriter& read_queue)
+{
+  read_queue.Clear();
+  read_queue.WriteU8(1);
+
+  for (u8 port = 0; port < Slippi::PLAYER_SLOT_COUNT; port++)
+  {
+    for (int is_follower = 0; is_follower < 2; is_follower++)
+    {
+      const auto& exists = is_follower ? frame.hasFollower : frame.hasPlayer;
+      if (!exists[port])
+      {
+        read_queue.Fill(0, CHARACTER_DATA_SIZE);
+        continue;
+      }
+
+      const Slippi::PlayerFrameData& data = (is_follower ? frame.followers : frame.players)[port];
+      read_queue.WriteU32(data.randomSeed);
+      read_queue.WriteFloat(data.joystickX);
+      read_queue.WriteFloat(data.joystickY);
+      read_queue.WriteFloat(data.cstickX);
+      read_queue.WriteFloat(data.cstickY);
+      read_queue.WriteFloat(data.trigger);
+      read_queue.WriteU32(data.buttons);
+      read_queue.WriteFloat(data.locationX);
+      read_queue.WriteFloat(data.locationY);
+      read_queue.WriteFloat(data.facingDirection);
+      read_queue.WriteU32((u32)data.animation);
+      read_queue.WriteU8(data.joystickXRaw);
+      read_queue.WriteFloat(data.percent);
+    }
+  }
+}
+
+static void MakeFrames(std::vector<Slippi::FrameData>* frames)
+{
+  std::mt19937 random(0);
+  std::uniform_real_distribution<float> stick(-1.0f, 1.0f);
+  for (s32 i = 0; i < SYNTHETIC_FRAME_COUNT; i++)
+  {
+    Slippi::FrameData frame;
+    frame.frame = Slippi::GAME_FIRST_FRAME + i;
+    frame.inputsFullyFetched = true;
+    for (u8 port = 0; port < 2; port++)
+    {
+      Slippi::PlayerFrameData& data = frame.players[port];
+      std::memset(&data, 0, sizeof(data));
+      data.randomSeed = random();
+      data.joystickX = stick(random);
+      data.joystickY = stick(random);
+      data.buttons = random() & 0xFFF;
+      data.locationX = stick(random) * 100;
+      data.locationY = stick(random) * 50;
+      data.facingDirection = port ? -1.0f : 1.0f;
+      data.animation = static_cast<u16>(random() % 400);
+      data.percent = static_cast<float>(i / 200);
+      frame.hasPlayer[port] = true;
+    }
+    frames->push_back(frame);
+  }
+}
+
+static bool ReadFrames(const std::string& path, std::vector<Slippi::FrameData>* frames)
+{
+  std::unique_ptr<Slippi::SlippiGame> game(Slippi::SlippiGame::FromFile(path));
+  if (!game || !game->AreSettingsLoaded())
+    return false;
+
+  const s32 frame_count = game->GetFrameCount();
+  for (s32 i = Slippi::GAME_FIRST_FRAME; i <= frame_count; i++)
+  {
+    const Slippi::FrameData* frame = game->GetFrame(i);
+    if (frame && frame->inputsFullyFetched)
+      frames->push_back(*frame);
+  }
+
+  return true;
+}
+
+template <typename Function>
+static double MeasureFrames(size_t frame_count, u32 repeats, Function function)
+{
+  double best_s = 0;
+  for (u32 i = 0; i < repeats; i++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frame_count; frame++)
+      function(frame);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best_s = i == 0 ? elapsed.count() : std::min(best_s, elapsed.count());
+  }
+  return frame_count ? best_s * 1e9 / frame_count : 0.0;
+}
+
+static void PrintUsage()
+{
+  printf("USAGE: slippi-exi-bench [-?] [--help] [-n <REPEATS>] [<.slp FILE>...]\n");
+  printf("-? / --help: Prints this message\n");
+  printf("-n <REPEATS>: How often all frames are built, the fastest time counts (default 5)\n");
+  printf("\n");
+  printf("Without replays, %d made up frames of a two player game are used.\n",
+         SYNTHETIC_FRAME_COUNT);
+}
+
+int main(int argc, const char* argv[])
+{
+  u32 repeats = 5;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "--help" || argument == "-?")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if (argument == "-n" && i + 1 < argc)
+    {
+      repeats = std::max(std::stoi(argv[++i]), 1);
+    }
+    else
+    {
+      paths.push_back(argument);
+    }
+  }
+
+  std::vector<Slippi::FrameData> frames;
+  for (const std::string& path : paths)
+  {
+    if (!ReadFrames(path, &frames))
+    {
+      fprintf(stderr, "%s: Failed to read the replay\n", path.c_str());
+      return 1;
+    }
+  }
+  if (paths.empty())
+    MakeFrames(&frames);
+
+  // Both have to produce the same bytes
+  std::vector<u8> vector_queue;
+  SlippiBufferWriter writer_queue(READ_QUEUE_SIZE);
+  for (const Slippi::FrameData& frame : frames)
+  {
+    BuildFrameWithVectors(frame, vector_queue);
+    BuildFrameWithWriter(frame, writer_queue);
+    if (vector_queue.size() != writer_queue.Size() ||
+        std::memcmp(vector_queue.data(), writer_queue.Data(), vector_queue.size()) != 0)
+    {
+      fprintf(stderr, "Frame %d: The responses differ\n", frame.frame);
+      return 1;
+    }
+  }
+
+  // The old queue kept its capacity between responses as well
+  const double vector_ns = MeasureFrames(frames.size(), repeats, [&](size_t i) {
+    BuildFrameWithVectors(frames[i], vector_queue);
+  });
+  const double writer_ns = MeasureFrames(frames.size(), repeats, [&](size_t i) {
+    BuildFrameWithWriter(frames[i], writer_queue);
+  });
+
+  printf("%zu frames, %zu bytes per response\n", frames.size(), writer_queue.Size());
+  printf("  std::vector per value: %8.1f ns/frame\n", vector_ns);
+  printf("  SlippiBufferWriter:    %8.1f ns/frame (%.2fx)\n", writer_ns,
+         writer_ns > 0 ? vector_ns / writer_ns : 0.0);
+  return 0;
+}
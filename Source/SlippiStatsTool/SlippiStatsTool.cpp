@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SlippiGame.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileSearch.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+
+// A combo has to land at least this many hits in a row to be counted
+static const u8 MIN_COMBO_HITS = 3;
+
+struct PlayerStats
+{
+  u8 port = 0;
+  u8 character = 0;
+  u8 final_stocks = 0;
+  float final_percent = 0;
+  u32 stocks_lost = 0;
+  float damage_taken = 0;
+  u32 hits_landed = 0;
+  u32 combos = 0;
+  u32 longest_combo = 0;
+  u8 most_used_move = 0;
+};
+
+struct ReplayStats
+{
+  std::string path;
+  bool is_valid = false;
+  u16 stage = 0;
+  s32 frame_count = 0;
+  std::vector<PlayerStats> players;
+};
+
+static bool IsHelpFlag(const std::string& argument)
+{
+  return argument == "--help" || argument == "-?";
+}
+
+static void PrintUsage()
+{
+  printf("USAGE: slippi-stats [-?] [--help] [-j <THREADS>] [-o <FILE>] [-c <DIRECTORY>] "
+         "<DIRECTORY OR .slp FILE>...\n");
+  printf("-? / --help: Prints this message\n");
+  printf("-j <THREADS>: Number of worker threads (defaults to the number of cores)\n");
+  printf("-o <OUTPUT FILE>: Write the stats to a file instead of stdout\n");
+  printf("-c <OUTPUT DIRECTORY>: Write every column to its own file in a directory instead\n");
+  printf("\n");
+  printf("Directories are searched recursively for .slp and .slpz files. The output is CSV with\n");
+  printf("one row per player per replay.\n");
+  printf("\n");
+  printf("With -c, each column is a separate file holding its values for all rows in the same\n");
+  printf("order. The file column is text with one path per line. The other columns are packed\n");
+  printf("arrays in the byte order of the host, their extension names the type (u8, u16, s32,\n");
+  printf("u32 or f32), e.g. for numpy.fromfile.\n");
+}
+
+static ReplayStats ProcessReplay(const std::string& path)
+{
+  ReplayStats stats;
+  stats.path = path;
+
+  std::unique_ptr<Slippi::SlippiGame> game(Slippi::SlippiGame::FromFile(path));
+  if (!game)
+    return stats;
+
+  // The first query pulls in and parses the whole file
+  if (!game->AreSettingsLoaded())
+    return stats;
+
+  Slippi::GameSettings* settings = game->GetSettings();
+  stats.is_valid = true;
+  stats.stage = settings->stage;
+  stats.frame_count = game->GetFrameCount();
+
+  for (u8 port = 0; port < Slippi::PLAYER_SLOT_COUNT; port++)
+  {
+    if (!game->DoesPlayerExist(port))
+      continue;
+
+    PlayerStats player;
+    player.port = port;
+    player.character = settings->players[port].characterId;
+
+    std::array<u32, 256> move_hits = {};
+    bool has_previous = false;
+    u8 previous_stocks = 0;
+    float previous_percent = 0;
+    u8 previous_combo = 0;
+
+    for (s32 i = Slippi::GAME_FIRST_FRAME; i <= stats.frame_count; i++)
+    {
+      Slippi::FrameData* frame = game->GetFrame(i);
+      if (!frame || !frame->hasPlayer[port] || !frame->inputsFullyFetched)
+        continue;
+
+      const Slippi::PlayerFrameData& data = frame->players[port];
+
+      if (has_previous)
+      {
+        if (data.stocks < previous_stocks)
+          player.stocks_lost += previous_stocks - data.stocks;
+
+        // Percent goes back to zero on death, only count increases
+        if (data.percent > previous_percent)
+          player.damage_taken += data.percent - previous_percent;
+
+        // The combo count belongs to the attacker and goes up by one for every hit landed
+        if (data.comboCount > previous_combo)
+        {
+          player.hits_landed += data.comboCount - previous_combo;
+          move_hits[data.lastMoveHitId]++;
+        }
+        else if (data.comboCount < previous_combo && previous_combo >= MIN_COMBO_HITS)
+        {
+          player.combos++;
+        }
+      }
+
+      player.longest_combo = std::max<u32>(player.longest_combo, data.comboCount);
+
+      has_previous = true;
+      previous_stocks = data.stocks;
+      previous_percent = data.percent;
+      previous_combo = data.comboCount;
+    }
+
+    // A combo still going on when the game ends counts as well
+    if (previous_combo >= MIN_COMBO_HITS)
+      player.combos++;
+
+    player.final_stocks = previous_stocks;
+    player.final_percent = previous_percent;
+    player.most_used_move = static_cast<u8>(
+        std::max_element(move_hits.begin(), move_hits.end()) - move_hits.begin());
+
+    stats.players.push_back(player);
+  }
+
+  return stats;
+}
+
+static std::vector<std::string> CollectReplays(const std::vector<std::string>& inputs)
+{
+  std::vector<std::string> directories;
+  std::vector<std::string> files;
+  for (const std::string& input : inputs)
+  {
+    if (File::IsDirectory(input))
+      directories.push_back(input);
+    else
+      files.push_back(input);
+  }
+
+  if (!directories.empty())
+  {
+    std::vector<std::string> found = Common::DoFileSearch(directories, {".slp", ".slpz"}, true);
+    files.insert(files.end(), found.begin(), found.end());
+  }
+
+  return files;
+}
+
+static void WriteStats(FILE* out, const std::vector<ReplayStats>& results)
+{
+  fprintf(out, "file,stage,frames,port,character,final_stocks,final_percent,stocks_lost,"
+               "damage_taken,hits_landed,combos,longest_combo,most_used_move\n");
+
+  for (const ReplayStats& replay : results)
+  {
+    for (const PlayerStats& player : replay.players)
+    {
+      fprintf(out, "\"%s\",%u,%d,%u,%u,%u,%.2f,%u,%.2f,%u,%u,%u,%u\n", replay.path.c_str(),
+              replay.stage, replay.frame_count, player.port + 1, player.character,
+              player.final_stocks, player.final_percent, player.stocks_lost, player.damage_taken,
+              player.hits_landed, player.combos, player.longest_combo, player.most_used_move);
+    }
+  }
+}
+
+template <typename T, typename Getter>
+static bool WriteColumn(const std::string& path, const std::vector<ReplayStats>& results,
+                        Getter get)
+{
+  std::vector<T> values;
+  for (const ReplayStats& replay : results)
+  {
+    for (const PlayerStats& player : replay.players)
+      values.push_back(static_cast<T>(get(replay, player)));
+  }
+
+  File::IOFile file(path, "wb");
+  return file.WriteArray(values.data(), values.size());
+}
+
+static bool WriteColumns(const std::string& directory, const std::vector<ReplayStats>& results)
+{
+  const std::string prefix = directory + DIR_SEP;
+  File::CreateFullPath(prefix);
+
+  std::string paths;
+  for (const ReplayStats& replay : results)
+  {
+    for (size_t i = 0; i < replay.players.size(); i++)
+      paths += replay.path + '\n';
+  }
+  File::IOFile path_file(prefix + "file.txt", "wb");
+  bool success = path_file.WriteBytes(paths.data(), paths.size());
+
+  using R = const ReplayStats&;
+  using P = const PlayerStats&;
+  success &= WriteColumn<u16>(prefix + "stage.u16", results, [](R r, P) { return r.stage; });
+  success &= WriteColumn<s32>(prefix + "frames.s32", results, [](R r, P) { return r.frame_count; });
+  success &= WriteColumn<u8>(prefix + "port.u8", results, [](R, P p) { return p.port + 1; });
+  success &= WriteColumn<u8>(prefix + "character.u8", results, [](R, P p) { return p.character; });
+  success &= WriteColumn<u8>(prefix + "final_stocks.u8", results,
+                             [](R, P p) { return p.final_stocks; });
+  success &= WriteColumn<float>(prefix + "final_percent.f32", results,
+                                [](R, P p) { return p.final_percent; });
+  success &= WriteColumn<u32>(prefix + "stocks_lost.u32", results,
+                              [](R, P p) { return p.stocks_lost; });
+  success &= WriteColumn<float>(prefix + "damage_taken.f32", results,
+                                [](R, P p) { return p.damage_taken; });
+  success &= WriteColumn<u32>(prefix + "hits_landed.u32", results,
+                              [](R, P p) { return p.hits_landed; });
+  success &= WriteColumn<u32>(prefix + "combos.u32", results, [](R, P p) { return p.combos; });
+  success &= WriteColumn<u32>(prefix + "longest_combo.u32", results,
+                              [](R, P p) { return p.longest_combo; });
+  success &= WriteColumn<u8>(prefix + "most_used_move.u8", results,
+                             [](R, P p) { return p.most_used_move; });
+
+  return success;
+}
+
+int main(int argc, const char* argv[])
+{
+  if (argc == 1 || (argc == 2 && IsHelpFlag(argv[1])))
+  {
+    PrintUsage();
+    return 0;
+  }
+
+  std::string output_name;
+  std::string column_directory;
+  u32 thread_count = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "-o" && i + 1 < argc)
+    {
+      output_name = argv[++i];
+    }
+    else if (argument == "-c" && i + 1 < argc)
+    {
+      column_directory = argv[++i];
+    }
+    else if (argument == "-j" && i + 1 < argc)
+    {
+      if (!TryParse(argv[++i], &thread_count) || thread_count == 0)
+      {
+        fprintf(stderr, "Invalid thread count: %s\n", argv[i]);
+        return 1;
+      }
+    }
+    else if (IsHelpFlag(argument))
+    {
+      PrintUsage();
+      return 0;
+    }
+    else
+    {
+      inputs.push_back(argument);
+    }
+  }
+
+  const std::vector<std::string> replays = CollectReplays(inputs);
+  if (replays.empty())
+  {
+    fprintf(stderr, "No replays found\n");
+    return 1;
+  }
+
+  thread_count = std::min<u32>(thread_count, static_cast<u32>(replays.size()));
+
+  // Replays vary a lot in length, so rather than splitting the list up front every worker grabs
+  // the next unclaimed file as soon as it is done with its current one
+  std::vector<ReplayStats> results(replays.size());
+  std::atomic<size_t> next_replay{0};
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (u32 i = 0; i < thread_count; i++)
+  {
+    workers.emplace_back([&] {
+      Common::SetCurrentThreadName("Slippi Stats Worker");
+
+      size_t index;
+      while ((index = next_replay.fetch_add(1, std::memory_order_relaxed)) < replays.size())
+        results[index] = ProcessReplay(replays[index]);
+    });
+  }
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (!column_directory.empty())
+  {
+    if (!WriteColumns(column_directory, results))
+    {
+      fprintf(stderr, "Failed to write the columns to %s\n", column_directory.c_str());
+      return 1;
+    }
+  }
+  else
+  {
+    File::IOFile output_file;
+    FILE* out = stdout;
+    if (!output_name.empty())
+    {
+      if (!output_file.Open(output_name, "w"))
+      {
+        fprintf(stderr, "Failed to open %s\n", output_name.c_str());
+        return 1;
+      }
+      out = output_file.GetHandle();
+    }
+
+    WriteStats(out, results);
+  }
+
+  size_t failed = std::count_if(results.begin(), results.end(),
+                                [](const ReplayStats& replay) { return !replay.is_valid; });
+  for (const ReplayStats& replay : results)
+  {
+    if (!replay.is_valid)
+      fprintf(stderr, "Failed to parse %s\n", replay.path.c_str());
+  }
+
+  fprintf(stderr, "Processed %zu replays (%zu failed) in %.2f s with %u threads, %.1f replays/s\n",
+          replays.size(), failed, seconds, thread_count, replays.size() / std::max(seconds, 1e-6));
+
+  return failed == replays.size() ? 1 : 0;
+}
@@ -0,0 +1,649 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Measures the lookups the texture cache does on its index of the cache entries, with the texture
+// binds and EFB copies of FIFO logs. Textures aren't decoded, so only the time spent on finding,
+// inserting and removing entries is measured, once with the std::multimap index the texture cache
+// used before and once with TextureAddressIndex.
+//
+// With --hash, measures how fast textures of different formats and sizes are hashed instead.
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "Common/Swap.h"
+#include "Core/FifoPlayer/FifoAnalyzer.h"
+#include "Core/FifoPlayer/FifoDataFile.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/TextureCacheIndex.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// Same as in TextureCacheBase
+static const u32 TEXTURE_KILL_THRESHOLD = 64;
+
+struct Event
+{
+  enum class Type
+  {
+    Bind,
+    Copy,
+    EndFrame,
+  };
+
+  Type type;
+  u32 address;
+  u32 size;
+  u64 hash;
+};
+
+struct Entry
+{
+  u32 addr = 0;
+  u32 size_in_bytes = 0;
+  u64 id = 0;
+  u64 hash = 0;
+  u32 frame = 0;
+  bool is_copy = false;
+  bool is_in_hash_index = false;
+  // Only used by MultimapIndex
+  std::multimap<u64, Entry*>::iterator hash_iter;
+};
+
+// Counted by both indexes, they have to come out the same
+struct Counts
+{
+  u64 address_hits = 0;
+  u64 hash_hits = 0;
+  u64 misses = 0;
+  u64 overlapping = 0;
+  u64 invalidations = 0;
+
+  bool operator==(const Counts& other) const
+  {
+    return address_hits == other.address_hits && hash_hits == other.hash_hits &&
+           misses == other.misses && overlapping == other.overlapping &&
+           invalidations == other.invalidations;
+  }
+};
+
+// The index of the texture cache before TextureAddressIndex
+class MultimapIndex
+{
+public:
+  template <typename Function>
+  void ForEachAtAddress(u32 address, Function function)
+  {
+    const auto range = m_by_address.equal_range(address);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+      if (!function(iter->second))
+        return;
+    }
+  }
+
+  template <typename Function>
+  void ForEachWithHash(u64 hash, Function function)
+  {
+    const auto range = m_by_hash.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+      if (!function(iter->second))
+        return;
+    }
+  }
+
+  // Removes the entries the function returns true for
+  template <typename Function>
+  void ForEachOverlapping(u32 address, u32 size, Function function)
+  {
+    constexpr u32 max_texture_size = 1024 * 1024 * 4;
+    const u32 lower_address = address > max_texture_size ? address - max_texture_size : 0;
+    auto iter = m_by_address.lower_bound(lower_address);
+    const auto end = m_by_address.upper_bound(address + size);
+    while (iter != end)
+    {
+      if (function(iter->second))
+        iter = Erase(iter);
+      else
+        ++iter;
+    }
+  }
+
+  template <typename Function>
+  void RemoveIf(Function function)
+  {
+    auto iter = m_by_address.begin();
+    while (iter != m_by_address.end())
+    {
+      if (function(iter->second))
+        iter = Erase(iter);
+      else
+        ++iter;
+    }
+  }
+
+  void Insert(Entry* entry)
+  {
+    m_by_address.emplace(entry->addr, entry);
+    if (!entry->is_copy)
+    {
+      entry->hash_iter = m_by_hash.emplace(entry->hash, entry);
+      entry->is_in_hash_index = true;
+    }
+  }
+
+  void Erase(Entry* entry)
+  {
+    const auto range = m_by_address.equal_range(entry->addr);
+    const auto iter = std::find_if(range.first, range.second,
+                                   [&](const auto& pair) { return pair.second == entry; });
+    if (iter != range.second)
+      Erase(iter);
+  }
+
+  void RemoveFromHashIndex(Entry* entry)
+  {
+    if (!entry->is_in_hash_index)
+      return;
+
+    m_by_hash.erase(entry->hash_iter);
+    entry->is_in_hash_index = false;
+  }
+
+private:
+  std::multimap<u32, Entry*>::iterator Erase(std::multimap<u32, Entry*>::iterator iter)
+  {
+    RemoveFromHashIndex(iter->second);
+    return m_by_address.erase(iter);
+  }
+
+  std::multimap<u32, Entry*> m_by_address;
+  std::multimap<u64, Entry*> m_by_hash;
+};
+
+// The index of the texture cache now
+class FlatIndex
+{
+public:
+  template <typename Function>
+  void ForEachAtAddress(u32 address, Function function)
+  {
+    for (Entry* entry : m_by_address.AtAddress(address))
+    {
+      if (!function(entry))
+        return;
+    }
+  }
+
+  template <typename Function>
+  void ForEachWithHash(u64 hash, Function function)
+  {
+    for (Entry* entry : m_by_hash.Find(hash))
+    {
+      if (!function(entry))
+        return;
+    }
+  }
+
+  template <typename Function>
+  void ForEachOverlapping(u32 address, u32 size, Function function)
+  {
+    for (Entry* entry : m_by_address.FindOverlapping(address, size))
+    {
+      if (function(entry))
+        Erase(entry);
+    }
+  }
+
+  template <typename Function>
+  void RemoveIf(Function function)
+  {
+    std::vector<Entry*> removed;
+    m_by_address.ForEach([&](Entry* entry) {
+      if (function(entry))
+        removed.push_back(entry);
+    });
+
+    for (Entry* entry : removed)
+      Erase(entry);
+  }
+
+  void Insert(Entry* entry)
+  {
+    m_by_address.Insert(entry);
+    if (!entry->is_copy)
+    {
+      m_by_hash.Insert(entry->hash, entry);
+      entry->is_in_hash_index = true;
+    }
+  }
+
+  void Erase(Entry* entry)
+  {
+    RemoveFromHashIndex(entry);
+    m_by_address.Erase(entry);
+  }
+
+  void RemoveFromHashIndex(Entry* entry)
+  {
+    if (!entry->is_in_hash_index)
+      return;
+
+    m_by_hash.Erase(entry->hash, entry);
+    entry->is_in_hash_index = false;
+  }
+
+private:
+  TextureAddressIndex<Entry> m_by_address;
+  FlatMultiMap<u64, Entry*> m_by_hash;
+};
+
+static bool Overlaps(const Entry* entry, u32 address, u32 size)
+{
+  return entry->addr < address + size && address < entry->addr + entry->size_in_bytes;
+}
+
+// Does what TextureCacheBase::Load, CopyRenderTargetToTexture and Cleanup do with the index
+template <typename Index>
+static Counts Replay(const std::vector<Event>& events)
+{
+  Index index;
+  Counts counts;
+  // Entries are never freed, like in the texture cache
+  std::deque<Entry> entries;
+  u32 frame = 0;
+
+  const auto create_entry = [&](u32 address, u32 size, u64 hash, bool is_copy) {
+    entries.emplace_back();
+    Entry* entry = &entries.back();
+    entry->addr = address;
+    entry->size_in_bytes = size;
+    entry->id = entries.size();
+    entry->hash = hash;
+    entry->frame = frame;
+    entry->is_copy = is_copy;
+    index.Insert(entry);
+    return entry;
+  };
+
+  for (const Event& event : events)
+  {
+    switch (event.type)
+    {
+    case Event::Type::Bind:
+    {
+      Entry* found = nullptr;
+      Entry* oldest = nullptr;
+      index.ForEachAtAddress(event.address, [&](Entry* entry) {
+        if (entry->is_copy || entry->hash == event.hash)
+        {
+          found = entry;
+          return false;
+        }
+        if (entry->frame != frame && (!oldest || entry->frame < oldest->frame))
+          oldest = entry;
+        return true;
+      });
+
+      if (found)
+      {
+        counts.address_hits++;
+        found->frame = frame;
+        break;
+      }
+
+      index.ForEachWithHash(event.hash, [&](Entry* entry) {
+        found = entry->size_in_bytes == event.size ? entry : nullptr;
+        return !found;
+      });
+
+      if (found)
+      {
+        counts.hash_hits++;
+        found->frame = frame;
+        break;
+      }
+
+      counts.misses++;
+      if (oldest)
+      {
+        index.Erase(oldest);
+        counts.invalidations++;
+      }
+
+      // New textures look for EFB copies to apply as partial texture updates
+      create_entry(event.address, event.size, event.hash, false);
+      index.ForEachOverlapping(event.address, event.size, [&](Entry* entry) {
+        if (entry->is_copy && Overlaps(entry, event.address, event.size))
+          counts.overlapping++;
+        return false;
+      });
+      break;
+    }
+
+    case Event::Type::Copy:
+      index.ForEachOverlapping(event.address, event.size, [&](Entry* entry) {
+        if (!Overlaps(entry, event.address, event.size))
+          return false;
+
+        counts.overlapping++;
+        if (entry->addr >= event.address &&
+            entry->addr + entry->size_in_bytes <= event.address + event.size)
+        {
+          counts.invalidations++;
+          return true;
+        }
+
+        index.RemoveFromHashIndex(entry);
+        return false;
+      });
+      create_entry(event.address, event.size, 0, true);
+      break;
+
+    case Event::Type::EndFrame:
+      frame++;
+      index.RemoveIf([&](Entry* entry) {
+        const bool is_old = frame > TEXTURE_KILL_THRESHOLD + entry->frame;
+        if (is_old)
+          counts.invalidations++;
+        return is_old;
+      });
+      break;
+    }
+  }
+
+  return counts;
+}
+
+static u64 HashTexture(u32 address, u32 tex_image0, u32 generation)
+{
+  u64 hash = (static_cast<u64>(tex_image0) << 32) | address;
+  hash ^= generation * 0x9E3779B97F4A7C15ULL;
+  return hash;
+}
+
+// The textures are hashed by their address, their format and how often their memory was updated,
+// which finds the same textures as hashing their contents would, as long as they aren't loaded at
+// several addresses
+static bool ReadEvents(const std::string& path, std::vector<Event>* events)
+{
+  std::unique_ptr<FifoDataFile> file = FifoDataFile::Load(path, false);
+  if (!file)
+    return false;
+
+  const u32* cp_mem = file->GetCPMem();
+  FifoAnalyzer::LoadCPReg(0x50, cp_mem[0x50], FifoAnalyzer::s_CpMem);
+  FifoAnalyzer::LoadCPReg(0x60, cp_mem[0x60], FifoAnalyzer::s_CpMem);
+  for (int i = 0; i < 8; ++i)
+  {
+    FifoAnalyzer::LoadCPReg(0x70 + i, cp_mem[0x70 + i], FifoAnalyzer::s_CpMem);
+    FifoAnalyzer::LoadCPReg(0x80 + i, cp_mem[0x80 + i], FifoAnalyzer::s_CpMem);
+    FifoAnalyzer::LoadCPReg(0x90 + i, cp_mem[0x90 + i], FifoAnalyzer::s_CpMem);
+  }
+
+  std::array<u32, FifoDataFile::BP_MEM_SIZE> bp_mem;
+  std::copy_n(file->GetBPMem(), bp_mem.size(), bp_mem.begin());
+  u32 bp_mask = 0xFFFFFF;
+  std::unordered_map<u32, u32> generations;
+
+  for (u32 frame_index = 0; frame_index < file->GetFrameCount(); ++frame_index)
+  {
+    const FifoFrameInfo& frame = file->GetFrame(frame_index);
+    FifoAnalyzer::s_DrawingObject = false;
+
+    // Textures are looked up when a draw uses them after they were changed
+    std::bitset<8> changed_stages;
+    size_t next_update = 0;
+    u32 position = 0;
+    while (position < frame.fifoData.size())
+    {
+      for (; next_update < frame.memoryUpdates.size() &&
+             frame.memoryUpdates[next_update].fifoPosition <= position;
+           ++next_update)
+      {
+        if (frame.memoryUpdates[next_update].type == MemoryUpdate::TEXTURE_MAP)
+          generations[frame.memoryUpdates[next_update].address]++;
+      }
+
+      const u8* data = &frame.fifoData[position];
+      const u32 size = FifoAnalyzer::AnalyzeCommand(data, FifoAnalyzer::DECODE_PLAYBACK);
+      if (size == 0)
+      {
+        fprintf(stderr, "%s: Unknown command in frame %u\n", path.c_str(), frame_index);
+        return false;
+      }
+      position += size;
+
+      if (data[0] & 0x80)
+      {
+        for (u32 stage = 0; stage < changed_stages.size(); stage++)
+        {
+          if (!changed_stages[stage])
+            continue;
+
+          const u32 set = stage < 4 ? stage : stage - 4 + 0x20;
+          TexImage0 image0;
+          image0.hex = bp_mem[BPMEM_TX_SETIMAGE0 + set];
+          const u32 address = (bp_mem[BPMEM_TX_SETIMAGE3 + set] & 0xFFFFFF) << 5;
+          const u32 texture_size = TexDecoder_GetTextureSizeInBytes(
+              image0.width + 1, image0.height + 1, static_cast<TextureFormat>(image0.format));
+          events->push_back({Event::Type::Bind, address, texture_size,
+                             HashTexture(address, image0.hex, generations[address])});
+        }
+        changed_stages.reset();
+        continue;
+      }
+
+      if (data[0] != OpcodeDecoder::GX_LOAD_BP_REG)
+        continue;
+
+      const u32 command = Common::swap32(data + 1);
+      const u32 reg = command >> 24;
+      const u32 value = command & 0xFFFFFF;
+      if (reg == BPMEM_BP_MASK)
+      {
+        bp_mask = value;
+        continue;
+      }
+      bp_mem[reg] = (bp_mem[reg] & ~bp_mask) | (value & bp_mask);
+      bp_mask = 0xFFFFFF;
+
+      if ((reg >= BPMEM_TX_SETIMAGE0 && reg < BPMEM_TX_SETIMAGE0 + 4) ||
+          (reg >= BPMEM_TX_SETIMAGE3 && reg < BPMEM_TX_SETIMAGE3 + 4))
+      {
+        changed_stages.set(reg & 3);
+      }
+      else if ((reg >= BPMEM_TX_SETIMAGE0_4 && reg < BPMEM_TX_SETIMAGE0_4 + 4) ||
+               (reg >= BPMEM_TX_SETIMAGE3_4 && reg < BPMEM_TX_SETIMAGE3_4 + 4))
+      {
+        changed_stages.set(4 + (reg & 3));
+      }
+      else if (reg == BPMEM_TRIGGER_EFB_COPY)
+      {
+        // Covers the rows of blocks of the copy, with the block height of most copy formats
+        UPE_Copy copy;
+        copy.Hex = value;
+        const u32 address = (bp_mem[BPMEM_EFB_ADDR] & 0xFFFFFF) << 5;
+        const u32 stride = bp_mem[BPMEM_MIPMAP_STRIDE] << 5;
+        u32 rows = ((bp_mem[BPMEM_EFB_BR] >> 10) & 0x3FF) + 1;
+        if (!copy.copy_to_xfb)
+          rows = ((copy.half_scale ? rows / 2 : rows) + 3) / 4;
+        events->push_back({Event::Type::Copy, address, stride * rows, 0});
+      }
+    }
+
+    events->push_back({Event::Type::EndFrame, 0, 0, 0});
+  }
+
+  return true;
+}
+
+template <typename Index>
+static double MeasureReplay(const std::vector<Event>& events, u32 repeats, Counts* counts)
+{
+  double best_ms = 0;
+  for (u32 i = 0; i < repeats; i++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    *counts = Replay<Index>(events);
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best_ms = i == 0 ? elapsed.count() : std::min(best_ms, elapsed.count());
+  }
+  return best_ms;
+}
+
+template <typename Function>
+static double MeasureThroughput(u32 size, u32 repeats, Function function)
+{
+  // At least 64 MB per run, so small textures are measured over enough calls
+  const u32 calls = std::max<u32>(1, (64 << 20) / size);
+  double best_s = 0;
+  for (u32 i = 0; i < repeats; i++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 call = 0; call < calls; call++)
+      function();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best_s = i == 0 ? elapsed.count() : std::min(best_s, elapsed.count());
+  }
+  return best_s > 0 ? static_cast<double>(size) * calls / best_s / (1 << 20) : 0.0;
+}
+
+// Compares the full hash with the CRC32 (or MurmurHash3) of every 8 bytes, which was the full hash
+// before, and with the 128 samples the texture cache took by default
+static void MeasureHashes(u32 repeats)
+{
+  static const struct
+  {
+    const char* name;
+    TextureFormat format;
+  } formats[] = {{"I4", TextureFormat::I4},         {"I8", TextureFormat::I8},
+                 {"IA8", TextureFormat::IA8},       {"RGB565", TextureFormat::RGB565},
+                 {"RGBA8", TextureFormat::RGBA8},   {"CMPR", TextureFormat::CMPR}};
+  static const u32 sizes[] = {32, 128, 512, 1024};
+
+  Common::SetHash64Function();
+  std::mt19937 random(0);
+  std::vector<u8> data(TexDecoder_GetTextureSizeInBytes(1024, 1024, TextureFormat::RGBA8));
+  std::generate(data.begin(), data.end(), [&] { return static_cast<u8>(random()); });
+
+  printf("format  size       bytes      full MB/s  every 8 bytes MB/s  128 samples MB/s\n");
+  for (const auto& format : formats)
+  {
+    for (u32 size : sizes)
+    {
+      const u32 bytes = TexDecoder_GetTextureSizeInBytes(size, size, format.format);
+      volatile u64 sink = 0;
+      const double full = MeasureThroughput(
+          bytes, repeats, [&] { sink = sink + Common::GetHash64(data.data(), bytes, 0); });
+      const double every_8_bytes = MeasureThroughput(
+          bytes, repeats, [&] { sink = sink + Common::GetHash64(data.data(), bytes, bytes / 8); });
+      const double sampled = MeasureThroughput(
+          bytes, repeats, [&] { sink = sink + Common::GetHash64(data.data(), bytes, 128); });
+      printf("%-7s %4ux%-4u %9u %12.0f %19.0f %17.0f\n", format.name, size, size, bytes, full,
+             every_8_bytes, sampled);
+    }
+  }
+}
+
+static void PrintUsage()
+{
+  printf("USAGE: texture-cache-bench [-?] [--help] [-n <REPEATS>] <FIFO LOG>...\n");
+  printf("       texture-cache-bench [-n <REPEATS>] --hash\n");
+  printf("-? / --help: Prints this message\n");
+  printf("-n <REPEATS>: How often every log is replayed, the fastest time counts (default 5)\n");
+  printf("--hash: Measures the texture hashes instead\n");
+}
+
+int main(int argc, const char* argv[])
+{
+  u32 repeats = 5;
+  bool measure_hashes = false;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "--help" || argument == "-?")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if (argument == "--hash")
+    {
+      measure_hashes = true;
+    }
+    else if (argument == "-n" && i + 1 < argc)
+    {
+      repeats = std::max(std::stoi(argv[++i]), 1);
+    }
+    else
+    {
+      paths.push_back(argument);
+    }
+  }
+
+  if (measure_hashes)
+  {
+    MeasureHashes(repeats);
+    return 0;
+  }
+
+  if (paths.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  FifoAnalyzer::Init();
+
+  int result = 0;
+  for (const std::string& path : paths)
+  {
+    std::vector<Event> events;
+    if (!ReadEvents(path, &events))
+    {
+      fprintf(stderr, "%s: Failed to read the FIFO log\n", path.c_str());
+      result = 1;
+      continue;
+    }
+
+    Counts multimap_counts, flat_counts;
+    const double multimap_ms = MeasureReplay<MultimapIndex>(events, repeats, &multimap_counts);
+    const double flat_ms = MeasureReplay<FlatIndex>(events, repeats, &flat_counts);
+
+    printf("%s: %zu events\n", path.c_str(), events.size());
+    printf("  %llu found at their address, %llu by hash, %llu new, %llu overlapping, "
+           "%llu invalidated\n",
+           static_cast<unsigned long long>(flat_counts.address_hits),
+           static_cast<unsigned long long>(flat_counts.hash_hits),
+           static_cast<unsigned long long>(flat_counts.misses),
+           static_cast<unsigned long long>(flat_counts.overlapping),
+           static_cast<unsigned long long>(flat_counts.invalidations));
+    printf("  std::multimap:       %9.3f ms\n", multimap_ms);
+    printf("  TextureAddressIndex: %9.3f ms (%.2fx)\n", flat_ms,
+           flat_ms > 0 ? multimap_ms / flat_ms : 0.0);
+
+    if (!(multimap_counts == flat_counts))
+    {
+      fprintf(stderr, "%s: The indexes found different entries\n", path.c_str());
+      result = 1;
+    }
+  }
+
+  return result;
+}
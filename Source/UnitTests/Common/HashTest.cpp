@@ -0,0 +1,90 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+
+namespace
+{
+std::vector<u8> RandomData(size_t size)
+{
+  std::mt19937 random(size);
+  std::vector<u8> data(size);
+  std::generate(data.begin(), data.end(), [&] { return static_cast<u8>(random()); });
+  return data;
+}
+
+std::vector<u64> FullHashes(const std::vector<u8>& data)
+{
+  std::vector<u64> hashes;
+  for (u32 len = 0; len <= data.size(); len += len < 256 ? 1 : 61)
+    hashes.push_back(Common::GetHash64(data.data(), len, 0));
+  return hashes;
+}
+}  // namespace
+
+TEST(Hash, FullHashIsTheSameWithEveryImplementation)
+{
+  const std::vector<u8> data = RandomData(5000);
+  const CPUInfo saved_cpu_info = cpu_info;
+
+  Common::SetHash64Function();
+  const std::vector<u64> expected = FullHashes(data);
+
+  cpu_info.bAVX2 = false;
+  Common::SetHash64Function();
+  EXPECT_EQ(expected, FullHashes(data));
+
+  cpu_info.bSSE2 = false;
+  cpu_info.bASIMD = false;
+  Common::SetHash64Function();
+  EXPECT_EQ(expected, FullHashes(data));
+
+  cpu_info = saved_cpu_info;
+  Common::SetHash64Function();
+}
+
+TEST(Hash, FullHashSeesEveryByte)
+{
+  Common::SetHash64Function();
+  std::vector<u8> data = RandomData(3000);
+  const u64 hash = Common::GetHash64(data.data(), 3000, 0);
+
+  for (size_t i = 0; i < data.size(); i += 7)
+  {
+    data[i] ^= 0x10;
+    EXPECT_NE(hash, Common::GetHash64(data.data(), 3000, 0)) << "byte " << i;
+    data[i] ^= 0x10;
+  }
+  EXPECT_EQ(hash, Common::GetHash64(data.data(), 3000, 0));
+}
+
+TEST(Hash, FullHashSeesReorderedData)
+{
+  Common::SetHash64Function();
+  std::vector<u8> data = RandomData(2048);
+  const u64 hash = Common::GetHash64(data.data(), 2048, 0);
+
+  // Two stripes of 64 bytes, and two halves of the 8 byte values the hash works on
+  std::vector<u8> swapped_stripes = data;
+  std::swap_ranges(swapped_stripes.begin(), swapped_stripes.begin() + 64,
+                   swapped_stripes.begin() + 64);
+  EXPECT_NE(hash, Common::GetHash64(swapped_stripes.data(), 2048, 0));
+
+  std::vector<u8> swapped_halves = data;
+  std::swap_ranges(swapped_halves.begin(), swapped_halves.begin() + 4,
+                   swapped_halves.begin() + 4);
+  EXPECT_NE(hash, Common::GetHash64(swapped_halves.data(), 2048, 0));
+
+  // Trailing zeros
+  std::vector<u8> zeros(100);
+  EXPECT_NE(Common::GetHash64(zeros.data(), 99, 0), Common::GetHash64(zeros.data(), 100, 0));
+}
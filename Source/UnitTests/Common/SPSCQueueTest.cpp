@@ -69,3 +69,60 @@ TEST(SPSCQueue, MultiThreaded)
   popper_thread.join();
   inserter_thread.join();
 }
+
+TEST(FixedSPSCQueue, Simple)
+{
+  Common::FixedSPSCQueue<u32, 4> q;
+
+  EXPECT_EQ(0u, q.Size());
+  EXPECT_TRUE(q.Empty());
+
+  for (u32 i = 0; i < 4; ++i)
+    EXPECT_TRUE(q.TryPush(i));
+  EXPECT_TRUE(q.Full());
+  EXPECT_FALSE(q.TryPush(4u));
+  EXPECT_EQ(4u, q.Size());
+
+  // Wrap around the ring a few times while checking the FIFO order.
+  for (u32 i = 0; i < 100; ++i)
+  {
+    u32 v;
+    EXPECT_TRUE(q.Pop(v));
+    EXPECT_EQ(i, v);
+    EXPECT_TRUE(q.TryPush(i + 4));
+  }
+
+  q.Clear();
+  EXPECT_TRUE(q.Empty());
+  u32 v;
+  EXPECT_FALSE(q.Pop(v));
+}
+
+TEST(FixedSPSCQueue, MultiThreaded)
+{
+  Common::FixedSPSCQueue<u32, 64> q;
+
+  auto inserter = [&q]() {
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      while (!q.TryPush(i))
+        ;
+    }
+  };
+
+  auto popper = [&q]() {
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      u32 v;
+      while (!q.Pop(v))
+        ;
+      EXPECT_EQ(i, v);
+    }
+  };
+
+  std::thread popper_thread(popper);
+  std::thread inserter_thread(inserter);
+
+  popper_thread.join();
+  inserter_thread.join();
+}
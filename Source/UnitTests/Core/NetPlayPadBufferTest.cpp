@@ -0,0 +1,196 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Flag.h"
+#include "Core/NetPlayPadBuffer.h"
+#include "InputCommon/GCPadStatus.h"
+
+using NetPlay::PadBuffer;
+
+namespace
+{
+// PadBuffer::CAPACITY
+constexpr u32 CAPACITY = 1024;
+
+GCPadStatus MakeStatus(u32 i)
+{
+  GCPadStatus status{};
+  status.button = static_cast<u16>(i);
+  status.stickX = static_cast<u8>(i >> 16);
+  return status;
+}
+
+u32 GetValue(const GCPadStatus& status)
+{
+  return status.button | status.stickX << 16;
+}
+}  // namespace
+
+TEST(NetPlayPadBuffer, Simple)
+{
+  PadBuffer buffer;
+  GCPadStatus status;
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_FALSE(buffer.Pop(&status));
+
+  EXPECT_TRUE(buffer.Push(MakeStatus(1), 0));
+  EXPECT_EQ(1u, buffer.Size());
+  ASSERT_TRUE(buffer.Pop(&status));
+  EXPECT_EQ(1u, GetValue(status));
+  EXPECT_EQ(0u, buffer.Size());
+
+  // Test the FIFO order.
+  for (u32 i = 0; i < 100; ++i)
+    EXPECT_TRUE(buffer.Push(MakeStatus(i), i + 1));
+  EXPECT_EQ(100u, buffer.Size());
+  for (u32 i = 0; i < 100; ++i)
+  {
+    ASSERT_TRUE(buffer.Pop(&status));
+    EXPECT_EQ(i, GetValue(status));
+  }
+  EXPECT_FALSE(buffer.Pop(&status));
+}
+
+TEST(NetPlayPadBuffer, Wraparound)
+{
+  PadBuffer buffer;
+  for (u32 i = 0; i < CAPACITY; ++i)
+    EXPECT_TRUE(buffer.Push(MakeStatus(i), i));
+  EXPECT_EQ(CAPACITY, buffer.Size());
+  EXPECT_FALSE(buffer.Push(MakeStatus(CAPACITY), CAPACITY));
+
+  // Wrap around the ring a few times while keeping it full and checking the FIFO order.
+  GCPadStatus status;
+  for (u32 i = 0; i < 3 * CAPACITY + 7; ++i)
+  {
+    ASSERT_TRUE(buffer.Pop(&status));
+    EXPECT_EQ(i, GetValue(status));
+    EXPECT_TRUE(buffer.Push(MakeStatus(i + CAPACITY), i + CAPACITY));
+    EXPECT_FALSE(buffer.Push(MakeStatus(0), 0));
+  }
+  EXPECT_EQ(CAPACITY, buffer.Size());
+
+  for (u32 i = 3 * CAPACITY + 7; i < 4 * CAPACITY + 7; ++i)
+  {
+    ASSERT_TRUE(buffer.Pop(&status));
+    EXPECT_EQ(i, GetValue(status));
+  }
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_FALSE(buffer.Pop(&status));
+}
+
+TEST(NetPlayPadBuffer, Clear)
+{
+  PadBuffer buffer;
+  for (u32 i = 0; i < 10; ++i)
+    buffer.Push(MakeStatus(i), i);
+  GCPadStatus status;
+  ASSERT_TRUE(buffer.Pop(&status));
+
+  buffer.Clear();
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_FALSE(buffer.Pop(&status));
+
+  // Inputs of the next game start over at index 0
+  EXPECT_TRUE(buffer.Push(MakeStatus(42), 0));
+  ASSERT_TRUE(buffer.Pop(&status));
+  EXPECT_EQ(42u, GetValue(status));
+
+  // Room for a full buffer again, across the end of the ring
+  for (u32 i = 0; i < CAPACITY; ++i)
+    EXPECT_TRUE(buffer.Push(MakeStatus(i), i + 1));
+  EXPECT_FALSE(buffer.Push(MakeStatus(0), 0));
+  buffer.Clear();
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_TRUE(buffer.Push(MakeStatus(7), 0));
+  EXPECT_EQ(1u, buffer.Size());
+}
+
+TEST(NetPlayPadBuffer, BlockingPopWokenByPush)
+{
+  PadBuffer buffer;
+  Common::Flag is_running(true);
+
+  // Doesn't block if there is input already
+  buffer.Push(MakeStatus(1), 0);
+  EXPECT_TRUE(buffer.WaitForInput(is_running));
+  GCPadStatus status;
+  ASSERT_TRUE(buffer.Pop(&status));
+
+  bool has_input = false;
+  std::thread popper([&] {
+    has_input = buffer.WaitForInput(is_running);
+    if (has_input)
+      has_input = buffer.Pop(&status);
+  });
+
+  // Give the popper time to fall asleep
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  buffer.Push(MakeStatus(2), 1);
+  popper.join();
+
+  EXPECT_TRUE(has_input);
+  EXPECT_EQ(2u, GetValue(status));
+  const PadBuffer::WaitStats stats = buffer.GetWaitStats();
+  EXPECT_EQ(1u, stats.waits);
+  EXPECT_GE(stats.max_us, 10000u);
+
+  buffer.ResetWaitStats();
+  EXPECT_EQ(0u, buffer.GetWaitStats().waits);
+}
+
+TEST(NetPlayPadBuffer, InterruptEndsWait)
+{
+  PadBuffer buffer;
+  Common::Flag is_running(true);
+
+  bool has_input = true;
+  std::thread popper([&] { has_input = buffer.WaitForInput(is_running); });
+
+  // Waking it up while still running only makes it check again
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  buffer.Interrupt();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  is_running.Clear();
+  buffer.Interrupt();
+  popper.join();
+
+  EXPECT_FALSE(has_input);
+}
+
+TEST(NetPlayPadBuffer, MultiThreaded)
+{
+  PadBuffer buffer;
+  Common::Flag is_running(true);
+
+  auto inserter = [&buffer]() {
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      while (!buffer.Push(MakeStatus(i), i))
+        std::this_thread::yield();
+    }
+  };
+
+  auto popper = [&buffer, &is_running]() {
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      ASSERT_TRUE(buffer.WaitForInput(is_running));
+      GCPadStatus status;
+      ASSERT_TRUE(buffer.Pop(&status));
+      EXPECT_EQ(i, GetValue(status));
+    }
+  };
+
+  std::thread popper_thread(popper);
+  std::thread inserter_thread(inserter);
+
+  popper_thread.join();
+  inserter_thread.join();
+}
@@ -0,0 +1,268 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <vector>
+
+#include <SFML/Network/Packet.hpp>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/NetPlayPadCoding.h"
+#include "InputCommon/GCPadStatus.h"
+
+using namespace NetPlay;
+
+namespace
+{
+constexpr PadMapping PAD = 2;
+
+GCPadStatus MakeStatus(u32 seed)
+{
+  GCPadStatus status{};
+  status.button = static_cast<u16>(seed * 3);
+  status.stickX = static_cast<u8>(seed);
+  status.stickY = static_cast<u8>(seed / 2);
+  status.substickX = static_cast<u8>(seed / 4);
+  status.triggerRight = static_cast<u8>(seed % 7);
+  status.analogB = static_cast<u8>(seed / 16);
+  status.isConnected = seed % 5 != 0;
+  return status;
+}
+
+void ExpectSameStatus(const GCPadStatus& expected, const GCPadStatus& actual)
+{
+  EXPECT_EQ(expected.button, actual.button);
+  EXPECT_EQ(expected.stickX, actual.stickX);
+  EXPECT_EQ(expected.stickY, actual.stickY);
+  EXPECT_EQ(expected.substickX, actual.substickX);
+  EXPECT_EQ(expected.substickY, actual.substickY);
+  EXPECT_EQ(expected.triggerLeft, actual.triggerLeft);
+  EXPECT_EQ(expected.triggerRight, actual.triggerRight);
+  EXPECT_EQ(expected.analogA, actual.analogA);
+  EXPECT_EQ(expected.analogB, actual.analogB);
+  EXPECT_EQ(expected.isConnected, actual.isConnected);
+}
+
+std::vector<PadRecord> ReadRecords(sf::Packet& packet)
+{
+  std::vector<PadRecord> records;
+  while (!packet.endOfPacket())
+  {
+    PadMapping pad;
+    packet >> pad;
+    EXPECT_EQ(PAD, pad);
+
+    PadRecord record;
+    if (!ReadPadRecord(packet, &record))
+    {
+      ADD_FAILURE() << "malformed record";
+      break;
+    }
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+// Feeds a packet into the receive state like NetPlayClient does and collects the new inputs
+bool ReceivePacket(sf::Packet& packet, PadReceiveState& receive, std::vector<GCPadStatus>& out)
+{
+  bool is_in_order = true;
+  for (const PadRecord& record : ReadRecords(packet))
+  {
+    is_in_order &= receive.Receive(record, [&](const GCPadStatus& status, u32 index) {
+      EXPECT_EQ(out.size(), index);
+      out.push_back(status);
+    });
+  }
+  return is_in_order;
+}
+
+// Pushes count inputs to the history and returns a packet like PollLocalPad sends it
+sf::Packet SendInputs(PadSendHistory& history, std::vector<GCPadStatus>& sent, u32 count)
+{
+  const u32 first_new = history.End();
+  for (u32 i = 0; i < count; i++)
+  {
+    sent.push_back(MakeStatus(static_cast<u32>(sent.size())));
+    history.Push(sent.back());
+  }
+
+  sf::Packet packet;
+  EXPECT_TRUE(history.Encode(PAD, history.GetRedundantStart(first_new), packet));
+  return packet;
+}
+}  // namespace
+
+TEST(NetPlayPadCoding, RoundTrip)
+{
+  PadSendHistory history;
+  std::vector<GCPadStatus> sent;
+  // Long runs of the same input and more inputs than fit into one record
+  for (u32 i = 0; i < 700; i++)
+  {
+    sent.push_back(MakeStatus(i < 300 ? 0 : i / 3));
+    history.Push(sent.back());
+  }
+
+  sf::Packet packet;
+  ASSERT_TRUE(history.Encode(PAD, 0, packet));
+  const std::vector<PadRecord> records = ReadRecords(packet);
+  ASSERT_EQ(3u, records.size());
+
+  std::vector<GCPadStatus> received;
+  for (const PadRecord& record : records)
+  {
+    EXPECT_EQ(received.size(), record.first);
+    received.insert(received.end(), record.inputs.begin(), record.inputs.end());
+  }
+  ASSERT_EQ(sent.size(), received.size());
+  for (size_t i = 0; i < sent.size(); i++)
+    ExpectSameStatus(sent[i], received[i]);
+}
+
+TEST(NetPlayPadCoding, RejectsTruncatedRecord)
+{
+  PadSendHistory history;
+  for (u32 i = 0; i < 4; i++)
+    history.Push(MakeStatus(i + 1));
+
+  sf::Packet packet;
+  ASSERT_TRUE(history.Encode(PAD, 0, packet));
+
+  sf::Packet truncated;
+  truncated.append(packet.getData(), packet.getDataSize() - 1);
+  PadMapping pad;
+  truncated >> pad;
+  PadRecord record;
+  EXPECT_FALSE(ReadPadRecord(truncated, &record));
+}
+
+TEST(NetPlayPadCoding, RedundantStart)
+{
+  PadSendHistory history;
+  EXPECT_EQ(0u, history.GetRedundantStart(0));
+  for (u32 i = 0; i < 20; i++)
+    history.Push(MakeStatus(i));
+  EXPECT_EQ(0u, history.GetRedundantStart(3));
+  EXPECT_EQ(20u - PAD_DATA_REDUNDANCY, history.GetRedundantStart(20));
+
+  // Inputs that aren't kept anymore can't be sent again
+  for (u32 i = 0; i < 2000; i++)
+    history.Push(MakeStatus(i));
+  EXPECT_EQ(history.End() - 1024, history.GetRedundantStart(0));
+  sf::Packet packet;
+  EXPECT_FALSE(history.Encode(PAD, 0, packet));
+  EXPECT_FALSE(history.Encode(PAD, history.End() + 1, packet));
+}
+
+TEST(NetPlayPadCoding, RedundancyCoversLostPacket)
+{
+  PadSendHistory history;
+  PadReceiveState receive;
+  std::vector<GCPadStatus> sent, received;
+
+  sf::Packet first = SendInputs(history, sent, 2);
+  ASSERT_TRUE(ReceivePacket(first, receive, received));
+  SendInputs(history, sent, 2);
+  sf::Packet third = SendInputs(history, sent, 2);
+  EXPECT_TRUE(ReceivePacket(third, receive, received));
+  EXPECT_FALSE(receive.ShouldRequestResend(0));
+
+  // Duplicates are dropped
+  sf::Packet again = SendInputs(history, sent, 0);
+  EXPECT_TRUE(ReceivePacket(again, receive, received));
+
+  ASSERT_EQ(sent.size(), received.size());
+  for (size_t i = 0; i < sent.size(); i++)
+    ExpectSameStatus(sent[i], received[i]);
+}
+
+TEST(NetPlayPadCoding, GapIsRequestedOnce)
+{
+  PadSendHistory history;
+  PadReceiveState receive;
+  std::vector<GCPadStatus> sent, received;
+
+  sf::Packet first = SendInputs(history, sent, 1);
+  ASSERT_TRUE(ReceivePacket(first, receive, received));
+  EXPECT_FALSE(receive.ShouldRequestResend(0));
+
+  // More is lost than the redundant inputs cover
+  SendInputs(history, sent, PAD_DATA_REDUNDANCY + 1);
+  sf::Packet later = SendInputs(history, sent, 1);
+  EXPECT_FALSE(ReceivePacket(later, receive, received));
+  EXPECT_TRUE(receive.ShouldRequestResend(10));
+  EXPECT_EQ(1u, receive.Next());
+
+  // Further packets before the resend arrives don't ask again
+  sf::Packet next = SendInputs(history, sent, 1);
+  EXPECT_FALSE(ReceivePacket(next, receive, received));
+  EXPECT_FALSE(receive.ShouldRequestResend(20));
+
+  sf::Packet resend;
+  ASSERT_TRUE(history.Encode(PAD, receive.Next(), resend));
+  EXPECT_TRUE(ReceivePacket(resend, receive, received));
+  EXPECT_FALSE(receive.ShouldRequestResend(30));
+
+  ASSERT_EQ(sent.size(), received.size());
+  for (size_t i = 0; i < sent.size(); i++)
+    ExpectSameStatus(sent[i], received[i]);
+}
+
+TEST(NetPlayPadCoding, LostResendIsRequestedAgain)
+{
+  PadSendHistory history;
+  PadReceiveState receive;
+  std::vector<GCPadStatus> sent, received;
+
+  sf::Packet first = SendInputs(history, sent, 1);
+  ASSERT_TRUE(ReceivePacket(first, receive, received));
+  SendInputs(history, sent, PAD_DATA_REDUNDANCY + 1);
+  sf::Packet later = SendInputs(history, sent, 1);
+  EXPECT_FALSE(ReceivePacket(later, receive, received));
+  EXPECT_TRUE(receive.ShouldRequestResend(1000));
+
+  // The request or its answer was lost
+  EXPECT_FALSE(receive.ShouldRequestResend(1000 + PAD_RESEND_TIMEOUT_MS - 1));
+  EXPECT_TRUE(receive.ShouldRequestResend(1000 + PAD_RESEND_TIMEOUT_MS));
+  EXPECT_FALSE(receive.ShouldRequestResend(1000 + PAD_RESEND_TIMEOUT_MS + 1));
+  EXPECT_TRUE(receive.ShouldRequestResend(1000 + 2 * PAD_RESEND_TIMEOUT_MS));
+
+  sf::Packet resend;
+  ASSERT_TRUE(history.Encode(PAD, receive.Next(), resend));
+  EXPECT_TRUE(ReceivePacket(resend, receive, received));
+  EXPECT_EQ(sent.size(), received.size());
+}
+
+TEST(NetPlayPadCoding, LostLastPacketIsRequested)
+{
+  PadSendHistory history;
+  PadReceiveState receive;
+  std::vector<GCPadStatus> sent, received;
+
+  sf::Packet first = SendInputs(history, sent, 3);
+  ASSERT_TRUE(ReceivePacket(first, receive, received));
+  EXPECT_FALSE(receive.ShouldRequestResend(500));
+
+  // The last packet before the sender waits is lost, so no gap is ever seen
+  SendInputs(history, sent, 2);
+  EXPECT_FALSE(receive.ShouldRequestResend(500 + PAD_RESEND_TIMEOUT_MS / 2));
+  EXPECT_TRUE(receive.ShouldRequestResend(500 + PAD_RESEND_TIMEOUT_MS));
+
+  sf::Packet resend;
+  ASSERT_TRUE(history.Encode(PAD, receive.Next(), resend));
+  EXPECT_TRUE(ReceivePacket(resend, receive, received));
+  ASSERT_EQ(sent.size(), received.size());
+  for (size_t i = 0; i < sent.size(); i++)
+    ExpectSameStatus(sent[i], received[i]);
+
+  // Progress restarts the timeout
+  EXPECT_FALSE(receive.ShouldRequestResend(500 + PAD_RESEND_TIMEOUT_MS + 1));
+  EXPECT_FALSE(receive.ShouldRequestResend(500 + 2 * PAD_RESEND_TIMEOUT_MS));
+  EXPECT_TRUE(receive.ShouldRequestResend(501 + 2 * PAD_RESEND_TIMEOUT_MS));
+
+  receive.Reset();
+  EXPECT_EQ(0u, receive.Next());
+  EXPECT_FALSE(receive.ShouldRequestResend(10000));
+}
@@ -0,0 +1,344 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SlippiCompression.h>
+#include <SlippiGame.h>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+
+namespace
+{
+constexpr u16 GAME_INIT_SIZE = 320;
+constexpr u16 PRE_FRAME_SIZE = 58;
+constexpr u16 POST_FRAME_SIZE = 33;
+constexpr u16 GAME_END_SIZE = 1;
+
+// Long enough to need a second frame chunk
+constexpr s32 FRAME_COUNT = 400;
+constexpr s32 LAST_FRAME = Slippi::GAME_FIRST_FRAME + FRAME_COUNT - 1;
+constexpr u8 PLAYER_COUNT = 2;
+// Doesn't divide the events of a frame, so most blocks end in the middle of one
+constexpr size_t EVENTS_PER_BLOCK = 37;
+
+void AppendU16(std::vector<u8>& out, u16 value)
+{
+  out.push_back(value >> 8);
+  out.push_back(value & 0xFF);
+}
+
+void AppendU32(std::vector<u8>& out, u32 value)
+{
+  AppendU16(out, value >> 16);
+  AppendU16(out, value & 0xFFFF);
+}
+
+std::vector<u8> MakePayloadSizes()
+{
+  std::vector<u8> event{Slippi::EVENT_PAYLOAD_SIZES, 1 + 4 * 3};
+  event.push_back(Slippi::EVENT_GAME_INIT);
+  AppendU16(event, GAME_INIT_SIZE);
+  event.push_back(Slippi::EVENT_PRE_FRAME_UPDATE);
+  AppendU16(event, PRE_FRAME_SIZE);
+  event.push_back(Slippi::EVENT_POST_FRAME_UPDATE);
+  AppendU16(event, POST_FRAME_SIZE);
+  event.push_back(Slippi::EVENT_GAME_END);
+  AppendU16(event, GAME_END_SIZE);
+  return event;
+}
+
+std::vector<u8> MakeGameInit()
+{
+  std::vector<u8> event(1 + GAME_INIT_SIZE, 0);
+  event[0] = Slippi::EVENT_GAME_INIT;
+  event[1] = 1;
+  for (u8 port = 0; port < Slippi::PLAYER_SLOT_COUNT; port++)
+  {
+    // Character, player type and color of every port, type 3 is an empty slot
+    u8* info = &event[1 + 4 + 4 * (24 + 9 * port)];
+    info[0] = port + 2;
+    info[1] = port < PLAYER_COUNT ? 0 : 3;
+  }
+  return event;
+}
+
+// Every byte after the frame and port depends on both, so nothing repeats between updates
+std::vector<u8> MakeFrameUpdate(u8 command, s32 frame, u8 port)
+{
+  const u16 size = command == Slippi::EVENT_PRE_FRAME_UPDATE ? PRE_FRAME_SIZE : POST_FRAME_SIZE;
+  std::vector<u8> event{command};
+  AppendU32(event, static_cast<u32>(frame));
+  event.push_back(port);
+  event.push_back(0);
+  for (u16 i = 6; i < size; i++)
+    event.push_back(static_cast<u8>(frame * 31 + port * 57 + i * 13 + (i * frame) / 7));
+
+  // Keep the character from turning into Sheik
+  if (command == Slippi::EVENT_POST_FRAME_UPDATE)
+    event[1 + 6] = 1;
+  return event;
+}
+
+std::vector<std::vector<u8>> MakeEvents()
+{
+  std::vector<std::vector<u8>> events{MakePayloadSizes(), MakeGameInit()};
+  for (s32 frame = Slippi::GAME_FIRST_FRAME; frame <= LAST_FRAME; frame++)
+  {
+    for (u8 port = 0; port < PLAYER_COUNT; port++)
+      events.push_back(MakeFrameUpdate(Slippi::EVENT_PRE_FRAME_UPDATE, frame, port));
+    for (u8 port = 0; port < PLAYER_COUNT; port++)
+      events.push_back(MakeFrameUpdate(Slippi::EVENT_POST_FRAME_UPDATE, frame, port));
+  }
+  events.push_back({Slippi::EVENT_GAME_END, 2});
+  return events;
+}
+
+// The frame the last pre frame update in the first event_count events belongs to
+s32 GetLastFrame(const std::vector<std::vector<u8>>& events, size_t event_count)
+{
+  for (size_t i = event_count; i > 0; i--)
+  {
+    const std::vector<u8>& event = events[i - 1];
+    if (event[0] == Slippi::EVENT_PRE_FRAME_UPDATE)
+      return static_cast<s32>(event[1] << 24 | event[2] << 16 | event[3] << 8 | event[4]);
+  }
+  return 0;
+}
+
+struct CompressedReplay
+{
+  std::vector<u8> header;
+  // Events blocks, then the metadata block
+  std::vector<std::vector<u8>> blocks;
+  // Number of events contained in the blocks up to and including each one
+  std::vector<size_t> event_counts;
+};
+
+CompressedReplay Compress(const std::vector<std::vector<u8>>& events)
+{
+  CompressedReplay replay;
+  Slippi::writeCompressedHeader(replay.header);
+
+  Slippi::ReplayEncoder encoder;
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    encoder.appendEvents(events[i].data(), events[i].size());
+    if ((i + 1) % EVENTS_PER_BLOCK == 0 || i + 1 == events.size())
+    {
+      replay.blocks.emplace_back();
+      encoder.finishBlock(replay.blocks.back());
+      replay.event_counts.push_back(i + 1);
+    }
+  }
+
+  const std::string metadata = "{U\x08metadata{}}";
+  replay.blocks.emplace_back();
+  Slippi::writeCompressedBlock(Slippi::BLOCK_TYPE_METADATA,
+                               reinterpret_cast<const u8*>(metadata.data()), metadata.size(),
+                               replay.blocks.back());
+  return replay;
+}
+
+void ExpectSameFloat(float expected, float actual)
+{
+  EXPECT_EQ(0, std::memcmp(&expected, &actual, sizeof(float)));
+}
+
+void ExpectSamePlayer(const Slippi::PlayerFrameData& expected,
+                      const Slippi::PlayerFrameData& actual)
+{
+  EXPECT_EQ(expected.randomSeed, actual.randomSeed);
+  EXPECT_EQ(expected.internalCharacterId, actual.internalCharacterId);
+  EXPECT_EQ(expected.animation, actual.animation);
+  ExpectSameFloat(expected.locationX, actual.locationX);
+  ExpectSameFloat(expected.locationY, actual.locationY);
+  ExpectSameFloat(expected.facingDirection, actual.facingDirection);
+  EXPECT_EQ(expected.stocks, actual.stocks);
+  ExpectSameFloat(expected.percent, actual.percent);
+  ExpectSameFloat(expected.shieldSize, actual.shieldSize);
+  EXPECT_EQ(expected.lastMoveHitId, actual.lastMoveHitId);
+  EXPECT_EQ(expected.comboCount, actual.comboCount);
+  EXPECT_EQ(expected.lastHitBy, actual.lastHitBy);
+  ExpectSameFloat(expected.joystickX, actual.joystickX);
+  ExpectSameFloat(expected.joystickY, actual.joystickY);
+  ExpectSameFloat(expected.cstickX, actual.cstickX);
+  ExpectSameFloat(expected.cstickY, actual.cstickY);
+  ExpectSameFloat(expected.trigger, actual.trigger);
+  EXPECT_EQ(expected.buttons, actual.buttons);
+  EXPECT_EQ(expected.physicalButtons, actual.physicalButtons);
+  ExpectSameFloat(expected.lTrigger, actual.lTrigger);
+  ExpectSameFloat(expected.rTrigger, actual.rTrigger);
+}
+
+class SlippiCompressionTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_temp_dir = File::CreateTempDir();
+    ASSERT_FALSE(m_temp_dir.empty());
+    m_events = MakeEvents();
+    m_replay = Compress(m_events);
+    // Otherwise the tests below don't cross any block boundary
+    ASSERT_GT(m_replay.blocks.size(), 10u);
+  }
+
+  void TearDown() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  // The uncompressed replay parsed the same way, to compare against
+  std::unique_ptr<Slippi::SlippiGame> ParseRaw()
+  {
+    const std::string path = m_temp_dir + "/raw.slp";
+    File::IOFile file(path, "wb");
+    for (const std::vector<u8>& event : m_events)
+      file.WriteBytes(event.data(), event.size());
+    file.Close();
+
+    std::unique_ptr<Slippi::SlippiGame> game(Slippi::SlippiGame::FromFile(path));
+    EXPECT_NE(nullptr, game);
+    if (game)
+      game->DoesFrameExist(Slippi::GAME_FIRST_FRAME);
+    return game;
+  }
+
+  void ExpectSameFrames(Slippi::SlippiGame& expected, Slippi::SlippiGame& actual, s32 last_frame)
+  {
+    for (s32 frame = Slippi::GAME_FIRST_FRAME; frame <= last_frame; frame++)
+    {
+      const Slippi::FrameData* expected_frame = expected.GetFrame(frame);
+      const Slippi::FrameData* actual_frame = actual.GetFrame(frame);
+      ASSERT_NE(nullptr, expected_frame);
+      ASSERT_NE(nullptr, actual_frame) << "frame " << frame;
+      EXPECT_EQ(frame, actual_frame->frame);
+      for (u8 port = 0; port < Slippi::PLAYER_SLOT_COUNT; port++)
+      {
+        ASSERT_EQ(expected_frame->hasPlayer[port], actual_frame->hasPlayer[port]);
+        if (expected_frame->hasPlayer[port])
+          ExpectSamePlayer(expected_frame->players[port], actual_frame->players[port]);
+      }
+    }
+  }
+
+  std::string m_temp_dir;
+  std::vector<std::vector<u8>> m_events;
+  CompressedReplay m_replay;
+};
+}  // namespace
+
+TEST_F(SlippiCompressionTest, BlockBoundaries)
+{
+  const std::string path = m_temp_dir + "/game.slpz";
+  File::IOFile file(path, "wb");
+  file.WriteBytes(m_replay.header.data(), m_replay.header.size());
+  for (const std::vector<u8>& block : m_replay.blocks)
+    file.WriteBytes(block.data(), block.size());
+  file.Close();
+
+  std::unique_ptr<Slippi::SlippiGame> game(Slippi::SlippiGame::FromFile(path));
+  ASSERT_NE(nullptr, game);
+  ASSERT_TRUE(game->AreSettingsLoaded());
+  EXPECT_TRUE(game->IsProcessingComplete());
+  EXPECT_EQ(LAST_FRAME, game->GetFrameCount());
+  EXPECT_TRUE(game->DoesPlayerExist(1));
+  EXPECT_FALSE(game->DoesPlayerExist(2));
+
+  std::unique_ptr<Slippi::SlippiGame> raw = ParseRaw();
+  ASSERT_NE(nullptr, raw);
+  EXPECT_EQ(raw->GetFrameCount(), game->GetFrameCount());
+  ExpectSameFrames(*raw, *game, LAST_FRAME);
+}
+
+TEST_F(SlippiCompressionTest, TailFollow)
+{
+  const std::string path = m_temp_dir + "/game.slpz";
+  File::IOFile file(path, "wb");
+  std::unique_ptr<Slippi::SlippiGame> game(Slippi::SlippiGame::FromFile(path));
+  ASSERT_NE(nullptr, game);
+
+  // Not even the header is there yet
+  file.WriteBytes(m_replay.header.data(), 3);
+  file.Flush();
+  EXPECT_FALSE(game->DoesFrameExist(Slippi::GAME_FIRST_FRAME));
+  file.WriteBytes(&m_replay.header[3], m_replay.header.size() - 3);
+  file.Flush();
+  EXPECT_FALSE(game->DoesFrameExist(Slippi::GAME_FIRST_FRAME));
+
+  s32 last_frame = 0;
+  for (size_t i = 0; i < m_replay.blocks.size(); i++)
+  {
+    // The file is written in pieces smaller than a block header as well
+    const std::vector<u8>& block = m_replay.blocks[i];
+    const size_t split = i % 2 ? block.size() / 2 : Slippi::COMPRESSED_BLOCK_HEADER_SIZE - 2;
+    file.WriteBytes(block.data(), split);
+    file.Flush();
+    game->DoesFrameExist(Slippi::GAME_FIRST_FRAME);
+    if (i > 0)
+    {
+      EXPECT_EQ(last_frame, game->GetFrameCount()) << "block " << i;
+    }
+    // The game end event is in the last events block
+    EXPECT_EQ(i >= m_replay.event_counts.size(), game->IsProcessingComplete());
+
+    file.WriteBytes(&block[split], block.size() - split);
+    file.Flush();
+    game->DoesFrameExist(Slippi::GAME_FIRST_FRAME);
+    if (i < m_replay.event_counts.size())
+    {
+      last_frame = GetLastFrame(m_events, m_replay.event_counts[i]);
+      EXPECT_EQ(last_frame, game->GetFrameCount()) << "block " << i;
+      EXPECT_TRUE(game->DoesFrameExist(last_frame));
+      EXPECT_FALSE(game->DoesFrameExist(last_frame + 1));
+    }
+  }
+
+  EXPECT_TRUE(game->IsProcessingComplete());
+  EXPECT_EQ(LAST_FRAME, game->GetFrameCount());
+  std::unique_ptr<Slippi::SlippiGame> raw = ParseRaw();
+  ASSERT_NE(nullptr, raw);
+  ExpectSameFrames(*raw, *game, LAST_FRAME);
+}
+
+TEST_F(SlippiCompressionTest, TruncatedFinalBlock)
+{
+  // Like after a crash, the last events block was only partially written and nothing follows
+  const size_t complete_blocks = m_replay.event_counts.size() - 1;
+  const std::vector<u8>& truncated = m_replay.blocks[complete_blocks];
+
+  const std::string path = m_temp_dir + "/game.slpz";
+  File::IOFile file(path, "wb");
+  file.WriteBytes(m_replay.header.data(), m_replay.header.size());
+  for (size_t i = 0; i < complete_blocks; i++)
+    file.WriteBytes(m_replay.blocks[i].data(), m_replay.blocks[i].size());
+  file.WriteBytes(truncated.data(), truncated.size() - 1);
+  file.Flush();
+
+  std::unique_ptr<Slippi::SlippiGame> game(Slippi::SlippiGame::FromFile(path));
+  ASSERT_NE(nullptr, game);
+  const s32 last_frame = GetLastFrame(m_events, m_replay.event_counts[complete_blocks - 1]);
+  for (int poll = 0; poll < 3; poll++)
+  {
+    EXPECT_TRUE(game->DoesFrameExist(last_frame));
+    EXPECT_FALSE(game->DoesFrameExist(last_frame + 1));
+    EXPECT_EQ(last_frame, game->GetFrameCount());
+    EXPECT_FALSE(game->IsProcessingComplete());
+  }
+
+  std::unique_ptr<Slippi::SlippiGame> raw = ParseRaw();
+  ASSERT_NE(nullptr, raw);
+  ExpectSameFrames(*raw, *game, last_frame - 1);
+
+  // Finishing the block later still works
+  file.WriteBytes(&truncated.back(), 1);
+  file.Flush();
+  EXPECT_TRUE(game->DoesFrameExist(LAST_FRAME));
+  EXPECT_TRUE(game->IsProcessingComplete());
+  ExpectSameFrames(*raw, *game, LAST_FRAME);
+}
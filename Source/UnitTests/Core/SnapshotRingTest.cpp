@@ -0,0 +1,190 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/MemoryUtil.h"
+#include "Core/MemTools.h"
+#include "Core/SnapshotRing.h"
+
+namespace
+{
+// Larger than the page size of any host, so every write below is to a page of its own
+constexpr u32 PAGE_STRIDE = 0x10000;
+// As large as MEM1 and ARAM together
+constexpr u32 REGION_SIZE = 640 * PAGE_STRIDE;
+
+class TestSnapshotSource final : public State::SnapshotSource
+{
+public:
+  TestSnapshotSource(u8* memory, bool use_write_faults)
+      : m_memory(memory), m_use_write_faults(use_write_faults)
+  {
+  }
+
+  std::vector<Memory::MemoryView> GetViews() override
+  {
+    return {{m_memory, 0, m_memory, REGION_SIZE}};
+  }
+  u32 GetViewsVersion() override { return 1; }
+  bool IsExceptionHandlerInstalled() override { return m_use_write_faults; }
+
+  void SaveState(std::vector<u8>& buffer) override
+  {
+    buffer.assign(1, state);
+    if (on_save)
+      on_save();
+  }
+  void LoadState(std::vector<u8>& buffer) override { state = buffer.at(0); }
+
+  u8 state = 0;
+  // Runs after the memory was saved
+  std::function<void()> on_save;
+
+private:
+  u8* m_memory;
+  bool m_use_write_faults;
+};
+
+class SnapshotRingTest : public testing::TestWithParam<bool>
+{
+protected:
+  void SetUp() override
+  {
+    EMM::InstallExceptionHandler();
+    m_memory = static_cast<u8*>(Common::AllocateMemoryPages(REGION_SIZE));
+    ASSERT_NE(m_memory, nullptr);
+
+    auto source = std::make_unique<TestSnapshotSource>(m_memory, GetParam());
+    m_source = source.get();
+    m_ring = std::make_unique<State::SnapshotRing>(4, std::move(source));
+  }
+
+  void TearDown() override
+  {
+    // Stops tracking, which makes the memory writable again
+    m_ring.reset();
+    Common::FreeMemoryPages(m_memory, REGION_SIZE);
+    EMM::UninstallExceptionHandler();
+  }
+
+  volatile u8& Page(u32 page) { return m_memory[page * PAGE_STRIDE]; }
+  u8 Get(u32 page) { return Page(page); }
+
+  u8* m_memory = nullptr;
+  TestSnapshotSource* m_source = nullptr;
+  std::unique_ptr<State::SnapshotRing> m_ring;
+};
+}  // namespace
+
+TEST_P(SnapshotRingTest, WriteAfterSave)
+{
+  ASSERT_TRUE(m_ring->Save());
+  Page(0) = 1;
+  m_source->state = 1;
+  ASSERT_TRUE(m_ring->Save());
+  EXPECT_EQ(1u, m_ring->GetLastPageCount());
+
+  Page(0) = 2;
+  m_source->state = 2;
+  ASSERT_TRUE(m_ring->Restore(1));
+  EXPECT_EQ(1, Get(0));
+  EXPECT_EQ(1, m_source->state);
+
+  ASSERT_TRUE(m_ring->Restore(0));
+  EXPECT_EQ(0, Get(0));
+  EXPECT_EQ(0, m_source->state);
+  EXPECT_EQ(1u, m_ring->Size());
+}
+
+TEST_P(SnapshotRingTest, RestoresOnlyDirtyPages)
+{
+  ASSERT_TRUE(m_ring->Save());
+  Page(1) = 1;
+  Page(2) = 1;
+  ASSERT_TRUE(m_ring->Save());
+  Page(3) = 2;
+  ASSERT_TRUE(m_ring->Save());
+  Page(4) = 3;
+
+  // Page 4 changed since the newest snapshot, page 3 is stored in it
+  ASSERT_TRUE(m_ring->Restore(1));
+  EXPECT_EQ(2u, m_ring->GetLastPageCount());
+  EXPECT_EQ(1, Get(1));
+  EXPECT_EQ(1, Get(2));
+  EXPECT_EQ(0, Get(3));
+  EXPECT_EQ(0, Get(4));
+
+  // Writes after a restore are tracked as well
+  Page(2) = 4;
+  ASSERT_TRUE(m_ring->Restore(1));
+  EXPECT_EQ(1u, m_ring->GetLastPageCount());
+  EXPECT_EQ(1, Get(2));
+}
+
+TEST_P(SnapshotRingTest, WriteDuringSave)
+{
+  // The page was dirty during the save, so it was protected again just before. Another thread
+  // writing to it at that point must not be lost.
+  ASSERT_TRUE(m_ring->Save());
+  Page(5) = 1;
+  m_source->on_save = [this] { Page(5) = 2; };
+  ASSERT_TRUE(m_ring->Save());
+  m_source->on_save = nullptr;
+
+  ASSERT_TRUE(m_ring->Restore(1));
+  EXPECT_EQ(1, Get(5));
+
+  // Same with a thread that keeps writing while snapshots are taken
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    for (u8 value = 0; !stop.load(); value = value % 100 + 1)
+      Page(6) = value;
+  });
+  for (int i = 0; i < 200; i++)
+    ASSERT_TRUE(m_ring->Save());
+  stop.store(true);
+  writer.join();
+
+  ASSERT_TRUE(m_ring->Save());
+  const u8 saved = Page(6);
+  Page(6) = 0xff;
+  ASSERT_TRUE(m_ring->Restore(m_ring->Size() - 1));
+  EXPECT_EQ(saved, Get(6));
+}
+
+TEST_P(SnapshotRingTest, Timing)
+{
+  // Roughly what a game writes in a frame
+  constexpr u32 DIRTY_PAGES = 24;
+
+  ASSERT_TRUE(m_ring->Save());
+  for (int i = 0; i < 3; i++)
+  {
+    for (u32 page = 0; page < DIRTY_PAGES; page++)
+      Page(page) = static_cast<u8>(i + 1);
+    ASSERT_TRUE(m_ring->Save());
+  }
+  const u64 save_us = m_ring->GetLastSaveTimeUs();
+
+  ASSERT_TRUE(m_ring->Restore(0));
+  EXPECT_EQ(0, Get(0));
+
+  printf("snapshot ring timing (%s, %u KiB tracked, %u dirty pages):\n",
+         GetParam() ? "write faults" : "comparing pages", REGION_SIZE / 1024, DIRTY_PAGES);
+  printf("save      %llu us\n", static_cast<unsigned long long>(save_us));
+  printf("restore   %llu us (%u pages)\n",
+         static_cast<unsigned long long>(m_ring->GetLastRestoreTimeUs()),
+         m_ring->GetLastPageCount());
+}
+
+INSTANTIATE_TEST_CASE_P(SnapshotRing, SnapshotRingTest, testing::Bool());
@@ -2,8 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
-// Stub implementation of the Host_* callbacks for tests. These implementations
-// do nothing except return default values when required.
+// Stub implementation of the Host_* callbacks for tests and texture-cache-bench. These
+// implementations do nothing except return default values when required.
 
 #include <memory>
 #include <string>
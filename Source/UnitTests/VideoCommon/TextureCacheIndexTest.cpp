@@ -0,0 +1,152 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureCacheIndex.h"
+
+namespace
+{
+struct Entry
+{
+  u32 addr;
+  u32 size_in_bytes;
+  u64 id;
+};
+}  // namespace
+
+TEST(FlatMultiMap, KeepsValuesInInsertionOrder)
+{
+  FlatMultiMap<u32, int> map;
+  EXPECT_TRUE(map.Find(0x100).empty());
+
+  map.Insert(0x100, 1);
+  map.Insert(0x200, 2);
+  map.Insert(0x100, 3);
+  map.Insert(0x100, 4);
+  EXPECT_EQ(4u, map.Size());
+  EXPECT_EQ(std::vector<int>({1, 3, 4}), map.Find(0x100));
+  EXPECT_EQ(std::vector<int>({2}), map.Find(0x200));
+
+  EXPECT_TRUE(map.Erase(0x100, 3));
+  EXPECT_FALSE(map.Erase(0x100, 3));
+  EXPECT_FALSE(map.Erase(0x300, 1));
+  EXPECT_EQ(std::vector<int>({1, 4}), map.Find(0x100));
+
+  map.Clear();
+  EXPECT_EQ(0u, map.Size());
+  EXPECT_TRUE(map.Find(0x200).empty());
+}
+
+TEST(FlatMultiMap, MatchesMultimap)
+{
+  FlatMultiMap<u32, int> map;
+  std::multimap<u32, int> expected;
+  std::mt19937 random(1234);
+
+  for (int i = 0; i < 20000; i++)
+  {
+    // Few distinct keys, so that runs of colliding keys get erased from the middle
+    const u32 key = (random() % 512) * 32;
+    if (random() % 3 != 0)
+    {
+      map.Insert(key, i);
+      expected.emplace(key, i);
+    }
+    else
+    {
+      const auto range = expected.equal_range(key);
+      if (range.first == range.second)
+        continue;
+      const int value = std::next(range.first, random() % std::distance(range.first, range.second))
+                            ->second;
+      EXPECT_TRUE(map.Erase(key, value));
+      expected.erase(std::find_if(range.first, range.second,
+                                  [&](const auto& pair) { return pair.second == value; }));
+    }
+  }
+
+  EXPECT_EQ(expected.size(), map.Size());
+  for (u32 key = 0; key < 512 * 32; key += 32)
+  {
+    std::vector<int> values;
+    const auto range = expected.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+      values.push_back(it->second);
+    EXPECT_EQ(values, map.Find(key));
+  }
+}
+
+TEST(TextureAddressIndex, FindsOverlappingEntriesInOrder)
+{
+  TextureAddressIndex<Entry> index;
+  std::vector<std::unique_ptr<Entry>> entries;
+  std::mt19937 random(5678);
+
+  for (u64 id = 0; id < 2000; id++)
+  {
+    const u32 addr = (random() % 0x40000) * 32;
+    const u32 size = random() % 8 == 0 ? 0 : (random() % 0x2000) * 32;
+    entries.push_back(std::make_unique<Entry>(Entry{addr, size, id}));
+    index.Insert(entries.back().get());
+  }
+
+  // Erase some of them again
+  for (size_t i = 0; i < entries.size(); i += 3)
+    index.Erase(entries[i].get());
+  EXPECT_EQ(entries.size() - (entries.size() + 2) / 3, index.Size());
+
+  for (int i = 0; i < 500; i++)
+  {
+    const u32 addr = (random() % 0x40000) * 32;
+    const u32 size = (random() % 0x1000) * 32;
+    const std::vector<Entry*> found = index.FindOverlapping(addr, size);
+
+    EXPECT_TRUE(std::is_sorted(found.begin(), found.end(), [](const Entry* a, const Entry* b) {
+      return a->addr != b->addr ? a->addr < b->addr : a->id < b->id;
+    }));
+    EXPECT_EQ(found.end(), std::adjacent_find(found.begin(), found.end()));
+
+    for (size_t j = 0; j < entries.size(); j++)
+    {
+      const Entry* entry = entries[j].get();
+      const bool overlaps = entry->addr < addr + size && addr < entry->addr + entry->size_in_bytes;
+      const bool is_erased = j % 3 == 0;
+      const bool is_found = std::find(found.begin(), found.end(), entry) != found.end();
+      EXPECT_TRUE(is_erased ? !is_found : !overlaps || is_found) << "entry " << j;
+    }
+  }
+}
+
+TEST(TextureAddressIndex, FindsEntriesAtAddress)
+{
+  TextureAddressIndex<Entry> index;
+  Entry a{0x1000, 0x100, 0}, b{0x1000, 0, 1}, c{0x10000, 0x8000, 2};
+  index.Insert(&a);
+  index.Insert(&b);
+  index.Insert(&c);
+
+  EXPECT_EQ(std::vector<Entry*>({&a, &b}), index.AtAddress(0x1000));
+  EXPECT_EQ(std::vector<Entry*>({&c}), index.AtAddress(0x10000));
+  EXPECT_TRUE(index.AtAddress(0x3000).empty());
+
+  // Empty entries are still found at their address, and large ones on each of their pages
+  EXPECT_EQ(std::vector<Entry*>({&a, &b}), index.FindOverlapping(0x1000, 0));
+  EXPECT_EQ(std::vector<Entry*>({&c}), index.FindOverlapping(0x15000, 0x20));
+  EXPECT_EQ(std::vector<Entry*>({&a, &b, &c}), index.FindOverlapping(0x1000, 0x10000));
+
+  index.Erase(&a);
+  EXPECT_EQ(std::vector<Entry*>({&b}), index.AtAddress(0x1000));
+
+  size_t count = 0;
+  index.ForEach([&](Entry*) { count++; });
+  EXPECT_EQ(2u, count);
+}
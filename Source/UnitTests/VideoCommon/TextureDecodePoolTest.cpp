@@ -0,0 +1,81 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/Align.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecodePool.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+struct TestLevel
+{
+  u32 width;
+  u32 height;
+  std::vector<u8> src;
+  std::vector<u8> expected;
+  std::vector<u8> decoded;
+};
+
+void TestFormat(TextureDecodePool* pool, TextureFormat format)
+{
+  std::mt19937 random(static_cast<u32>(format));
+  std::vector<u8> tlut(TexDecoder_GetPaletteSize(TextureFormat::C14X2));
+  for (u8& byte : tlut)
+    byte = static_cast<u8>(random());
+
+  // Large enough to be split into several tiles, with a mipmap chain queued behind it
+  std::vector<TestLevel> levels;
+  for (u32 size = 512; size >= 8; size /= 4)
+  {
+    TestLevel level;
+    level.width = size;
+    level.height = Common::AlignUp(size * 3 / 4, TexDecoder_GetBlockHeightInTexels(format));
+    level.src.resize(TexDecoder_GetTextureSizeInBytes(level.width, level.height, format));
+    for (u8& byte : level.src)
+      byte = static_cast<u8>(random());
+    level.expected.resize(level.width * level.height * 4);
+    level.decoded.resize(level.expected.size());
+    TexDecoder_Decode(level.expected.data(), level.src.data(), level.width, level.height, format,
+                      tlut.data(), TLUTFormat::RGB5A3);
+    levels.push_back(std::move(level));
+  }
+
+  for (TestLevel& level : levels)
+  {
+    pool->QueueLevel(level.decoded.data(), level.src.data(), level.width, level.height, format,
+                     tlut.data(), TLUTFormat::RGB5A3);
+  }
+  for (const TestLevel& level : levels)
+  {
+    pool->WaitForNextLevel();
+    EXPECT_EQ(level.expected, level.decoded) << "format " << static_cast<int>(format);
+  }
+}
+
+void TestAllFormats(TextureDecodePool* pool)
+{
+  for (TextureFormat format :
+       {TextureFormat::I4, TextureFormat::I8, TextureFormat::IA4, TextureFormat::IA8,
+        TextureFormat::RGB565, TextureFormat::RGB5A3, TextureFormat::RGBA8, TextureFormat::C4,
+        TextureFormat::C8, TextureFormat::C14X2, TextureFormat::CMPR})
+  {
+    TestFormat(pool, format);
+  }
+}
+}  // namespace
+
+TEST(TextureDecodePool, MatchesDecodingAtOnce)
+{
+  TextureDecodePool pool;
+  TestAllFormats(&pool);
+
+  pool.ResizeWorkerThreads(3);
+  TestAllFormats(&pool);
+}